@@ -49,6 +49,7 @@ list (APPEND MAIN_SOURCE_FILES
         opm/core/pressure/mimetic/mimetic.c
         opm/core/pressure/msmfem/dfs.c
         opm/core/pressure/msmfem/partition.c
+        opm/core/pressure/tpfa/cell_ordering.c
         opm/core/pressure/tpfa/cfs_tpfa_residual.c
         opm/core/pressure/tpfa/ifs_tpfa.c
         opm/core/props/BlackoilPropertiesBasic.cpp
@@ -65,6 +66,7 @@ list (APPEND MAIN_SOURCE_FILES
         opm/core/props/satfunc/SaturationPropsBasic.cpp
         opm/core/props/satfunc/SaturationPropsFromDeck.cpp
         opm/core/simulator/BlackoilState.cpp
+        opm/core/simulator/ImpesStepController.cpp
         opm/core/simulator/TwophaseState.cpp
         opm/core/simulator/SimulatorReport.cpp
         opm/core/transport/TransportSolverTwophaseInterface.cpp
@@ -75,6 +77,7 @@ list (APPEND MAIN_SOURCE_FILES
         opm/core/transport/reorder/tarjan.c
         opm/core/utility/miscUtilities.cpp
         opm/core/utility/miscUtilitiesBlackoil.cpp
+        opm/core/wells/FlattenedWellsGroups.cpp
         opm/core/wells/InjectionSpecification.cpp
         opm/core/wells/ProductionSpecification.cpp
         opm/core/wells/WellCollection.cpp
@@ -87,12 +90,19 @@ list (APPEND MAIN_SOURCE_FILES
 # originally generated with the command:
 # find tests -name '*.cpp' -a ! -wholename '*/not-unit/*' -printf '\t%p\n' | sort
 list (APPEND TEST_SOURCE_FILES
+	tests/test_cfs_tpfa_residual.cpp
 	tests/test_dgbasis.cpp
 	tests/test_flowdiagnostics.cpp
+	tests/test_ifs_tpfa.cpp
+	tests/test_impesstepcontroller.cpp
+	tests/test_mimetic.cpp
+	tests/test_partition.cpp
 	tests/test_parallelistlinformation.cpp
 	tests/test_wells.cpp
 	tests/test_linearsolver.cpp
 	tests/test_parallel_linearsolver.cpp
+	tests/test_regiontemperaturetable.cpp
+	tests/test_rockcompressibility.cpp
 	tests/test_satfunc.cpp
 	tests/test_shadow.cpp
 	tests/test_equil.cpp
@@ -114,6 +124,7 @@ list (APPEND TEST_DATA_FILES
 	tests/liveoil.DATA
 	tests/capillary.DATA
 	tests/capillary_overlap.DATA
+	tests/capillary_regions.DATA
         tests/capillarySwatinit.DATA
 	tests/deadfluids.DATA
 	tests/equil_livegas.DATA
@@ -141,6 +152,9 @@ list (APPEND TEST_DATA_FILES
 # originally generated with the command:
 # find examples -name '*.c*' -printf '\t%p\n' | sort
 list (APPEND EXAMPLE_SOURCE_FILES
+	examples/benchmark_equil.cpp
+	examples/benchmark_mimetic_ip.cpp
+	examples/benchmark_wellcollection.cpp
 	examples/compute_eikonal_from_files.cpp
 	examples/compute_initial_state.cpp
 	examples/compute_tof_from_files.cpp
@@ -188,6 +202,7 @@ list (APPEND PUBLIC_HEADER_FILES
         opm/core/pressure/mimetic/mimetic.h
         opm/core/pressure/msmfem/dfs.h
         opm/core/pressure/msmfem/partition.h
+        opm/core/pressure/tpfa/cell_ordering.h
         opm/core/pressure/tpfa/cfs_tpfa_residual.h
         opm/core/pressure/tpfa/compr_quant_general.h
         opm/core/pressure/tpfa/compr_source.h
@@ -205,6 +220,7 @@ list (APPEND PUBLIC_HEADER_FILES
         opm/core/props/phaseUsageFromDeck.hpp
         opm/core/props/pvt/PvtPropertiesBasic.hpp
         opm/core/props/pvt/PvtPropertiesIncompFromDeck.hpp
+        opm/core/props/pvt/RegionTemperatureTable.hpp
         opm/core/props/pvt/ThermalGasPvtWrapper.hpp
         opm/core/props/pvt/ThermalOilPvtWrapper.hpp
         opm/core/props/pvt/ThermalWaterPvtWrapper.hpp
@@ -221,6 +237,7 @@ list (APPEND PUBLIC_HEADER_FILES
         opm/core/simulator/EquilibrationHelpers.hpp
         opm/core/simulator/ExplicitArraysFluidState.hpp
         opm/core/simulator/ExplicitArraysSatDerivativesFluidState.hpp
+        opm/core/simulator/ImpesStepController.hpp
         opm/core/simulator/SimulatorReport.hpp
         opm/core/simulator/TwophaseState.hpp
         opm/core/simulator/WellState.hpp
@@ -240,6 +257,7 @@ list (APPEND PUBLIC_HEADER_FILES
         opm/core/utility/miscUtilities_impl.hpp
         opm/core/well_controls.h
         opm/core/wells.h
+        opm/core/wells/FlattenedWellsGroups.hpp
         opm/core/wells/InjectionSpecification.hpp
         opm/core/wells/ProductionSpecification.hpp
         opm/core/wells/WellCollection.hpp
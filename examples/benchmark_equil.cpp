@@ -0,0 +1,353 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <opm/core/grid.h>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/simulator/initStateEquil.hpp>
+#include <opm/core/utility/RegionMapping.hpp>
+#include <opm/core/utility/StopWatch.hpp>
+#include <opm/core/utility/compressedToCartesian.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <opm/parser/eclipse/Parser/ParseContext.hpp>
+#include <opm/parser/eclipse/Parser/Parser.hpp>
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+
+#include <opm/material/fluidmatrixinteractions/EclMaterialLawManager.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+    struct DeckSpec
+    {
+        int nx, ny, nz;
+        int num_regions;
+        double top, dz;
+        double datum, goc, woc, contact_shift;
+        bool swatinit;
+    };
+
+    /// Three-phase live oil deck on an nx*ny*nz corner-point grid.  The
+    /// equilibration regions are slabs along the x axis, and the
+    /// contacts of each region are contact_shift deeper than those of
+    /// the previous one.
+    std::string syntheticDeck(const DeckSpec& s)
+    {
+        const int nxy = s.nx * s.ny;
+        const int nc = nxy * s.nz;
+        std::ostringstream d;
+        d.precision(12);
+
+        d << "RUNSPEC\nWATER\nOIL\nGAS\nDISGAS\n"
+          << "DIMENS\n" << s.nx << ' ' << s.ny << ' ' << s.nz << " /\n"
+          << "TABDIMS\n1 1 40 20 1 20 /\n"
+          << "EQLDIMS\n" << s.num_regions << " /\n"
+          << "START\n1 'JAN' 2017 /\n";
+
+        // Vertical pillars on a 50m by 50m lateral mesh, and horizontal
+        // layers of thickness dz.
+        const double bottom = s.top + s.nz*s.dz;
+        d << "GRID\nCOORD\n";
+        for (int j = 0; j <= s.ny; ++j) {
+            for (int i = 0; i <= s.nx; ++i) {
+                d << 50*i << ' ' << 50*j << ' ' << s.top << ' '
+                  << 50*i << ' ' << 50*j << ' ' << bottom << '\n';
+            }
+        }
+        d << "/\nZCORN\n";
+        for (int k = 0; k < s.nz; ++k) {
+            d << 4*nxy << '*' << s.top + k*s.dz << ' '
+              << 4*nxy << '*' << s.top + (k + 1)*s.dz << '\n';
+        }
+        d << "/\n"
+          << "PORO\n" << nc << "*0.2 /\n"
+          << "PERMX\n" << nc << "*100 /\n"
+          << "PERMY\n" << nc << "*100 /\n"
+          << "PERMZ\n" << nc << "*10 /\n";
+
+        d << "PROPS\n"
+          << "PVTO\n"
+          << "  0    1  1.000 1.20 /\n"
+          << " 50  100  1.030 1.10 /\n"
+          << "100  200  1.063 1.06 /\n"
+          << "150  300  1.094 0.98 /\n"
+          << "200  400  1.120 0.94\n"
+          << "     500  1.119 0.94 /\n"
+          << "/\n"
+          << "PVDG\n"
+          << " 50 0.020 0.01\n"
+          << "200 0.005 0.02\n"
+          << "500 0.002 0.03 /\n"
+          << "PVTW\n1 1.0 4.0E-5 0.96 0.0 /\n"
+          << "ROCK\n1 5.0E-5 /\n"
+          << "DENSITY\n700 1000 1 /\n"
+          << "SWOF\n"
+          << "0.2  0.0  1.0 2.0\n"
+          << "0.5  0.2  0.3 0.5\n"
+          << "1.0  1.0  0.0 0.0 /\n"
+          << "SGOF\n"
+          << "0.0  0.0  1.0 0.0\n"
+          << "0.4  0.3  0.2 0.3\n"
+          << "0.8  1.0  0.0 1.0 /\n";
+        if (s.swatinit) {
+            // Linear in depth, such that SWATINIT rescales the
+            // capillary pressure in the transition zones.
+            d << "SWATINIT\n";
+            for (int k = 0; k < s.nz; ++k) {
+                d << nxy << '*' << (0.2 + 0.8*k/std::max(s.nz - 1, 1)) << '\n';
+            }
+            d << "/\n";
+        }
+
+        d << "REGIONS\nEQLNUM\n";
+        for (int row = 0; row < s.ny * s.nz; ++row) {
+            int i0 = 0;
+            for (int r = 0; r < s.num_regions; ++r) {
+                const int i1 = (long long)(r + 1) * s.nx / s.num_regions;
+                if (i1 > i0) {
+                    d << (i1 - i0) << '*' << (r + 1) << ' ';
+                }
+                i0 = i1;
+            }
+            d << '\n';
+        }
+        d << "/\n";
+
+        d << "SOLUTION\nEQUIL\n";
+        for (int r = 0; r < s.num_regions; ++r) {
+            const double shift = r * s.contact_shift;
+            d << s.datum + shift << " 250 " << s.woc + shift << " 0.25 "
+              << s.goc + shift << " 0.35 1 0 0 /\n";
+        }
+        d << "RSVD\n";
+        for (int r = 0; r < s.num_regions; ++r) {
+            d << s.top << " 120\n" << s.top + s.nz*s.dz << " 150 /\n";
+        }
+
+        d << "SCHEDULE\n";
+        return d.str();
+    }
+
+    /// Peak resident set size in kB, or -1 if unknown.
+    long peakMemoryKb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::stol(line.substr(6));
+            }
+        }
+        return -1;
+    }
+
+    double checksum(const std::vector<double>& v)
+    {
+        double sum = 0.0;
+        for (const double x : v) {
+            sum += x;
+        }
+        return sum;
+    }
+
+} // anon namespace
+
+
+// Times the stages of the equilibration-based initialisation on a
+// synthetic multi-region deck and writes a JSON report.  The checksums
+// of the results make it usable for regression checks across versions.
+int
+main(int argc, char** argv)
+try
+{
+    using namespace Opm;
+
+    ParameterGroup param(argc, argv);
+
+    DeckSpec spec;
+    spec.nx = param.getDefault("nx", 100);
+    spec.ny = param.getDefault("ny", 100);
+    spec.nz = param.getDefault("nz", 100);
+    spec.num_regions = param.getDefault("num_regions", 4);
+    spec.top = param.getDefault("top", 2000.0);
+    spec.dz = param.getDefault("dz", 2.0);
+    spec.datum = param.getDefault("datum", spec.top + 0.4*spec.nz*spec.dz);
+    spec.goc = param.getDefault("goc", spec.top + 0.3*spec.nz*spec.dz);
+    spec.woc = param.getDefault("woc", spec.top + 0.7*spec.nz*spec.dz);
+    spec.contact_shift = param.getDefault("contact_shift", 0.0);
+    spec.swatinit = param.getDefault("swatinit", false);
+    const std::string report_file = param.getDefault<std::string>("report", "");
+    const double grav = param.getDefault("gravity", unit::gravity);
+
+    time::StopWatch clock;
+    clock.start();
+    ParseContext parseContext;
+    Parser parser;
+    const Deck deck = parser.parseString(syntheticDeck(spec), parseContext);
+    const EclipseState eclipseState(deck, parseContext);
+    GridManager gm(eclipseState.getInputGrid());
+    const UnstructuredGrid& grid = *gm.c_grid();
+    const int nc = grid.number_of_cells;
+
+    typedef FluidSystems::BlackOil<double> FluidSystem;
+    FluidSystem::initFromDeck(deck, eclipseState);
+
+    typedef ThreePhaseMaterialTraits<double,
+        /*wettingPhaseIdx=*/FluidSystem::waterPhaseIdx,
+        /*nonWettingPhaseIdx=*/FluidSystem::oilPhaseIdx,
+        /*gasPhaseIdx=*/FluidSystem::gasPhaseIdx> MaterialTraits;
+    typedef EclMaterialLawManager<MaterialTraits> MaterialLawManager;
+
+    const std::vector<int> compressedToCartesianIdx
+        = compressedToCartesian(grid.number_of_cells, grid.global_cell);
+    MaterialLawManager materialLawManager;
+    materialLawManager.initFromDeck(deck, eclipseState, compressedToCartesianIdx);
+    clock.stop();
+    const double setup_time = clock.secsSinceStart();
+    const long setup_memory = peakMemoryKb();
+
+    // The stages one at a time, for all regions, with the same calls as
+    // EQUIL::DeckDependent::InitialStateComputer makes.
+    const std::vector<EquilRecord> rec = EQUIL::DeckDependent::getEquil(eclipseState);
+    const RegionMapping<> eqlmap(EQUIL::DeckDependent::equilnum(eclipseState, grid));
+    std::vector<double> swat_init;
+    if (spec.swatinit) {
+        const std::vector<double>& swat_init_ecl =
+            eclipseState.get3DProperties().getDoubleGridProperty("SWATINIT").getData();
+        swat_init.resize(nc);
+        for (int c = 0; c < nc; ++c) {
+            swat_init[c] = swat_init_ecl[grid.global_cell ? grid.global_cell[c] : c];
+        }
+    }
+    const auto& rsvdTables = eclipseState.getTableManager().getRsvdTables();
+    std::vector<EQUIL::EquilReg> eqreg;
+    for (size_t r = 0; r < rec.size(); ++r) {
+        const RsvdTable& rsvd = rsvdTables.getTable<RsvdTable>(r);
+        auto rs = std::make_shared<EQUIL::Miscibility::RsVD<FluidSystem>>(0,
+                      rsvd.getColumn("DEPTH").vectorCopy(), rsvd.getColumn("RS").vectorCopy());
+        eqreg.emplace_back(rec[r], rs, std::make_shared<EQUIL::Miscibility::NoMixing>(), 0);
+    }
+
+    const int np = FluidSystem::numPhases;
+    std::vector<std::vector<double>> press(np, std::vector<double>(nc));
+    std::vector<std::vector<double>> sat(np, std::vector<double>(nc));
+    std::vector<double> rs(nc), rv(nc);
+
+    clock.start();
+    const EQUIL::CellDepths depths(grid);
+    clock.stop();
+    const double depth_time = clock.secsSinceStart();
+
+    clock.start();
+    for (const auto& r : eqlmap.activeRegions()) {
+        EQUIL::phasePressures<FluidSystem>(eqreg[r], eqlmap.cells(r), depths, grav, press);
+    }
+    clock.stop();
+    const double pressure_time = clock.secsSinceStart();
+
+    clock.start();
+    for (const auto& r : eqlmap.activeRegions()) {
+        EQUIL::phaseSaturations<FluidSystem>(grid, eqreg[r], eqlmap.cells(r), materialLawManager,
+                                             swat_init, press, sat);
+    }
+    clock.stop();
+    const double saturation_time = clock.secsSinceStart();
+
+    clock.start();
+    const int oilpos = FluidSystem::oilPhaseIdx;
+    const int gaspos = FluidSystem::gasPhaseIdx;
+    for (const auto& r : eqlmap.activeRegions()) {
+        const auto& cells = eqlmap.cells(r);
+        const std::vector<double> temp = EQUIL::temperature(grid, eqreg[r], cells);
+        EQUIL::computeRs(grid, cells, press[oilpos], temp, eqreg[r].dissolutionCalculator(), sat[gaspos], rs);
+        EQUIL::computeRs(grid, cells, press[gaspos], temp, eqreg[r].evaporationCalculator(), sat[oilpos], rv);
+    }
+    clock.stop();
+    const double rsrv_time = clock.secsSinceStart();
+
+    // The complete initialisation, with regions equilibrated concurrently.
+    // SWATINIT scaling is recomputed from the same capillary pressures,
+    // so reusing the law manager of the stages gives the same state.
+    clock.start();
+    EQUIL::DeckDependent::InitialStateComputer<FluidSystem> isc(materialLawManager, eclipseState, grid, grav);
+    clock.stop();
+    const double total_time = clock.secsSinceStart();
+    const long peak_memory = peakMemoryKb();
+
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+
+    std::ostringstream report;
+    report.precision(12);
+    report << "{\n"
+           << "  \"cells\": " << nc << ",\n"
+           << "  \"regions\": " << spec.num_regions << ",\n"
+           << "  \"swatinit\": " << (spec.swatinit ? "true" : "false") << ",\n"
+           << "  \"threads\": " << threads << ",\n"
+           << "  \"time\": {\n"
+           << "    \"setup\": " << setup_time << ",\n"
+           << "    \"cell_depths\": " << depth_time << ",\n"
+           << "    \"phase_pressures\": " << pressure_time << ",\n"
+           << "    \"phase_saturations\": " << saturation_time << ",\n"
+           << "    \"rs_rv\": " << rsrv_time << ",\n"
+           << "    \"initial_state_computer\": " << total_time << "\n"
+           << "  },\n"
+           << "  \"peak_memory_kb\": {\n"
+           << "    \"after_setup\": " << setup_memory << ",\n"
+           << "    \"after_equilibration\": " << peak_memory << "\n"
+           << "  },\n"
+           << "  \"checksum\": {\n"
+           << "    \"oil_pressure\": " << checksum(isc.press()[oilpos]) << ",\n"
+           << "    \"water_saturation\": " << checksum(isc.saturation()[FluidSystem::waterPhaseIdx]) << ",\n"
+           << "    \"gas_saturation\": " << checksum(isc.saturation()[gaspos]) << ",\n"
+           << "    \"rs\": " << checksum(isc.rs()) << ",\n"
+           << "    \"stages_oil_pressure\": " << checksum(press[oilpos]) << "\n"
+           << "  }\n"
+           << "}\n";
+
+    if (report_file.empty()) {
+        std::cout << report.str();
+    } else {
+        std::ofstream file(report_file.c_str());
+        file << report.str();
+    }
+}
+catch (const std::exception &e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    throw;
+}
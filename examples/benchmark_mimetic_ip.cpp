@@ -0,0 +1,115 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <opm/core/grid.h>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/pressure/mimetic/mimetic.h>
+#include <opm/core/pressure/tpfa/trans_tpfa.h>
+#include <opm/core/utility/StopWatch.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+
+// Times the setup of the static mimetic inner products against the
+// static two-point transmissibilities on a Cartesian grid.
+int
+main(int argc, char** argv)
+try
+{
+    using namespace Opm;
+
+    ParameterGroup param(argc, argv);
+
+    const int nx = param.getDefault("nx", 100);
+    const int ny = param.getDefault("ny", 100);
+    const int nz = param.getDefault("nz", 100);
+    const int repeats = param.getDefault("repeats", 3);
+
+    GridManager grid_manager(nx, ny, nz, 1.0, 1.0, 1.0);
+    UnstructuredGrid* grid = const_cast<UnstructuredGrid*>(grid_manager.c_grid());
+    const int nc = grid->number_of_cells;
+    const int d = grid->dimensions;
+
+    // Diagonal, anisotropic permeability.
+    std::vector<double> perm(nc * d * d, 0.0);
+    for (int c = 0; c < nc; ++c) {
+        for (int j = 0; j < d; ++j) {
+            perm[c*d*d + j*(d + 1)] = 1.0 + 0.5*j;
+        }
+    }
+
+    int max_nconn = 0;
+    std::size_t sum_nconn2 = 0;
+    for (int c = 0; c < nc; ++c) {
+        const int n = grid->cell_facepos[c + 1] - grid->cell_facepos[c];
+        max_nconn = std::max(max_nconn, n);
+        sum_nconn2 += static_cast<std::size_t>(n) * n;
+    }
+
+    std::vector<double> Binv0(sum_nconn2), Binv(sum_nconn2);
+    std::vector<size_t> bpos(nc + 1);
+    mim_ip_block_offsets(nc, grid->cell_facepos, &bpos[0]);
+    std::vector<double> totmob(nc, 1.0);
+    std::vector<double> htrans(grid->cell_facepos[nc]), trans(grid->number_of_faces);
+
+    double ip_time = 0.0, mob_time = 0.0, tpfa_time = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        time::StopWatch clock;
+
+        clock.start();
+        mim_ip_simple_all(nc, d, max_nconn,
+                          grid->cell_facepos, grid->cell_faces,
+                          grid->face_cells, grid->face_centroids,
+                          grid->face_normals, grid->face_areas,
+                          grid->cell_centroids, grid->cell_volumes,
+                          &perm[0], &Binv0[0]);
+        clock.stop();
+        ip_time += clock.secsSinceStart();
+
+        clock.start();
+        mim_ip_mobility_update_offsets(nc, &bpos[0], &totmob[0],
+                                       &Binv0[0], &Binv[0]);
+        clock.stop();
+        mob_time += clock.secsSinceStart();
+
+        clock.start();
+        tpfa_htrans_compute(grid, &perm[0], &htrans[0]);
+        tpfa_trans_compute(grid, &htrans[0], &trans[0]);
+        clock.stop();
+        tpfa_time += clock.secsSinceStart();
+    }
+
+    std::cout << "Cells:                        " << nc << '\n'
+              << "Mimetic inner products (s):   " << ip_time / repeats << '\n'
+              << "Mobility update (s):          " << mob_time / repeats << '\n'
+              << "TPFA transmissibilities (s):  " << tpfa_time / repeats << std::endl;
+}
+catch (const std::exception &e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    throw;
+}
@@ -0,0 +1,126 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <opm/core/wells/WellCollection.hpp>
+#include <opm/core/wells/WellsGroup.hpp>
+#include <opm/core/utility/StopWatch.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Builds a FIELD -> groups -> subgroups -> wells hierarchy through
+// WellCollection::addChild(), as WellsManager does, and times the
+// construction and the name lookups.  The lookups are also done by
+// searching the tree with WellsGroupInterface::findGroup() for
+// comparison.
+int
+main(int argc, char** argv)
+try
+{
+    using namespace Opm;
+
+    ParameterGroup param(argc, argv);
+    const int num_wells = param.getDefault("num_wells", 5000);
+    const int num_groups = param.getDefault("num_groups", 500);
+    const int groups_per_top = param.getDefault("groups_per_top", 10);
+
+    PhaseUsage pu;
+    pu.num_phases = 3;
+    for (int phase = 0; phase < BlackoilPhases::MaxNumPhases + BlackoilPhases::NumCryptoPhases; ++phase) {
+        pu.phase_used[phase] = phase < BlackoilPhases::MaxNumPhases;
+        pu.phase_pos[phase] = phase < BlackoilPhases::MaxNumPhases ? phase : -1;
+    }
+    pu.has_solvent = false;
+    pu.has_polymer = false;
+    pu.has_energy = false;
+    const ProductionSpecification prod_spec;
+    const InjectionSpecification inj_spec;
+
+    std::vector<std::string> group_names(num_groups);
+    std::vector<std::string> well_names(num_wells);
+    for (int g = 0; g < num_groups; ++g) {
+        group_names[g] = "G" + std::to_string(g);
+    }
+    for (int w = 0; w < num_wells; ++w) {
+        well_names[w] = "W" + std::to_string(w);
+    }
+
+    time::StopWatch clock;
+    clock.start();
+    WellCollection collection;
+    std::shared_ptr<WellsGroupInterface> field =
+        std::make_shared<WellsGroup>("FIELD", 1.0, prod_spec, inj_spec, pu);
+    collection.addChild(field);
+    // Every groups_per_top'th group is attached to FIELD, the others
+    // to the closest such group before them.
+    for (int g = 0; g < num_groups; ++g) {
+        std::shared_ptr<WellsGroupInterface> group =
+            std::make_shared<WellsGroup>(group_names[g], 1.0, prod_spec, inj_spec, pu);
+        const int top = g - g % groups_per_top;
+        collection.addChild(group, g == top ? std::string("FIELD") : group_names[top]);
+    }
+    for (int w = 0; w < num_wells; ++w) {
+        std::shared_ptr<WellsGroupInterface> well =
+            std::make_shared<WellNode>(well_names[w], 1.0, prod_spec, inj_spec, pu);
+        collection.addChild(well, group_names[w % num_groups]);
+    }
+    clock.stop();
+    const double build_time = clock.secsSinceStart();
+
+    int found = 0;
+    clock.start();
+    for (const auto& name : group_names) {
+        found += collection.findNode(name) != NULL;
+    }
+    for (const auto& name : well_names) {
+        found += &collection.findWellNode(name) != NULL;
+    }
+    clock.stop();
+    const double lookup_time = clock.secsSinceStart();
+
+    int found_tree = 0;
+    clock.start();
+    for (const auto& name : group_names) {
+        found_tree += field->findGroup(name) != NULL;
+    }
+    for (const auto& name : well_names) {
+        found_tree += field->findGroup(name) != NULL;
+    }
+    clock.stop();
+    const double tree_time = clock.secsSinceStart();
+
+    std::cout << "Wells:               " << num_wells << '\n'
+              << "Groups:              " << num_groups << '\n'
+              << "Build collection:    " << build_time << " s\n"
+              << "Indexed lookups:     " << lookup_time << " s (" << found << " found)\n"
+              << "Tree search lookups: " << tree_time << " s (" << found_tree << " found)\n";
+}
+catch (const std::exception &e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    throw;
+}
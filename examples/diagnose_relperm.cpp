@@ -42,6 +42,7 @@
 #include <boost/algorithm/string/case_conv.hpp>
 #include <memory>
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <numeric>
@@ -50,7 +51,9 @@
 
 void usage() {
     std::cout << std::endl << 
-        "Usage: diagnose_relperm <eclipseFile>" << std::endl;
+        "Usage: diagnose_relperm <eclipseFile> [maxMessagesPerCategory]" << std::endl <<
+        "With maxMessagesPerCategory > 0, only the first issues of each kind of" << std::endl <<
+        "scaled end-point issue are reported, followed by a summary." << std::endl;
 }
 
 
@@ -97,6 +100,9 @@ try
     streamLog->setMessageLimiter(std::make_shared<MessageLimiter>(10));
     streamLog->setMessageFormatter(std::make_shared<SimpleMessageFormatter>(true, true));
     RelpermDiagnostics diagnostic;
+    if (argc > 2) {
+        diagnostic.setMaxMessagesPerCategory(std::atoi(argv[2]));
+    }
     diagnostic.diagnosis(eclState, deck, grid);
 }
 catch (const std::exception &e) {
@@ -59,6 +59,7 @@ namespace Opm
     ///                                and completions does not change during the
     ///                                run. However, controls (only) are allowed
     ///                                to change.
+    /// \param[in] ordering      Cell ordering of the Jacobian system.
     CompressibleTpfa::CompressibleTpfa(const UnstructuredGrid& grid,
                                        const BlackoilPropertiesInterface& props,
                                        const RockCompressibility* rock_comp_props,
@@ -67,7 +68,8 @@ namespace Opm
                                        const double change_tol,
                                        const int maxiter,
                                        const double* gravity,
-                                       const struct Wells* wells)
+                                       const struct Wells* wells,
+                                       const tpfa_cell_ordering ordering)
         : grid_(grid),
           props_(props),
           rock_comp_props_(rock_comp_props),
@@ -88,6 +90,7 @@ namespace Opm
         }
         const int num_dofs = grid.number_of_cells + (wells ? wells->number_of_wells : 0);
         pressure_increment_.resize(num_dofs);
+        system_increment_.resize(num_dofs);
         UnstructuredGrid* gg = const_cast<UnstructuredGrid*>(&grid_);
         tpfa_htrans_compute(gg, props.permeability(), &htrans_[0]);
         tpfa_trans_compute(gg, &htrans_[0], &trans_[0]);
@@ -103,7 +106,7 @@ namespace Opm
         cfs_tpfa_res_wells w;
         w.W = const_cast<struct Wells*>(wells_);
         w.data = NULL;
-        h_ = cfs_tpfa_res_construct(gg, &w, props.numPhases());
+        h_ = cfs_tpfa_res_construct_ordered(gg, &w, props.numPhases(), ordering);
     }
 
 
@@ -206,6 +209,65 @@ namespace Opm
 
 
 
+    /// Maximum stable time step for explicit transport.
+    double CompressibleTpfa::stableTransportStep(const BlackoilState& state,
+                                                 const WellState& well_state)
+    {
+        // The fluid data is evaluated at the latest Newton iterate and at
+        // the surface volumes of the previous transport step, update it.
+        computePerIterationDynamicData(0.0, state, well_state);
+
+        const double* well_bhp = well_state.bhp().empty() ? NULL : &well_state.bhp()[0];
+        UnstructuredGrid* gg = const_cast<UnstructuredGrid*>(&grid_);
+        CompletionData completion_data;
+        completion_data.wdp = ! wellperf_wdp_.empty() ? &wellperf_wdp_[0] : 0;
+        completion_data.A = ! wellperf_A_.empty() ? &wellperf_A_[0] : 0;
+        completion_data.phasemob = ! wellperf_phasemob_.empty() ? &wellperf_phasemob_[0] : 0;
+        cfs_tpfa_res_wells wells_tmp;
+        wells_tmp.W = const_cast<Wells*>(wells_);
+        wells_tmp.data = &completion_data;
+        cfs_tpfa_res_forces forces;
+        forces.wells = &wells_tmp;
+        forces.src = NULL;
+        compr_quantities_gen cq;
+        cq.nphases = props_.numPhases();
+        cq.Ac = &cell_A_[0];
+        cq.dAc = &cell_dA_[0];
+        cq.Af = &face_A_[0];
+        cq.phasemobf = &face_phasemob_[0];
+        cq.voldiscr = &cell_voldisc_[0];
+
+        return cfs_tpfa_res_impes_maxtime(gg, &forces, &cq, &trans_[0],
+                                          &face_gravcap_[0], &state.pressure()[0],
+                                          well_bhp, &porevol_[0], h_);
+    }
+
+
+
+
+    /// Explicit transport of surface volumes.
+    void CompressibleTpfa::explicitTransport(const double dt,
+                                             BlackoilState& state)
+    {
+        UnstructuredGrid* gg = const_cast<UnstructuredGrid*>(&grid_);
+        CompletionData completion_data;
+        completion_data.wdp = ! wellperf_wdp_.empty() ? &wellperf_wdp_[0] : 0;
+        completion_data.A = ! wellperf_A_.empty() ? &wellperf_A_[0] : 0;
+        completion_data.phasemob = ! wellperf_phasemob_.empty() ? &wellperf_phasemob_[0] : 0;
+        cfs_tpfa_res_wells wells_tmp;
+        wells_tmp.W = const_cast<Wells*>(wells_);
+        wells_tmp.data = &completion_data;
+        cfs_tpfa_res_forces forces;
+        forces.wells = &wells_tmp;
+        forces.src = NULL;
+
+        cfs_tpfa_res_expl_mass_transport(gg, &forces, props_.numPhases(), dt,
+                                         &porevol_[0], h_, &state.surfacevol()[0]);
+    }
+
+
+
+
 
     /// Compute well potentials.
     void CompressibleTpfa::computeWellPotentials(const BlackoilState& state)
@@ -334,9 +396,7 @@ namespace Opm
         if (rock_comp_props_ && rock_comp_props_->isActive()) {
             computePorevolume(grid_, props_.porosity(), *rock_comp_props_, state.pressure(), porevol_);
             rock_comp_.resize(nc);
-            for (int cell = 0; cell < nc; ++cell) {
-                rock_comp_[cell] = rock_comp_props_->rockComp(state.pressure()[cell]);
-            }
+            rock_comp_props_->rockComp(nc, cell_p, 0, &rock_comp_[0]);
         }
     }
 
@@ -552,9 +612,17 @@ namespace Opm
     void CompressibleTpfa::solveIncrement()
     {
         // Increment is equal to -J^{-1}F
-        linsolver_.solve(h_->J, h_->F, &pressure_increment_[0]);
-        std::transform(pressure_increment_.begin(), pressure_increment_.end(),
-                       pressure_increment_.begin(), std::negate<double>());
+        linsolver_.solve(h_->J, h_->F, &system_increment_[0]);
+
+        // Bring cell increments back to the grid's cell ordering.
+        const int nc = grid_.number_of_cells;
+        const int ndof = pressure_increment_.size();
+        for (int c = 0; c < nc; ++c) {
+            pressure_increment_[c] = -system_increment_[h_->cell_row[c]];
+        }
+        for (int dof = nc; dof < ndof; ++dof) {
+            pressure_increment_[dof] = -system_increment_[dof];
+        }
     }
 
 
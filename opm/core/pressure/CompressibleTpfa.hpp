@@ -21,6 +21,8 @@
 #define OPM_COMPRESSIBLETPFA_HEADER_INCLUDED
 
 
+#include <opm/core/pressure/tpfa/cell_ordering.h>
+
 #include <vector>
 
 struct UnstructuredGrid;
@@ -61,6 +63,10 @@ namespace Opm
         ///                                   and completions does not change during the
         ///                                   run. However, controls (only) are allowed
         ///                                   to change.
+        /// \param[in] ordering         Cell ordering of the Jacobian system. A
+        ///                             bandwidth-reducing ordering improves memory
+        ///                             locality on unstructured grids. Results are
+        ///                             always reported in the grid's cell ordering.
         CompressibleTpfa(const UnstructuredGrid& grid,
                          const BlackoilPropertiesInterface& props,
                          const RockCompressibility* rock_comp_props,
@@ -69,7 +75,8 @@ namespace Opm
                          const double change_tol,
                          const int maxiter,
                          const double* gravity,
-                         const Wells* wells);
+                         const Wells* wells,
+                         const tpfa_cell_ordering ordering = TPFA_NATURAL_ORDER);
 
         /// Destructor.
         virtual ~CompressibleTpfa();
@@ -89,6 +96,24 @@ namespace Opm
         /// are significant.)
         bool singularPressure() const;
 
+        /// Maximum stable time step for explicit transport of the
+        /// surface volumes with the fluxes of the current pressure
+        /// solution.  Refreshes the fluid data from the state, so it
+        /// must be called again after each call to explicitTransport().
+        /// \param[in] state       State after a call to solve().
+        /// \param[in] well_state  Well state after a call to solve().
+        /// \return Stable step in seconds, HUGE_VAL if there is no flow.
+        double stableTransportStep(const BlackoilState& state,
+                                   const WellState& well_state);
+
+        /// Advance the surface volumes of the state explicitly in time,
+        /// using the fluxes of the latest call to stableTransportStep().
+        /// Saturations are not updated.
+        /// \param[in]     dt     Time step, no larger than the stable step.
+        /// \param[in,out] state  State whose surfacevol() is updated.
+        void explicitTransport(const double dt,
+                               BlackoilState& state);
+
     private:
         virtual void computePerSolveDynamicData(const double dt,
                                                 const BlackoilState& state,
@@ -152,6 +177,8 @@ namespace Opm
         std::vector<double> rock_comp_; // Empty unless rock_comp_props_ is non-null.
         // The update to be applied to the pressures (cell and bhp).
         std::vector<double> pressure_increment_;
+        // Solution of the Jacobian system, in the system's row ordering.
+        std::vector<double> system_increment_;
         // True if the matrix assembled would be singular but for the
         // adjustment made in the cfs_*_assemble() calls. This happens
         // if everything is incompressible and there are no pressure
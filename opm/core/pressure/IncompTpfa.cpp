@@ -59,13 +59,15 @@ namespace Opm
     ///                                   to change.
     /// \param[in] src              Source terms. May be empty().
     /// \param[in] bcs              Boundary conditions, treat as all noflow if null.
+    /// \param[in] ordering         Cell ordering of the linear system.
     IncompTpfa::IncompTpfa(const UnstructuredGrid& grid,
                            const IncompPropertiesInterface& props,
                            LinearSolverInterface& linsolver,
                            const double* gravity,
                            const Wells* wells,
                            const std::vector<double>& src,
-                           const FlowBoundaryConditions* bcs)
+                           const FlowBoundaryConditions* bcs,
+                           const tpfa_cell_ordering ordering)
         : grid_(grid),
           props_(props),
           rock_comp_props_(NULL),
@@ -81,7 +83,7 @@ namespace Opm
           allcells_(grid.number_of_cells),
           trans_ (grid.number_of_faces)
     {
-        computeStaticData();
+        computeStaticData(ordering);
     }
 
 
@@ -106,6 +108,7 @@ namespace Opm
     ///                                   to change.
     /// \param[in] src              Source terms. May be empty().
     /// \param[in] bcs              Boundary conditions, treat as all noflow if null.
+    /// \param[in] ordering         Cell ordering of the linear system.
     IncompTpfa::IncompTpfa(const UnstructuredGrid& grid,
                            const IncompPropertiesInterface& props,
                            const RockCompressibility* rock_comp_props,
@@ -116,7 +119,8 @@ namespace Opm
                            const double* gravity,
                            const Wells* wells,
                            const std::vector<double>& src,
-                           const FlowBoundaryConditions* bcs)
+                           const FlowBoundaryConditions* bcs,
+                           const tpfa_cell_ordering ordering)
         : grid_(grid),
           props_(props),
           rock_comp_props_(rock_comp_props),
@@ -132,7 +136,7 @@ namespace Opm
           allcells_(grid.number_of_cells),
           trans_ (grid.number_of_faces)
     {
-        computeStaticData();
+        computeStaticData(ordering);
     }
 
 
@@ -240,7 +244,7 @@ namespace Opm
 
             // Update pressure vars with increment.
             for (int c = 0; c < nc; ++c) {
-                state.pressure()[c] += h_->x[c];
+                state.pressure()[c] += h_->x[h_->cell_row[c]];
             }
             for (int w = 0; w < nw; ++w) {
                 well_state.bhp()[w] += h_->x[nc + w];
@@ -285,7 +289,7 @@ namespace Opm
 
 
     /// Compute data that never changes (after construction).
-    void IncompTpfa::computeStaticData()
+    void IncompTpfa::computeStaticData(const tpfa_cell_ordering ordering)
     {
         if (wells_ && (wells_->number_of_phases != props_.numPhases())) {
             OPM_THROW(std::runtime_error, "Inconsistent number of phases specified (wells vs. props): "
@@ -306,13 +310,18 @@ namespace Opm
         // gpress_omegaweighted_ is sent to assembler always, and it dislikes
         // getting a zero pointer.
         gpress_omegaweighted_.resize(gg->cell_facepos[ gg->number_of_cells ], 0.0);
+        totmob_.resize(grid_.number_of_cells);
+        kr_.resize(grid_.number_of_cells * props_.numPhases());
+        if (gravity_) {
+            omega_.resize(grid_.number_of_cells);
+        }
         if (rock_comp_props_) {
             rock_comp_.resize(grid_.number_of_cells);
         }
         for (int c = 0; c < grid_.number_of_cells; ++c) {
             allcells_[c] = c;
         }
-        h_ = ifs_tpfa_construct(gg, const_cast<struct Wells*>(wells_));
+        h_ = ifs_tpfa_construct_ordered(gg, const_cast<struct Wells*>(wells_), ordering);
     }
 
 
@@ -328,6 +337,7 @@ namespace Opm
         // Computed here:
         //
         // std::vector<double> wdp_;
+        // std::vector<double> kr_;
         // std::vector<double> totmob_;
         // std::vector<double> omega_;
         // std::vector<double> trans_;
@@ -342,12 +352,15 @@ namespace Opm
         }
         // totmob_, omega_, gpress_omegaweighted_
         if (gravity_) {
-            computeTotalMobilityOmega(props_, allcells_, state.saturation(), totmob_, omega_);
+            computeTotalMobilityOmega(props_, grid_.number_of_cells, &allcells_[0],
+                                      &state.saturation()[0], &kr_[0],
+                                      &totmob_[0], &omega_[0]);
             mim_ip_density_update(grid_.number_of_cells, grid_.cell_facepos,
                                   &omega_[0],
                                   &gpress_[0], &gpress_omegaweighted_[0]);
         } else {
-            computeTotalMobility(props_, allcells_, state.saturation(), totmob_);
+            computeTotalMobility(props_, grid_.number_of_cells, &allcells_[0],
+                                 &state.saturation()[0], &kr_[0], &totmob_[0]);
         }
         // trans_
         tpfa_eff_trans_compute(const_cast<UnstructuredGrid*>(&grid_), &totmob_[0], &htrans_[0], &trans_[0]);
@@ -381,9 +394,7 @@ namespace Opm
 
         computePorevolume(grid_, props_.porosity(), *rock_comp_props_, state.pressure(), porevol_);
         if (rock_comp_props_ && rock_comp_props_->isActive()) {
-            for (int cell = 0; cell < grid_.number_of_cells; ++cell) {
-                rock_comp_[cell] = rock_comp_props_->rockComp(state.pressure()[cell]);
-            }
+            rock_comp_props_->rockComp(grid_.number_of_cells, &state.pressure()[0], 0, &rock_comp_[0]);
         }
         if (wells_) {
             std::copy(state.pressure().begin(), state.pressure().end(), pressures_.begin());
@@ -476,7 +487,9 @@ namespace Opm
         // Make sure h_->x contains the direct solution vector.
         assert(int(state.pressure().size()) == grid_.number_of_cells);
         assert(int(state.faceflux().size()) == grid_.number_of_faces);
-        std::copy(state.pressure().begin(), state.pressure().end(), h_->x);
+        for (int c = 0; c < grid_.number_of_cells; ++c) {
+            h_->x[h_->cell_row[c]] = state.pressure()[c];
+        }
         std::copy(well_state.bhp().begin(), well_state.bhp().end(), h_->x + grid_.number_of_cells);
 
         // Obtain solution.
@@ -62,13 +62,18 @@ namespace Opm
         ///                                   to change.
         /// \param[in] src              Source terms. May be empty().
         /// \param[in] bcs              Boundary conditions, treat as all noflow if null.
+        /// \param[in] ordering         Cell ordering of the linear system. A
+        ///                             bandwidth-reducing ordering improves memory
+        ///                             locality on unstructured grids. Results are
+        ///                             always reported in the grid's cell ordering.
 	IncompTpfa(const UnstructuredGrid& grid,
                    const IncompPropertiesInterface& props,
                    LinearSolverInterface& linsolver,
                    const double* gravity,
                    const Wells* wells,
 		   const std::vector<double>& src,
-		   const FlowBoundaryConditions* bcs);
+		   const FlowBoundaryConditions* bcs,
+                   const tpfa_cell_ordering ordering = TPFA_NATURAL_ORDER);
 
 	/// Construct solver, possibly with rock compressibility.
         /// \param[in] grid             A 2d or 3d grid.
@@ -89,6 +94,7 @@ namespace Opm
         ///                                   to change.
         /// \param[in] src              Source terms. May be empty().
         /// \param[in] bcs              Boundary conditions, treat as all noflow if null.
+        /// \param[in] ordering         Cell ordering of the linear system.
 	IncompTpfa(const UnstructuredGrid& grid,
                    const IncompPropertiesInterface& props,
                    const RockCompressibility* rock_comp_props,
@@ -99,7 +105,8 @@ namespace Opm
                    const double* gravity,
                    const Wells* wells,
 		   const std::vector<double>& src,
-		   const FlowBoundaryConditions* bcs);
+		   const FlowBoundaryConditions* bcs,
+                   const tpfa_cell_ordering ordering = TPFA_NATURAL_ORDER);
 
 	/// Destructor.
 	virtual ~IncompTpfa();
@@ -130,7 +137,7 @@ namespace Opm
                            WellState& well_state);
     private:
         // Helper functions.
-        void computeStaticData();
+        void computeStaticData(const tpfa_cell_ordering ordering);
         virtual void computePerSolveDynamicData(const double dt,
                                                 const SimulationDataContainer& state,
                                                 const WellState& well_state);
@@ -166,6 +173,7 @@ namespace Opm
         // ------ Data that will be modified for every solve. ------
 	std::vector<double> trans_ ;
         std::vector<double> wdp_;
+        std::vector<double> kr_;
         std::vector<double> totmob_;
         std::vector<double> omega_;
 	std::vector<double> gpress_omegaweighted_;
@@ -22,9 +22,127 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 #include <opm/core/linalg/blas_lapack.h>
 #include <opm/core/pressure/mimetic/mimetic.h>
 
+/* ------------------------------------------------------------------ */
+/* mim_ip_block_offsets() in freshly allocated storage.  NULL on      */
+/* allocation failure.                                                */
+/* ------------------------------------------------------------------ */
+static size_t *
+ip_offsets(int ncells, const int *pconn)
+/* ------------------------------------------------------------------ */
+{
+    size_t *bpos;
+
+    bpos = malloc((ncells + 1) * sizeof *bpos);
+
+    if (bpos != NULL) {
+        mim_ip_block_offsets(ncells, pconn, bpos);
+    }
+
+    return bpos;
+}
+
+
+/* ------------------------------------------------------------------ */
+/* Specialised mim_ip_simple() for hexahedral cells (nf = 6, d = 3).  */
+/*                                                                    */
+/* The orthogonal projection Q*Q' onto the range of M = diag(A)*C is  */
+/* formed as M*inv(M'*M)*M' with the 3-by-3 normal matrix inverted by */
+/* cofactor expansion.  All loops have compile-time trip counts and   */
+/* there are no LAPACK calls.  Returns zero, without touching Binv,   */
+/* if the normal matrix is numerically singular (degenerate cell).    */
+/* ------------------------------------------------------------------ */
+static int
+mim_ip_simple_hex(double v, const double *K, const double *C,
+                  const double *A, const double *N, double *Binv)
+/* ------------------------------------------------------------------ */
+{
+    enum { nf = 6, d = 3 };
+
+    int    i, j, k;
+    double M[nf * d], W[nf * d], NK[nf * d];
+    double G[d * d], Ginv[d * d];
+    double det, t, a1, a2, x;
+
+    for (j = 0; j < d; j++) {
+        for (i = 0; i < nf; i++) {
+            M[i + j*nf] = A[i] * C[i + j*nf];
+        }
+    }
+
+    /* G <- M'*M */
+    for (j = 0; j < d; j++) {
+        for (i = 0; i < d; i++) {
+            G[i + j*d] = 0.0;
+            for (k = 0; k < nf; k++) {
+                G[i + j*d] += M[k + i*nf] * M[k + j*nf];
+            }
+        }
+    }
+
+    Ginv[0] = G[4]*G[8] - G[7]*G[5];
+    Ginv[1] = G[7]*G[2] - G[1]*G[8];
+    Ginv[2] = G[1]*G[5] - G[4]*G[2];
+    Ginv[3] = G[6]*G[5] - G[3]*G[8];
+    Ginv[4] = G[0]*G[8] - G[6]*G[2];
+    Ginv[5] = G[3]*G[2] - G[0]*G[5];
+    Ginv[6] = G[3]*G[7] - G[6]*G[4];
+    Ginv[7] = G[6]*G[1] - G[0]*G[7];
+    Ginv[8] = G[0]*G[4] - G[3]*G[1];
+
+    det = G[0]*Ginv[0] + G[3]*Ginv[1] + G[6]*Ginv[2];
+
+    if (! (det > 1.0e-12 * G[0] * G[4] * G[8])) {
+        return 0;
+    }
+
+    for (i = 0; i < d * d; i++) {
+        Ginv[i] /= det;
+    }
+
+    /* W <- M*inv(G),  NK <- N*K */
+    for (j = 0; j < d; j++) {
+        for (i = 0; i < nf; i++) {
+            W [i + j*nf] = 0.0;
+            NK[i + j*nf] = 0.0;
+
+            for (k = 0; k < d; k++) {
+                W [i + j*nf] += M[i + k*nf] * Ginv[k + j*d];
+                NK[i + j*nf] += N[i + k*nf] * K   [k + j*d];
+            }
+        }
+    }
+
+    t = K[0] + K[4] + K[8];
+
+    a1 = 1.0     /      v ;
+    a2 = 6.0 * t / (d * v);
+
+    /* Binv <- (N*K*N' + t*A*(I - W*M')*A) / vol, cf. mim_ip_simple() */
+    for (j = 0; j < nf; j++) {
+        for (i = 0; i < nf; i++) {
+            x = (i == j) ? 1.0 : 0.0;
+            t = 0.0;
+
+            for (k = 0; k < d; k++) {
+                x -= W [i + k*nf] * M[j + k*nf];
+                t += NK[i + k*nf] * N[j + k*nf];
+            }
+
+            Binv[i + j*nf] = a1*t + a2*(A[i] * A[j] * x);
+        }
+    }
+
+    return 1;
+}
+
+
 /* ------------------------------------------------------------------ */
 void
 mim_ip_simple_all(int ncells, int d, int max_nconn,
@@ -34,48 +152,70 @@ mim_ip_simple_all(int ncells, int d, int max_nconn,
                   double *perm, double *Binv)
 /* ------------------------------------------------------------------ */
 {
-    int i, j, c, f, nconn, fpos2, lwork;
+    int i, j, c, f, nconn, lwork, nthreads;
+
+    size_t wsz, *bpos;
 
-    double *C, *N, *A, *work, s;
+    double *wspace, *C, *N, *A, *work, s;
 
     double cc[3] = { 0.0 };     /* No more than 3 space dimensions */
 
+#if defined(_OPENMP)
+    nthreads = omp_get_max_threads();
+#else
+    nthreads = 1;
+#endif
+
+    /* Workspace [C, N, A, work] for each thread. */
     lwork = 64 * (max_nconn * d);                 /* 64 from ILAENV() */
-    C     = malloc((max_nconn * d) * sizeof *C);
-    N     = malloc((max_nconn * d) * sizeof *N);
-    A     = malloc(max_nconn       * sizeof *A);
-    work  = malloc(lwork           * sizeof *work);
+    wsz   = 2 * (max_nconn * d) + max_nconn + lwork;
+
+    bpos   = ip_offsets(ncells, pconn);
+    wspace = malloc(nthreads * wsz * sizeof *wspace);
+
+    if ((bpos != NULL) && (wspace != NULL)) {
+#pragma omp parallel private(i, j, c, f, nconn, C, N, A, work, s, cc)
+        {
+#if defined(_OPENMP)
+            C = wspace + (omp_get_thread_num() * wsz);
+#else
+            C = wspace;
+#endif
+            N    = C + (max_nconn * d);
+            A    = N + (max_nconn * d);
+            work = A + max_nconn;
 
-    if ((C != NULL) && (N != NULL) && (A != NULL) && (work != NULL)) {
-        fpos2 = 0;
+#pragma omp for schedule(static)
+            for (c = 0; c < ncells; c++) {
+                for (j = 0; j < d; j++) {
+                    cc[j] = ccentroid[j + c*d];
+                }
 
-        for (c = 0; c < ncells; c++) {
-            for (j = 0; j < d; j++) {
-                cc[j] = ccentroid[j + c*d];
-            }
+                nconn = pconn[c + 1] - pconn[c];
 
-            nconn = pconn[c + 1] - pconn[c];
+                for (i = 0; i < nconn; i++) {
+                    f = conn[pconn[c] + i];
+                    s = 2.0*(fneighbour[2 * f] == c) - 1.0;
 
-            for (i = 0; i < nconn; i++) {
-                f = conn[pconn[c] + i];
-                s = 2.0*(fneighbour[2 * f] == c) - 1.0;
+                    A[i] = farea[f];
 
-                A[i] = farea[f];
+                    for (j = 0; j < d; j++) {
+                        C[i + j*nconn] = fcentroid  [j + f*d] - cc[j];
+                        N[i + j*nconn] = s * fnormal[j + f*d];
+                    }
+                }
 
-                for (j = 0; j < d; j++) {
-                    C[i + j*nconn] = fcentroid  [j + f*d] - cc[j];
-                    N[i + j*nconn] = s * fnormal[j + f*d];
+                if ((d != 3) || (nconn != 6) ||
+                    ! mim_ip_simple_hex(cvol[c], &perm[c * d * d],
+                                        C, A, N, &Binv[bpos[c]])) {
+                    mim_ip_simple(nconn, nconn, d, cvol[c], &perm[c * d * d],
+                                  C, A, N, &Binv[bpos[c]], work, lwork);
                 }
             }
-
-            mim_ip_simple(nconn, nconn, d, cvol[c], &perm[c * d * d],
-                          C, A, N, &Binv[fpos2], work, lwork);
-
-            fpos2 += nconn * nconn;
         }
     }
 
-    free(work);  free(A);  free(N);  free(C);
+    free(wspace);  free(bpos);
 }
 
 
@@ -200,10 +340,11 @@ mim_ip_compute_gpress(int nc, int d, const double *grav,
 
     const double *cc, *fc;
 
-    for (c = i = 0; c < nc; c++) {
+#pragma omp parallel for private(i, j, cc, fc)
+    for (c = 0; c < nc; c++) {
         cc = ccentroid + (c * d);
 
-        for (; i < pconn[c + 1]; i++) {
+        for (i = pconn[c]; i < pconn[c + 1]; i++) {
             fc = fcentroid + (conn[i] * d);
 
             gpress[i] = 0.0;
@@ -215,6 +356,25 @@ mim_ip_compute_gpress(int nc, int d, const double *grav,
 }
 
 
+/* bpos[c] = \sum_{k<c} n_k^2 */
+/* ---------------------------------------------------------------------- */
+void
+mim_ip_block_offsets(int nc, const int *pconn, size_t *bpos)
+/* ---------------------------------------------------------------------- */
+{
+    int    c;
+    size_t n;
+
+    bpos[0] = 0;
+
+    for (c = 0; c < nc; c++) {
+        n = pconn[c + 1] - pconn[c];
+
+        bpos[c + 1] = bpos[c] + n * n;
+    }
+}
+
+
 /* inv(B) <- \lambda_t(s)*inv(B)_0 */
 /* ---------------------------------------------------------------------- */
 void
@@ -236,6 +396,26 @@ mim_ip_mobility_update(int nc, const int *pconn, const double *totmob,
 }
 
 
+/* inv(B) <- \lambda_t(s)*inv(B)_0, cells in parallel */
+/* ---------------------------------------------------------------------- */
+void
+mim_ip_mobility_update_offsets(int nc, const size_t *bpos,
+                               const double *totmob,
+                               const double *Binv0, double *Binv)
+/* ---------------------------------------------------------------------- */
+{
+    int    c;
+    size_t p2;
+
+#pragma omp parallel for private(p2) schedule(static)
+    for (c = 0; c < nc; c++) {
+        for (p2 = bpos[c]; p2 < bpos[c + 1]; p2++) {
+            Binv[p2] = totmob[c] * Binv0[p2];
+        }
+    }
+}
+
+
 /* G <- \sum_i \rho_i f_i(s) * G_0 */
 /* ---------------------------------------------------------------------- */
 void
@@ -245,8 +425,9 @@ mim_ip_density_update(int nc, const int *pconn, const double *omega,
 {
     int c, i;
 
-    for (c = i = 0; c < nc; c++) {
-        for (; i < pconn[c + 1]; i++) {
+#pragma omp parallel for private(i)
+    for (c = 0; c < nc; c++) {
+        for (i = pconn[c]; i < pconn[c + 1]; i++) {
             gpress[i] = omega[c] * gpress0[i];
         }
     }
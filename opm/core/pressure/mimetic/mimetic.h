@@ -25,6 +25,8 @@
  * Routines to assist mimetic discretisations of the flow equation.
  */
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -154,7 +156,10 @@ mim_ip_simple(int nf, int nconn, int d,
  * Compute the mimetic inner products given a grid and cell-wise
  * permeability tensors.
  *
- * This function applies mim_ip_simple() to all specified cells.
+ * This function applies mim_ip_simple() to all specified cells.  Cells
+ * are processed in parallel if OpenMP is enabled, and hexahedral cells
+ * (six faces in three space dimensions) use a specialised kernel that
+ * avoids LAPACK calls.
  *
  * @param[in]  ncells       Number of cells.
  * @param[in]  d            Number of physical dimensions.
@@ -240,6 +245,41 @@ mim_ip_mobility_update(int nc, const int *pconn, const double *totmob,
                        const double *Binv0, double *Binv);
 
 
+/**
+ * Compute the start of each cell's block in an array of (inverse)
+ * inner products, i.e.,
+ * \f$\mathit{bpos}_c = \sum_{k<c} n_k^2\f$ with \f$n_k\f$ the
+ * number of connections of cell \f$k\f$.  The offsets depend on the
+ * grid topology only, and may be reused for all calls to
+ * mim_ip_mobility_update_offsets().
+ *
+ * @param[in]  nc    Number of cells.
+ * @param[in]  pconn Start pointers of cell-to-face topology
+ *                   mapping.
+ * @param[out] bpos  Block offsets.  Array of size <CODE>nc + 1</CODE>.
+ */
+void
+mim_ip_block_offsets(int nc, const int *pconn, size_t *bpos);
+
+
+/**
+ * Same as mim_ip_mobility_update(), but with the block offsets
+ * precomputed by mim_ip_block_offsets().  Cells are processed in
+ * parallel, and no work space is allocated.
+ *
+ * @param[in]  nc     Number of cells.
+ * @param[in]  bpos   Block offsets from mim_ip_block_offsets().
+ * @param[in]  totmob Total mobility for all cells.  Array of size @c nc.
+ * @param[in]  Binv0  Inverse inner product results for all cells.
+ * @param[out] Binv   Inverse inner product results incorporating
+ *                    effects of multiple fluid phases.
+ */
+void
+mim_ip_mobility_update_offsets(int nc, const size_t *bpos,
+                               const double *totmob,
+                               const double *Binv0, double *Binv);
+
+
 /**
  * Incorporate effects of multiple fluid phases into existing, local,
  * static mimetic discretisations of gravity pressure.
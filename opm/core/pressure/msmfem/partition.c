@@ -19,6 +19,7 @@
 
 #include "config.h"
 #include <assert.h>
+#include <math.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -362,6 +363,8 @@ partition_create_c2c(int nc, int nneigh, const int *neigh,
                 }
             }
 
+            (*pc2c)[0] = 0;
+
             ret = nc;
         } else {
             free(*pc2c);
@@ -382,10 +385,10 @@ partition_create_c2c(int nc, int nneigh, const int *neigh,
 /* Release dfs() memory resources. */
 /* ---------------------------------------------------------------------- */
 static void
-deallocate_dfs_arrays(int *ia, int *ja, int *colour, int *work)
+deallocate_dfs_arrays(int *ia, int *ja, int *work)
 /* ---------------------------------------------------------------------- */
 {
-    free(work);  free(colour);  free(ja);  free(ia);
+    free(work);  free(ja);  free(ia);
 }
 
 
@@ -396,23 +399,20 @@ deallocate_dfs_arrays(int *ia, int *ja, int *colour, int *work)
 /* ---------------------------------------------------------------------- */
 static int
 allocate_dfs_arrays(int n, int nnz,
-                    int **ia, int **ja, int **colour, int **work)
+                    int **ia, int **ja, int **work)
 /* ---------------------------------------------------------------------- */
 {
     int ret;
 
     *ia     = malloc((n + 1) * sizeof **ia    );
     *ja     = malloc(nnz     * sizeof **ja    );
-    *colour = malloc(n       * sizeof **colour);
     *work   = malloc(2 * n   * sizeof **work  );
 
-    if ((*ia     == NULL) || (*ja   == NULL) ||
-        (*colour == NULL) || (*work == NULL)) {
-        deallocate_dfs_arrays(*ia, *ja, *colour, *work);
+    if ((*ia == NULL) || (*ja == NULL) || (*work == NULL)) {
+        deallocate_dfs_arrays(*ia, *ja, *work);
 
         *ia     = NULL;
         *ja     = NULL;
-        *colour = NULL;
         *work   = NULL;
 
         ret = 0;
@@ -515,6 +515,11 @@ create_block_conns(int        b   ,
  * i=0:nneigh-1.  Negative entries in 'neigh' represent invalid cells
  * (outside domain).
  *
+ * Blocks are labelled concurrently (OpenMP), each thread using its own
+ * dfs() work arrays.  New block numbers are assigned in order of
+ * increasing original block number, independently of the number of
+ * threads.
+ *
  * Returns number of new blocks (0 if all blocks internally connected)
  * if successful and -1 otherwise. */
 /* ---------------------------------------------------------------------- */
@@ -523,57 +528,79 @@ partition_split_disconnected(int nc, int nneigh, const int *neigh, int *p)
 /* ---------------------------------------------------------------------- */
 {
     int inv_ok, c2c_ok, dfs_ok;
-    int i, b, ret, maxblk, ncolour, max_blk_cells, max_blk_conn;
+    int i, b, ret, maxblk, max_blk_cells, max_blk_conn;
 
-    int *pb2c, *b2c, *loc, *pc2c, *c2c;
-    int *ia, *ja, *colour, *work;
+    int *pb2c, *b2c, *loc, *pc2c, *c2c, *colour, *ncolour;
+    int *ia, *ja, *work;
 
     maxblk = max_block(nc, p);
 
-    inv_ok = partition_allocate_inverse(nc, maxblk, &pb2c, &b2c);
-    c2c_ok = partition_create_c2c(nc, nneigh, neigh, &pc2c, &c2c);
-    loc    = malloc(nc * sizeof *loc);
+    inv_ok  = partition_allocate_inverse(nc, maxblk, &pb2c, &b2c);
+    c2c_ok  = partition_create_c2c(nc, nneigh, neigh, &pc2c, &c2c);
+    loc     = malloc(nc           * sizeof *loc    );
+    colour  = malloc(nc           * sizeof *colour );
+    ncolour = malloc((maxblk + 1) * sizeof *ncolour);
 
-    if (inv_ok && c2c_ok && (loc != NULL)) {
+    if (inv_ok && c2c_ok &&
+        (loc != NULL) && (colour != NULL) && (ncolour != NULL)) {
         partition_invert(nc, p, pb2c, b2c);
         partition_localidx(maxblk + 1, pb2c, b2c, loc);
 
         count_block_conns(maxblk + 1, pb2c, b2c, pc2c,
                           &max_blk_cells, &max_blk_conn);
 
-        dfs_ok = allocate_dfs_arrays(max_blk_cells, max_blk_conn,
-                                     &ia, &ja, &colour, &work);
-        if (dfs_ok) {
-            /* Target acquired.  Fire. */
-            ret = 0;
+        dfs_ok = 1;
+
+#pragma omp parallel private(b, ia, ja, work)
+        {
+            /* Component labels of block 'b' are stored in
+             * colour[pb2c[b] : pb2c[b+1]-1], i.e., in b2c order. */
+            if (! allocate_dfs_arrays(max_blk_cells, max_blk_conn,
+                                      &ia, &ja, &work)) {
+#pragma omp atomic write
+                dfs_ok = 0;
+            }
 
+#pragma omp for schedule(dynamic, 64)
             for (b = 0; b < maxblk + 1; b++) {
-                create_block_conns(b, p, loc, pb2c, b2c, pc2c, c2c, ia, ja);
+                if (ia != NULL) {
+                    create_block_conns(b, p, loc, pb2c, b2c,
+                                       pc2c, c2c, ia, ja);
 
-                dfs(pb2c[b + 1] - pb2c[b], ia, ja, &ncolour, colour, work);
+                    dfs(pb2c[b + 1] - pb2c[b], ia, ja,
+                        &ncolour[b], colour + pb2c[b], work);
+                }
+            }
+
+            deallocate_dfs_arrays(ia, ja, work);
+        }
 
-                if (ncolour > 1) {
-                    /* Block contains more than one component.  Assign
-                     * new block numbers for cells in components
-                     * 1:ncomp-1. */
+        if (dfs_ok) {
+            /* Target acquired.  Fire.  Block 'b' contains ncolour[b]
+             * components.  Assign new block numbers for cells in
+             * components 1:ncolour[b]-1. */
+            ret = 0;
+
+            for (b = 0; b < maxblk + 1; b++) {
+                if (ncolour[b] > 1) {
                     for (i = pb2c[b]; i < pb2c[b + 1]; i++) {
-                        if (colour[i - pb2c[b]] > 0) {
-                            p[b2c[i]] = maxblk + ret + colour[i - pb2c[b]];
+                        if (colour[i] > 0) {
+                            p[b2c[i]] = maxblk + ret + colour[i];
                         }
                     }
 
-                    ret += ncolour - 1;
+                    ret += ncolour[b] - 1;
                 }
             }
         } else {
             ret = -1;
         }
-
-        deallocate_dfs_arrays(ia, ja, colour, work);
     } else {
         ret = -1;
     }
 
+    free(ncolour);
+    free(colour);
     free(loc);
     partition_destroy_c2c(pc2c, c2c);
     partition_deallocate_inverse(pb2c, b2c);
@@ -581,6 +608,304 @@ partition_split_disconnected(int nc, int nneigh, const int *neigh, int *p)
     return ret;
 }
 
+
+/* ---------------------------------------------------------------------- */
+/* Union-find support for partition_agglomerate().                       */
+/* ---------------------------------------------------------------------- */
+static int
+uf_find(int *parent, int c)
+/* ---------------------------------------------------------------------- */
+{
+    while (parent[c] != c) {
+        parent[c] = parent[parent[c]]; /* Path halving */
+        c         = parent[c];
+    }
+
+    return c;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static void
+uf_union(int *parent, int *size, int r1, int r2)
+/* ---------------------------------------------------------------------- */
+{
+    if (size[r1] < size[r2]) {
+        parent[r1]  = r2;
+        size  [r2] += size[r1];
+    } else {
+        parent[r2]  = r1;
+        size  [r1] += size[r2];
+    }
+}
+
+
+/* Order connections with positive weight by decreasing weight.  The
+ * weights are binned on a logarithmic scale (counting sort), so the
+ * ordering is approximate within a factor of (wmax/wmin)^(1/NBIN).
+ * Connections to cells outside the domain are excluded.
+ *
+ * Returns number of connections in 'order' (array of size 'nneigh'). */
+/* ---------------------------------------------------------------------- */
+static int
+sort_conn_by_weight(int nneigh, const int *neigh, const double *w,
+                    int *key, int *order)
+/* ---------------------------------------------------------------------- */
+{
+    enum { NBIN = 1024 };
+
+    int    i, k, n, pos[NBIN + 1];
+    double wmin, wmax, lmin, scale;
+
+    wmin = HUGE_VAL;
+    wmax = 0.0;
+
+    for (i = 0; i < nneigh; i++) {
+        if ((neigh[2*i + 0] >= 0) && (neigh[2*i + 1] >= 0) && (w[i] > 0.0)) {
+            if (w[i] < wmin) { wmin = w[i]; }
+            if (w[i] > wmax) { wmax = w[i]; }
+        }
+    }
+
+    lmin  = (wmax > 0.0) ? log(wmin) : 0.0;
+    scale = (wmax > wmin) ? (NBIN - 1) / (log(wmax) - lmin) : 0.0;
+
+#pragma omp parallel for
+    for (i = 0; i < nneigh; i++) {
+        key[i] = -1;
+
+        if ((neigh[2*i + 0] >= 0) && (neigh[2*i + 1] >= 0) && (w[i] > 0.0)) {
+            /* Largest weight in bin 0 */
+            key[i] = (NBIN - 1) - (int) (scale * (log(w[i]) - lmin));
+        }
+    }
+
+    for (k = 0; k < NBIN + 1; k++) { pos[k] = 0; }
+
+    for (i = 0; i < nneigh; i++) {
+        if (key[i] >= 0) { pos[ key[i] + 1 ] += 1; }
+    }
+
+    for (k = 1; k <= NBIN; k++) { pos[k] += pos[k - 1]; }
+
+    n = pos[NBIN];
+
+    for (i = 0; i < nneigh; i++) {
+        if (key[i] >= 0) { order[ pos[ key[i] ] ++ ] = i; }
+    }
+
+    return n;
+}
+
+
+/* Agglomerate 'nc' cells into connected blocks by greedily merging
+ * across connections in order of decreasing weight 'w' (e.g.,
+ * transmissibilities, one non-negative value per neighbourship).  A
+ * merge is accepted if the resulting block contains at most
+ * 'max_size' cells.  Blocks containing fewer than 'min_size' cells are
+ * subsequently merged into their most strongly connected neighbouring
+ * block if the result contains at most 'max_size + min_size' cells.
+ *
+ * Neighbourship 'neigh' is defined as in partition_split_disconnected().
+ * Connections with non-positive weight are ignored.  If 'w' is NULL,
+ * all connections are given unit weight.
+ *
+ * Store partition in vector 'p' (assumed to hold at least 'nc' slots).
+ * Block numbers are contiguous, starting at zero.  All blocks are
+ * connected.
+ *
+ * Returns number of blocks if successful and -1 if unable to allocate
+ * work arrays. */
+/* ---------------------------------------------------------------------- */
+int
+partition_agglomerate(int nc, int nneigh, const int *neigh,
+                      const double *w, int min_size, int max_size,
+                      int *p)
+/* ---------------------------------------------------------------------- */
+{
+    int     i, j, n, r1, r2, pass, lim, ret;
+    int    *parent, *size, *key, *order;
+    double *unit;
+
+    unit   = NULL;
+    parent = malloc(nc     * sizeof *parent);
+    size   = malloc(nc     * sizeof *size  );
+    key    = malloc(nneigh * sizeof *key   );
+    order  = malloc(nneigh * sizeof *order );
+
+    if ((w == NULL) && (nneigh > 0)) {
+        unit = malloc(nneigh * sizeof *unit);
+
+        if (unit != NULL) {
+            for (i = 0; i < nneigh; i++) { unit[i] = 1.0; }
+        }
+
+        w = unit;
+    }
+
+    if ((parent != NULL) && (size  != NULL) &&
+        (((key  != NULL) && (order != NULL) && (w != NULL)) ||
+         (nneigh == 0))) {
+
+        for (i = 0; i < nc; i++) {
+            parent[i] = i;
+            size  [i] = 1;
+        }
+
+        n = (nneigh > 0) ? sort_conn_by_weight(nneigh, neigh, w, key, order)
+            : 0;
+
+        for (pass = 0; pass < 2; pass++) {
+            lim = (pass == 0) ? max_size : max_size + min_size;
+
+            for (j = 0; j < n; j++) {
+                i  = order[j];
+                r1 = uf_find(parent, neigh[2*i + 0]);
+                r2 = uf_find(parent, neigh[2*i + 1]);
+
+                if ((r1 != r2) && (size[r1] + size[r2] <= lim) &&
+                    ((pass == 0) ||
+                     (size[r1] < min_size) || (size[r2] < min_size))) {
+                    uf_union(parent, size, r1, r2);
+                }
+            }
+        }
+
+        for (i = 0; i < nc; i++) {
+            p[i] = uf_find(parent, i);
+        }
+
+        ret = 0;
+
+        if (nc > 0) {
+            /* Maximum block number, or -1 on allocation failure */
+            ret = partition_compress(nc, p);
+
+            if (ret >= 0) {
+                ret += 1;
+            }
+        }
+    } else {
+        ret = -1;
+    }
+
+    free(unit);  free(order);  free(key);  free(size);  free(parent);
+
+    return ret;
+}
+
+
+/* Compute quality metrics of partition 'p' of 'nc' cells.
+ * Neighbourship 'neigh' is defined as in partition_split_disconnected().
+ * Weights 'w' (one per neighbourship) may be NULL, in which case all
+ * connections are given unit weight.
+ *
+ * Returns 1 if successful and 0 if unable to allocate work arrays. */
+/* ---------------------------------------------------------------------- */
+int
+partition_quality_compute(int nc, const int *p,
+                          int nneigh, const int *neigh, const double *w,
+                          struct partition_quality *q)
+/* ---------------------------------------------------------------------- */
+{
+    int     i, b, b1, b2, nblk, ncut, ok;
+    int    *cnt, *ptr, *adj;
+    double  wi, wtot, wcut, ssq;
+
+    nblk = max_block(nc, p) + 1;
+
+    cnt = malloc(nblk       * sizeof *cnt);
+    ptr = malloc((nblk + 1) * sizeof *ptr);
+    adj = malloc(MAX(nneigh, 1) * sizeof *adj);
+
+    ok = (cnt != NULL) && (ptr != NULL) && (adj != NULL);
+
+    if (ok) {
+        /* Block sizes */
+        for (b = 0; b < nblk; b++) { cnt[b] = 0; }
+        for (i = 0; i < nc  ; i++) { cnt[p[i]] += 1; }
+
+        q->nblocks    = 0;
+        q->min_cells  = nc;
+        q->max_cells  = 0;
+
+        for (b = 0; b < nblk; b++) {
+            if (cnt[b] > 0) {
+                q->nblocks  += 1;
+                q->min_cells = (cnt[b] < q->min_cells) ? cnt[b] : q->min_cells;
+                q->max_cells = MAX(q->max_cells, cnt[b]);
+            }
+        }
+
+        q->mean_cells = (q->nblocks > 0) ? ((double) nc) / q->nblocks : 0.0;
+
+        ssq = 0.0;
+        for (b = 0; b < nblk; b++) {
+            if (cnt[b] > 0) {
+                ssq += (cnt[b] - q->mean_cells) * (cnt[b] - q->mean_cells);
+            }
+        }
+
+        q->stddev_cells = (q->nblocks > 0) ? sqrt(ssq / q->nblocks) : 0.0;
+
+        /* Cut connections, bucketed by smaller block number */
+        for (b = 0; b < nblk + 1; b++) { ptr[b] = 0; }
+
+        ncut = 0;
+        wtot = wcut = 0.0;
+
+        for (i = 0; i < nneigh; i++) {
+            if ((neigh[2*i + 0] >= 0) && (neigh[2*i + 1] >= 0)) {
+                b1 = p[neigh[2*i + 0]];
+                b2 = p[neigh[2*i + 1]];
+                wi = (w != NULL) ? w[i] : 1.0;
+
+                wtot += wi;
+
+                if (b1 != b2) {
+                    ptr[ ((b1 < b2) ? b1 : b2) + 1 ] += 1;
+
+                    ncut += 1;
+                    wcut += wi;
+                }
+            }
+        }
+
+        for (b = 1; b <= nblk; b++) { ptr[b] += ptr[b - 1]; }
+
+        for (i = 0; i < nneigh; i++) {
+            if ((neigh[2*i + 0] >= 0) && (neigh[2*i + 1] >= 0)) {
+                b1 = p[neigh[2*i + 0]];
+                b2 = p[neigh[2*i + 1]];
+
+                if (b1 < b2) { adj[ ptr[b1] ++ ] = b2; }
+                if (b2 < b1) { adj[ ptr[b2] ++ ] = b1; }
+            }
+        }
+
+        /* Count distinct neighbouring blocks.  Reuse 'cnt' as marker. */
+        for (b = 0; b < nblk; b++) { cnt[b] = -1; }
+
+        q->ncut          = ncut;
+        q->ncoarse_faces = 0;
+
+        for (b = 0, i = 0; b < nblk; b++) {
+            for (; i < ptr[b]; i++) {
+                if (cnt[ adj[i] ] != b) {
+                    cnt[ adj[i] ]     = b;
+                    q->ncoarse_faces += 1;
+                }
+            }
+        }
+
+        q->cut_weight = (wtot > 0.0) ? wcut / wtot : 0.0;
+    }
+
+    free(adj);  free(ptr);  free(cnt);
+
+    return ok;
+}
+
 /* Local Variables:    */
 /* c-basic-offset:4    */
 /* End:                */
@@ -24,6 +24,18 @@
 extern "C" {
 #endif
 
+/* Quality metrics of a partition, see partition_quality_compute(). */
+struct partition_quality {
+    int    nblocks;       /* Number of non-empty blocks */
+    int    min_cells;     /* Number of cells in smallest block */
+    int    max_cells;     /* Number of cells in largest block */
+    double mean_cells;    /* Mean number of cells per block */
+    double stddev_cells;  /* Standard deviation of block sizes */
+    int    ncut;          /* Fine-scale connections between blocks */
+    int    ncoarse_faces; /* Distinct pairs of connected blocks */
+    double cut_weight;    /* Fraction of connection weight that is cut */
+};
+
 int
 partition_unif_idx(int ndims, int nc,
                    const int *fine_d,
@@ -55,6 +67,16 @@ int
 partition_split_disconnected(int nc, int nneigh, const int *neigh,
                              int *p);
 
+int
+partition_agglomerate(int nc, int nneigh, const int *neigh,
+                      const double *w, int min_size, int max_size,
+                      int *p);
+
+int
+partition_quality_compute(int nc, const int *p,
+                          int nneigh, const int *neigh, const double *w,
+                          struct partition_quality *q);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,219 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#include <opm/core/grid.h>
+#include <opm/core/pressure/tpfa/cell_ordering.h>
+
+
+/* ---------------------------------------------------------------------- */
+static void
+natural_ordering(int nc, int *cell_row)
+/* ---------------------------------------------------------------------- */
+{
+    int c;
+
+    for (c = 0; c < nc; c++) {
+        cell_row[c] = c;
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+static int
+neighbour(const struct UnstructuredGrid *G, int c, int i)
+/* ---------------------------------------------------------------------- */
+{
+    int f, c1;
+
+    f  = G->cell_faces[i];
+    c1 = G->face_cells[2*f + 0];
+
+    return (c1 == c) ? G->face_cells[2*f + 1] : c1;
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* Number of interior connections of each cell and list of all cells     */
+/* sorted by increasing number of connections (counting sort).           */
+/* ---------------------------------------------------------------------- */
+static int
+sort_by_degree(const struct UnstructuredGrid *G, int *deg, int *sorted)
+/* ---------------------------------------------------------------------- */
+{
+    int  c, i, maxdeg, ok;
+    int *pos;
+
+    maxdeg = 0;
+    for (c = 0; c < G->number_of_cells; c++) {
+        deg[c] = 0;
+
+        for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
+            deg[c] += neighbour(G, c, i) >= 0;
+        }
+
+        if (deg[c] > maxdeg) { maxdeg = deg[c]; }
+    }
+
+    pos = calloc(maxdeg + 2, sizeof *pos);
+    ok  = pos != NULL;
+
+    if (ok) {
+        for (c = 0; c < G->number_of_cells; c++) {
+            pos[ deg[c] + 1 ] += 1;
+        }
+
+        for (i = 1; i <= maxdeg + 1; i++) {
+            pos[i] += pos[i - 1];
+        }
+
+        for (c = 0; c < G->number_of_cells; c++) {
+            sorted[ pos[ deg[c] ] ++ ] = c;
+        }
+    }
+
+    free(pos);
+
+    return ok;
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* Sort queue[first .. last-1] by increasing degree (insertion sort).     */
+/* Segments are short, bounded by the number of faces of a single cell.   */
+/* ---------------------------------------------------------------------- */
+static void
+sort_segment(const int *deg, int first, int last, int *queue)
+/* ---------------------------------------------------------------------- */
+{
+    int i, j, c;
+
+    for (i = first + 1; i < last; i++) {
+        c = queue[i];
+
+        for (j = i; (j > first) && (deg[ queue[j - 1] ] > deg[c]); j--) {
+            queue[j] = queue[j - 1];
+        }
+
+        queue[j] = c;
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* Reverse Cuthill-McKee.  Every connected component is traversed in     */
+/* breadth-first order starting from its cell of minimum degree, and      */
+/* neighbours are visited in order of increasing degree.                  */
+/* ---------------------------------------------------------------------- */
+static int
+rcm_ordering(const struct UnstructuredGrid *G, int *cell_row)
+/* ---------------------------------------------------------------------- */
+{
+    int  nc, s, c, n, i, head, tail, first, ok;
+    int *iwork, *deg, *queue, *seed;
+
+    nc    = G->number_of_cells;
+    iwork = malloc(3 * ((size_t) nc) * sizeof *iwork);
+
+    ok = iwork != NULL;
+
+    if (ok) {
+        deg   = iwork;
+        queue = deg   + nc;
+        seed  = queue + nc;
+
+        ok = sort_by_degree(G, deg, seed);
+    }
+
+    if (ok) {
+        for (c = 0; c < nc; c++) { cell_row[c] = -1; }
+
+        head = tail = 0;
+        for (s = 0; s < nc; s++) {
+            if (cell_row[ seed[s] ] >= 0) { continue; }
+
+            cell_row[ seed[s] ] = 0;
+            queue[ tail++ ]     = seed[s];
+
+            while (head < tail) {
+                c     = queue[ head++ ];
+                first = tail;
+
+                for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
+                    n = neighbour(G, c, i);
+
+                    if ((n >= 0) && (cell_row[n] < 0)) {
+                        cell_row[n]     = 0;
+                        queue[ tail++ ] = n;
+                    }
+                }
+
+                sort_segment(deg, first, tail, queue);
+            }
+        }
+
+        assert (tail == nc);
+
+        /* Reverse Cuthill-McKee sequence */
+        for (i = 0; i < nc; i++) {
+            cell_row[ queue[i] ] = nc - 1 - i;
+        }
+    }
+
+    free(iwork);
+
+    return ok;
+}
+
+
+/* ======================================================================
+ * Public interface below separator.
+ * ====================================================================== */
+
+/* ---------------------------------------------------------------------- */
+int
+cell_ordering_compute(const struct UnstructuredGrid *G       ,
+                      enum tpfa_cell_ordering        ordering,
+                      int                           *cell_row)
+/* ---------------------------------------------------------------------- */
+{
+    int ok;
+
+    ok = 1;
+
+    switch (ordering) {
+    case TPFA_RCM_ORDER:
+        ok = rcm_ordering(G, cell_row);
+        break;
+
+    case TPFA_NATURAL_ORDER:
+    default:
+        natural_ordering(G->number_of_cells, cell_row);
+        break;
+    }
+
+    if (! ok) {
+        natural_ordering(G->number_of_cells, cell_row);
+    }
+
+    return ok;
+}
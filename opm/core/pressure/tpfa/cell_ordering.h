@@ -0,0 +1,67 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_CELL_ORDERING_HEADER_INCLUDED
+#define OPM_CELL_ORDERING_HEADER_INCLUDED
+
+/**
+ * \file
+ * Cell renumbering schemes that reduce the bandwidth of the two-point
+ * connectivity matrix.  Used by the TPFA assemblers to lay out the rows of
+ * the linear system such that assembly and matrix-vector products access
+ * memory in a mostly linear fashion.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct UnstructuredGrid;
+
+/**
+ * Cell orderings supported by the TPFA assemblers.
+ */
+enum tpfa_cell_ordering {
+    TPFA_NATURAL_ORDER = 0,     /**< Rows follow grid's cell numbering */
+    TPFA_RCM_ORDER     = 1      /**< Reverse Cuthill-McKee ordering */
+};
+
+
+/**
+ * Assign linear system row to each grid cell.
+ *
+ * @param[in]  G        Grid.
+ * @param[in]  ordering Requested cell ordering.
+ * @param[out] cell_row Row index of each cell.  Array of size
+ *                      <CODE>G->number_of_cells</CODE>.  On successful
+ *                      return, a permutation of <CODE>0, ...,
+ *                      G->number_of_cells - 1</CODE>.
+ * @return One (1) if successful and zero (0) in case of allocation failure
+ * in which case the natural ordering is assigned to @c cell_row.
+ */
+int
+cell_ordering_compute(const struct UnstructuredGrid *G       ,
+                      enum tpfa_cell_ordering        ordering,
+                      int                           *cell_row);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* OPM_CELL_ORDERING_HEADER_INCLUDED */
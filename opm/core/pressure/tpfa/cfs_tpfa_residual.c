@@ -11,6 +11,7 @@
 #include <opm/core/linalg/blas_lapack.h>
 #include <opm/core/linalg/sparse_sys.h>
 
+#include <opm/core/pressure/tpfa/cell_ordering.h>
 #include <opm/core/pressure/tpfa/compr_quant_general.h>
 #include <opm/core/pressure/tpfa/compr_source.h>
 #include <opm/core/pressure/tpfa/trans_tpfa.h>
@@ -38,9 +39,14 @@ struct densrat_util {
 };
 
 
+struct fluid_kernels;
+
 struct cfs_tpfa_res_impl {
     int                  is_incomp;
 
+    /* Small dense fluid matrix algebra, selected by number of phases */
+    const struct fluid_kernels *kern;
+
     /* One entry per component per face */
     double              *compflux_f;       /* A_{ij} v_{ij} */
     double              *compflux_deriv_f; /* A_{ij} \partial_{p} v_{ij} */
@@ -54,10 +60,19 @@ struct cfs_tpfa_res_impl {
     /* Scratch array for face pressure calculation */
     double              *scratch_f;
 
+    /* Scratch array for explicit transport, np entries per cell */
+    double              *cell_work;
+
     struct densrat_util *ratio;
 
+    /* Positions in J->sa, computed once at construction */
+    int                 *diag;  /* Diagonal, one per unknown (nc + nw) */
+    int                 *fslot; /* (1,1), (1,2), (2,2), (2,1) per face */
+    int                 *wslot; /* (c,w), (w,c) per perforation */
+
     /* Linear storage */
     double *ddata;
+    int    *idata;
 };
 
 
@@ -121,6 +136,7 @@ impl_deallocate(struct cfs_tpfa_res_impl *pimpl)
 /* ---------------------------------------------------------------------- */
 {
     if (pimpl != NULL) {
+        free              (pimpl->idata);
         free              (pimpl->ddata);
         deallocate_densrat(pimpl->ratio);
     }
@@ -140,7 +156,7 @@ impl_allocate(struct UnstructuredGrid   *G       ,
     size_t                nnu, nwperf;
     struct cfs_tpfa_res_impl *new;
 
-    size_t ddata_sz;
+    size_t ddata_sz, idata_sz;
 
     nnu    = G->number_of_cells;
     nwperf = 0;
@@ -164,14 +180,21 @@ impl_allocate(struct UnstructuredGrid   *G       ,
     ddata_sz += np * (1 + 2)                 ; /* flux_work */
 
     ddata_sz += 1  *      G->number_of_faces ; /* scratch_f */
+    ddata_sz += np *      G->number_of_cells ; /* cell_work */
+
+    idata_sz  = 1  *      G->number_of_cells ; /* cell_row */
+    idata_sz += 1  *      nnu                ; /* diag */
+    idata_sz += 4  *      G->number_of_faces ; /* fslot */
+    idata_sz += 2  *      nwperf             ; /* wslot */
 
     new = malloc(1 * sizeof *new);
 
     if (new != NULL) {
         new->ddata = malloc(ddata_sz * sizeof *new->ddata);
+        new->idata = malloc(idata_sz * sizeof *new->idata);
         new->ratio = allocate_densrat(max_conn, np);
 
-        if (new->ddata == NULL || new->ratio == NULL) {
+        if (new->ddata == NULL || new->idata == NULL || new->ratio == NULL) {
             impl_deallocate(new);
             new = NULL;
         }
@@ -184,7 +207,8 @@ impl_allocate(struct UnstructuredGrid   *G       ,
 /* ---------------------------------------------------------------------- */
 static struct CSRMatrix *
 construct_matrix(struct UnstructuredGrid   *G    ,
-                 struct cfs_tpfa_res_wells *wells)
+                 struct cfs_tpfa_res_wells *wells,
+                 const int                 *row  )
 /* ---------------------------------------------------------------------- */
 {
     int    f, c1, c2, w, i, nc, nnu;
@@ -214,8 +238,8 @@ construct_matrix(struct UnstructuredGrid   *G    ,
             c2 = G->face_cells[2*f + 1];
 
             if ((c1 >= 0) && (c2 >= 0)) {
-                A->ia[ c1 + 1 ] += 1;
-                A->ia[ c2 + 1 ] += 1;
+                A->ia[ row[c1] + 1 ] += 1;
+                A->ia[ row[c2] + 1 ] += 1;
             }
         }
 
@@ -227,7 +251,7 @@ construct_matrix(struct UnstructuredGrid   *G    ,
                 for (; i < W->well_connpos[w + 1]; i++) {
                     c1 = W->well_cells[i];
 
-                    A->ia[ 0  + c1 + 1 ] += 1; /* c -> w */
+                    A->ia[ row[c1] + 1 ] += 1; /* c -> w */
                     A->ia[ nc + w  + 1 ] += 1; /* w -> c */
                 }
             }
@@ -252,8 +276,8 @@ construct_matrix(struct UnstructuredGrid   *G    ,
             c2 = G->face_cells[2*f + 1];
 
             if ((c1 >= 0) && (c2 >= 0)) {
-                A->ja[ A->ia[ c1 + 1 ] ++ ] = c2;
-                A->ja[ A->ia[ c2 + 1 ] ++ ] = c1;
+                A->ja[ A->ia[ row[c1] + 1 ] ++ ] = row[c2];
+                A->ja[ A->ia[ row[c2] + 1 ] ++ ] = row[c1];
             }
         }
 
@@ -265,8 +289,8 @@ construct_matrix(struct UnstructuredGrid   *G    ,
                 for (; i < W->well_connpos[w + 1]; i++) {
                     c1 = W->well_cells[i];
 
-                    A->ja[ A->ia[ 0  + c1 + 1 ] ++ ] = nc + w;
-                    A->ja[ A->ia[ nc + w  + 1 ] ++ ] = c1    ;
+                    A->ja[ A->ia[ row[c1] + 1 ] ++ ] = nc + w ;
+                    A->ja[ A->ia[ nc + w  + 1 ] ++ ] = row[c1];
                 }
             }
         }
@@ -281,6 +305,67 @@ construct_matrix(struct UnstructuredGrid   *G    ,
 }
 
 
+/* ---------------------------------------------------------------------- */
+/* Locate, once and for all, the Jacobian elements touched during        */
+/* assembly so that no row searches are needed when forming the system.  */
+/* ---------------------------------------------------------------------- */
+static void
+compute_matrix_slots(struct UnstructuredGrid   *G    ,
+                     struct cfs_tpfa_res_wells *wells,
+                     struct cfs_tpfa_res_data  *h    )
+/* ---------------------------------------------------------------------- */
+{
+    int        c, f, c1, c2, r1, r2, w, i, nc;
+    int       *slot;
+    const int *row;
+
+    struct CSRMatrix *J;
+    struct Wells     *W;
+
+    J   = h->J;
+    row = h->cell_row;
+    nc  = G->number_of_cells;
+
+    for (c = 0; c < nc; c++) {
+        h->pimpl->diag[c] = csrmatrix_elm_index(row[c], row[c], J);
+    }
+
+    for (i = nc; i < (int) J->m; i++) {
+        h->pimpl->diag[i] = csrmatrix_elm_index(i, i, J);
+    }
+
+    for (f = 0, slot = h->pimpl->fslot; f < G->number_of_faces; f++, slot += 4) {
+        c1 = G->face_cells[2*f + 0];
+        c2 = G->face_cells[2*f + 1];
+
+        if ((c1 >= 0) && (c2 >= 0)) {
+            r1 = row[c1];  r2 = row[c2];
+
+            slot[0] = csrmatrix_elm_index(r1, r1, J);
+            slot[1] = csrmatrix_elm_index(r1, r2, J);
+            slot[2] = csrmatrix_elm_index(r2, r2, J);
+            slot[3] = csrmatrix_elm_index(r2, r1, J);
+        } else {
+            slot[0] = slot[1] = slot[2] = slot[3] = -1;
+        }
+    }
+
+    if ((wells != NULL) && (wells->W != NULL)) {
+        W    = wells->W;
+        slot = h->pimpl->wslot;
+
+        for (w = i = 0; w < W->number_of_wells; w++) {
+            for (; i < W->well_connpos[w + 1]; i++, slot += 2) {
+                r1 = row[ W->well_cells[i] ];
+
+                slot[0] = csrmatrix_elm_index(r1    , nc + w, J);
+                slot[1] = csrmatrix_elm_index(nc + w, r1    , J);
+            }
+        }
+    }
+}
+
+
 static void
 factorise_fluid_matrix(int np, const double *A, struct densrat_util *ratio)
 {
@@ -349,6 +434,214 @@ matmat(int np, int ncol, const double *A, const double *B, double *C)
 }
 
 
+/* ---------------------------------------------------------------------- */
+/* Specialised fluid matrix algebra for two and three phases.            */
+/*                                                                        */
+/* The generic kernels above incur the full BLAS/LAPACK call overhead on  */
+/* every 2-by-2 or 3-by-3 system of every cell and interface.  The        */
+/* kernels below are fully unrolled in the row dimension and process all  */
+/* right-hand sides/columns in a single, branch-free loop.  Factorisation */
+/* stores the explicit inverse, computed by cofactor expansion, in        */
+/* ratio->lu.  All matrices are stored in column major order.             */
+/* ---------------------------------------------------------------------- */
+
+static void
+factorise_fluid_matrix_2(int np, const double *A, struct densrat_util *ratio)
+{
+    double det, *inv;
+
+    (void) np;
+
+    inv = ratio->lu;
+    det = A[0]*A[3] - A[2]*A[1];
+
+    assert (fabs(det) > 0.0);
+
+    det    = 1.0 / det;
+    inv[0] =   A[3] * det;
+    inv[1] = - A[1] * det;
+    inv[2] = - A[2] * det;
+    inv[3] =   A[0] * det;
+}
+
+
+static void
+solve_linear_systems_2(int                  np   ,
+                       MAT_SIZE_T           nrhs ,
+                       struct densrat_util *ratio,
+                       double              *b    )
+{
+    MAT_SIZE_T    k;
+    double        b0, b1;
+    const double *inv;
+
+    (void) np;
+
+    inv = ratio->lu;
+    for (k = 0; k < nrhs; k++, b += 2) {
+        b0 = b[0];  b1 = b[1];
+
+        b[0] = inv[0]*b0 + inv[2]*b1;
+        b[1] = inv[1]*b0 + inv[3]*b1;
+    }
+}
+
+
+static void
+matvec_2(int nrow, int ncol, const double *A, const double *x, double *y)
+{
+    int    j;
+    double y0, y1;
+
+    (void) nrow;
+
+    y0 = y1 = 0.0;
+    for (j = 0; j < ncol; j++, A += 2) {
+        y0 += A[0] * x[j];
+        y1 += A[1] * x[j];
+    }
+
+    y[0] = y0;  y[1] = y1;
+}
+
+
+static void
+matmat_2(int np, int ncol, const double *A, const double *B, double *C)
+{
+    int j;
+
+    (void) np;
+
+    for (j = 0; j < ncol; j++, B += 2, C += 2) {
+        C[0] = A[0]*B[0] + A[2]*B[1];
+        C[1] = A[1]*B[0] + A[3]*B[1];
+    }
+}
+
+
+static void
+factorise_fluid_matrix_3(int np, const double *A, struct densrat_util *ratio)
+{
+    double c00, c01, c02, det, *inv;
+
+    (void) np;
+
+    inv = ratio->lu;
+
+    /* Cofactors of first column */
+    c00 = A[4]*A[8] - A[7]*A[5];
+    c01 = A[7]*A[2] - A[1]*A[8];
+    c02 = A[1]*A[5] - A[4]*A[2];
+
+    det = A[0]*c00 + A[3]*c01 + A[6]*c02;
+
+    assert (fabs(det) > 0.0);
+
+    det    = 1.0 / det;
+    inv[0] = c00 * det;
+    inv[1] = c01 * det;
+    inv[2] = c02 * det;
+    inv[3] = (A[6]*A[5] - A[3]*A[8]) * det;
+    inv[4] = (A[0]*A[8] - A[6]*A[2]) * det;
+    inv[5] = (A[3]*A[2] - A[0]*A[5]) * det;
+    inv[6] = (A[3]*A[7] - A[6]*A[4]) * det;
+    inv[7] = (A[6]*A[1] - A[0]*A[7]) * det;
+    inv[8] = (A[0]*A[4] - A[3]*A[1]) * det;
+}
+
+
+static void
+solve_linear_systems_3(int                  np   ,
+                       MAT_SIZE_T           nrhs ,
+                       struct densrat_util *ratio,
+                       double              *b    )
+{
+    MAT_SIZE_T    k;
+    double        b0, b1, b2;
+    const double *inv;
+
+    (void) np;
+
+    inv = ratio->lu;
+    for (k = 0; k < nrhs; k++, b += 3) {
+        b0 = b[0];  b1 = b[1];  b2 = b[2];
+
+        b[0] = inv[0]*b0 + inv[3]*b1 + inv[6]*b2;
+        b[1] = inv[1]*b0 + inv[4]*b1 + inv[7]*b2;
+        b[2] = inv[2]*b0 + inv[5]*b1 + inv[8]*b2;
+    }
+}
+
+
+static void
+matvec_3(int nrow, int ncol, const double *A, const double *x, double *y)
+{
+    int    j;
+    double y0, y1, y2;
+
+    (void) nrow;
+
+    y0 = y1 = y2 = 0.0;
+    for (j = 0; j < ncol; j++, A += 3) {
+        y0 += A[0] * x[j];
+        y1 += A[1] * x[j];
+        y2 += A[2] * x[j];
+    }
+
+    y[0] = y0;  y[1] = y1;  y[2] = y2;
+}
+
+
+static void
+matmat_3(int np, int ncol, const double *A, const double *B, double *C)
+{
+    int j;
+
+    (void) np;
+
+    for (j = 0; j < ncol; j++, B += 3, C += 3) {
+        C[0] = A[0]*B[0] + A[3]*B[1] + A[6]*B[2];
+        C[1] = A[1]*B[0] + A[4]*B[1] + A[7]*B[2];
+        C[2] = A[2]*B[0] + A[5]*B[1] + A[8]*B[2];
+    }
+}
+
+
+struct fluid_kernels {
+    void (*factorise)(int np, const double *A, struct densrat_util *ratio);
+    void (*solve)    (int np, MAT_SIZE_T nrhs,
+                      struct densrat_util *ratio, double *b);
+    void (*matvec)   (int nrow, int ncol,
+                      const double *A, const double *x, double *y);
+    void (*matmat)   (int np, int ncol,
+                      const double *A, const double *B, double *C);
+};
+
+
+static const struct fluid_kernels generic_kernels = {
+    factorise_fluid_matrix  , solve_linear_systems  , matvec  , matmat
+};
+
+static const struct fluid_kernels two_phase_kernels = {
+    factorise_fluid_matrix_2, solve_linear_systems_2, matvec_2, matmat_2
+};
+
+static const struct fluid_kernels three_phase_kernels = {
+    factorise_fluid_matrix_3, solve_linear_systems_3, matvec_3, matmat_3
+};
+
+
+static const struct fluid_kernels *
+select_fluid_kernels(int np)
+{
+    switch (np) {
+    case 2:  return &two_phase_kernels;
+    case 3:  return &three_phase_kernels;
+    default: return &generic_kernels;
+    }
+}
+
+
 static void
 compute_darcyflux_and_deriv(int           np,
                             double        trans,
@@ -405,10 +698,10 @@ compute_compflux_and_deriv(struct UnstructuredGrid  *G     ,
                                         pimpl->flux_work + np);
 
             /* Component flux = Af * v*/
-            matvec(np, np, Af, pimpl->flux_work     , cflux );
+            pimpl->kern->matvec(np, np, Af, pimpl->flux_work     , cflux );
 
             /* Derivative = Af * (dv/dp) */
-            matmat(np, 2 , Af, pimpl->flux_work + np, dcflux);
+            pimpl->kern->matmat(np, 2 , Af, pimpl->flux_work + np, dcflux);
         }
 
         /* Boundary connections excluded */
@@ -463,10 +756,10 @@ compute_well_compflux_and_deriv(struct cfs_tpfa_res_wells *wells ,
                                         pimpl->flux_work + np);
 
             /* Component flux = Ap * q*/
-            matvec(np, np, Ap, pimpl->flux_work     , pflux );
+            pimpl->kern->matvec(np, np, Ap, pimpl->flux_work     , pflux );
 
             /* Derivative = Ap * (dq/dp) */
-            matmat(np, 2 , Ap, pimpl->flux_work + np, dpflux);
+            pimpl->kern->matmat(np, 2 , Ap, pimpl->flux_work + np, dpflux);
         }
     }
 }
@@ -558,14 +851,14 @@ compute_cell_contrib(struct UnstructuredGrid  *G    ,
     nconn = init_cell_contrib(G, c, np, pvol, dt, z, pimpl);
     nrhs  = 1 + (1 + 2)*nconn;  /* [z, Af*v, Af*dv] */
 
-    factorise_fluid_matrix(np, Ac, pimpl->ratio);
-    solve_linear_systems  (np, nrhs, pimpl->ratio,
+    pimpl->kern->factorise(np, Ac, pimpl->ratio);
+    pimpl->kern->solve    (np, nrhs, pimpl->ratio,
                            pimpl->ratio->linsolve_buffer);
 
     /* Sum residual contributions over the connections (+ accumulation):
      *   t1 <- (Ac \ [z, Af*v]) * [-pvol; repmat(dt, [nconn, 1])] */
-    matvec(np, nconn + 1, pimpl->ratio->linsolve_buffer,
-           pimpl->ratio->coeff, pimpl->ratio->t1);
+    pimpl->kern->matvec(np, nconn + 1, pimpl->ratio->linsolve_buffer,
+                        pimpl->ratio->coeff, pimpl->ratio->t1);
 
     /* Compute residual in cell 'c' */
     pimpl->ratio->residual = pvol;
@@ -579,8 +872,8 @@ compute_cell_contrib(struct UnstructuredGrid  *G    ,
                 pimpl->ratio->mat_row);
 
     /* t2 <- A \ ((dA/dp) * t1) */
-    matvec(np, np, dAc, pimpl->ratio->t1, pimpl->ratio->t2);
-    solve_linear_systems(np, 1, pimpl->ratio, pimpl->ratio->t2);
+    pimpl->kern->matvec(np, np, dAc, pimpl->ratio->t1, pimpl->ratio->t2);
+    pimpl->kern->solve (np, 1, pimpl->ratio, pimpl->ratio->t2);
 
     dF2 = 0.0;
     for (p = 0; p < np; p++) {
@@ -629,7 +922,7 @@ assemble_sources(double                    dt ,
         assert (src->cell[i]            >= 0      );
         assert (((size_t) src->cell[i]) <  h->J->m);
 
-        h->F[ src->cell[ i ] ] -= dt * src->flux[ i ];
+        h->F[ h->cell_row[ src->cell[ i ] ] ] -= dt * src->flux[ i ];
     }
 }
 
@@ -641,29 +934,28 @@ assemble_cell_contrib(struct UnstructuredGrid  *G,
                       struct cfs_tpfa_res_data *h)
 /* ---------------------------------------------------------------------- */
 {
-    int c1, c2, i, f, j1, j2, off;
+    int        c1, i, f, j1, j2, off;
+    const int *slot;
 
-    j1 = csrmatrix_elm_index(c, c, h->J);
+    j1 = h->pimpl->diag[ c ];
 
     h->J->sa[j1] += h->pimpl->ratio->mat_row[ 0 ];
 
     off = 1;
     for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++, off++) {
-        f = G->cell_faces[i];
-
-        c1 = G->face_cells[2*f + 0];
-        c2 = G->face_cells[2*f + 1];
+        f    = G->cell_faces[i];
+        slot = h->pimpl->fslot + (4 * f);
 
-        c2 = (c1 == c) ? c2 : c1;
-
-        if (c2 >= 0) {
-            j2 = csrmatrix_elm_index(c, c2, h->J);
+        if (slot[0] >= 0) {
+            /* (c1,c2) if 'c' is first cell of 'f', (c2,c1) otherwise */
+            c1 = G->face_cells[2*f + 0];
+            j2 = (c1 == c) ? slot[1] : slot[3];
 
             h->J->sa[j2] += h->pimpl->ratio->mat_row[ off ];
         }
     }
 
-    h->F[ c ] = h->pimpl->ratio->residual;
+    h->F[ h->cell_row[c] ] = h->pimpl->ratio->residual;
 
     return 0;
 }
@@ -685,8 +977,8 @@ init_completion_contrib(int                       i    ,
            2 * np * sizeof *pimpl->ratio->linsolve_buffer);
 
     /* buffer <- Ac \ [A_{wi}q_{wi}, A_{wi} dq_{wi}] */
-    factorise_fluid_matrix(np, Ac, pimpl->ratio);
-    solve_linear_systems  (np, 1 + 2, pimpl->ratio,
+    pimpl->kern->factorise(np, Ac, pimpl->ratio);
+    pimpl->kern->solve    (np, 1 + 2, pimpl->ratio,
                            pimpl->ratio->linsolve_buffer);
 
     /* t1 <- Ac \ (A_{wi} q_{wi}) */
@@ -695,13 +987,13 @@ init_completion_contrib(int                       i    ,
            np * sizeof *pimpl->ratio->t1);
 
     /* t2 <- Ac \ ((dA/dp) * t1) (== -d(Ac^{-1})/dp (A_{wi} q_{wi})) */
-    matvec(np, np, dAc, pimpl->ratio->t1, pimpl->ratio->t2);
-    solve_linear_systems(np, 1, pimpl->ratio, pimpl->ratio->t2);
+    pimpl->kern->matvec(np, np, dAc, pimpl->ratio->t1, pimpl->ratio->t2);
+    pimpl->kern->solve (np, 1, pimpl->ratio, pimpl->ratio->t2);
 }
 
 
 static void
-assemble_completion_to_cell(int c, int wdof, int np, double dt,
+assemble_completion_to_cell(int i, int c, int wdof, int np, double dt,
                             struct cfs_tpfa_res_data *h)
 {
     int    p;
@@ -719,12 +1011,12 @@ assemble_completion_to_cell(int c, int wdof, int np, double dt,
      *
      * Note negative sign due to perforation flux convention (positive
      * flux into reservoir). */
-    h->F[ c ] -= dt * s1;
+    h->F[ h->cell_row[c] ] -= dt * s1;
 
     /* Assemble Jacobian contributions from well completion. */
     assert (wdof > c);
-    jc = csrmatrix_elm_index(c, c   , h->J);
-    jw = csrmatrix_elm_index(c, wdof, h->J);
+    jc = h->pimpl->diag [ c       ];
+    jw = h->pimpl->wslot[ 2*i + 0 ];
 
     /* Compressibility-like (diagonal) Jacobian term.  Positive sign
      * since the negative derivative in ->ratio->t2 (see
@@ -850,7 +1142,7 @@ welleq_coeff_surfrate(int i, int np, struct cfs_tpfa_res_data *h,
 
 /* ---------------------------------------------------------------------- */
 static void
-assemble_completion_to_well(int i, int w, int c, int nc, int np,
+assemble_completion_to_well(int i, int w, int nc, int np,
                             double pw, double dt,
                             struct cfs_tpfa_res_wells *wells,
                             struct cfs_tpfa_res_data  *h    )
@@ -894,8 +1186,8 @@ assemble_completion_to_well(int i, int w, int c, int nc, int np,
 
     /* Assemble completion contributions */
     wdof = nc + w;
-    jc   = csrmatrix_elm_index(wdof, c   , h->J);
-    jw   = csrmatrix_elm_index(wdof, wdof, h->J);
+    jc   = h->pimpl->wslot[ 2*i + 1 ];
+    jw   = h->pimpl->diag [ wdof    ];
 
     h->F    [ wdof ] += dt * res;
     h->J->sa[ jc   ] += dt * w2c;
@@ -947,7 +1239,7 @@ assemble_well_contrib(struct cfs_tpfa_res_wells   *wells ,
             init_completion_contrib(i, np, Ac, dAc, h->pimpl);
 
             if (is_open) {
-                assemble_completion_to_cell(c, nc + w, np, dt, h);
+                assemble_completion_to_cell(i, c, nc + w, np, dt, h);
             }
 
             /* Prepare for RESV controls */
@@ -955,7 +1247,7 @@ assemble_well_contrib(struct cfs_tpfa_res_wells   *wells ,
                                         h->pimpl->flux_work,
                                         h->pimpl->flux_work + np);
 
-            assemble_completion_to_well(i, w, c, nc, np, pw, dt, wells, h);
+            assemble_completion_to_well(i, w, nc, np, pw, dt, wells, h);
         }
 
         ctrl = W->ctrls[ w ];
@@ -1168,6 +1460,19 @@ cfs_tpfa_res_construct(struct UnstructuredGrid   *G      ,
                        struct cfs_tpfa_res_wells *wells  ,
                        int                        nphases)
 /* ---------------------------------------------------------------------- */
+{
+    return cfs_tpfa_res_construct_ordered(G, wells, nphases,
+                                          TPFA_NATURAL_ORDER);
+}
+
+
+/* ---------------------------------------------------------------------- */
+struct cfs_tpfa_res_data *
+cfs_tpfa_res_construct_ordered(struct UnstructuredGrid   *G       ,
+                               struct cfs_tpfa_res_wells *wells   ,
+                               int                        nphases ,
+                               enum tpfa_cell_ordering    ordering)
+/* ---------------------------------------------------------------------- */
 {
     size_t                    nf, nwperf;
     struct cfs_tpfa_res_data *h;
@@ -1175,8 +1480,18 @@ cfs_tpfa_res_construct(struct UnstructuredGrid   *G      ,
     h = malloc(1 * sizeof *h);
 
     if (h != NULL) {
+        h->J     = NULL;
         h->pimpl = impl_allocate(G, wells, maxconn(G), nphases);
-        h->J     = construct_matrix(G, wells);
+
+        if (h->pimpl != NULL) {
+            h->pimpl->kern = select_fluid_kernels(nphases);
+            h->cell_row    = h->pimpl->idata;
+
+            /* Allocation failure falls back to natural ordering. */
+            cell_ordering_compute(G, ordering, h->cell_row);
+
+            h->J = construct_matrix(G, wells, h->cell_row);
+        }
 
         if ((h->pimpl == NULL) || (h->J == NULL)) {
             cfs_tpfa_res_destroy(h);
@@ -1209,6 +1524,15 @@ cfs_tpfa_res_construct(struct UnstructuredGrid   *G      ,
 
         h->pimpl->scratch_f        =
             h->pimpl->flux_work                      + (nphases * (1 + 2));
+
+        h->pimpl->cell_work        =
+            h->pimpl->scratch_f                      + (1 * nf);
+
+        h->pimpl->diag  = h->cell_row     + G->number_of_cells;
+        h->pimpl->fslot = h->pimpl->diag  + h->J->m;
+        h->pimpl->wslot = h->pimpl->fslot + (4 * nf);
+
+        compute_matrix_slots(G, wells, h);
     }
 
     return h;
@@ -1322,15 +1646,15 @@ cfs_tpfa_res_comprock_assemble(
     /* Add new terms to residual and Jacobian. */
     rock_is_incomp = 1;
     for (c = 0; c < G->number_of_cells; c++) {
-        j = csrmatrix_elm_index(c, c, h->J);
+        j = h->pimpl->diag[c];
 
         dpv = (porevol[c] - porevol0[c]);
         if (dpv != 0.0 || rock_comp[c] != 0.0) {
             rock_is_incomp = 0;
         }
 
-        h->J->sa[j] += porevol[c] * rock_comp[c];
-        h->F[c]     += dpv;
+        h->J->sa[j]             += porevol[c] * rock_comp[c];
+        h->F[ h->cell_row[c] ] += dpv;
     }
 
     /* Re-do the singularity-removing adjustment if necessary */
@@ -1386,246 +1710,198 @@ cfs_tpfa_res_fpress(struct UnstructuredGrid  *G        ,
 }
 
 
-#if 0
 /* ---------------------------------------------------------------------- */
-void
-cfs_tpfa_res_retrieve_masstrans(struct UnstructuredGrid               *G,
-                            int                   np,
-                            struct cfs_tpfa_res_data *h,
-                            double               *masstrans_f)
+static double
+total_darcyflux(int           np   ,
+                double        trans,
+                double        dp   ,
+                const double *pmob ,
+                const double *gcap )
 /* ---------------------------------------------------------------------- */
 {
-    memcpy(masstrans_f, h->pimpl->masstrans_f,
-           np * G->number_of_faces * sizeof *masstrans_f);
-}
+    int    p;
+    double v;
 
+    v = 0.0;
+    for (p = 0; p < np; p++) {
+        v += pmob[p] * (dp + ((gcap != NULL) ? gcap[p] : 0.0));
+    }
 
-/* ---------------------------------------------------------------------- */
-void
-cfs_tpfa_res_retrieve_gravtrans(struct UnstructuredGrid               *G,
-                            int                   np,
-                            struct cfs_tpfa_res_data *h,
-                            double               *gravtrans_f)
-/* ---------------------------------------------------------------------- */
-{
-    memcpy(gravtrans_f, h->pimpl->gravtrans_f,
-           np * G->number_of_faces * sizeof *gravtrans_f);
+    return trans * v;
 }
 
 
 /* ---------------------------------------------------------------------- */
-static double
-cfs_tpfa_res_impes_maxtime_cell(int                      c,
-                            struct UnstructuredGrid                  *G,
-                            struct compr_quantities *cq,
-                            const double            *trans,
-                            const double            *porevol,
-                            struct cfs_tpfa_res_data    *h,
-                            const double            *dpmobf,
-                            const double            *surf_dens,
-                            const double            *gravity)
+/* Component fluxes (compflux_f, compflux_p) and total Darcy flux across  */
+/* each interior face (scratch_f) at pressure point (cpress, wpress).     */
+/* Total outflow from each cell to the wells is accumulated in cell_work. */
+/* ---------------------------------------------------------------------- */
+static void
+compute_transport_fluxes(struct UnstructuredGrid     *G        ,
+                         struct cfs_tpfa_res_forces  *forces   ,
+                         struct compr_quantities_gen *cq       ,
+                         const double                *trans    ,
+                         const double                *gravcap_f,
+                         const double                *cpress   ,
+                         const double                *wpress   ,
+                         struct cfs_tpfa_res_impl    *pimpl    )
 /* ---------------------------------------------------------------------- */
 {
-    /* Reference:
-       K. H. Coats, "IMPES Stability: The Stable Step", SPE 69225
-
-       Capillary pressure parts not included.
-    */
-
-    int i, j, k, f, c2;
-    double f11, f12, f21, f22;
-    double dp, dzg, tr, tmob, detF, eqv_flux;
-    const double *pmob;
-    const double *A;
-    /* This is intended to be compatible with the dune-porsol blackoil
-       code. This library is otherwise not depending on particular
-       orderings of phases or components, so at some point this
-       function should be generalized. */
-    enum { Water = 0, Oil = 1, Gas = 2 };
-    enum { num_phases = 3 };
-    double rho[num_phases];
-    double pot[num_phases];
-    /* Notation: dpmob[Oil][Water] is d/ds_w(lambda_o) */
-    double dpmob[num_phases][num_phases]
-        = { {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0} };
-
-    assert (cq->nphases == 3);
-
-    f11 = f12 = f21 = f22 = 0.0;
-
-    /* Loop over neighbour faces to accumulate f11, f12 etc. */
-    for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; ++i) {
-        f  = G->cell_faces[i];
-        if ((c2 = G->face_cells[2*f + 0]) == c) {
-            c2  = G->face_cells[2*f + 1];
-        }
+    int           c, c1, c2, f, i, w, np;
+    double        v;
+    struct Wells *W;
 
-        /* Initially only interior faces */
-        if (c2 < 0) {
-            continue;
+    np = cq->nphases;
+
+    compute_compflux_and_deriv(G, np, cpress, trans, cq->phasemobf,
+                               gravcap_f, cq->Af, pimpl);
+
+    for (f = 0; f < G->number_of_faces; f++) {
+        c1 = G->face_cells[2*f + 0];
+        c2 = G->face_cells[2*f + 1];
+
+        pimpl->scratch_f[f] = 0.0;
+
+        if ((c1 >= 0) && (c2 >= 0)) {
+            pimpl->scratch_f[f] =
+                total_darcyflux(np, trans[f], cpress[c1] - cpress[c2],
+                                cq->phasemobf + f*np, gravcap_f + f*np);
         }
+    }
+
+    vector_zero(G->number_of_cells, pimpl->cell_work);
+
+    if ((forces           != NULL) &&
+        (forces->wells    != NULL) &&
+        (forces->wells->W != NULL)) {
+
+        compute_well_compflux_and_deriv(forces->wells, np,
+                                        cpress, wpress, pimpl);
 
-        /* Computing density */
-        A = cq->Af + f*(cq->nphases)*(cq->nphases);
-        for (j = 0; j < cq->nphases; ++j) {
-            rho[j] = 0.0;
-            for (k = 0; k < cq->nphases; ++k) {
-                rho[j] += A[cq->nphases*j + k]*surf_dens[k];
+        W = forces->wells->W;
+        for (w = i = 0; w < W->number_of_wells; w++) {
+            for (; i < W->well_connpos[w + 1]; i++) {
+                c = W->well_cells[i];
+                v = total_darcyflux(np, W->WI[i],
+                                    wpress[w] + forces->wells->data->wdp[i]
+                                    - cpress[c],
+                                    forces->wells->data->phasemob + i*np,
+                                    NULL);
+
+                /* v < 0 => production from cell 'c' */
+                pimpl->cell_work[c] += MAX(-v, 0.0);
             }
         }
-        /* Computing gravity potentials */
-        dp = h->x[c] - h->x[c2];
-        dzg = 0.0;
-        for (j = 0; j < G->dimensions; ++j) {
-            dzg += (G->cell_centroids[G->dimensions*c + j] - G->cell_centroids[G->dimensions*c2 + j])*gravity[j];
-        }
-        for (j = 0; j < cq->nphases; ++j) {
-            pot[j] = fabs(dp - rho[j]*dzg);
-        }
-        /* Filling the dpmob array from available data.
-           Note that we only need the following combinations:
-           (Water, Water)
-           (Water, Gas)
-           (Oil, Water)
-           (Oil, Gas)
-           (Gas, Gas)
-
-           No derivatives w.r.t. Oil is needed, since there are only two
-           independent saturation variables.
-
-           The lack of (Gas, Water) may be due to assumptions on the
-           three-phase model used (should be checked to be compatible
-           with our choices).
-        */
-        dpmob[Water][Water] = dpmobf[9*f];
-        dpmob[Water][Gas] = dpmobf[9*f + 2];
-        dpmob[Oil][Water] = dpmobf[9*f + 3];
-        dpmob[Oil][Gas] = dpmobf[9*f + 5];
-        dpmob[Gas][Gas] = dpmobf[9*f + 8];
-        /* Computing the flux parts f_ij */
-        pmob = cq->phasemobf + f*cq->nphases;
-        tr = trans[f];
-        tmob = pmob[Water] + pmob[Oil] + pmob[Gas];
-        f11 += tr*((pmob[Oil] + pmob[Gas])*dpmob[Water][Water]*pot[Water]
-                   - pmob[Water]*dpmob[Oil][Water]*pot[Oil])/tmob;
-        f12 += -tr*(pmob[Water]*dpmob[Oil][Gas]*pot[Oil]
-                    + pmob[Water]*dpmob[Gas][Gas]*pot[Gas]
-                    - (pmob[Oil] + pmob[Gas])*dpmob[Water][Gas]*pot[Water])/tmob;
-        f21 += -tr*(pmob[Gas]*dpmob[Water][Water]*pot[Water]
-                    + pmob[Gas]*dpmob[Oil][Water]*pot[Oil])/tmob;
-        f22 += tr*(-pmob[Gas]*dpmob[Oil][Gas]*pot[Oil]
-                   + (pmob[Water] + pmob[Oil])*dpmob[Gas][Gas]*pot[Gas]
-                   - pmob[Gas]*dpmob[Water][Gas]*pot[Water])/tmob;
     }
-
-    /* (from eq. 3, 4a-e, 5a-c)
-       F_i = 1/2 |f11_i + f22_i + \sqrt{G}|
-       G = (f11_i + f22_i)^2 - 4 det(F_i)
-       fXX_i = \sum_j fXX_ij     (j runs over the neighbours)
-       det(F_i) = f11_i f22_i - f12_i f21_i
-    */
-    detF = f11*f22 - f12*f21;
-    eqv_flux = 0.5*fabs(f11 + f22 + sqrt((f11 + f22)*(f11 + f22) - 4*detF));
-    /* delta_t < porevol/eqv_flux */
-    return porevol[c]/eqv_flux;
 }
 
+
 /* ---------------------------------------------------------------------- */
 double
-cfs_tpfa_res_impes_maxtime(struct UnstructuredGrid                  *G,
-                       struct compr_quantities *cq,
-                       const double            *trans,
-                       const double            *porevol,
-                       struct cfs_tpfa_res_data    *h,
-                       const double            *dpmobf,
-                       const double            *surf_dens,
-                       const double            *gravity)
+cfs_tpfa_res_impes_maxtime(struct UnstructuredGrid     *G        ,
+                           struct cfs_tpfa_res_forces  *forces   ,
+                           struct compr_quantities_gen *cq       ,
+                           const double                *trans    ,
+                           const double                *gravcap_f,
+                           const double                *cpress   ,
+                           const double                *wpress   ,
+                           const double                *porevol  ,
+                           struct cfs_tpfa_res_data    *h        )
 /* ---------------------------------------------------------------------- */
 {
-    int c;
-    double max_dt, cell_dt;
-    max_dt = 1e100;
-    for (c = 0; c < G->number_of_cells; ++c) {
-        cell_dt = cfs_tpfa_res_impes_maxtime_cell(c, G, cq, trans, porevol, h,
-                                              dpmobf, surf_dens, gravity);
-        if (cell_dt < max_dt) {
-            max_dt = cell_dt;
+    int           c, i, f;
+    double        max_dt, out, v;
+    const double *fflux, *wout;
+
+    compute_transport_fluxes(G, forces, cq, trans, gravcap_f,
+                             cpress, wpress, h->pimpl);
+
+    fflux  = h->pimpl->scratch_f;
+    wout   = h->pimpl->cell_work;
+    max_dt = HUGE_VAL;
+
+    /* Cells are independent: total outflow of cell 'c' from its faces
+     * plus production into wells. */
+#pragma omp parallel for reduction(min:max_dt) private(i, f, out, v)
+    for (c = 0; c < G->number_of_cells; c++) {
+        out = wout[c];
+
+        for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
+            f = G->cell_faces[i];
+            v = (G->face_cells[2*f + 0] == c) ? fflux[f] : - fflux[f];
+
+            out += MAX(v, 0.0);
+        }
+
+        if ((out > 0.0) && (porevol[c] / out < max_dt)) {
+            max_dt = porevol[c] / out;
         }
     }
+
     return max_dt;
 }
 
 
-
 /* ---------------------------------------------------------------------- */
 void
-cfs_tpfa_res_expl_mass_transport(struct UnstructuredGrid                 *G,
-                             well_t                 *W,
-                             struct completion_data *wdata,
-                             int                     np,
-                             double                  dt,
-                             const double           *porevol,
-                             struct cfs_tpfa_res_data   *h,
-                             double                 *surf_vol)
+cfs_tpfa_res_expl_mass_transport(struct UnstructuredGrid    *G      ,
+                                 struct cfs_tpfa_res_forces *forces ,
+                                 int                         np     ,
+                                 double                      dt     ,
+                                 const double               *porevol,
+                                 struct cfs_tpfa_res_data   *h      ,
+                                 double                     *zc     )
 /* ---------------------------------------------------------------------- */
 {
-    int    c, i, f, c2, p, w;
-    double dp, dz, gsgn;
-    const double *masstrans_f, *gravtrans_f, *masstrans_p, *gravtrans_p;
-    const double *cpress, *wpress;
-
-    /* Suppress warning about unused parameter. */
-    (void) wdata;
-
-    masstrans_f = h->pimpl->masstrans_f;
-    gravtrans_f = h->pimpl->gravtrans_f;
-    masstrans_p = h->pimpl->masstrans_p;
-    gravtrans_p = h->pimpl->gravtrans_p;
-    cpress = h->x;
-    wpress = h->x + G->number_of_cells;
-
-    /* Transport through interior faces */
-    for (c = i = 0; c < G->number_of_cells; c++) {
-        for (; i < G->cell_facepos[c + 1]; i++) {
-            f  = G->cell_faces[i];
+    int           c, i, f, p, w;
+    double        s, *net;
+    const double *cflux, *pflux;
+    struct Wells *W;
 
-            if ((c2 = G->face_cells[2*f + 0]) == c) {
-              gsgn = 1.0;
-                c2  = G->face_cells[2*f + 1];
-            } else {
-              gsgn = -1.0;
-            }
+    cflux = h->pimpl->compflux_f;
+    net   = h->pimpl->cell_work;
 
-            if (c2 >= 0) {
-                dp = cpress[c] - cpress[c2];
+    vector_zero(np * G->number_of_cells, net);
 
-                for (p = 0; p < np; p++) {
-                    dz  = masstrans_f[f*np + p] * dp;
-                    dz += gravtrans_f[f*np + p] * gsgn;
+    /* Transport through well perforations.  Perforation fluxes are
+     * positive into the reservoir. */
+    if ((forces           != NULL) &&
+        (forces->wells    != NULL) &&
+        (forces->wells->W != NULL)) {
 
-                    /* dz > 0 => flow from c into c2. */
-                    surf_vol[c*np + p] -= dz * dt / porevol[c];
-                }
-            }
-        }
-    }
+        W     = forces->wells->W;
+        pflux = h->pimpl->compflux_p;
 
-    /* Transport through well perforations */
-    if (W != NULL) {
         for (w = i = 0; w < W->number_of_wells; w++) {
             for (; i < W->well_connpos[w + 1]; i++) {
                 c = W->well_cells[i];
-                dp = wpress[w] - cpress[c];
 
                 for (p = 0; p < np; p++) {
-                    dz = masstrans_p[i*np + p] * dp;
-                    dz += gravtrans_p[i*np + p];
+                    net[c*np + p] += pflux[i*np + p];
+                }
+            }
+        }
+    }
+
+    /* Transport through interior faces.  Face fluxes are positive from
+     * first to second cell of the face. */
+#pragma omp parallel for private(i, f, p, s)
+    for (c = 0; c < G->number_of_cells; c++) {
+        for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
+            f = G->cell_faces[i];
 
-                    /* dz > 0 => flow from perforation into c. */
-                    surf_vol[c*np + p] += dz * dt / porevol[c];
+            if ((G->face_cells[2*f + 0] >= 0) &&
+                (G->face_cells[2*f + 1] >= 0)) {
+                s = (G->face_cells[2*f + 0] == c) ? -1.0 : 1.0;
+
+                for (p = 0; p < np; p++) {
+                    net[c*np + p] += s * cflux[f*np + p];
                 }
             }
         }
+
+        for (p = 0; p < np; p++) {
+            zc[c*np + p] += dt * net[c*np + p] / porevol[c];
+        }
     }
 }
-#endif
@@ -23,6 +23,7 @@
 #include <opm/core/grid.h>
 #include <opm/core/wells.h>
 
+#include <opm/core/pressure/tpfa/cell_ordering.h>
 #include <opm/core/pressure/tpfa/compr_source.h>
 
 /**
@@ -99,6 +100,13 @@ struct cfs_tpfa_res_data {
     struct CSRMatrix         *J; /**< Jacobian matrix */
     double                   *F; /**< Residual vector (right-hand side) */
 
+    /**
+     * Row of linear system associated to each cell.  The residual of cell
+     * @c c is <CODE>F[cell_row[c]]</CODE>.  Well unknowns always occupy the
+     * trailing rows, in order.
+     */
+    int                      *cell_row;
+
     struct cfs_tpfa_res_impl *pimpl; /**< Internal management structure */
 };
 
@@ -126,6 +134,32 @@ cfs_tpfa_res_construct(struct UnstructuredGrid   *G      ,
                        int                        nphases);
 
 
+/**
+ * Construct assembler for system of linear equations whose rows follow a
+ * particular cell ordering.
+ *
+ * Identical to cfs_tpfa_res_construct() except that the rows of the Jacobian
+ * system associated to grid cells are permuted according to @c ordering.  A
+ * bandwidth-reducing ordering improves memory locality of assembly and of the
+ * matrix-vector products in iterative solvers on unstructured grids.  Callers
+ * must map between cell and row indices through
+ * <CODE>cell_row</CODE> when interpreting @c F or the solution of the
+ * Jacobian system.
+ *
+ * @param[in] G        Grid
+ * @param[in] wells    Well description.  @c NULL in case of no wells.
+ * @param[in] nphases  Number of active fluid phases in this simulation run.
+ * @param[in] ordering Cell ordering of linear system.
+ * @return Fully formed assembler structure.  @c NULL in case of allocation
+ * failure.  Must be destroyed using function cfs_tpfa_res_destroy().
+ */
+struct cfs_tpfa_res_data *
+cfs_tpfa_res_construct_ordered(struct UnstructuredGrid   *G       ,
+                               struct cfs_tpfa_res_wells *wells   ,
+                               int                        nphases ,
+                               enum tpfa_cell_ordering    ordering);
+
+
 /**
  * Destroy assembler for system of linear equations.
  *
@@ -331,40 +365,77 @@ cfs_tpfa_res_fpress(struct UnstructuredGrid  *G,
                     const double             *fflux,
                     double                   *fpress);
 
-#if 0
-void
-cfs_tpfa_retrieve_masstrans(struct UnstructuredGrid *G,
-                            int                      np,
-                            struct cfs_tpfa_data    *h,
-                            double                  *masstrans_f);
-
-void
-cfs_tpfa_retrieve_gravtrans(struct UnstructuredGrid *G,
-                            int                      np,
-                            struct cfs_tpfa_data    *h,
-                            double                  *gravtrans_f);
 
+/**
+ * Compute maximum stable time step for explicit transport of the fluid
+ * components using the fluxes at the current pressure point.
+ *
+ * The stable step is estimated by the throughput (CFL) condition
+ * \f[
+ * \Delta t \le \min_i \frac{\Phi_i}{\sum_j \max(v_{ij}, 0) + q_i^-}
+ * \f]
+ * in which \f$v_{ij}\f$ is the total Darcy flux from cell \f$i\f$ to cell
+ * \f$j\f$, \f$\Phi_i\f$ is the pore-volume of cell \f$i\f$ and
+ * \f$q_i^-\f$ is the total production from cell \f$i\f$ into wells.  Capillary
+ * pressure effects are not included.  As a side effect, the component fluxes
+ * needed by function cfs_tpfa_res_expl_mass_transport() are computed and
+ * stored in the assembler.
+ *
+ * @param[in]     G         Grid.
+ * @param[in]     forces    Driving forces.  Explicit source terms are ignored.
+ * @param[in]     cq        Compressible quantities describing the current fluid
+ *                          state.  Fields @c Af and @c phasemobf must be valid.
+ * @param[in]     trans     Background transmissibilities as defined by function
+ *                          tpfa_trans_compute().
+ * @param[in]     gravcap_f Discrete gravity and capillary forces.
+ * @param[in]     cpress    Cell pressures.  One scalar value per grid cell.
+ * @param[in]     wpress    Well (bottom-hole) pressures.  One scalar value per
+ *                          well.  @c NULL in case of no wells.
+ * @param[in]     porevol   Pore-volumes.  One (positive) scalar value for each
+ *                          grid cell.
+ * @param[in,out] h         Valid assembler obtained from a previous call to
+ *                          constructor function cfs_tpfa_res_construct().
+ *
+ * @return Maximum stable time step.  @c HUGE_VAL if there is no flow.
+ */
 double
-cfs_tpfa_impes_maxtime(struct UnstructuredGrid *G,
-                       struct compr_quantities *cq,
-                       const double            *trans,
-                       const double            *porevol,
-                       struct cfs_tpfa_data    *h,
-                       const double            *dpmobf,
-                       const double            *surf_dens,
-                       const double            *gravity);
+cfs_tpfa_res_impes_maxtime(struct UnstructuredGrid     *G        ,
+                           struct cfs_tpfa_res_forces  *forces   ,
+                           struct compr_quantities_gen *cq       ,
+                           const double                *trans    ,
+                           const double                *gravcap_f,
+                           const double                *cpress   ,
+                           const double                *wpress   ,
+                           const double                *porevol  ,
+                           struct cfs_tpfa_res_data    *h        );
 
-void
-cfs_tpfa_expl_mass_transport(struct UnstructuredGrid *G,
-                             well_t                  *W,
-                             struct completion_data  *wdata,
-                             int                      np,
-                             double                   dt,
-                             const double            *porevol,
-                             struct cfs_tpfa_data    *h,
-                             double                  *surf_vol);
 
-#endif
+/**
+ * Advance component volumes explicitly in time using the component fluxes
+ * computed in the most recent call to function cfs_tpfa_res_impes_maxtime().
+ *
+ * @param[in]     G       Grid.
+ * @param[in]     forces  Driving forces.  Must be the same as in the call to
+ *                        cfs_tpfa_res_impes_maxtime().
+ * @param[in]     np      Number of fluid phases (and components).
+ * @param[in]     dt      Time step size.  Should not exceed the maximum time
+ *                        step reported by cfs_tpfa_res_impes_maxtime().
+ * @param[in]     porevol Pore-volumes.  One (positive) scalar value for each
+ *                        grid cell.
+ * @param[in,out] h       Assembler.
+ * @param[in,out] zc      Component volumes, per pore-volume, at surface
+ *                        conditions for all components in all cells stored
+ *                        consecutively per cell.  Array of size
+ *                        <CODE>G->number_of_cells * np</CODE>.
+ */
+void
+cfs_tpfa_res_expl_mass_transport(struct UnstructuredGrid    *G      ,
+                                 struct cfs_tpfa_res_forces *forces ,
+                                 int                         np     ,
+                                 double                      dt     ,
+                                 const double               *porevol,
+                                 struct cfs_tpfa_res_data   *h      ,
+                                 double                     *zc     );
 
 #ifdef __cplusplus
 }
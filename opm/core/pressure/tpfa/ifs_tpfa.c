@@ -10,6 +10,7 @@
 #include <opm/core/wells.h>
 #include <opm/core/well_controls.h>
 #include <opm/core/pressure/flow_bc.h>
+#include <opm/core/pressure/tpfa/cell_ordering.h>
 #include <opm/core/pressure/tpfa/ifs_tpfa.h>
 
 
@@ -36,9 +37,16 @@ mult_csr_matrix(const struct CSRMatrix *A,
 struct ifs_tpfa_impl {
     double *fgrav;              /* Accumulated grav contrib/face */
     double *work;
+    double *pwork;              /* Pressure in system ordering */
+
+    /* Positions in A->sa, computed once at construction */
+    int    *diag;               /* Diagonal, one per unknown (nc + nw) */
+    int    *fslot;              /* (1,1), (1,2), (2,2), (2,1) per face */
+    int    *wslot;              /* (c,w), (w,c) per perforation */
 
     /* Linear storage */
     double *ddata;
+    int    *idata;
 };
 
 
@@ -48,6 +56,7 @@ impl_deallocate(struct ifs_tpfa_impl *pimpl)
 /* ---------------------------------------------------------------------- */
 {
     if (pimpl != NULL) {
+        free(pimpl->idata);
         free(pimpl->ddata);
     }
 
@@ -63,24 +72,33 @@ impl_allocate(struct UnstructuredGrid *G,
 {
     struct ifs_tpfa_impl *new;
 
-    size_t nnu;
-    size_t ddata_sz;
+    size_t nnu, nperf;
+    size_t ddata_sz, idata_sz;
 
-    nnu = G->number_of_cells;
+    nnu   = G->number_of_cells;
+    nperf = 0;
     if (W != NULL) {
-        nnu += W->number_of_wells;
+        nnu   += W->number_of_wells;
+        nperf  = W->well_connpos[ W->number_of_wells ];
     }
 
     ddata_sz  = 2 * nnu;                 /* b, x */
     ddata_sz += 1 * G->number_of_faces;  /* fgrav */
     ddata_sz += 1 * nnu;                 /* work */
+    ddata_sz += 1 * nnu;                 /* pwork */
+
+    idata_sz  = 1 * G->number_of_cells;  /* cell_row */
+    idata_sz += 1 * nnu;                 /* diag */
+    idata_sz += 4 * G->number_of_faces;  /* fslot */
+    idata_sz += 2 * nperf;               /* wslot */
 
     new = malloc(1 * sizeof *new);
 
     if (new != NULL) {
         new->ddata = malloc(ddata_sz * sizeof *new->ddata);
+        new->idata = malloc(idata_sz * sizeof *new->idata);
 
-        if (new->ddata == NULL) {
+        if ((new->ddata == NULL) || (new->idata == NULL)) {
             impl_deallocate(new);
             new = NULL;
         }
@@ -93,7 +111,8 @@ impl_allocate(struct UnstructuredGrid *G,
 /* ---------------------------------------------------------------------- */
 static struct CSRMatrix *
 ifs_tpfa_construct_matrix(struct UnstructuredGrid *G,
-                          struct Wells            *W)
+                          struct Wells            *W,
+                          const int               *row)
 /* ---------------------------------------------------------------------- */
 {
     int    f, c1, c2, w, i, nc, nnu;
@@ -120,8 +139,8 @@ ifs_tpfa_construct_matrix(struct UnstructuredGrid *G,
             c2 = G->face_cells[2*f + 1];
 
             if ((c1 >= 0) && (c2 >= 0)) {
-                A->ia[ c1 + 1 ] += 1;
-                A->ia[ c2 + 1 ] += 1;
+                A->ia[ row[c1] + 1 ] += 1;
+                A->ia[ row[c2] + 1 ] += 1;
             }
         }
 
@@ -131,7 +150,7 @@ ifs_tpfa_construct_matrix(struct UnstructuredGrid *G,
                 for (; i < W->well_connpos[w + 1]; i++) {
                     c1 = W->well_cells[i];
 
-                    A->ia[ 0  + c1 + 1 ] += 1; /* c -> w */
+                    A->ia[ row[c1] + 1 ] += 1; /* c -> w */
                     A->ia[ nc + w  + 1 ] += 1; /* w -> c */
                 }
             }
@@ -156,8 +175,8 @@ ifs_tpfa_construct_matrix(struct UnstructuredGrid *G,
             c2 = G->face_cells[2*f + 1];
 
             if ((c1 >= 0) && (c2 >= 0)) {
-                A->ja[ A->ia[ c1 + 1 ] ++ ] = c2;
-                A->ja[ A->ia[ c2 + 1 ] ++ ] = c1;
+                A->ja[ A->ia[ row[c1] + 1 ] ++ ] = row[c2];
+                A->ja[ A->ia[ row[c2] + 1 ] ++ ] = row[c1];
             }
         }
 
@@ -167,8 +186,8 @@ ifs_tpfa_construct_matrix(struct UnstructuredGrid *G,
                 for (; i < W->well_connpos[w + 1]; i++) {
                     c1 = W->well_cells[i];
 
-                    A->ja[ A->ia[ 0  + c1 + 1 ] ++ ] = nc + w;
-                    A->ja[ A->ia[ nc + w  + 1 ] ++ ] = c1    ;
+                    A->ja[ A->ia[ row[c1] + 1 ] ++ ] = nc + w ;
+                    A->ja[ A->ia[ nc + w  + 1 ] ++ ] = row[c1];
                 }
             }
         }
@@ -183,6 +202,65 @@ ifs_tpfa_construct_matrix(struct UnstructuredGrid *G,
 }
 
 
+/* ---------------------------------------------------------------------- */
+/* Locate, once and for all, the matrix elements touched during assembly */
+/* so that no row searches are needed when forming the linear system.    */
+/* ---------------------------------------------------------------------- */
+static void
+compute_matrix_slots(struct UnstructuredGrid *G,
+                     struct Wells            *W,
+                     struct ifs_tpfa_data    *h)
+/* ---------------------------------------------------------------------- */
+{
+    int        c, f, c1, c2, r1, r2, w, i, nc;
+    int       *slot;
+    const int *row;
+
+    struct CSRMatrix *A;
+
+    A   = h->A;
+    row = h->cell_row;
+    nc  = G->number_of_cells;
+
+    for (c = 0; c < nc; c++) {
+        h->pimpl->diag[c] = csrmatrix_elm_index(row[c], row[c], A);
+    }
+
+    for (i = nc; i < (int) A->m; i++) {
+        h->pimpl->diag[i] = csrmatrix_elm_index(i, i, A);
+    }
+
+    for (f = 0, slot = h->pimpl->fslot; f < G->number_of_faces; f++, slot += 4) {
+        c1 = G->face_cells[2*f + 0];
+        c2 = G->face_cells[2*f + 1];
+
+        if ((c1 >= 0) && (c2 >= 0)) {
+            r1 = row[c1];  r2 = row[c2];
+
+            slot[0] = csrmatrix_elm_index(r1, r1, A);
+            slot[1] = csrmatrix_elm_index(r1, r2, A);
+            slot[2] = csrmatrix_elm_index(r2, r2, A);
+            slot[3] = csrmatrix_elm_index(r2, r1, A);
+        } else {
+            slot[0] = slot[1] = slot[2] = slot[3] = -1;
+        }
+    }
+
+    if (W != NULL) {
+        slot = h->pimpl->wslot;
+
+        for (w = i = 0; w < W->number_of_wells; w++) {
+            for (; i < W->well_connpos[w + 1]; i++, slot += 2) {
+                r1 = row[ W->well_cells[i] ];
+
+                slot[0] = csrmatrix_elm_index(r1    , nc + w, A);
+                slot[1] = csrmatrix_elm_index(nc + w, r1    , A);
+            }
+        }
+    }
+}
+
+
 /* ---------------------------------------------------------------------- */
 /* fgrav = accumarray(cf(j), grav(j).*sgn(j), [nf, 1]) */
 /* ---------------------------------------------------------------------- */
@@ -232,18 +310,18 @@ assemble_bhp_well(int nc, int w,
     wdof  = nc + w;
     bhp   = well_controls_get_current_target(ctrls);
 
-    jw    = csrmatrix_elm_index(wdof, wdof, h->A);
+    jw    = h->pimpl->diag[ wdof ];
 
     for (i = W->well_connpos[w]; i < W->well_connpos[w + 1]; i++) {
 
         c     = W->well_cells  [ i ];
         trans = mt[ c ] * W->WI[ i ];
 
-        jc = csrmatrix_elm_index(c, c, h->A);
+        jc = h->pimpl->diag[ c ];
 
         /* c<->c diagonal contribution from well */
         h->A->sa[ jc   ] += trans;
-        h->b    [ c    ] += trans * (bhp + wdp[ i ]);
+        h->b    [ h->cell_row[c] ] += trans * (bhp + wdp[ i ]);
 
         /* w<->w diagonal contribution from well, trivial eqn. */
         h->A->sa[ jw   ] += trans;
@@ -271,15 +349,15 @@ assemble_rate_well(int nc, int w,
     wdof  = nc + w;
     resv  = well_controls_get_current_target(ctrls);
 
-    jww   = csrmatrix_elm_index(wdof, wdof, h->A);
+    jww   = h->pimpl->diag[ wdof ];
 
     for (i = W->well_connpos[w]; i < W->well_connpos[w + 1]; i++) {
 
         c   = W->well_cells[ i ];
 
-        jcc = csrmatrix_elm_index(c   , c   , h->A);
-        jcw = csrmatrix_elm_index(c   , wdof, h->A);
-        jwc = csrmatrix_elm_index(wdof, c   , h->A);
+        jcc = h->pimpl->diag [ c       ];
+        jcw = h->pimpl->wslot[ 2*i + 0 ];
+        jwc = h->pimpl->wslot[ 2*i + 1 ];
 
         /* Connection transmissibility */
         trans = mt[ c ] * W->WI[ i ];
@@ -287,7 +365,7 @@ assemble_rate_well(int nc, int w,
         /* c->w connection */
         h->A->sa[ jcc  ] += trans;
         h->A->sa[ jcw  ] -= trans;
-        h->b    [ c    ] += trans * wdp[ i ];
+        h->b    [ h->cell_row[c] ] += trans * wdp[ i ];
 
         /* w->c connection */
         h->A->sa[ jwc  ] -= trans;
@@ -326,7 +404,7 @@ assemble_shut_well(int nc, int w,
 
     wdof  = nc + w;
 
-    jw    = csrmatrix_elm_index(wdof, wdof, h->A);
+    jw    = h->pimpl->diag[ wdof ];
 
     for (i = W->well_connpos[w]; i < W->well_connpos[w + 1]; i++) {
 
@@ -448,7 +526,8 @@ assemble_bc_contrib(struct UnstructuredGrid             *G    ,
                 t  = trans[ f ];
                 s  = 2.0*is_outflow - 1.0;
                 c1 = is_outflow ? c1 : c2;
-                ix = csrmatrix_elm_index(c1, c1, h->A);
+                ix = h->pimpl->diag[ c1 ];
+                c1 = h->cell_row[ c1 ];
 
                 h->A->sa[ ix ] += t;
                 h->b    [ c1 ] += t * bc->value[ i ];
@@ -470,7 +549,7 @@ assemble_bc_contrib(struct UnstructuredGrid             *G    ,
                 c1 = (c1 >= 0) ? c1 : c2;
 
                 /* Interpret BC as flow *INTO* cell */
-                h->b[ c1 ] += bc->value[ i ];
+                h->b[ h->cell_row[c1] ] += bc->value[ i ];
             }
         }
 
@@ -592,11 +671,12 @@ assemble_incompressible(struct UnstructuredGrid      *G     ,
                         int                          *ok    )
 /* ---------------------------------------------------------------------- */
 {
-    int c1, c2, c, i, f, j1, j2;
+    int c1, c2, c, f;
 
     int res_is_neumann, wells_are_rate;
 
-    double s;
+    double     t, g;
+    const int *slot;
 
     *ok = 1;
     csrmatrix_zero(         h->A);
@@ -604,26 +684,23 @@ assemble_incompressible(struct UnstructuredGrid      *G     ,
 
     compute_grav_term(G, gpress, h->pimpl->fgrav);
 
-    for (c = i = 0; c < G->number_of_cells; c++) {
-        j1 = csrmatrix_elm_index(c, c, h->A);
-
-        for (; i < G->cell_facepos[c + 1]; i++) {
-            f = G->cell_faces[i];
-
-            c1 = G->face_cells[2*f + 0];
-            c2 = G->face_cells[2*f + 1];
-
-            s  = 2.0*(c1 == c) - 1.0;
-            c2 = (c1 == c) ? c2 : c1;
+    /* Single sweep over faces.  Gravity contributions vanish on
+     * boundary faces (see compute_grav_term()). */
+    for (f = 0, slot = h->pimpl->fslot; f < G->number_of_faces; f++, slot += 4) {
+        c1 = G->face_cells[2*f + 0];
+        c2 = G->face_cells[2*f + 1];
 
-            h->b[c] -= trans[f] * (s * h->pimpl->fgrav[f]);
+        if ((c1 >= 0) && (c2 >= 0)) {
+            t = trans[f];
+            g = t * h->pimpl->fgrav[f];
 
-            if (c2 >= 0) {
-                j2 = csrmatrix_elm_index(c, c2, h->A);
+            h->A->sa[ slot[0] ] += t;
+            h->A->sa[ slot[1] ] -= t;
+            h->A->sa[ slot[2] ] += t;
+            h->A->sa[ slot[3] ] -= t;
 
-                h->A->sa[j1] += trans[f];
-                h->A->sa[j2] -= trans[f];
-            }
+            h->b[ h->cell_row[c1] ] -= g;
+            h->b[ h->cell_row[c2] ] += g;
         }
     }
 
@@ -653,7 +730,7 @@ assemble_incompressible(struct UnstructuredGrid      *G     ,
         if (F->src != NULL) {
             /* Contributions from explicit source terms. */
             for (c = 0; c < G->number_of_cells; c++) {
-                h->b[c] += F->src[c];
+                h->b[ h->cell_row[c] ] += F->src[c];
             }
         }
     }
@@ -671,13 +748,34 @@ ifs_tpfa_construct(struct UnstructuredGrid *G,
                    struct Wells            *W)
 /* ---------------------------------------------------------------------- */
 {
+    return ifs_tpfa_construct_ordered(G, W, TPFA_NATURAL_ORDER);
+}
+
+
+/* ---------------------------------------------------------------------- */
+struct ifs_tpfa_data *
+ifs_tpfa_construct_ordered(struct UnstructuredGrid *G       ,
+                           struct Wells            *W       ,
+                           enum tpfa_cell_ordering  ordering)
+/* ---------------------------------------------------------------------- */
+{
+    size_t                nnu;
     struct ifs_tpfa_data *new;
 
     new = malloc(1 * sizeof *new);
 
     if (new != NULL) {
+        new->A     = NULL;
         new->pimpl = impl_allocate(G, W);
-        new->A     = ifs_tpfa_construct_matrix(G, W);
+
+        if (new->pimpl != NULL) {
+            new->cell_row = new->pimpl->idata;
+
+            /* Allocation failure falls back to natural ordering. */
+            cell_ordering_compute(G, ordering, new->cell_row);
+
+            new->A = ifs_tpfa_construct_matrix(G, W, new->cell_row);
+        }
 
         if ((new->pimpl == NULL) || (new->A == NULL)) {
             ifs_tpfa_destroy(new);
@@ -686,11 +784,20 @@ ifs_tpfa_construct(struct UnstructuredGrid *G,
     }
 
     if (new != NULL) {
+        nnu = new->A->m;
+
         new->b = new->pimpl->ddata;
-        new->x = new->b                       + new->A->m;
+        new->x = new->b                       + nnu;
 
-        new->pimpl->fgrav = new->x            + new->A->m;
+        new->pimpl->fgrav = new->x            + nnu;
         new->pimpl->work  = new->pimpl->fgrav + G->number_of_faces;
+        new->pimpl->pwork = new->pimpl->work  + nnu;
+
+        new->pimpl->diag  = new->cell_row     + G->number_of_cells;
+        new->pimpl->fslot = new->pimpl->diag  + nnu;
+        new->pimpl->wslot = new->pimpl->fslot + (4 * G->number_of_faces);
+
+        compute_matrix_slots(G, W, new);
     }
 
     return new;
@@ -748,12 +855,12 @@ ifs_tpfa_assemble_comprock(struct UnstructuredGrid      *G        ,
      */
     if (ok) {
         for (c = 0; c < G->number_of_cells; c++) {
-            j = csrmatrix_elm_index(c, c, h->A);
+            j = h->pimpl->diag[c];
 
             d = porevol[c] * rock_comp[c] / dt;
 
-            h->A->sa[j] += d;
-            h->b[c]     += d * pressure[c];
+            h->A->sa[j]             += d;
+            h->b[ h->cell_row[c] ] += d * pressure[c];
         }
     }
 
@@ -777,7 +884,7 @@ ifs_tpfa_assemble_comprock_increment(struct UnstructuredGrid      *G        ,
 {
     int     c, w, wdof, system_singular, ok;
     size_t  j;
-    double *v, dpvdt;
+    double *v, *p, dpvdt;
 
     ok = 1;
     assemble_incompressible(G, F, trans, gpress, h, &system_singular, &ok);
@@ -788,16 +895,25 @@ ifs_tpfa_assemble_comprock_increment(struct UnstructuredGrid      *G        ,
      */
 
     if (ok) {
+        /* Bring previous pressure into system ordering */
+        p = h->pimpl->pwork;
+        for (c = 0; c < G->number_of_cells; c++) {
+            p[ h->cell_row[c] ] = prev_pressure[c];
+        }
+        for (j = G->number_of_cells; j < h->A->m; j++) {
+            p[j] = prev_pressure[j];
+        }
+
         v = h->pimpl->work;
-        mult_csr_matrix(h->A, prev_pressure, v);
+        mult_csr_matrix(h->A, p, v);
 
         for (c = 0; c < G->number_of_cells; c++) {
-            j = csrmatrix_elm_index(c, c, h->A);
+            j = h->pimpl->diag[c];
 
             dpvdt = (porevol[c] - initial_porevolume[c]) / dt;
 
             h->A->sa[j] += porevol[c] * rock_comp[c] / dt;
-            h->b[c]     -= dpvdt + v[c];
+            h->b[ h->cell_row[c] ] -= dpvdt + v[ h->cell_row[c] ];
         }
 
         if (F->W != NULL) {
@@ -822,7 +938,7 @@ ifs_tpfa_press_flux(struct UnstructuredGrid      *G    ,
                     struct ifs_tpfa_solution     *soln )
 /* ---------------------------------------------------------------------- */
 {
-    int    c1, c2, f;
+    int    c, c1, c2, f;
     double dh;
 
     double *cpress, *fflux;
@@ -834,8 +950,10 @@ ifs_tpfa_press_flux(struct UnstructuredGrid      *G    ,
     cpress = soln->cell_press;
     fflux  = soln->face_flux ;
 
-    /* Assign cell pressure directly from solution vector */
-    memcpy(cpress, h->x, G->number_of_cells * sizeof *cpress);
+    /* Assign cell pressure from solution vector */
+    for (c = 0; c < G->number_of_cells; c++) {
+        cpress[c] = h->x[ h->cell_row[c] ];
+    }
 
     for (f = 0; f < G->number_of_faces; f++) {
         c1 = G->face_cells[2*f + 0];
@@ -187,6 +187,7 @@ namespace Opm
         virtual  void swatInitScaling(const int cell,
                                       const double pcow, 
                                       double & swat);
+        using BlackoilPropertiesInterface::swatInitScaling;
 
 
     private:
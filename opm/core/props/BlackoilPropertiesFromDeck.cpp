@@ -50,11 +50,8 @@ namespace Opm
                                                            const ParameterGroup& param,
                                                            bool init_rock)
     {
-        std::vector<int> compressedToCartesianIdx
-            = compressedToCartesian(grid.number_of_cells, grid.global_cell);
-
-        auto materialLawManager = std::make_shared<MaterialLawManager>();
-        materialLawManager->initFromDeck(deck, eclState, compressedToCartesianIdx);
+        auto materialLawManager = makeMaterialLawManager_(deck, eclState, grid.number_of_cells,
+                                                          grid.global_cell, param);
 
         init(deck, eclState, materialLawManager, grid.number_of_cells, grid.global_cell, grid.cartdims, param, init_rock);
     }
@@ -84,11 +81,8 @@ namespace Opm
                                                            const ParameterGroup& param,
                                                            bool init_rock)
     {
-        std::vector<int> compressedToCartesianIdx
-            = compressedToCartesian(number_of_cells, global_cell);
-
-        auto materialLawManager = std::make_shared<MaterialLawManager>();
-        materialLawManager->initFromDeck(deck, eclState, compressedToCartesianIdx);
+        auto materialLawManager = makeMaterialLawManager_(deck, eclState, number_of_cells,
+                                                          global_cell, param);
 
         init(deck,
              eclState,
@@ -139,10 +133,16 @@ namespace Opm
         oilPvt_.initFromDeck(deck, eclState);
         gasPvt_.initFromDeck(deck, eclState);
         waterPvt_.initFromDeck(deck, eclState);
+        if (!materialLawManager) {
+            OPM_THROW(std::runtime_error, "BlackoilPropertiesFromDeck::init() -- no material law manager given.");
+        }
         SaturationPropsFromDeck* ptr
             = new SaturationPropsFromDeck();
         ptr->init(phaseUsageFromDeck(deck), materialLawManager);
-        satprops_.reset(ptr);
+        // CompressibleTpfa and the mobility helpers ask for all cells.
+        ptr->cacheAllCellsGrouping(number_of_cells);
+        satpropsState_->satprops.reset(ptr);
+        satpropsState_->ready.store(true, std::memory_order_release);
     }
 
     inline void BlackoilPropertiesFromDeck::init(const Opm::Deck& deck,
@@ -174,10 +174,77 @@ namespace Opm
             OPM_THROW(std::runtime_error, "Sorry, end point scaling currently available for the 'gwseg' model only.");
         }
 
-        SaturationPropsFromDeck* ptr
-            = new SaturationPropsFromDeck();
-        ptr->init(phaseUsageFromDeck(deck), materialLawManager);
-        satprops_.reset(ptr);
+        if (materialLawManager) {
+            SaturationPropsFromDeck* ptr
+                = new SaturationPropsFromDeck();
+            ptr->init(phaseUsageFromDeck(deck), materialLawManager);
+            // CompressibleTpfa and the mobility helpers ask for all cells.
+            ptr->cacheAllCellsGrouping(number_of_cells);
+            satpropsState_->satprops.reset(ptr);
+            satpropsState_->ready.store(true, std::memory_order_release);
+        } else if (satpropsState_->materialLawFactory) {
+            satpropsState_->numCells = number_of_cells;
+        } else {
+            OPM_THROW(std::runtime_error, "BlackoilPropertiesFromDeck::init() -- no material law manager given.");
+        }
+    }
+
+    std::shared_ptr<BlackoilPropertiesFromDeck::MaterialLawManager>
+    BlackoilPropertiesFromDeck::makeMaterialLawManager_(const Opm::Deck& deck,
+                                                        const Opm::EclipseState& eclState,
+                                                        int number_of_cells,
+                                                        const int* global_cell,
+                                                        const ParameterGroup& param)
+    {
+        std::vector<int> compressedToCartesianIdx
+            = compressedToCartesian(number_of_cells, global_cell);
+
+        if (param.getDefault("lazy_material_laws", false)) {
+            // Only the references to the deck and the cell mapping are
+            // kept; the per-cell parameters are built by satprops().
+            const Opm::Deck* deckPtr = &deck;
+            const Opm::EclipseState* eclStatePtr = &eclState;
+            satpropsState_->materialLawFactory = [deckPtr, eclStatePtr, compressedToCartesianIdx]()
+            {
+                auto materialLawManager = std::make_shared<MaterialLawManager>();
+                materialLawManager->initFromDeck(*deckPtr, *eclStatePtr, compressedToCartesianIdx);
+                return materialLawManager;
+            };
+            return std::shared_ptr<MaterialLawManager>();
+        }
+
+        auto materialLawManager = std::make_shared<MaterialLawManager>();
+        materialLawManager->initFromDeck(deck, eclState, compressedToCartesianIdx);
+        return materialLawManager;
+    }
+
+    SaturationPropsFromDeck& BlackoilPropertiesFromDeck::satprops() const
+    {
+        SatpropsState& state = *satpropsState_;
+        if (state.materialLawFactory) {
+            std::call_once(state.initialized, [this, &state]()
+            {
+                std::shared_ptr<SaturationPropsFromDeck> ptr(new SaturationPropsFromDeck());
+                ptr->init(phaseUsage_, state.materialLawFactory());
+                ptr->cacheAllCellsGrouping(state.numCells);
+                state.satprops = ptr;
+                state.ready.store(true, std::memory_order_release);
+            });
+        }
+        return *state.satprops;
+    }
+
+    bool BlackoilPropertiesFromDeck::materialLawsInitialized() const
+    {
+        return satpropsState_->ready.load(std::memory_order_acquire);
+    }
+
+    void BlackoilPropertiesFromDeck::writeMaterialLawReport(std::ostream& os) const
+    {
+        const int nc = cellPvtRegionIdx_.size();
+        std::vector<int> cells(nc);
+        std::iota(cells.begin(), cells.end(), 0);
+        SaturationPropsFromDeck::writeSharingReport(satprops().parameterSharing(nc, cells.data()), os);
     }
 
     BlackoilPropertiesFromDeck::~BlackoilPropertiesFromDeck()
@@ -733,7 +800,7 @@ namespace Opm
                                              double* kr,
                                              double* dkrds) const
     {
-        satprops_->relperm(n, s, cells, kr, dkrds);
+        satprops().relperm(n, s, cells, kr, dkrds);
     }
 
 
@@ -752,7 +819,7 @@ namespace Opm
                                               double* pc,
                                               double* dpcds) const
     {
-        satprops_->capPress(n, s, cells, pc, dpcds);
+        satprops().capPress(n, s, cells, pc, dpcds);
     }
 
 
@@ -768,7 +835,7 @@ namespace Opm
                                               double* smin,
                                               double* smax) const
     {
-        satprops_->satRange(n, cells, smin, smax);
+        satprops().satRange(n, cells, smin, smax);
     }
 
 
@@ -780,7 +847,20 @@ namespace Opm
                                                      const double pcow,
                                                      double & swat)
     {
-        satprops_->swatInitScaling(cell, pcow, swat);
+        satprops().swatInitScaling(cell, pcow, swat);
+    }
+
+    /// Batched version of swatInitScaling().
+    /// \param[in]     n      Number of cells.
+    /// \param[in]     cells  Array of n cell indices, each occurring only once.
+    /// \param[in]     pcow   Array of n values of P_oil - P_water.
+    /// \param[in/out] swat   Array of n water saturations, possibly modified on return.
+    void BlackoilPropertiesFromDeck::swatInitScaling(const int n,
+                                                     const int* cells,
+                                                     const double* pcow,
+                                                     double* swat)
+    {
+        satprops().swatInitScaling(n, cells, pcow, swat);
     }
 
 } // namespace Opm
@@ -31,7 +31,11 @@
 
 #include <opm/parser/eclipse/Deck/Deck.hpp>
 
+#include <atomic>
+#include <functional>
+#include <iosfwd>
 #include <memory>
+#include <mutex>
 
 struct UnstructuredGrid;
 
@@ -63,6 +67,9 @@ namespace Opm
         ///                        pvt_tab_size (200)          number of uniform sample points for dead-oil pvt tables.
         ///                        sat_tab_size (200)          number of uniform sample points for saturation tables.
         ///                        threephase_model("simple")  three-phase relperm model (accepts "simple" and "stone2").
+        ///                        lazy_material_laws (false)  defer building the material law parameters
+        ///                                                    until saturation functions are first evaluated.
+        ///                                                    The deck and eclState must then outlive this object.
         ///                      For both size parameters, a 0 or negative value indicates that no spline fitting is to
         ///                      be done, and the input fluid data used directly for linear interpolation.
         BlackoilPropertiesFromDeck(const Opm::Deck& deck,
@@ -98,6 +105,16 @@ namespace Opm
         /// Destructor.
         virtual ~BlackoilPropertiesFromDeck();
 
+        /// True if the material law parameters have been built.  Only
+        /// false if lazy_material_laws was requested and no saturation
+        /// function has been evaluated yet.
+        bool materialLawsInitialized() const;
+
+        /// Write a summary of the memory used by the material law
+        /// parameters of all cells and of how much of it could be
+        /// shared between cells.  Builds the parameters if necessary.
+        void writeMaterialLawReport(std::ostream& os) const;
+
 
         // ---- Rock interface ----
 
@@ -235,6 +252,20 @@ namespace Opm
                                       const double pcow, 
                                       double & swat);
 
+        /// Batched version of swatInitScaling(), evaluated in parallel.
+        /// The scaling is stored in the material law manager, so it is
+        /// shared with every object holding that manager, for instance
+        /// the simulator run that follows the initialization.
+        /// \param[in]     n      Number of cells.
+        /// \param[in]     cells  Array of n cell indices, each occurring only once.
+        /// \param[in]     pcow   Array of n values of P_oil - P_water.
+        /// \param[in/out] swat   Array of n water saturations, possibly
+        ///                       modified on return.
+        virtual void swatInitScaling(const int n,
+                                     const int* cells,
+                                     const double* pcow,
+                                     double* swat);
+
         const OilPvtMultiplexer<double>& oilPvt() const
         {
             return oilPvt_;
@@ -307,6 +338,18 @@ namespace Opm
                   const ParameterGroup& param,
                   bool init_rock);
 
+        // Constructor helper: builds the material law manager now, or
+        // arranges for it to be built on first use if requested in param.
+        std::shared_ptr<MaterialLawManager>
+        makeMaterialLawManager_(const Opm::Deck& deck,
+                                const Opm::EclipseState& eclState,
+                                int number_of_cells,
+                                const int* global_cell,
+                                const ParameterGroup& param);
+
+        // Saturation functions, built here if construction was deferred.
+        SaturationPropsFromDeck& satprops() const;
+
         RockFromDeck rock_;
         PhaseUsage phaseUsage_;
         std::vector<int> cellPvtRegionIdx_;
@@ -314,7 +357,22 @@ namespace Opm
         GasPvtMultiplexer<double> gasPvt_;
         WaterPvtMultiplexer<double> waterPvt_;
         std::shared_ptr<MaterialLawManager> materialLawManager_;
-        std::shared_ptr<SaturationPropsInterface> satprops_;
+
+        // The saturation functions and, if their construction is
+        // deferred, what is needed to build them.  Held through a
+        // shared_ptr, so that the class stays copyable and copies share
+        // the saturation functions, built or not.
+        struct SatpropsState
+        {
+            std::shared_ptr<SaturationPropsFromDeck> satprops;
+            // Non-empty if the material law parameters are built on first use.
+            std::function<std::shared_ptr<MaterialLawManager>()> materialLawFactory;
+            int numCells = 0;
+            std::once_flag initialized;
+            // Set once satprops is built, may be read from any thread.
+            std::atomic<bool> ready{ false };
+        };
+        std::shared_ptr<SatpropsState> satpropsState_ = std::make_shared<SatpropsState>();
         std::vector<double> surfaceDensities_;
         mutable std::vector<double> B_;
         mutable std::vector<double> dB_;
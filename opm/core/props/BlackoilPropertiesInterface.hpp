@@ -174,6 +174,23 @@ namespace Opm
                                       const double pcow, 
                                       double & swat) = 0;
 
+        /// Batched version of swatInitScaling(), for instance for all
+        /// cells of an equilibration region.
+        /// \param[in]     n      Number of cells.
+        /// \param[in]     cells  Array of n cell indices, each occurring only once.
+        /// \param[in]     pcow   Array of n values of P_oil - P_water.
+        /// \param[in/out] swat   Array of n water saturations, possibly
+        ///                       modified on return.
+        virtual void swatInitScaling(const int n,
+                                     const int* cells,
+                                     const double* pcow,
+                                     double* swat)
+        {
+            for (int i = 0; i < n; ++i) {
+                swatInitScaling(cells[i], pcow[i], swat[i]);
+            }
+        }
+
     };
 
 
@@ -47,6 +47,8 @@ namespace Opm
         materialLawManager->initFromDeck(deck, eclState, compressedToCartesianIdx);
 
         satprops_.init(deck, materialLawManager);
+        // The solvers mostly ask for all cells at once.
+        satprops_.cacheAllCellsGrouping(grid.number_of_cells);
         if (pvt_.numPhases() != satprops_.numPhases()) {
             OPM_THROW(std::runtime_error, "IncompPropertiesFromDeck::IncompPropertiesFromDeck() - Inconsistent number of phases in pvt data ("
                   << pvt_.numPhases() << ") and saturation-dependent function data (" << satprops_.numPhases() << ").");
@@ -0,0 +1,156 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_REGION_TEMPERATURE_TABLE_HPP
+#define OPM_REGION_TEMPERATURE_TABLE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+    /// Piecewise linear functions of temperature, one per PVT region,
+    /// stored in flat arrays.  The tables of all regions are copied out
+    /// of the deck tables once, so evaluation involves neither column
+    /// name lookups nor table container accesses.  Outside the range
+    /// of the sampled temperatures the functions are extrapolated as
+    /// constants, like SimpleTable::evaluate() does.
+    class RegionTemperatureTable
+    {
+    public:
+        RegionTemperatureTable()
+            : start_(1, 0)
+        {}
+
+        /// Append the table of the next region.
+        /// \param[in] table   Deck table with a "Temperature" column.
+        /// \param[in] column  Name of the column holding the function values.
+        /// \param[in] scale   Factor applied to all function values.
+        template <class Table>
+        void addRegion(const Table& table,
+                       const std::string& column,
+                       const double scale = 1.0)
+        {
+            const auto& temp = table.getColumn("Temperature");
+            const auto& val = table.getColumn(column);
+            assert(temp.size() == val.size());
+            assert(temp.size() > 0);
+
+            for (size_t row = 0; row < temp.size(); ++row) {
+                temp_.push_back(temp[row]);
+                value_.push_back(scale*val[row]);
+            }
+            start_.push_back(static_cast<int>(temp_.size()));
+        }
+
+        /// Number of regions added so far.
+        int numRegions() const
+        {
+            return static_cast<int>(start_.size()) - 1;
+        }
+
+        /// True if no region has been added.
+        bool empty() const
+        {
+            return numRegions() == 0;
+        }
+
+        /// Evaluate the function of a single region.
+        double evaluate(const int region, const double T) const
+        {
+            return evaluate_(start_[region], start_[region + 1], T);
+        }
+
+        /// Evaluate the functions for a batch of elements and pass
+        /// each result to op(i, value).  Elements are processed one
+        /// region at a time, such that only a single table is live in
+        /// the inner loop.
+        /// \param[in] n          Number of elements.
+        /// \param[in] regionIdx  Region of each element, all elements are
+        ///                       in region 0 if null.
+        /// \param[in] T          Temperature of each element.
+        /// \param[in] op         Callable with signature void(int, double).
+        template <class Op>
+        void forEach(const int n,
+                     const int* regionIdx,
+                     const double* T,
+                     Op op) const
+        {
+            const int nreg = numRegions();
+
+            if (regionIdx == 0 || nreg == 1) {
+                for (int i = 0; i < n; ++i) {
+                    op(i, evaluate_(start_[0], start_[1], T[i]));
+                }
+                return;
+            }
+
+            // Group the elements by region (counting sort).
+            std::vector<int> pos(nreg + 1, 0);
+            for (int i = 0; i < n; ++i) {
+                assert(regionIdx[i] >= 0 && regionIdx[i] < nreg);
+                ++pos[regionIdx[i] + 1];
+            }
+            for (int r = 0; r < nreg; ++r) {
+                pos[r + 1] += pos[r];
+            }
+            std::vector<int> order(n);
+            {
+                std::vector<int> next(pos.begin(), pos.end() - 1);
+                for (int i = 0; i < n; ++i) {
+                    order[next[regionIdx[i]]++] = i;
+                }
+            }
+
+            for (int r = 0; r < nreg; ++r) {
+                const int begin = start_[r];
+                const int end = start_[r + 1];
+                for (int k = pos[r]; k < pos[r + 1]; ++k) {
+                    const int i = order[k];
+                    op(i, evaluate_(begin, end, T[i]));
+                }
+            }
+        }
+
+    private:
+        double evaluate_(const int begin, const int end, const double T) const
+        {
+            const double* t = temp_.data();
+            if (T <= t[begin]) {
+                return value_[begin];
+            }
+            if (T >= t[end - 1]) {
+                return value_[end - 1];
+            }
+            const int hi = static_cast<int>(std::upper_bound(t + begin, t + end, T) - t);
+            const int lo = hi - 1;
+            const double w = (T - t[lo]) / (t[hi] - t[lo]);
+            return (1.0 - w)*value_[lo] + w*value_[hi];
+        }
+
+        std::vector<double> temp_;
+        std::vector<double> value_;
+        std::vector<int> start_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_REGION_TEMPERATURE_TABLE_HPP
@@ -21,6 +21,7 @@
 #define OPM_THERMAL_OIL_PVT_WRAPPER_HPP
 
 #include <opm/core/props/pvt/PvtInterface.hpp>
+#include <opm/core/props/pvt/RegionTemperatureTable.hpp>
 #include <opm/common/ErrorMacros.hpp>
 
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
@@ -60,10 +61,10 @@ namespace Opm
 
             // viscosity
             if (deck->hasKeyword("VISCREF")) {
-                oilvisctTables_ = &tables->getOilvisctTables();
+                const auto& oilvisctTables = tables->getOilvisctTables();
                 const auto& viscrefKeyword = deck->getKeyword("VISCREF");
 
-                assert(int(oilvisctTables_->size()) == numRegions);
+                assert(int(oilvisctTables.size()) == numRegions);
                 assert(int(viscrefKeyword.size()) == numRegions);
 
                 viscrefPress_.resize(numRegions);
@@ -89,6 +90,11 @@ namespace Opm
                                        &muRef_[regionIdx],
                                        &tmp1,
                                        &tmp2);
+
+                    // the table is stored as the ratio to the reference
+                    // viscosity, i.e., the multiplier of the isothermal one.
+                    oilvisct_.addRegion(oilvisctTables.getTable<OilvisctTable>(regionIdx),
+                                        "Viscosity", 1.0/muRef_[regionIdx]);
                 }
             }
 
@@ -113,7 +119,7 @@ namespace Opm
                         const double* z,
                         double* output_mu) const
         {
-            if (oilvisctTables_)
+            if (!oilvisct_.empty())
                 // TODO: temperature dependence for viscosity depending on z
                 OPM_THROW(std::runtime_error,
                           "temperature dependent viscosity as a function of z "
@@ -135,31 +141,20 @@ namespace Opm
             // compute the isothermal viscosity and its derivatives
             isothermalPvt_->mu(n, pvtRegionIdx, p, T, r, output_mu, output_dmudp, output_dmudr);
 
-            if (!oilvisctTables_)
+            if (oilvisct_.empty())
                 // isothermal case
                 return;
 
-            // temperature dependence
-            for (int i = 0; i < n; ++i) {
-                int regionIdx = getPvtRegionIndex_(pvtRegionIdx, i);
-
-                // calculate the viscosity of the isothermal keyword for the reference
-                // pressure given by the VISCREF keyword.
-                double muRef = muRef_[regionIdx];
-
-                // compute the viscosity deviation due to temperature
-                double alpha;
-                {
-                    const OilvisctTable& oilvisctTable = oilvisctTables_->getTable<OilvisctTable>(regionIdx);
-                    double muOilvisct = oilvisctTable.evaluate("Viscosity", T[i]);
-                    alpha = muOilvisct/muRef;
-                }
-
-                output_mu[i] *= alpha;
-                output_dmudp[i] *= alpha;
-                output_dmudr[i] *= alpha;
-                // TODO (?): derivative of viscosity w.r.t. temperature.
-            }
+            // temperature dependence. the precompiled tables directly yield the
+            // viscosity deviation due to temperature relative to the viscosity of the
+            // isothermal keyword at the reference pressure given by VISCREF.
+            oilvisct_.forEach(n, pvtRegionIdx, T,
+                              [&](int i, double alpha) {
+                                  output_mu[i] *= alpha;
+                                  output_dmudp[i] *= alpha;
+                                  output_dmudr[i] *= alpha;
+                                  // TODO (?): derivative of viscosity w.r.t. temperature.
+                              });
         }
 
         virtual void mu(const int n,
@@ -175,30 +170,20 @@ namespace Opm
             // compute the isothermal viscosity and its derivatives
             isothermalPvt_->mu(n, pvtRegionIdx, p, T, r, cond, output_mu, output_dmudp, output_dmudr);
 
-            if (!oilvisctTables_)
+            if (oilvisct_.empty())
                 // isothermal case
                 return;
 
-            // temperature dependence
-            for (int i = 0; i < n; ++i) {
-                int regionIdx = getPvtRegionIndex_(pvtRegionIdx, i);
-
-                // calculate the viscosity of the isothermal keyword for the reference
-                // pressure given by the VISCREF keyword.
-                double muRef = muRef_[regionIdx];
-
-                // compute the viscosity deviation due to temperature
-                double alpha;
-                {
-                    const OilvisctTable& oilvisctTable = oilvisctTables_->getTable<OilvisctTable>(regionIdx);
-                    double muOilvisct = oilvisctTable.evaluate("Viscosity", T[i]);
-                    alpha = muOilvisct/muRef;
-                }
-                output_mu[i] *= alpha;
-                output_dmudp[i] *= alpha;
-                output_dmudr[i] *= alpha;
-                // TODO (?): derivative of viscosity w.r.t. temperature.
-            }
+            // temperature dependence. the precompiled tables directly yield the
+            // viscosity deviation due to temperature relative to the viscosity of the
+            // isothermal keyword at the reference pressure given by VISCREF.
+            oilvisct_.forEach(n, pvtRegionIdx, T,
+                              [&](int i, double alpha) {
+                                  output_mu[i] *= alpha;
+                                  output_dmudp[i] *= alpha;
+                                  output_dmudr[i] *= alpha;
+                                  // TODO (?): derivative of viscosity w.r.t. temperature.
+                              });
         }
 
         virtual void B(const int n,
@@ -359,13 +344,6 @@ namespace Opm
         }
 
     private:
-        int getPvtRegionIndex_(const int* pvtRegionIdx, int cellIdx) const
-        {
-            if (!pvtRegionIdx)
-                return 0;
-            return pvtRegionIdx[cellIdx];
-        }
-
         // the PVT propertied for the isothermal case
         std::shared_ptr<const PvtInterface> isothermalPvt_;
 
@@ -375,7 +353,9 @@ namespace Opm
         std::vector<double> viscrefRs_;
         std::vector<double> muRef_;
 
-        const TableContainer* oilvisctTables_;
+        // OILVISCT tables of all PVT regions divided by muRef_, empty in the
+        // isothermal case.
+        RegionTemperatureTable oilvisct_;
 
         // The PVT properties needed for temperature dependence of the density. This is
         // specified as one value per EOS in the manual, but we unconditionally use the
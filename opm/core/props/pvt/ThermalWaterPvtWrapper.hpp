@@ -21,6 +21,7 @@
 #define OPM_THERMAL_WATER_PVT_WRAPPER_HPP
 
 #include <opm/core/props/pvt/PvtInterface.hpp>
+#include <opm/core/props/pvt/RegionTemperatureTable.hpp>
 #include <opm/common/ErrorMacros.hpp>
 
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
@@ -45,7 +46,7 @@ namespace Opm
                           const Opm::EclipseState& eclipseState)
         {
             isothermalPvt_ = isothermalPvt;
-            watvisctTables_ = 0;
+            watvisct_ = RegionTemperatureTable();
 
             // stuff which we need to get from the PVTW keyword
             const auto& pvtwKeyword = deck->getKeyword("PVTW");
@@ -67,10 +68,10 @@ namespace Opm
             // (basically we expect well-behaved VISCREF and WATVISCT keywords.)
             if (deck->hasKeyword("VISCREF")) {
                 auto tables = eclipseState->getTableManager();
-                watvisctTables_ = &tables->getWatvisctTables();
+                const auto& watvisctTables = tables->getWatvisctTables();
                 const auto& viscrefKeyword = deck->getKeyword("VISCREF");
 
-                assert(int(watvisctTables_->size()) == numRegions);
+                assert(int(watvisctTables.size()) == numRegions);
                 assert(int(viscrefKeyword.size()) == numRegions);
 
                 viscrefPress_.resize(numRegions);
@@ -78,6 +79,15 @@ namespace Opm
                     const auto& viscrefRecord = viscrefKeyword.getRecord(regionIdx);
 
                     viscrefPress_[regionIdx] = viscrefRecord.getItem("REFERENCE_PRESSURE").getSIDouble(0);
+
+                    // calculate the viscosity of the isothermal keyword for the
+                    // reference pressure given by the VISCREF keyword and store the
+                    // table as the ratio to it.
+                    double x = -pvtwViscosibility_[regionIdx]*(viscrefPress_[regionIdx] - pvtwRefPress_[regionIdx]);
+                    double muRef = pvtwViscosity_[regionIdx]/(1.0 + x + 0.5*x*x);
+
+                    watvisct_.addRegion(watvisctTables.getTable<WatvisctTable>(regionIdx),
+                                        "Viscosity", 1.0/muRef);
                 }
             }
 
@@ -107,7 +117,7 @@ namespace Opm
                         const double* z,
                         double* output_mu) const
         {
-            if (watvisctTables_)
+            if (!watvisct_.empty())
                 // TODO: temperature dependence for viscosity depending on z
                 OPM_THROW(std::runtime_error,
                           "temperature dependent viscosity as a function of z "
@@ -129,32 +139,19 @@ namespace Opm
             // compute the isothermal viscosity and its derivatives
             isothermalPvt_->mu(n, pvtRegionIdx, p, T, r, output_mu, output_dmudp, output_dmudr);
 
-            if (!watvisctTables_)
+            if (watvisct_.empty())
                 // isothermal case
                 return;
 
-            // temperature dependence
-            for (int i = 0; i < n; ++i) {
-                int tableIdx = getTableIndex_(pvtRegionIdx, i);
-
-                // calculate the viscosity of the isothermal keyword for the reference
-                // pressure given by the VISCREF keyword.
-                double x = -pvtwViscosibility_[tableIdx]*(viscrefPress_[tableIdx] - pvtwRefPress_[tableIdx]);
-                double muRef = pvtwViscosity_[tableIdx]/(1.0 + x + 0.5*x*x);
-
-                // compute the viscosity deviation due to temperature
-                double alpha;
-                {
-                    const WatvisctTable& watVisctTable = watvisctTables_->getTable<WatvisctTable>(tableIdx);
-                    double muWatvisct = watVisctTable.evaluate("Viscosity", T[i]);
-                    alpha = muWatvisct/muRef;
-                }
-
-                output_mu[i] *= alpha;
-                output_dmudp[i] *= alpha;
-                output_dmudr[i] *= alpha;
-                // TODO (?): derivative of viscosity w.r.t. temperature.
-            }
+            // temperature dependence. the precompiled tables directly yield the
+            // viscosity deviation due to temperature.
+            watvisct_.forEach(n, pvtRegionIdx, T,
+                              [&](int i, double alpha) {
+                                  output_mu[i] *= alpha;
+                                  output_dmudp[i] *= alpha;
+                                  output_dmudr[i] *= alpha;
+                                  // TODO (?): derivative of viscosity w.r.t. temperature.
+                              });
         }
 
         virtual void mu(const int n,
@@ -170,31 +167,19 @@ namespace Opm
             // compute the isothermal viscosity and its derivatives
             isothermalPvt_->mu(n, pvtRegionIdx, p, T, r, cond, output_mu, output_dmudp, output_dmudr);
 
-            if (!watvisctTables_)
+            if (watvisct_.empty())
                 // isothermal case
                 return;
 
-            // temperature dependence
-            for (int i = 0; i < n; ++i) {
-                int tableIdx = getTableIndex_(pvtRegionIdx, i);
-
-                // calculate the viscosity of the isothermal keyword for the reference
-                // pressure given by the VISCREF keyword.
-                double x = -pvtwViscosibility_[tableIdx]*(viscrefPress_[tableIdx] - pvtwRefPress_[tableIdx]);
-                double muRef = pvtwViscosity_[tableIdx]/(1.0 + x + 0.5*x*x);
-
-                // compute the viscosity deviation due to temperature
-                double alpha;
-                {
-                    const WatvisctTable& watVisctTable = watvisctTables_->getTable<WatvisctTable>(tableIdx);
-                    double muWatvisct = watVisctTable.evaluate("Viscosity", T[i]);
-                    alpha = muWatvisct/muRef;
-                }
-                output_mu[i] *= alpha;
-                output_dmudp[i] *= alpha;
-                output_dmudr[i] *= alpha;
-                // TODO (?): derivative of viscosity w.r.t. temperature.
-            }
+            // temperature dependence. the precompiled tables directly yield the
+            // viscosity deviation due to temperature.
+            watvisct_.forEach(n, pvtRegionIdx, T,
+                              [&](int i, double alpha) {
+                                  output_mu[i] *= alpha;
+                                  output_dmudp[i] *= alpha;
+                                  output_dmudr[i] *= alpha;
+                                  // TODO (?): derivative of viscosity w.r.t. temperature.
+                              });
         }
 
         virtual void B(const int n,
@@ -390,7 +375,9 @@ namespace Opm
         std::vector<double> pvtwViscosity_;
         std::vector<double> pvtwViscosibility_;
 
-        const TableContainer* watvisctTables_;
+        // WATVISCT tables of all PVT regions divided by the reference viscosity,
+        // empty in the isothermal case.
+        RegionTemperatureTable watvisct_;
     };
 
 }
@@ -25,118 +25,285 @@
 #include <opm/common/OpmLog/OpmLog.hpp>
 #include <opm/core/utility/linearInterpolation.hpp>
 
+#include <opm/parser/eclipse/EclipseState/Grid/EclipseGrid.hpp>
 #include <opm/parser/eclipse/EclipseState/Tables/RocktabTable.hpp>
 #include <opm/parser/eclipse/EclipseState/Tables/TableManager.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <iostream>
 
 namespace Opm
 {
 
-    RockCompressibility::RockCompressibility(const ParameterGroup& param)
+    namespace
+    {
+        // Cartesian index of each active cell of the input grid.
+        std::vector<int> activeGlobalCells(const EclipseGrid& grid)
+        {
+            std::vector<int> global_cell(grid.getNumActive());
+            for (size_t i = 0; i < global_cell.size(); ++i) {
+                global_cell[i] = grid.getGlobalIndex(i);
+            }
+            return global_cell;
+        }
+    } // anonymous namespace
+
+    RockCompressibility::Region::Region()
         : pref_(0.0),
-          rock_comp_(0.0)
+          rock_comp_(0.0),
+          uniform_(false),
+          inv_dp_(0.0)
+    {
+    }
+
+    int RockCompressibility::Region::interval(const double p) const
+    {
+        const int last = static_cast<int>(p_.size()) - 2;
+        if (p <= p_[0]) {
+            return 0;
+        }
+        if (p >= p_[last + 1]) {
+            return last;
+        }
+        if (uniform_) {
+            return std::min(static_cast<int>((p - p_[0])*inv_dp_), last);
+        }
+        return static_cast<int>(std::upper_bound(p_.begin(), p_.end(), p) - p_.begin()) - 1;
+    }
+
+    void RockCompressibility::Region::poroMult(const double p, double& mult, double& dmultdp) const
+    {
+        if (p_.empty()) {
+            // Approximating with a quadratic curve.
+            const double cpnorm = rock_comp_*(p - pref_);
+            mult = 1.0 + cpnorm + 0.5*cpnorm*cpnorm;
+            dmultdp = rock_comp_ + cpnorm*rock_comp_;
+        } else if (p_.size() == 1) {
+            mult = poromult_[0];
+            dmultdp = 0.0;
+        } else {
+            const int i = interval(p);
+            dmultdp = (poromult_[i + 1] - poromult_[i])/(p_[i + 1] - p_[i]);
+            mult = dmultdp*(p - p_[i]) + poromult_[i];
+        }
+    }
+
+    void RockCompressibility::Region::setUniform()
+    {
+        uniform_ = false;
+        const int n = p_.size();
+        if (n < 3) {
+            return;
+        }
+        const double dp = (p_[n - 1] - p_[0])/(n - 1);
+        for (int i = 1; i < n; ++i) {
+            if (std::fabs(p_[i] - (p_[0] + i*dp)) > 1e-12*std::fabs(dp)*n) {
+                return;
+            }
+        }
+        uniform_ = true;
+        inv_dp_ = 1.0/dp;
+    }
+
+
+
+    RockCompressibility::RockCompressibility(const ParameterGroup& param)
+        : regions_(1)
     {
-        pref_ = param.getDefault("rock_compressibility_pref", 100.0)*unit::barsa;
-        rock_comp_ = param.getDefault("rock_compressibility", 0.0)/unit::barsa;
+        regions_[0].pref_ = param.getDefault("rock_compressibility_pref", 100.0)*unit::barsa;
+        regions_[0].rock_comp_ = param.getDefault("rock_compressibility", 0.0)/unit::barsa;
     }
 
     RockCompressibility::RockCompressibility(const Opm::EclipseState& eclipseState,
                                              const bool is_io_rank)
-        : pref_(0.0),
-          rock_comp_(0.0)
+        : RockCompressibility(eclipseState,
+                              eclipseState.getInputGrid().getNumActive(),
+                              activeGlobalCells(eclipseState.getInputGrid()).data(),
+                              is_io_rank)
+    {
+    }
+
+    RockCompressibility::RockCompressibility(const Opm::EclipseState& eclipseState,
+                                             const int number_of_cells,
+                                             const int* global_cell,
+                                             const bool is_io_rank)
     {
         const auto& tables = eclipseState.getTableManager();
         const auto& rocktabTables = tables.getRocktabTables();
         if (rocktabTables.size() > 0) {
-            const auto& rocktabTable = rocktabTables.getTable<RocktabTable>(0);
-            if (rocktabTables.size() != 1)
-                OPM_THROW(std::runtime_error, "Can only handle a single region in ROCKTAB.");
-
-            p_ = rocktabTable.getColumn("PO").vectorCopy( );
-            poromult_ = rocktabTable.getColumn("PV_MULT").vectorCopy();
-            if (rocktabTable.hasColumn("PV_MULT_TRAN")) {
-                transmult_ =  rocktabTable.getColumn("PV_MULT_TRAN").vectorCopy();
-            } else {
-                transmult_ =  rocktabTable.getColumn("PV_MULT_TRANX").vectorCopy();
+            regions_.resize(rocktabTables.size());
+            for (size_t r = 0; r < rocktabTables.size(); ++r) {
+                const auto& rocktabTable = rocktabTables.getTable<RocktabTable>(r);
+                Region& region = regions_[r];
+                region.p_ = rocktabTable.getColumn("PO").vectorCopy( );
+                region.poromult_ = rocktabTable.getColumn("PV_MULT").vectorCopy();
+                if (rocktabTable.hasColumn("PV_MULT_TRAN")) {
+                    region.transmult_ =  rocktabTable.getColumn("PV_MULT_TRAN").vectorCopy();
+                } else {
+                    region.transmult_ =  rocktabTable.getColumn("PV_MULT_TRANX").vectorCopy();
+                }
+                region.setUniform();
             }
         } else if (!tables.getRockTable().empty()) {
             const auto& rockKeyword = tables.getRockTable();
-            if (rockKeyword.size() != 1) {
-                if (is_io_rank) {
-                    OpmLog::warning("Can only handle a single region in ROCK ("
-                                    + std::to_string(rockKeyword.size())
-                                    + " regions specified)."
-                                    + " Ignoring all except for the first.\n");
-                }
+            regions_.resize(rockKeyword.size());
+            for (size_t r = 0; r < rockKeyword.size(); ++r) {
+                regions_[r].pref_ = rockKeyword[r].reference_pressure;
+                regions_[r].rock_comp_ = rockKeyword[r].compressibility;
             }
-
-            pref_ = rockKeyword[0].reference_pressure;
-            rock_comp_ = rockKeyword[0].compressibility;
         } else {
+            regions_.resize(1);
             OpmLog::warning("No rock compressibility data found in deck (ROCK or ROCKTAB).");
         }
+
+        const auto& props = eclipseState.get3DProperties();
+        if (number_of_cells > 0 && props.hasDeckIntGridProperty("ROCKNUM")) {
+            const std::vector<int>& rocknum = props.getIntGridProperty("ROCKNUM").getData();
+            cell_region_.resize(number_of_cells);
+            for (int cell = 0; cell < number_of_cells; ++cell) {
+                const int deck_pos = (global_cell == NULL) ? cell : global_cell[cell];
+                const int r = rocknum[deck_pos] - 1;
+                if (r < 0 || r >= numRegions()) {
+                    OPM_THROW(std::runtime_error, "ROCKNUM value " << r + 1 << " in cell " << cell
+                              << " is outside the range of the " << numRegions()
+                              << " rock compressibility regions.");
+                }
+                cell_region_[cell] = r;
+            }
+        } else if (numRegions() != 1 && is_io_rank) {
+            OpmLog::warning("No ROCKNUM given for the " + std::to_string(numRegions())
+                            + " rock compressibility regions."
+                            + " Using the first region in all cells.\n");
+        }
     }
 
     bool RockCompressibility::isActive() const
     {
-        return !p_.empty() || (rock_comp_ != 0.0);
+        for (const Region& region : regions_) {
+            if (!region.p_.empty() || (region.rock_comp_ != 0.0)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int RockCompressibility::numRegions() const
+    {
+        return regions_.size();
+    }
+
+    const RockCompressibility::Region& RockCompressibility::region(const int cell) const
+    {
+        assert(cell_region_.empty() || cell < int(cell_region_.size()));
+        return cell_region_.empty() ? regions_[0] : regions_[cell_region_[cell]];
     }
 
     double RockCompressibility::poroMult(double pressure) const
     {
-        if (p_.empty()) {
-            // Approximating with a quadratic curve.
-            const double cpnorm = rock_comp_*(pressure - pref_);
-            return (1.0 + cpnorm + 0.5*cpnorm*cpnorm);
-        } else {
-            return Opm::linearInterpolation(p_, poromult_, pressure);
-        }
+        double mult, dmultdp;
+        regions_[0].poroMult(pressure, mult, dmultdp);
+        return mult;
     }
 
     double RockCompressibility::poroMultDeriv(double pressure) const
     {
-        if (p_.empty()) {
-            // Approximating poro multiplier with a quadratic curve,
-            // we must use its derivative.
-            const double cpnorm = rock_comp_*(pressure - pref_);
-            return rock_comp_ + cpnorm*rock_comp_;
-        } else {
-            return Opm::linearInterpolationDerivative(p_, poromult_, pressure);
-        }
+        double mult, dmultdp;
+        regions_[0].poroMult(pressure, mult, dmultdp);
+        return dmultdp;
     }
 
     double RockCompressibility::transMult(double pressure) const
     {
-        if (p_.empty()) {
+        const Region& region = regions_[0];
+        if (region.p_.empty()) {
             return 1.0;
         } else {
-            return Opm::linearInterpolation(p_, transmult_, pressure);
+            return Opm::linearInterpolation(region.p_, region.transmult_, pressure);
         }
     }
 
     double RockCompressibility::transMultDeriv(double pressure) const
     {
-        if (p_.empty()) {
+        const Region& region = regions_[0];
+        if (region.p_.empty()) {
             return 0.0;
         } else {
-            return Opm::linearInterpolationDerivative(p_, transmult_, pressure);
+            return Opm::linearInterpolationDerivative(region.p_, region.transmult_, pressure);
         }
     }
 
     double RockCompressibility::rockComp(double pressure) const
     {
-        if (p_.empty()) {
-            return rock_comp_;
+        const Region& region = regions_[0];
+        if (region.p_.empty()) {
+            return region.rock_comp_;
         } else {
-            //const double poromult = Opm::linearInterpolation(p_, poromult_, pressure);
-            //const double dporomultdp = Opm::linearInterpolationDerivative(p_, poromult_, pressure);
-            const double poromult = Opm::linearInterpolation(p_, poromult_, pressure);
-            const double dporomultdp = Opm::linearInterpolationDerivative(p_, poromult_, pressure);
+            double mult, dmultdp;
+            region.poroMult(pressure, mult, dmultdp);
+            return dmultdp/mult;
+        }
+    }
 
-            return dporomultdp/poromult;
+    void RockCompressibility::poroMult(const int n,
+                                       const double* pressure,
+                                       const int* cells,
+                                       double* mult,
+                                       double* dmultdp) const
+    {
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i) {
+            const int cell = (cells == NULL) ? i : cells[i];
+            double dm;
+            region(cell).poroMult(pressure[i], mult[i], dm);
+            if (dmultdp != NULL) {
+                dmultdp[i] = dm;
+            }
         }
     }
 
-} // namespace Opm
+    void RockCompressibility::rockComp(const int n,
+                                       const double* pressure,
+                                       const int* cells,
+                                       double* rock_comp) const
+    {
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i) {
+            const int cell = (cells == NULL) ? i : cells[i];
+            const Region& r = region(cell);
+            if (r.p_.empty()) {
+                rock_comp[i] = r.rock_comp_;
+            } else {
+                double mult, dmultdp;
+                r.poroMult(pressure[i], mult, dmultdp);
+                rock_comp[i] = dmultdp/mult;
+            }
+        }
+    }
+
+    void RockCompressibility::resampleUniform(const int num_points)
+    {
+        if (num_points < 2) {
+            OPM_THROW(std::runtime_error, "Uniform rock compressibility tables need at least two points.");
+        }
+        for (Region& region : regions_) {
+            if (region.p_.size() < 2 || region.uniform_) {
+                continue;
+            }
+            const double p0 = region.p_.front();
+            const double dp = (region.p_.back() - p0)/(num_points - 1);
+            std::vector<double> p(num_points), poromult(num_points), transmult(num_points);
+            for (int i = 0; i < num_points; ++i) {
+                p[i] = (i == num_points - 1) ? region.p_.back() : p0 + i*dp;
+                poromult[i] = Opm::linearInterpolation(region.p_, region.poromult_, p[i]);
+                transmult[i] = Opm::linearInterpolation(region.p_, region.transmult_, p[i]);
+            }
+            region.p_.swap(p);
+            region.poromult_.swap(poromult);
+            region.transmult_.swap(transmult);
+            region.setUniform();
+        }
+    }
 
+} // namespace Opm
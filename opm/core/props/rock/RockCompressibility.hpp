@@ -29,14 +29,35 @@ namespace Opm
 
     class ParameterGroup;
 
+    /// Rock compressibility given by the keywords ROCK or ROCKTAB,
+    /// optionally with one table per ROCKNUM region.
+    ///
+    /// The scalar accessors evaluate the first region.  The batched
+    /// accessors take a list of cells and evaluate each cell's region,
+    /// finding the table interval of each pressure only once.
     class RockCompressibility
     {
     public:
         /// Construct from input deck.
-        /// Looks for the keywords ROCK and ROCKTAB.
+        /// Looks for the keywords ROCK, ROCKTAB and ROCKNUM.  The cells
+        /// are the active cells of the input grid, in order, as in a grid
+        /// made by GridManager from eclipseState.getInputGrid().  Use the
+        /// constructor taking global_cell for other cell numberings, for
+        /// instance the cells of one process of a distributed grid.
         RockCompressibility(const Opm::EclipseState& eclipseState,
                             const bool is_io_rank = true);
 
+        /// Construct from input deck.
+        /// Looks for the keywords ROCK, ROCKTAB and ROCKNUM.
+        /// \param[in] number_of_cells  Number of active cells.
+        /// \param[in] global_cell      Mapping from active cells to the
+        ///                             deck's cartesian cells, or null
+        ///                             if the mapping is the identity.
+        RockCompressibility(const Opm::EclipseState& eclipseState,
+                            const int number_of_cells,
+                            const int* global_cell,
+                            const bool is_io_rank = true);
+
         /// Construct from parameters.
         /// Accepts the following parameters (with defaults).
         ///    rock_compressibility_pref (100.0)   [given in bar]
@@ -61,12 +82,70 @@ namespace Opm
         /// Rock compressibility = (d poro / d p)*(1 / poro).
         double rockComp(double pressure) const;
 
+        /// Number of rock compressibility regions.
+        int numRegions() const;
+
+        /// Porosity multiplier and its derivative for a set of cells.
+        /// \param[in]  n         Number of data points.
+        /// \param[in]  pressure  Array of n pressure values.
+        /// \param[in]  cells     Array of n cell indices, or null if the
+        ///                       data points are the cells 0, ..., n-1.
+        /// \param[out] mult      Array of n porosity multipliers.
+        /// \param[out] dmultdp   Array of n derivatives with respect to
+        ///                       pressure.  Not computed if null.
+        void poroMult(const int n,
+                      const double* pressure,
+                      const int* cells,
+                      double* mult,
+                      double* dmultdp) const;
+
+        /// Rock compressibility for a set of cells.
+        /// \param[in]  n          Number of data points.
+        /// \param[in]  pressure   Array of n pressure values.
+        /// \param[in]  cells      Array of n cell indices, or null if the
+        ///                        data points are the cells 0, ..., n-1.
+        /// \param[out] rock_comp  Array of n compressibilities.
+        void rockComp(const int n,
+                      const double* pressure,
+                      const int* cells,
+                      double* rock_comp) const;
+
+        /// Replace each tabulated (ROCKTAB) region by its linear
+        /// interpolant on num_points uniformly spaced pressures spanning
+        /// the same range.  Lookups in a uniform table take constant
+        /// time, at the cost of an interpolation error unless the
+        /// original pressures are uniformly spaced already (those tables
+        /// are detected at construction and need no resampling).
+        void resampleUniform(const int num_points);
+
     private:
-        std::vector<double> p_;
-        std::vector<double> poromult_;
-        std::vector<double> transmult_;
-        double pref_;
-        double rock_comp_;
+        struct Region
+        {
+            Region();
+
+            // Table interval containing p.  Clamped to the first and
+            // last interval, i.e., the tables are extrapolated linearly.
+            int interval(const double p) const;
+
+            // Porosity multiplier and derivative at pressure p.
+            void poroMult(const double p, double& mult, double& dmultdp) const;
+
+            // Detect uniformly spaced table pressures.
+            void setUniform();
+
+            std::vector<double> p_;
+            std::vector<double> poromult_;
+            std::vector<double> transmult_;
+            double pref_;
+            double rock_comp_;
+            bool uniform_;
+            double inv_dp_;
+        };
+
+        const Region& region(const int cell) const;
+
+        std::vector<Region> regions_;
+        std::vector<int> cell_region_; // Empty if all cells are in region 0.
     };
 
 } // namespace Opm
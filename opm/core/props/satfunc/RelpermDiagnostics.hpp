@@ -62,6 +62,17 @@ namespace Opm {
                        const Deck& deck,
                        const GridT& grid);
 
+        ///Limit the number of messages written per kind of scaled
+        ///end-point issue.  Further issues of that kind are only
+        ///counted, and reported in one summary line.
+        ///\param[in] max_messages  Maximum number of messages per
+        ///                          kind, zero (the default) means
+        ///                          no limit.
+        void setMaxMessagesPerCategory(const int max_messages)
+        {
+            maxMessagesPerCategory_ = max_messages;
+        }
+
     private:
         enum FluidSystem {
             OilWater,
@@ -81,6 +92,8 @@ namespace Opm {
   
         SaturationFunctionFamily satFamily_;
 
+        int maxMessagesPerCategory_ = 0;
+
         std::vector<Opm::EclEpsScalingPointsInfo<double> > unscaledEpsInfo_;
         std::vector<Opm::EclEpsScalingPointsInfo<double> > scaledEpsInfo_;
 
@@ -20,6 +20,10 @@
 #ifndef OPM_RELPERMDIAGNOSTICS_IMPL_HEADER_INCLUDED
 #define OPM_RELPERMDIAGNOSTICS_IMPL_HEADER_INCLUDED
 
+#include <array>
+#include <map>
+#include <string>
+#include <tuple>
 #include <vector>
 #include <utility>
 
@@ -56,9 +60,76 @@ namespace Opm {
         EclEpsGridProperties epsGridProperties;
         epsGridProperties.initFromDeck(deck, eclState, /*imbibition=*/false);       
         const auto& satnum = eclState.get3DProperties().getIntGridProperty("SATNUM");
-        
+        const bool checkMobility = deck.hasKeyword("SCALECRS") && fluidSystem_ == FluidSystem::BlackOil;
+
+        // The kinds of issues checked for, one bit each.
+        enum { SguIssue = 1, SglIssue = 2, SowcrIssue = 4, SogcrIssue = 8 };
+        const int numCategories = 4;
+        const char* const issueText[numCategories] = {
+            "SGU exceed 1.0 - SWL",
+            "SGL exceed 1.0 - SWU",
+            "SOWCR + SWCR exceed 1.0",
+            "SOGCR + SGCR + SWL exceed 1.0"
+        };
+
+        // Extract and check the end points of all cells in parallel.
+        // Only the (normally few) cells with issues get messages below.
+        std::vector<unsigned char> issues(nc, 0);
+#pragma omp parallel for schedule(static)
+        for (int c = 0; c < nc; ++c) {
+            auto& eps = scaledEpsInfo_[c];
+            eps.extractScaled(eclState, epsGridProperties, compressedToCartesianIdx[c]);
+            unsigned char cellIssues = 0;
+            // SGU <= 1.0 - SWL
+            if (eps.Sgu > (1.0 - eps.Swl + tolerance)) {
+                cellIssues |= SguIssue;
+            }
+            // SGL <= 1.0 - SWU
+            if (eps.Sgl > (1.0 - eps.Swu + tolerance)) {
+                cellIssues |= SglIssue;
+            }
+            if (checkMobility) {
+                // Mobilility check.
+                if ((eps.Sowcr + eps.Swcr) >= (1.0 + tolerance)) {
+                    cellIssues |= SowcrIssue;
+                }
+                if ((eps.Sogcr + eps.Sgcr + eps.Swl) >= (1.0 + tolerance)) {
+                    cellIssues |= SogcrIssue;
+                }
+            }
+            issues[c] = cellIssues;
+        }
+
+        // Cells of the same SATNUM region with identical scaled end
+        // points have the same issues, and are reported once, by the
+        // first such cell.
+        typedef std::tuple<int, double, double, double, double,
+                           double, double, double, double> EpsKey;
+        std::map<EpsKey, std::pair<int, int> > firstCellAndCount;
+        std::vector<EpsKey> keys(nc);
+        for (int c = 0; c < nc; ++c) {
+            if (issues[c] == 0) {
+                continue;
+            }
+            const auto& eps = scaledEpsInfo_[c];
+            keys[c] = EpsKey(satnum.iget(compressedToCartesianIdx[c]),
+                             eps.Swl, eps.Swu, eps.Sgl, eps.Sgu,
+                             eps.Swcr, eps.Sowcr, eps.Sgcr, eps.Sogcr);
+            auto it = firstCellAndCount.insert(std::make_pair(keys[c], std::make_pair(c, 0))).first;
+            ++it->second.second;
+        }
+
         const std::string tag = "Scaled endpoints";
+        std::array<int, numCategories> reported = {{ 0, 0, 0, 0 }};
+        std::array<int, numCategories> suppressed = {{ 0, 0, 0, 0 }};
         for (int c = 0; c < nc; ++c) {
+            if (issues[c] == 0) {
+                continue;
+            }
+            const auto& group = firstCellAndCount[keys[c]];
+            if (group.first != c) {
+                continue;
+            }
             const int cartIdx = compressedToCartesianIdx[c];
             const std::string satnumIdx = std::to_string(satnum.iget(cartIdx));
             std::array<int, 3> ijk;
@@ -68,33 +139,29 @@ namespace Opm {
             const std::string cellIdx = "(" + std::to_string(ijk[0]) + ", " + 
                                    std::to_string(ijk[1]) + ", " +
                                    std::to_string(ijk[2]) + ")";
-            scaledEpsInfo_[c].extractScaled(eclState, epsGridProperties, cartIdx);
-
-            // SGU <= 1.0 - SWL
-            if (scaledEpsInfo_[c].Sgu > (1.0 - scaledEpsInfo_[c].Swl + tolerance)) {
-                const std::string msg = "For scaled endpoints input, cell" + cellIdx + " SATNUM = " + satnumIdx + ", SGU exceed 1.0 - SWL";
+            for (int k = 0; k < numCategories; ++k) {
+                if (!(issues[c] & (1 << k))) {
+                    continue;
+                }
+                if (maxMessagesPerCategory_ > 0 && reported[k] >= maxMessagesPerCategory_) {
+                    suppressed[k] += group.second;
+                    continue;
+                }
+                std::string msg = "For scaled endpoints input, cell" + cellIdx + " SATNUM = " + satnumIdx + ", " + issueText[k];
+                if (group.second > 1) {
+                    msg += " (also in " + std::to_string(group.second - 1) + " other cells with the same end points)";
+                }
                 OpmLog::warning(tag, msg);
+                ++reported[k];
             }
-            
-            // SGL <= 1.0 - SWU
-            if (scaledEpsInfo_[c].Sgl > (1.0 - scaledEpsInfo_[c].Swu + tolerance)) {
-                const std::string msg = "For scaled endpoints input, cell" + cellIdx + " SATNUM = " + satnumIdx + ", SGL exceed 1.0 - SWU";
+        }
+        for (int k = 0; k < numCategories; ++k) {
+            if (suppressed[k] > 0) {
+                const std::string msg = "For scaled endpoints input, " + std::string(issueText[k])
+                    + " in " + std::to_string(suppressed[k]) + " more cells, not reported individually";
                 OpmLog::warning(tag, msg);
             }
-
-            if (deck.hasKeyword("SCALECRS") && fluidSystem_ == FluidSystem::BlackOil) {
-                // Mobilility check.
-		    if ((scaledEpsInfo_[c].Sowcr + scaledEpsInfo_[c].Swcr) >= (1.0 + tolerance)) {
-                    const std::string msg = "For scaled endpoints input, cell" + cellIdx + " SATNUM = " + satnumIdx + ", SOWCR + SWCR exceed 1.0";
-                    OpmLog::warning(tag, msg);
-                }
-
-            if ((scaledEpsInfo_[c].Sogcr + scaledEpsInfo_[c].Sgcr + scaledEpsInfo_[c].Swl) >= (1.0 + tolerance)) {
-                    const std::string msg = "For scaled endpoints input, cell" + cellIdx + " SATNUM = " + satnumIdx + ", SOGCR + SGCR + SWL exceed 1.0";
-                    OpmLog::warning(tag, msg);
-                }
-            }
-        } 
+        }
     }
 
 } //namespace Opm
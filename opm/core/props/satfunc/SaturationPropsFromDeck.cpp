@@ -28,13 +28,169 @@
 #include <opm/core/simulator/ExplicitArraysFluidState.hpp>
 #include <opm/core/simulator/ExplicitArraysSatDerivativesFluidState.hpp>
 
+#include <algorithm>
+#include <array>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <utility>
 
 namespace Opm
 {
 
     typedef SaturationPropsFromDeck::MaterialLawManager::MaterialLaw MaterialLaw;
+    typedef SaturationPropsFromDeck::MaterialLawManager::MaterialLawParams MaterialLawParams;
+
+    namespace {
+
+        /// Sort the data points i = 0, ..., n-1 by the SATNUM region of
+        /// cells[i] (counting sort).
+        /// \param[out] order       Data points ordered by region.
+        /// \param[out] region      Region of each data point.
+        /// \param[out] regionCell  One cell of each region, -1 if the
+        ///                         region has no data points.
+        void groupByRegion(const SaturationPropsFromDeck::MaterialLawManager& materialLawManager,
+                           const int n,
+                           const int* cells,
+                           std::vector<int>& order,
+                           std::vector<int>& region,
+                           std::vector<int>& regionCell)
+        {
+            region.resize(n);
+            int numRegions = 0;
+            for (int i = 0; i < n; ++i) {
+                region[i] = materialLawManager.satnumRegionIdx(cells[i]);
+                numRegions = std::max(numRegions, region[i] + 1);
+            }
+            std::vector<int> start(numRegions + 1, 0);
+            regionCell.assign(numRegions, -1);
+            for (int i = 0; i < n; ++i) {
+                ++start[region[i] + 1];
+                if (regionCell[region[i]] < 0) {
+                    regionCell[region[i]] = cells[i];
+                }
+            }
+            for (int r = 0; r < numRegions; ++r) {
+                start[r + 1] += start[r];
+            }
+            order.resize(n);
+            for (int i = 0; i < n; ++i) {
+                order[start[region[i]]++] = i;
+            }
+        }
+
+        /// True if cells is 0, 1, ..., n-1.
+        bool isAllCells(const int n, const int* cells)
+        {
+            for (int i = 0; i < n; ++i) {
+                if (cells[i] != i) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// Smallest number of data points for which forEachDataPoint()
+        /// groups the data points by region and uses OpenMP threads.
+        /// Smaller calls, notably the single-cell calls of the reorder
+        /// transport solvers, are evaluated serially cell by cell.
+        const int minGroupedDataPoints = 256;
+
+        /// Calls op(fluidState, params, i) for the data points i = 0, ..., n-1,
+        /// with the fluid state positioned at i.
+        ///
+        /// Without end-point scaling and hysteresis all cells of a SATNUM
+        /// region have identical material law parameters.  The data points
+        /// are then grouped by region and evaluated with the parameters of
+        /// one representative cell per region, which stay in cache, instead
+        /// of each cell's own copy.  If cells is 0, ..., n-1 and a grouping
+        /// of those cells is given in allCells{Order,Region,RegionCell},
+        /// that grouping is used instead of computing a new one.
+        /// Otherwise the generic per-cell parameters are used.  In all
+        /// cases the data points are shared among OpenMP threads, each
+        /// with its own fluid state.  Fewer than minGroupedDataPoints
+        /// data points are evaluated serially with the per-cell
+        /// parameters, without allocating.
+        template <class FluidState, class Op>
+        void forEachDataPoint(const SaturationPropsFromDeck::MaterialLawManager& materialLawManager,
+                              const std::vector<int>& allCellsOrder,
+                              const std::vector<int>& allCellsRegion,
+                              const std::vector<int>& allCellsRegionCell,
+                              const PhaseUsage& phaseUsage,
+                              const int n,
+                              const double* s,
+                              const int* cells,
+                              Op op)
+        {
+            if (n < minGroupedDataPoints) {
+                FluidState fluidState(phaseUsage);
+                fluidState.setSaturationArray(s);
+                for (int i = 0; i < n; ++i) {
+                    fluidState.setIndex(i);
+                    op(fluidState, materialLawManager.materialLawParams(cells[i]), i);
+                }
+                return;
+            }
+
+            if (materialLawManager.enableEndPointScaling() || materialLawManager.enableHysteresis()) {
+#pragma omp parallel
+                {
+                    FluidState fluidState(phaseUsage);
+                    fluidState.setSaturationArray(s);
+#pragma omp for schedule(static)
+                    for (int i = 0; i < n; ++i) {
+                        fluidState.setIndex(i);
+                        op(fluidState, materialLawManager.materialLawParams(cells[i]), i);
+                    }
+                }
+                return;
+            }
+
+            const std::vector<int>* order = &allCellsOrder;
+            const std::vector<int>* region = &allCellsRegion;
+            const std::vector<int>* regionCell = &allCellsRegionCell;
+            std::vector<int> localOrder, localRegion, localRegionCell;
+            if (int(allCellsOrder.size()) != n || !isAllCells(n, cells)) {
+                groupByRegion(materialLawManager, n, cells,
+                              localOrder, localRegion, localRegionCell);
+                order = &localOrder;
+                region = &localRegion;
+                regionCell = &localRegionCell;
+            }
+
+            std::vector<const MaterialLawParams*> regionParams(regionCell->size(), nullptr);
+            for (size_t r = 0; r < regionCell->size(); ++r) {
+                if ((*regionCell)[r] >= 0) {
+                    regionParams[r] = &materialLawManager.materialLawParams((*regionCell)[r]);
+                }
+            }
+
+#pragma omp parallel
+            {
+                FluidState fluidState(phaseUsage);
+                fluidState.setSaturationArray(s);
+#pragma omp for schedule(static)
+                for (int k = 0; k < n; ++k) {
+                    const int i = (*order)[k];
+                    fluidState.setIndex(i);
+                    op(fluidState, *regionParams[(*region)[i]], i);
+                }
+            }
+        }
+
+#ifndef NDEBUG
+        /// True if no cell occurs more than once in cells[0], ...,
+        /// cells[n-1].  The hysteresis updates write to the parameters of
+        /// each cell in parallel, so they must not be given duplicates.
+        bool cellsAreUnique(const int n, const int* cells)
+        {
+            std::vector<int> sorted(cells, cells + n);
+            std::sort(sorted.begin(), sorted.end());
+            return std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+        }
+#endif
+
+    } // anonymous namespace
 
     // ----------- Methods of SaturationPropsFromDeck ---------
 
@@ -52,6 +208,24 @@ namespace Opm
         materialLawManager_ = materialLawManager;
     }
 
+    /// Precompute the grouping of the cells 0, ..., number_of_cells-1
+    /// by SATNUM region.
+    void SaturationPropsFromDeck::cacheAllCellsGrouping(const int number_of_cells)
+    {
+        allCellsOrder_.clear();
+        allCellsRegion_.clear();
+        allCellsRegionCell_.clear();
+        if (materialLawManager_->enableEndPointScaling() || materialLawManager_->enableHysteresis()) {
+            return;
+        }
+        std::vector<int> cells(number_of_cells);
+        for (int c = 0; c < number_of_cells; ++c) {
+            cells[c] = c;
+        }
+        groupByRegion(*materialLawManager_, number_of_cells, cells.data(),
+                      allCellsOrder_, allCellsRegion_, allCellsRegionCell_);
+    }
+
     /// \return   P, the number of phases.
     int SaturationPropsFromDeck::numPhases() const
     {
@@ -81,39 +255,39 @@ namespace Opm
 
         const int np = numPhases();
         if (dkrds) {
-            ExplicitArraysSatDerivativesFluidState fluidState(phaseUsage_);
-            fluidState.setSaturationArray(s);
-
             typedef ExplicitArraysSatDerivativesFluidState::Evaluation Evaluation;
-            Evaluation relativePerms[BlackoilPhases::MaxNumPhases];
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
-                MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
-
-                // copy the values calculated using opm-material to the target arrays
-                for (int krPhaseIdx = 0; krPhaseIdx < np; ++krPhaseIdx) {
-                    kr[np*i + krPhaseIdx] = relativePerms[krPhaseIdx].value();
-
-                    for (int satPhaseIdx = 0; satPhaseIdx < np; ++satPhaseIdx)
-                        dkrds[np*np*i + satPhaseIdx*np + krPhaseIdx] = relativePerms[krPhaseIdx].derivative(satPhaseIdx);
-                }
-            }
+            forEachDataPoint<ExplicitArraysSatDerivativesFluidState>(
+                *materialLawManager_, allCellsOrder_, allCellsRegion_, allCellsRegionCell_,
+                phaseUsage_, n, s, cells,
+                [&](const ExplicitArraysSatDerivativesFluidState& fluidState,
+                    const MaterialLawParams& params, const int i)
+                {
+                    Evaluation relativePerms[BlackoilPhases::MaxNumPhases];
+                    MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
+
+                    // copy the values calculated using opm-material to the target arrays
+                    for (int krPhaseIdx = 0; krPhaseIdx < np; ++krPhaseIdx) {
+                        kr[np*i + krPhaseIdx] = relativePerms[krPhaseIdx].value();
+
+                        for (int satPhaseIdx = 0; satPhaseIdx < np; ++satPhaseIdx)
+                            dkrds[np*np*i + satPhaseIdx*np + krPhaseIdx] = relativePerms[krPhaseIdx].derivative(satPhaseIdx);
+                    }
+                });
         } else {
-            ExplicitArraysFluidState fluidState(phaseUsage_);
-            fluidState.setSaturationArray(s);
-
-            double relativePerms[BlackoilPhases::MaxNumPhases] = { 0 };
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
-                MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
-
-                // copy the values calculated using opm-material to the target arrays
-                for (int krPhaseIdx = 0; krPhaseIdx < np; ++krPhaseIdx) {
-                    kr[np*i + krPhaseIdx] = relativePerms[krPhaseIdx];
-                }
-            }
+            forEachDataPoint<ExplicitArraysFluidState>(
+                *materialLawManager_, allCellsOrder_, allCellsRegion_, allCellsRegionCell_,
+                phaseUsage_, n, s, cells,
+                [&](const ExplicitArraysFluidState& fluidState,
+                    const MaterialLawParams& params, const int i)
+                {
+                    double relativePerms[BlackoilPhases::MaxNumPhases] = { 0 };
+                    MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
+
+                    // copy the values calculated using opm-material to the target arrays
+                    for (int krPhaseIdx = 0; krPhaseIdx < np; ++krPhaseIdx) {
+                        kr[np*i + krPhaseIdx] = relativePerms[krPhaseIdx];
+                    }
+                });
         }
     }
 
@@ -142,14 +316,14 @@ namespace Opm
         const int np = numPhases();
 
         if (dpcds) {
-            ExplicitArraysSatDerivativesFluidState fluidState(phaseUsage_);
             typedef ExplicitArraysSatDerivativesFluidState::Evaluation Evaluation;
-            fluidState.setSaturationArray(s);
-
-            Evaluation capillaryPressures[BlackoilPhases::MaxNumPhases];
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
+            forEachDataPoint<ExplicitArraysSatDerivativesFluidState>(
+                *materialLawManager_, allCellsOrder_, allCellsRegion_, allCellsRegionCell_,
+                phaseUsage_, n, s, cells,
+                [&](const ExplicitArraysSatDerivativesFluidState& fluidState,
+                    const MaterialLawParams& params, const int i)
+            {
+                Evaluation capillaryPressures[BlackoilPhases::MaxNumPhases];
                 MaterialLaw::capillaryPressures(capillaryPressures, params, fluidState);
 
                 // copy the values calculated using opm-material to the target arrays
@@ -174,15 +348,15 @@ namespace Opm
                         dpcds[np*np*i + satPhaseIdx*np + pcPhaseIdx] = capillaryPressures[BlackoilPhases::Liquid].derivative(canonicalSatPhaseIdx) + sign * capillaryPressures[canonicalPhaseIdx].derivative(canonicalSatPhaseIdx);
                     }
                 }
-            }
+            });
         } else {
-            ExplicitArraysFluidState fluidState(phaseUsage_);
-            fluidState.setSaturationArray(s);
-
-            double capillaryPressures[BlackoilPhases::MaxNumPhases] = { 0 };
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
+            forEachDataPoint<ExplicitArraysFluidState>(
+                *materialLawManager_, allCellsOrder_, allCellsRegion_, allCellsRegionCell_,
+                phaseUsage_, n, s, cells,
+                [&](const ExplicitArraysFluidState& fluidState,
+                    const MaterialLawParams& params, const int i)
+            {
+                double capillaryPressures[BlackoilPhases::MaxNumPhases] = { 0 };
                 MaterialLaw::capillaryPressures(capillaryPressures, params, fluidState);
 
                 // copy the values calculated using opm-material to the target arrays
@@ -199,7 +373,7 @@ namespace Opm
                     // to shift the reference phase to oil
                     pc[np*i + pcPhaseIdx] = capillaryPressures[BlackoilPhases::Liquid] + sign * capillaryPressures[canonicalPhaseIdx];
                 }
-            }
+            });
         }
     }
 
@@ -251,20 +425,26 @@ namespace Opm
 
     /// Update saturation state for the hysteresis tracking
     /// \param[in]  n      Number of data points.
+    /// \param[in]  cells  Array of n cell indices, each occurring only once.
     /// \param[in]  s      Array of nP saturation values.
     void SaturationPropsFromDeck::updateSatHyst(const int n,
                                                             const int* cells,
                                                             const double* s)
     {
         assert(cells != 0);
+        assert(cellsAreUnique(n, cells));
 
         if (materialLawManager_->enableHysteresis()) {
-            ExplicitArraysFluidState fluidState(phaseUsage_);
-            fluidState.setSaturationArray(s);
-
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                materialLawManager_->updateHysteresis(fluidState, cells[i]);
+            // The update of a cell only touches that cell's parameters.
+#pragma omp parallel
+            {
+                ExplicitArraysFluidState fluidState(phaseUsage_);
+                fluidState.setSaturationArray(s);
+#pragma omp for schedule(static)
+                for (int i = 0; i < n; ++i) {
+                    fluidState.setIndex(i);
+                    materialLawManager_->updateHysteresis(fluidState, cells[i]);
+                }
             }
         }
     }
@@ -273,6 +453,7 @@ namespace Opm
 
     /// Set hysteresis parameters for gas-oil
     /// \param[in]  n        Number of data points.
+    /// \param[in]  cells    Array of n cell indices, each occurring only once.
     /// \param[in]  pcswmdc  Array of hysteresis parameters (@see EclHysteresisTwoPhaseLawParams::pcSwMdc(...))
     /// \param[in]  krnswdc  Array of hysteresis parameters (@see EclHysteresisTwoPhaseLawParams::krnSwMdc(...))
     void SaturationPropsFromDeck::setGasOilHystParams(const int n,
@@ -281,8 +462,10 @@ namespace Opm
                              const double* krnswdc)
     {
         assert(cells != 0);
+        assert(cellsAreUnique(n, cells));
 
         if (materialLawManager_->enableHysteresis()) {
+#pragma omp parallel for schedule(static)
             for (int i = 0; i < n; ++i) {
                 materialLawManager_->setGasOilHysteresisParams(pcswmdc[i], krnswdc[i], cells[i]);
             }
@@ -301,6 +484,7 @@ namespace Opm
         assert(cells != 0);
 
         if (materialLawManager_->enableHysteresis()) {
+#pragma omp parallel for schedule(static)
             for (int i = 0; i < n; ++i) {
                 materialLawManager_->gasOilHysteresisParams(pcswmdc[i], krnswdc[i], cells[i]);
             }
@@ -316,6 +500,7 @@ namespace Opm
 
     /// Set hysteresis parameters for oil-water
     /// \param[in]  n        Number of data points.
+    /// \param[in]  cells    Array of n cell indices, each occurring only once.
     /// \param[in]  pcswmdc  Array of hysteresis parameters (@see EclHysteresisTwoPhaseLawParams::pcSwMdc(...))
     /// \param[in]  krnswdc  Array of hysteresis parameters (@see EclHysteresisTwoPhaseLawParams::krnSwMdc(...))
     void SaturationPropsFromDeck::setOilWaterHystParams(const int n,
@@ -324,8 +509,10 @@ namespace Opm
                                const double* krnswdc)
     {
         assert(cells != 0);
+        assert(cellsAreUnique(n, cells));
 
         if (materialLawManager_->enableHysteresis()) {
+#pragma omp parallel for schedule(static)
             for (int i = 0; i < n; ++i) {
                 materialLawManager_->setOilWaterHysteresisParams(pcswmdc[i], krnswdc[i], cells[i]);
             }
@@ -344,6 +531,7 @@ namespace Opm
         assert(cells != 0);
 
         if (materialLawManager_->enableHysteresis()) {
+#pragma omp parallel for schedule(static)
             for (int i = 0; i < n; ++i) {
                 materialLawManager_->oilWaterHysteresisParams(pcswmdc[i], krnswdc[i], cells[i]);
             }
@@ -358,6 +546,40 @@ namespace Opm
     }
 
 
+    /// Copy the hysteresis state of a set of cells out of the material
+    /// law parameters.
+    void SaturationPropsFromDeck::exportHysteresisState(const int n,
+                                                        const int* cells,
+                                                        HysteresisState& state) const
+    {
+        state.pcSwMdcOilWater.resize(n);
+        state.krnSwMdcOilWater.resize(n);
+        state.pcSwMdcGasOil.resize(n);
+        state.krnSwMdcGasOil.resize(n);
+        if (n == 0) {
+            return;
+        }
+        getOilWaterHystParams(n, cells, state.pcSwMdcOilWater.data(), state.krnSwMdcOilWater.data());
+        getGasOilHystParams(n, cells, state.pcSwMdcGasOil.data(), state.krnSwMdcGasOil.data());
+    }
+
+    /// Restore the hysteresis state of a set of cells.
+    void SaturationPropsFromDeck::importHysteresisState(const int n,
+                                                        const int* cells,
+                                                        const HysteresisState& state)
+    {
+        assert(int(state.pcSwMdcOilWater.size()) == n);
+        assert(int(state.krnSwMdcOilWater.size()) == n);
+        assert(int(state.pcSwMdcGasOil.size()) == n);
+        assert(int(state.krnSwMdcGasOil.size()) == n);
+        if (n == 0) {
+            return;
+        }
+        setOilWaterHystParams(n, cells, state.pcSwMdcOilWater.data(), state.krnSwMdcOilWater.data());
+        setGasOilHystParams(n, cells, state.pcSwMdcGasOil.data(), state.krnSwMdcGasOil.data());
+    }
+
+
     /// Update capillary pressure scaling according to pressure diff. and initial water saturation.
     /// \param[in]     cell  Cell index.
     /// \param[in]     pcow  P_oil - P_water.
@@ -368,4 +590,86 @@ namespace Opm
     {
         swat = materialLawManager_->applySwatinit(cell, pcow, swat);
     }
+
+    /// Batched version of swatInitScaling().
+    /// \param[in]     n      Number of cells.
+    /// \param[in]     cells  Array of n cell indices, each occurring only once.
+    /// \param[in]     pcow   Array of n values of P_oil - P_water.
+    /// \param[in/out] swat   Array of n water saturations, possibly modified on return.
+    void SaturationPropsFromDeck::swatInitScaling(const int n,
+                                                  const int* cells,
+                                                  const double* pcow,
+                                                  double* swat)
+    {
+        assert(cells != 0);
+        assert(cellsAreUnique(n, cells));
+
+        // Scaling a cell only modifies that cell's parameters.
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i) {
+            swat[i] = materialLawManager_->applySwatinit(cells[i], pcow[i], swat[i]);
+        }
+    }
+
+
+
+    SaturationPropsFromDeck::ParameterSharing
+    SaturationPropsFromDeck::parameterSharing(const int n,
+                                              const int* cells) const
+    {
+        ParameterSharing sharing;
+        sharing.numCells = n;
+        sharing.bytesPerCell = sizeof(MaterialLawParams);
+
+        if (materialLawManager_->enableHysteresis()) {
+            sharing.numDistinct = n;
+            return sharing;
+        }
+
+        const bool eps = materialLawManager_->enableEndPointScaling();
+
+        // Without hysteresis only the drainage curves are used, so the
+        // imbibition end points need not be compared.  The scaled
+        // maximum capillary pressures include the PCW and SWATINIT
+        // scaling.
+        typedef std::array<double, 16> ScaledPoints;
+        typedef std::pair<int, ScaledPoints> Key;
+        std::map<Key, int> distinct;
+        for (int i = 0; i < n; ++i) {
+            Key key(materialLawManager_->satnumRegionIdx(cells[i]), ScaledPoints());
+            if (eps) {
+                const auto& info = materialLawManager_->oilWaterScaledEpsInfoDrainage(cells[i]);
+                key.second = ScaledPoints{{ info.Swl, info.Swcr, info.Swu, info.Sowcr,
+                                            info.Sgl, info.Sgcr, info.Sgu, info.Sogcr,
+                                            info.maxPcow, info.maxPcgo,
+                                            info.pcowLeverettFactor, info.pcgoLeverettFactor,
+                                            info.maxKrw, info.maxKrow, info.maxKrog, info.maxKrg }};
+            }
+            ++distinct[key];
+        }
+        sharing.numDistinct = distinct.size();
+
+        return sharing;
+    }
+
+
+
+    void SaturationPropsFromDeck::writeSharingReport(const ParameterSharing& sharing,
+                                                     std::ostream& os)
+    {
+        const double mib = 1024.0*1024.0;
+        const std::ios_base::fmtflags flags = os.flags();
+        const std::streamsize precision = os.precision();
+        os << "Material law parameters: " << sharing.numCells << " cells, "
+           << sharing.numDistinct << " distinct parameter sets"
+           << std::fixed << std::setprecision(1);
+        if (sharing.numDistinct > 0) {
+            os << " (" << double(sharing.numCells)/sharing.numDistinct << " cells per set)";
+        }
+        os << "\n"
+           << "  per-cell storage: at least " << sharing.bytesPerCellTotal()/mib << " MiB\n"
+           << "  shared storage:   at least " << sharing.bytesShared()/mib << " MiB" << std::endl;
+        os.flags(flags);
+        os.precision(precision);
+    }
 } // namespace Opm
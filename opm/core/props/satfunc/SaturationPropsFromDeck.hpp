@@ -29,6 +29,8 @@
 #include <opm/parser/eclipse/Deck/Deck.hpp>
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 
+#include <cstddef>
+#include <iosfwd>
 #include <vector>
 
 struct UnstructuredGrid;
@@ -72,6 +74,14 @@ namespace Opm
             init(Opm::phaseUsageFromDeck(deck), materialLawManager);
         }
 
+        /// Precompute the grouping of the cells 0, ..., number_of_cells-1
+        /// by SATNUM region.  Later relperm() and capPress() calls for
+        /// exactly these cells, like the all-cells vectors of the pressure
+        /// and transport solvers and the pointer-based mobility helpers
+        /// in miscUtilities, then skip the region lookups and the
+        /// sorting.  Has no effect with end-point scaling or hysteresis.
+        void cacheAllCellsGrouping(const int number_of_cells);
+
         /// \return   P, the number of phases.
         int numPhases() const;
 
@@ -114,15 +124,21 @@ namespace Opm
                       double* smin,
                       double* smax) const;
 
-        /// Update saturation state for the hysteresis tracking 
-        /// \param[in]  n      Number of data points. 
-        /// \param[in]  s      Array of nP saturation values.             
+        /// Update saturation state for the hysteresis tracking.  The
+        /// cells are updated in parallel, so each cell may only occur
+        /// once, which is checked in debug builds.
+        /// \param[in]  n      Number of data points.
+        /// \param[in]  cells  Array of n cell indices, each occurring only once.
+        /// \param[in]  s      Array of nP saturation values.
         void updateSatHyst(const int n,
                            const int* cells,
                            const double* s);
 
-        /// Set hysteresis parameters for gas-oil
+        /// Set hysteresis parameters for gas-oil.  The cells are updated in
+        /// parallel, so each cell may only occur once, which is checked
+        /// in debug builds.
         /// \param[in]  n        Number of data points.
+        /// \param[in]  cells    Array of n cell indices, each occurring only once.
         /// \param[in]  pcswmdc  Array of hysteresis parameters (@see EclHysteresisTwoPhaseLawParams::pcSwMdc(...))
         /// \param[in]  krnswdc  Array of hysteresis parameters (@see EclHysteresisTwoPhaseLawParams::krnSwMdc(...))
         void setGasOilHystParams(const int n,
@@ -139,8 +155,11 @@ namespace Opm
                                  double* pcswmdc,
                                  double* krnswdc) const;
 
-        /// Set hysteresis parameters for oil-water
+        /// Set hysteresis parameters for oil-water.  The cells are updated in
+        /// parallel, so each cell may only occur once, which is checked
+        /// in debug builds.
         /// \param[in]  n        Number of data points.
+        /// \param[in]  cells    Array of n cell indices, each occurring only once.
         /// \param[in]  pcswmdc  Array of hysteresis parameters (@see EclHysteresisTwoPhaseLawParams::pcSwMdc(...))
         /// \param[in]  krnswdc  Array of hysteresis parameters (@see EclHysteresisTwoPhaseLawParams::krnSwMdc(...))
         void setOilWaterHystParams(const int n,
@@ -157,6 +176,36 @@ namespace Opm
                                    double* pcswmdc,
                                    double* krnswdc) const;
 
+        /// Hysteresis state of a set of cells, one array per quantity,
+        /// for instance for writing to and reading from restart files.
+        /// All arrays hold the value 2.0 if hysteresis is disabled.
+        struct HysteresisState
+        {
+            std::vector<double> pcSwMdcOilWater;    //!< Oil-water pcSwMdc per cell.
+            std::vector<double> krnSwMdcOilWater;   //!< Oil-water krnSwMdc per cell.
+            std::vector<double> pcSwMdcGasOil;      //!< Gas-oil pcSwMdc per cell.
+            std::vector<double> krnSwMdcGasOil;     //!< Gas-oil krnSwMdc per cell.
+        };
+
+        /// Copy the hysteresis state of a set of cells out of the
+        /// material law parameters, in parallel.
+        /// \param[in]  n      Number of cells.
+        /// \param[in]  cells  Array of n cell indices.
+        /// \param[out] state  Hysteresis state, arrays resized to n.
+        void exportHysteresisState(const int n,
+                                   const int* cells,
+                                   HysteresisState& state) const;
+
+        /// Restore the hysteresis state of a set of cells, in parallel.
+        /// Has no effect if hysteresis is disabled.  Each cell may only
+        /// occur once, which is checked in debug builds.
+        /// \param[in]  n      Number of cells.
+        /// \param[in]  cells  Array of n cell indices, each occurring only once.
+        /// \param[in]  state  Hysteresis state with arrays of size n.
+        void importHysteresisState(const int n,
+                                   const int* cells,
+                                   const HysteresisState& state);
+
         /// Update capillary pressure scaling according to pressure diff. and initial water saturation.
         /// \param[in]     cell  Cell index. 
         /// \param[in]     pcow  P_oil - P_water.
@@ -165,13 +214,61 @@ namespace Opm
                              const double pcow, 
                              double & swat);
 
+        /// Batched version of swatInitScaling(), for instance for all
+        /// cells of an equilibration region, in parallel.  The scaled
+        /// end-points are stored once, in the material law parameters of
+        /// the cells, so the simulator sees them through the shared
+        /// material law manager without a separate copy.
+        /// \param[in]     n      Number of cells.
+        /// \param[in]     cells  Array of n cell indices, each occurring only once.
+        /// \param[in]     pcow   Array of n values of P_oil - P_water.
+        /// \param[in/out] swat   Array of n water saturations, possibly
+        ///                       modified on return.
+        void swatInitScaling(const int n,
+                             const int* cells,
+                             const double* pcow,
+                             double* swat);
+
         /// Returns a reference to the MaterialLawManager
         const MaterialLawManager& materialLawManager() const { return *materialLawManager_; }
 
+        /// Summary of how many of the per-cell material law parameter
+        /// objects are actually distinct.
+        struct ParameterSharing
+        {
+            int numCells;               //!< Number of cells examined.
+            int numDistinct;            //!< Number of distinct parameter sets.
+            std::size_t bytesPerCell;   //!< Lower bound on the size of one parameter object.
+            std::size_t bytesPerCellTotal() const { return bytesPerCell*numCells; }
+            std::size_t bytesShared() const { return bytesPerCell*numDistinct; }
+        };
+
+        /// Count the distinct material law parameter sets of a set of
+        /// cells.  Cells share a parameter set if they are in the same
+        /// SATNUM region and, if end-point scaling is enabled, have the
+        /// same scaled end points, maximum relative permeabilities and
+        /// capillary pressure scaling (PCW, SWATINIT, Leverett).  With
+        /// hysteresis every cell carries its own state, and no sharing
+        /// is possible.
+        /// \param[in]  n      Number of cells.
+        /// \param[in]  cells  Array of n cell indices.
+        ParameterSharing parameterSharing(const int n,
+                                          const int* cells) const;
+
+        /// Write a human readable summary of parameterSharing() to os.
+        /// The format flags of os are left unchanged.
+        static void writeSharingReport(const ParameterSharing& sharing,
+                                       std::ostream& os);
+
 
     private:
         std::shared_ptr<MaterialLawManager> materialLawManager_;
         PhaseUsage phaseUsage_;
+        // Grouping of the cells 0, ..., N-1 by SATNUM region, see
+        // cacheAllCellsGrouping().  Empty if not cached.
+        std::vector<int> allCellsOrder_;
+        std::vector<int> allCellsRegion_;
+        std::vector<int> allCellsRegionCell_;
     };
 
 
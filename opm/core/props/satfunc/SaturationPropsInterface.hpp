@@ -74,9 +74,12 @@ namespace Opm
                               double* smin,
                               double* smax) const = 0;
                                            
-        /// Update saturation state for the hysteresis tracking 
-        /// \param[in]  n      Number of data points. 
-        /// \param[in]  s      Array of nP saturation values.             
+        /// Update saturation state for the hysteresis tracking.
+        /// Implementations may update the cells in parallel, so each
+        /// cell may only occur once.
+        /// \param[in]  n      Number of data points.
+        /// \param[in]  cells  Array of n cell indices, each occurring only once.
+        /// \param[in]  s      Array of nP saturation values.
         virtual void updateSatHyst(const int n,
                                    const int* cells,
                                    const double* s) = 0;
@@ -30,7 +30,10 @@
 namespace Opm
 {
 
-    enum HydroCarbonState {
+    /// Stored as one byte per cell, see countHydroCarbonStates() in
+    /// opm/core/utility/initHydroCarbonState.hpp for the number of
+    /// cells in each state.
+    enum HydroCarbonState : unsigned char {
         GasOnly = 0,
         GasAndOil = 1,
         OilOnly = 2
@@ -31,7 +31,10 @@
 #include <opm/material/fluidstates/SimpleModularFluidState.hpp>
 #include <opm/material/fluidmatrixinteractions/EclMaterialLawManager.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <memory>
+#include <vector>
 
 
 /*
@@ -68,6 +71,9 @@ namespace Opm
                                       const int phase2,
                                       const int cell,
                                       const double target_pc)
+
+        template <class FluidSystem, class MaterialLaw, class MaterialLawManager>
+        class PcInverseTables;
     } // namespace Equil
 } // namespace Opm
 
@@ -792,6 +798,196 @@ namespace Opm
             return std::abs(f0 - f1) < std::numeric_limits<double>::epsilon();
         }
 
+
+
+        /// Sampled capillary pressure functions of the saturation regions
+        /// of a set of cells, for faster versions of satFromPc() and
+        /// satFromSumOfPcs().
+        ///
+        /// Without end-point scaling and hysteresis, all cells of a SATNUM
+        /// region have the same capillary pressure functions.  These are
+        /// sampled once per region.  The samples bracket the solution of
+        /// pc(s) = target_pc within one sampling interval by binary
+        /// search, and the root finder then only works inside that
+        /// interval.  The free functions satFromPc() and satFromSumOfPcs()
+        /// are used for scaled cells and for functions that turn out not
+        /// to be monotone.  All methods are const and may be called
+        /// concurrently.
+        template <class FluidSystem, class MaterialLaw, class MaterialLawManager>
+        class PcInverseTables
+        {
+        public:
+            /// Sample the functions of the SATNUM regions of the cells.
+            /// \param[in] materialLawManager  Material laws.
+            /// \param[in] cells               Cells that will be looked up.
+            /// \param[in] num_samples         Number of samples per function.
+            PcInverseTables(const MaterialLawManager& materialLawManager,
+                            const std::vector<int>&   cells,
+                            const int                 num_samples = 200)
+                : materialLawManager_(materialLawManager)
+            {
+                if (materialLawManager.enableEndPointScaling() || materialLawManager.enableHysteresis()) {
+                    return;
+                }
+                const bool water = FluidSystem::phaseIsActive(FluidSystem::waterPhaseIdx);
+                const bool gas = FluidSystem::phaseIsActive(FluidSystem::gasPhaseIdx);
+                for (const int cell : cells) {
+                    const int satnum = materialLawManager.satnumRegionIdx(cell);
+                    if (satnum >= int(tables_.size())) {
+                        tables_.resize(satnum + 1);
+                    }
+                    Tables& t = tables_[satnum];
+                    if (t.sampled) {
+                        continue;
+                    }
+                    t.sampled = true;
+                    if (water) {
+                        samplePc(FluidSystem::waterPhaseIdx, cell, false, num_samples, t.water);
+                    }
+                    if (gas) {
+                        samplePc(FluidSystem::gasPhaseIdx, cell, true, num_samples, t.gas);
+                    }
+                    if (water && gas) {
+                        sampleSumOfPcs(FluidSystem::waterPhaseIdx, FluidSystem::gasPhaseIdx,
+                                       cell, num_samples, t.waterGas);
+                    }
+                }
+            }
+
+            /// Same as the free function satFromPc().
+            double satFromPc(const int phase,
+                             const int cell,
+                             const double target_pc,
+                             const bool increasing = false) const
+            {
+                const Table* table = find(cell, phase == FluidSystem::waterPhaseIdx && !increasing,
+                                          phase == FluidSystem::gasPhaseIdx && increasing, false);
+                if (table == nullptr) {
+                    return EQUIL::satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager_, phase, cell,
+                                                                                           target_pc, increasing);
+                }
+                const PcEq<FluidSystem, MaterialLaw, MaterialLawManager> f(materialLawManager_, phase, cell, target_pc);
+                return solve(*table, f, target_pc, 60);
+            }
+
+            /// Same as the free function satFromSumOfPcs().
+            double satFromSumOfPcs(const int phase1,
+                                   const int phase2,
+                                   const int cell,
+                                   const double target_pc) const
+            {
+                const Table* table = find(cell, false, false,
+                                          phase1 == FluidSystem::waterPhaseIdx
+                                          && phase2 == FluidSystem::gasPhaseIdx);
+                if (table == nullptr) {
+                    return EQUIL::satFromSumOfPcs<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager_, phase1, phase2,
+                                                                                                 cell, target_pc);
+                }
+                const PcEqSum<FluidSystem, MaterialLaw, MaterialLawManager> f(materialLawManager_, phase1, phase2, cell, target_pc);
+                return solve(*table, f, target_pc, 30);
+            }
+
+        private:
+            // Samples g_k = g(s_k), k = 0..N-1, of a function g that is
+            // non-increasing along the samples, from s_0 to s_{N-1}.
+            struct Table
+            {
+                std::vector<double> s;
+                std::vector<double> g;
+                bool valid = false;
+            };
+
+            struct Tables
+            {
+                bool sampled = false;
+                Table water;     // pcow(sw), sw from SWL to SWU.
+                Table gas;       // pcgo(sg), sg from SGU to SGL.
+                Table waterGas;  // pcow(sw) + pcgo(1 - sw), sw from SWL to SWU.
+            };
+
+            template <class Function>
+            static void sample(const Function& g, const double s0, const double s1,
+                               const int num_samples, Table& table)
+            {
+                table.s.resize(num_samples);
+                table.g.resize(num_samples);
+                table.valid = true;
+                for (int k = 0; k < num_samples; ++k) {
+                    // Exact end points, as in the free functions.
+                    const double s = (k == num_samples - 1) ? s1 : s0 + (s1 - s0)*k/(num_samples - 1);
+                    table.s[k] = s;
+                    table.g[k] = g(s);
+                    if (k > 0 && table.g[k] > table.g[k - 1]) {
+                        table.valid = false;
+                    }
+                }
+            }
+
+            void samplePc(const int phase, const int cell, const bool increasing,
+                          const int num_samples, Table& table) const
+            {
+                const double smin = minSaturations<FluidSystem>(materialLawManager_, phase, cell);
+                const double smax = maxSaturations<FluidSystem>(materialLawManager_, phase, cell);
+                const PcEq<FluidSystem, MaterialLaw, MaterialLawManager> g(materialLawManager_, phase, cell, 0.0);
+                sample(g, increasing ? smax : smin, increasing ? smin : smax, num_samples, table);
+            }
+
+            void sampleSumOfPcs(const int phase1, const int phase2, const int cell,
+                                const int num_samples, Table& table) const
+            {
+                const double smin = minSaturations<FluidSystem>(materialLawManager_, phase1, cell);
+                const double smax = maxSaturations<FluidSystem>(materialLawManager_, phase1, cell);
+                const PcEqSum<FluidSystem, MaterialLaw, MaterialLawManager> g(materialLawManager_, phase1, phase2, cell, 0.0);
+                sample(g, smin, smax, num_samples, table);
+            }
+
+            const Table* find(const int cell, const bool water, const bool gas, const bool waterGas) const
+            {
+                if (tables_.empty()) {
+                    return nullptr;
+                }
+                const int satnum = materialLawManager_.satnumRegionIdx(cell);
+                if (satnum >= int(tables_.size()) || !tables_[satnum].sampled) {
+                    return nullptr;
+                }
+                const Tables& t = tables_[satnum];
+                const Table* table = water ? &t.water : gas ? &t.gas : waterGas ? &t.waterGas : nullptr;
+                return (table != nullptr && table->valid) ? table : nullptr;
+            }
+
+            // Solve f(s) = g(s) - target_pc = 0 like the free functions,
+            // but with the root finder confined to the sampling interval
+            // where f changes sign.
+            template <class Function>
+            static double solve(const Table& table, const Function& f,
+                                const double target_pc, const int max_iter)
+            {
+                const int n = table.s.size();
+                if (table.g[0] - target_pc <= 0.0) {
+                    return table.s[0];
+                } else if (table.g[n - 1] - target_pc > 0.0) {
+                    return table.s[n - 1];
+                }
+                // First sample with g <= target_pc; g is non-increasing.
+                const int k = std::lower_bound(table.g.begin(), table.g.end(), target_pc,
+                                               [](const double gk, const double target)
+                                               { return gk > target; }) - table.g.begin();
+                assert(k > 0 && k < n);
+                if (table.g[k] == target_pc) {
+                    return table.s[k];
+                }
+                const double a = std::min(table.s[k - 1], table.s[k]);
+                const double b = std::max(table.s[k - 1], table.s[k]);
+                const double tol = 1e-6;
+                int iter_used = -1;
+                typedef RegulaFalsi<ThrowOnError> ScalarSolver;
+                return ScalarSolver::solve(f, a, b, max_iter, tol, iter_used);
+            }
+
+            const MaterialLawManager& materialLawManager_;
+            std::vector<Tables> tables_;   // Indexed by SATNUM region.
+        };
+
     } // namespace Equil
 } // namespace Opm
 
@@ -0,0 +1,154 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <opm/core/simulator/ImpesStepController.hpp>
+#include <opm/core/simulator/BlackoilState.hpp>
+#include <opm/core/simulator/WellState.hpp>
+#include <opm/core/pressure/CompressibleTpfa.hpp>
+#include <opm/core/props/BlackoilPropertiesInterface.hpp>
+#include <opm/core/utility/miscUtilitiesBlackoil.hpp>
+#include <opm/core/utility/StopWatch.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace Opm
+{
+
+    ImpesStepController::ImpesStepController(CompressibleTpfa& psolver,
+                                             const BlackoilPropertiesInterface& props,
+                                             const double cfl,
+                                             const int target_substeps,
+                                             const int max_substeps,
+                                             const double max_growth)
+        : psolver_(psolver),
+          props_(props),
+          cfl_(cfl),
+          target_substeps_(target_substeps),
+          max_substeps_(max_substeps),
+          max_growth_(max_growth),
+          suggested_dt_(HUGE_VAL),
+          num_substeps_(0)
+    {
+        if (!(cfl > 0.0 && cfl <= 1.0)) {
+            OPM_THROW(std::runtime_error, "ImpesStepController: CFL factor must be in (0, 1], got " << cfl);
+        }
+        if (target_substeps < 1 || max_substeps < target_substeps) {
+            OPM_THROW(std::runtime_error, "ImpesStepController: need 1 <= target_substeps <= max_substeps.");
+        }
+    }
+
+
+
+
+    SimulatorReport ImpesStepController::step(const double dt,
+                                              BlackoilState& state,
+                                              WellState& well_state)
+    {
+        SimulatorReport report;
+        time::StopWatch total_timer;
+        total_timer.start();
+
+        time::StopWatch pressure_timer;
+        pressure_timer.start();
+        psolver_.solve(dt, state, well_state);
+        pressure_timer.stop();
+
+        time::StopWatch transport_timer;
+        transport_timer.start();
+        double t = 0.0;
+        double min_stable_dt = HUGE_VAL;
+        num_substeps_ = 0;
+        substep_sizes_.clear();
+        while (t < dt) {
+            if (num_substeps_ == max_substeps_) {
+                OPM_THROW(std::runtime_error, "ImpesStepController: transport needs more than "
+                          << max_substeps_ << " substeps for a pressure step of " << dt << " seconds.");
+            }
+            const double stable_dt = cfl_ * psolver_.stableTransportStep(state, well_state);
+            min_stable_dt = std::min(min_stable_dt, stable_dt);
+            const double remaining = dt - t;
+            const double sub_dt = substepLength(remaining, stable_dt);
+            psolver_.explicitTransport(sub_dt, state);
+            // The mobilities and the stable step of the next substep
+            // are evaluated at the saturations of this one.
+            computeSaturation(props_, state);
+            t = (sub_dt == remaining) ? dt : t + sub_dt;
+            substep_sizes_.push_back(sub_dt);
+            ++num_substeps_;
+        }
+        transport_timer.stop();
+
+        // Aim for target_substeps_ substeps in the next step, with
+        // limited growth.
+        suggested_dt_ = std::min(target_substeps_ * min_stable_dt, max_growth_ * dt);
+
+        total_timer.stop();
+        report.pressure_time = pressure_timer.secsSinceStart();
+        report.transport_time = transport_timer.secsSinceStart();
+        report.total_time = total_timer.secsSinceStart();
+        report.converged = true;
+        return report;
+    }
+
+
+
+
+    double ImpesStepController::suggestedTimeStep() const
+    {
+        return suggested_dt_;
+    }
+
+
+
+
+    int ImpesStepController::numSubsteps() const
+    {
+        return num_substeps_;
+    }
+
+
+
+
+    const std::vector<double>& ImpesStepController::substepSizes() const
+    {
+        return substep_sizes_;
+    }
+
+
+
+
+    double ImpesStepController::substepLength(const double remaining,
+                                              const double stable_dt)
+    {
+        if (remaining <= stable_dt) {
+            return remaining;
+        }
+        // Split the last two substeps evenly rather than leaving a
+        // tiny remainder.
+        if (remaining < 2.0 * stable_dt) {
+            return 0.5 * remaining;
+        }
+        return stable_dt;
+    }
+
+} // namespace Opm
@@ -0,0 +1,113 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_IMPESSTEPCONTROLLER_HEADER_INCLUDED
+#define OPM_IMPESSTEPCONTROLLER_HEADER_INCLUDED
+
+#include <opm/core/simulator/SimulatorReport.hpp>
+
+#include <vector>
+
+namespace Opm
+{
+
+    class BlackoilState;
+    class BlackoilPropertiesInterface;
+    class CompressibleTpfa;
+    class WellState;
+
+    /// Sequential (IMPES) time step controller for black-oil models.
+    ///
+    /// Each call to step() solves the pressure equation implicitly once,
+    /// using CompressibleTpfa, and then transports the surface volumes
+    /// explicitly in as many substeps as required by the CFL condition
+    /// reported by CompressibleTpfa::stableTransportStep().  The number
+    /// of substeps needed is used to suggest the length of the next
+    /// pressure step, such that pressure solves are not wasted on steps
+    /// much shorter than what the transport can sustain.
+    class ImpesStepController
+    {
+    public:
+        /// Construct controller.
+        /// \param[in] psolver          Pressure solver.
+        /// \param[in] props            Fluid properties, used to recover
+        ///                             saturations from surface volumes.
+        /// \param[in] cfl              Fraction of the stable step used for
+        ///                             each transport substep, in (0, 1].
+        /// \param[in] target_substeps  Desired number of transport substeps
+        ///                             per pressure step.
+        /// \param[in] max_substeps     Maximum number of transport substeps
+        ///                             per pressure step.  step() throws if
+        ///                             exceeded.
+        /// \param[in] max_growth       Maximum factor by which the suggested
+        ///                             step may exceed the previous step.
+        ImpesStepController(CompressibleTpfa& psolver,
+                            const BlackoilPropertiesInterface& props,
+                            const double cfl = 0.9,
+                            const int target_substeps = 4,
+                            const int max_substeps = 100,
+                            const double max_growth = 2.0);
+
+        /// Advance the state by one pressure step followed by explicit,
+        /// CFL-limited transport substeps.
+        /// \param[in]     dt          Pressure time step.
+        /// \param[in,out] state       Reservoir state.  Pressures, fluxes,
+        ///                            surface volumes and saturations are
+        ///                            updated.
+        /// \param[in,out] well_state  Well state.
+        /// \return Timing of the pressure and transport parts.
+        SimulatorReport step(const double dt,
+                             BlackoilState& state,
+                             WellState& well_state);
+
+        /// Pressure time step suggested for the next call to step().
+        double suggestedTimeStep() const;
+
+        /// Number of transport substeps taken in the last call to step().
+        int numSubsteps() const;
+
+        /// Lengths of the transport substeps taken in the last call to
+        /// step(), in order.
+        const std::vector<double>& substepSizes() const;
+
+        /// Length of the next transport substep.
+        /// \param[in] remaining  Time left of the pressure step.
+        /// \param[in] stable_dt  CFL-limited stable step.
+        /// \return The stable step, or the remaining time if shorter.  When
+        ///         the remaining time is less than two stable steps it is
+        ///         split evenly rather than leaving a tiny last substep.
+        static double substepLength(const double remaining,
+                                    const double stable_dt);
+
+    private:
+        CompressibleTpfa& psolver_;
+        const BlackoilPropertiesInterface& props_;
+        const double cfl_;
+        const int target_substeps_;
+        const int max_substeps_;
+        const double max_growth_;
+
+        double suggested_dt_;
+        int num_substeps_;
+        std::vector<double> substep_sizes_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_IMPESSTEPCONTROLLER_HEADER_INCLUDED
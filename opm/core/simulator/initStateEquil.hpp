@@ -44,11 +44,17 @@
 #include <opm/material/fluidstates/SimpleModularFluidState.hpp>
 #include <opm/material/fluidmatrixinteractions/EclMaterialLawManager.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <exception>
 #include <utility>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /**
  * \file
  * Facilities for an ECLIPSE-style equilibration-based
@@ -69,6 +75,53 @@ namespace Opm
      */
     namespace EQUIL {
 
+        /**
+         * Depths of the cell centres and vertical extents of the cells
+         * of a grid, computed once for all equilibration regions.
+         */
+        class CellDepths {
+        public:
+            /**
+             * Compute depths of all cells of a grid.
+             *
+             * \param[in] G Grid.
+             */
+            template <class Grid>
+            explicit CellDepths(const Grid& G);
+
+            /**
+             * Compute depths of a subset of the cells of a grid.  The
+             * depths are indexed by the position of the cell in the
+             * range, not by the cell index, so that the storage is
+             * proportional to the size of the range.
+             *
+             * \param[in] G     Grid.
+             * \param[in] cells Range of cells.
+             */
+            template <class Grid, class CellRange>
+            CellDepths(const Grid& G, const CellRange& cells);
+
+            /// Depth of the cell centre.  The argument is a position in
+            /// the range for depths of a subset of the cells.
+            double center(const int cell) const { return center_[cell]; }
+
+            /// Minimum depth of the nodes of the cell.
+            double top(const int cell) const { return top_[cell]; }
+
+            /// Maximum depth of the nodes of the cell.
+            double bottom(const int cell) const { return bottom_[cell]; }
+
+        private:
+            template <class Grid>
+            void compute(const Grid& G, const std::vector<int>& cells);
+
+            std::vector<double> center_;
+            std::vector<double> top_;
+            std::vector<double> bottom_;
+        };
+
+
+
         /**
          * Compute initial phase pressures by means of equilibration.
          *
@@ -116,6 +169,36 @@ namespace Opm
 
 
 
+        /**
+         * Compute initial phase pressures by means of equilibration,
+         * writing them directly into arrays of all cells.
+         *
+         * Same as the above function, but with the cell depths computed
+         * in advance.  The cells are sorted by depth, so each branch of
+         * the integrated pressure curve of a phase is evaluated for a
+         * contiguous range of depths.
+         *
+         * \param[in]  reg    Current equilibration region.
+         * \param[in]  cells  Range that spans the cells of the current
+         *                    equilibration region.
+         * \param[in]  depths Depths of (at least) the cells of the
+         *                    current equilibration region.
+         * \param[in]  grav   Acceleration of gravity.
+         * \param[out] press  Phase pressures, one vector for each phase
+         *                    with one value for each cell of the grid.
+         *                    Only the values of the cells of the current
+         *                    equilibration region are assigned.
+         */
+        template <class FluidSystem, class Region, class CellRange>
+        void
+        phasePressures(const Region&                       reg,
+                       const CellRange&                    cells,
+                       const CellDepths&                   depths,
+                       const double                        grav,
+                       std::vector< std::vector<double> >& press);
+
+
+
         /**
          * Compute initial phase saturations by means of equilibration.
          *
@@ -156,11 +239,45 @@ namespace Opm
                          const Region&           reg,
                          const CellRange&        cells,
                          MaterialLawManager& materialLawManager,
-                         const std::vector<double> swat_init,
+                         const std::vector<double>& swat_init,
                          std::vector< std::vector<double> >& phase_pressures);
 
 
 
+        /**
+         * Compute initial phase saturations by means of equilibration,
+         * in arrays of all cells.
+         *
+         * Same as the above function, but the pressures are read from
+         * and the saturations written to arrays with one value per cell
+         * of the grid, such as those of the complete initial state.
+         * Only the values of the cells of the current equilibration
+         * region are accessed.
+         *
+         * \param[in]     G                  Grid.
+         * \param[in]     reg                Current equilibration region.
+         * \param[in]     cells              Range that spans the cells of the current
+         *                                   equilibration region.
+         * \param[in]     materialLawManager The MaterialLawManager from opm-material
+         * \param[in]     swat_init          A vector of initial water saturations.
+         * \param[in,out] phase_pressures    Phase pressures, one vector for each phase
+         *                                   with one value per cell of the grid.
+         *                                   Adjusted near the saturation end points.
+         * \param[out]    phase_saturations  Phase saturations, one vector for each phase
+         *                                   with one value per cell of the grid.
+         */
+        template <class FluidSystem, class Grid, class Region, class CellRange, class MaterialLawManager>
+        void
+        phaseSaturations(const Grid&             grid,
+                         const Region&           reg,
+                         const CellRange&        cells,
+                         MaterialLawManager& materialLawManager,
+                         const std::vector<double>& swat_init,
+                         std::vector< std::vector<double> >& phase_pressures,
+                         std::vector< std::vector<double> >& phase_saturations);
+
+
+
         /**
          * Compute initial Rs values.
          *
@@ -182,10 +299,27 @@ namespace Opm
         template <class Grid, class CellRangeType>
         std::vector<double> computeRs(const Grid& grid,
                                       const CellRangeType& cells,
-                                      const std::vector<double> oil_pressure,
+                                      const std::vector<double>& oil_pressure,
                                       const std::vector<double>& temperature,
                                       const Miscibility::RsFunction& rs_func,
-                                      const std::vector<double> gas_saturation);
+                                      const std::vector<double>& gas_saturation);
+
+        /**
+         * Compute initial Rs values in an array of all cells.
+         *
+         * Same as the above function, but oil_pressure, gas_saturation
+         * and rs have one value per cell of the grid.  Only the values
+         * of the cells in the 'cells' range are accessed.  The
+         * temperature still has one value per cell in range.
+         */
+        template <class Grid, class CellRangeType>
+        void computeRs(const Grid& grid,
+                       const CellRangeType& cells,
+                       const std::vector<double>& oil_pressure,
+                       const std::vector<double>& temperature,
+                       const Miscibility::RsFunction& rs_func,
+                       const std::vector<double>& gas_saturation,
+                       std::vector<double>& rs);
 
         namespace DeckDependent {
             inline
@@ -345,7 +479,8 @@ namespace Opm
                     }
                     
                     // Compute pressures, saturations, rs and rv factors.
-                    calcPressSatRsRv(eqlmap, rec, materialLawManager, G, grav);
+                    const CellDepths depths(G);
+                    calcPressSatRsRv(eqlmap, rec, materialLawManager, G, depths, grav);
 
                     // Modify oil pressure in no-oil regions so that the pressures of present phases can
                     // be recovered from the oil pressure and capillary relations.
@@ -388,51 +523,80 @@ namespace Opm
                                  const std::vector< EquilRecord >& rec  ,
                                  MaterialLawManager& materialLawManager,
                                  const Grid&                       G    ,
+                                 const CellDepths&                 depths,
                                  const double grav)
                 {
+                    // Regions are independent: each writes its own cells of
+                    // the result arrays, and only reads the shared tables.
+                    std::vector<int> regions;
                     for (const auto& r : reg.activeRegions()) {
-                        const auto& cells = reg.cells(r);
-                        if (cells.empty())
+                        if (reg.cells(r).empty())
                         {
                             OpmLog::warning("Equilibration region " + std::to_string(r + 1) 
                                             + " has no active cells");
                             continue;
                         }
-
-                        const EqReg eqreg(rec[r], rs_func_[r], rv_func_[r], regionPvtIdx_[r]);
-                   
-                        PVec pressures = phasePressures<FluidSystem>(G, eqreg, cells, grav);
-                        const std::vector<double>& temp = temperature(G, eqreg, cells);
-                        const PVec sat = phaseSaturations<FluidSystem>(G, eqreg, cells, materialLawManager, swat_init_, pressures);
-
-                        const int np = FluidSystem::numPhases;
-                        for (int p = 0; p < np; ++p) {
-                            copyFromRegion(pressures[p], cells, pp_[p]);
-                            copyFromRegion(sat[p], cells, sat_[p]);
+                        regions.push_back(r);
+                    }
+                    // Largest regions first, for load balance.
+                    std::stable_sort(regions.begin(), regions.end(),
+                                     [&reg](const int a, const int b)
+                                     { return reg.cells(a).size() > reg.cells(b).size(); });
+
+                    // With at least as many regions as threads, equilibrate
+                    // the regions concurrently.  Otherwise equilibrate them
+                    // one by one, with the cells of each region shared among
+                    // the threads in phaseSaturations().
+                    const int nreg = regions.size();
+                    int nthreads = 1;
+#ifdef _OPENMP
+                    nthreads = omp_get_max_threads();
+#endif
+                    std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic, 1) if (nreg >= nthreads && nthreads > 1)
+                    for (int i = 0; i < nreg; ++i) {
+                        try {
+                            calcPressSatRsRvRegion(reg, rec, regions[i], materialLawManager, G, depths, grav);
                         }
-                        const bool oil = FluidSystem::phaseIsActive(FluidSystem::oilPhaseIdx);
-                        const bool gas = FluidSystem::phaseIsActive(FluidSystem::gasPhaseIdx);
-                        if (oil && gas) {
-                            const int oilpos = FluidSystem::oilPhaseIdx;
-                            const int gaspos = FluidSystem::gasPhaseIdx;
-                            const Vec rs_vals = computeRs(G, cells, pressures[oilpos], temp, *(rs_func_[r]), sat[gaspos]);
-                            const Vec rv_vals = computeRs(G, cells, pressures[gaspos], temp, *(rv_func_[r]), sat[oilpos]);
-                            copyFromRegion(rs_vals, cells, rs_);
-                            copyFromRegion(rv_vals, cells, rv_);
+                        catch (...) {
+#pragma omp critical
+                            if (!error) {
+                                error = std::current_exception();
+                            }
                         }
                     }
+                    if (error) {
+                        std::rethrow_exception(error);
+                    }
                 }
 
-                template <class CellRangeType>
-                void copyFromRegion(const Vec& source,
-                                    const CellRangeType& cells,
-                                    Vec& destination)
+                template <class RMap, class MaterialLawManager, class Grid>
+                void
+                calcPressSatRsRvRegion(const RMap&                       reg  ,
+                                       const std::vector< EquilRecord >& rec  ,
+                                       const int                         r    ,
+                                       MaterialLawManager& materialLawManager,
+                                       const Grid&                       G    ,
+                                       const CellDepths&                 depths,
+                                       const double grav)
                 {
-                    auto s = source.begin();
-                    auto c = cells.begin();
-                    const auto e = cells.end();
-                    for (; c != e; ++c, ++s) {
-                        destination[*c] = *s;
+                    const auto& cells = reg.cells(r);
+                    const EqReg eqreg(rec[r], rs_func_[r], rv_func_[r], regionPvtIdx_[r]);
+
+                    // All results are written directly into the arrays of
+                    // the complete state.  Concurrent regions write
+                    // disjoint sets of cells.
+                    phasePressures<FluidSystem>(eqreg, cells, depths, grav, pp_);
+                    const std::vector<double>& temp = temperature(G, eqreg, cells);
+                    phaseSaturations<FluidSystem>(G, eqreg, cells, materialLawManager, swat_init_, pp_, sat_);
+
+                    const bool oil = FluidSystem::phaseIsActive(FluidSystem::oilPhaseIdx);
+                    const bool gas = FluidSystem::phaseIsActive(FluidSystem::gasPhaseIdx);
+                    if (oil && gas) {
+                        const int oilpos = FluidSystem::oilPhaseIdx;
+                        const int gaspos = FluidSystem::gasPhaseIdx;
+                        computeRs(G, cells, pp_[oilpos], temp, *(rs_func_[r]), sat_[gaspos], rs_);
+                        computeRs(G, cells, pp_[gaspos], temp, *(rv_func_[r]), sat_[oilpos], rv_);
                     }
                 }
 
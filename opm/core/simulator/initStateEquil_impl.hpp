@@ -28,62 +28,175 @@
 
 #include <opm/material/fluidsystems/BlackOilFluidSystem.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <exception>
 #include <functional>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 namespace Opm
 {
     namespace Details {
+        /// Solution of the scalar initial value problem
+        ///
+        ///     dy/dx = f(x, y),  y(span[0]) = y0,
+        ///
+        /// on the interval between span[0] and span[1], which may be
+        /// traversed in either direction.  Integrated by the embedded
+        /// Dormand-Prince 5(4) pair with adaptive step size control, so
+        /// steps are short where the solution bends (e.g. near fluid
+        /// contacts and depth table nodes) and long elsewhere.  Values
+        /// between the steps are computed by cubic Hermite interpolation
+        /// of the solution and its derivative at the step end points.
+        ///
+        /// Throws std::runtime_error if the error estimate of a step is
+        /// not finite, if the step size becomes negligible compared to
+        /// the interval, or if too many steps are attempted.
         template <class RHS>
-        class RK4IVP {
+        class DormandPrinceIVP {
         public:
-            RK4IVP(const RHS&                  f   ,
-                   const std::array<double,2>& span,
-                   const double                y0  ,
-                   const int                   N   )
-                : N_(N)
-                , span_(span)
+            /// Integrate the problem.
+            /// \param[in] f     Right hand side, callable as f(x, y).
+            /// \param[in] span  Start and end points of the interval.
+            /// \param[in] y0    Value at span[0].
+            /// \param[in] rtol  Relative tolerance of the local error per step.
+            /// \param[in] atol  Absolute tolerance of the local error per step.
+            DormandPrinceIVP(const RHS&                  f   ,
+                             const std::array<double,2>& span,
+                             const double                y0  ,
+                             const double                rtol = 1.0e-10,
+                             const double                atol = 1.0e-6)
             {
-                const double h  = stepsize();
-                const double h2 = h / 2;
-                const double h6 = h / 6;
-
-                y_.reserve(N + 1);
-                f_.reserve(N + 1);
+                const double len = span[1] - span[0];
 
+                x_.push_back(span[0]);
                 y_.push_back(y0);
-                f_.push_back(f(span_[0], y0));
+                f_.push_back(f(span[0], y0));
+
+                if (len == 0.0) {
+                    return;
+                }
+
+                const int    max_steps = 100000;
+                const double dir       = (len > 0.0) ? 1.0 : -1.0;
+                const double hmin      = 1.0e-12 * std::abs(len);
+
+                // The cubic interpolation between steps is less accurate
+                // than the steps themselves, so the step length is also
+                // bounded by a fraction of the interval.
+                const double hmax = std::abs(len) / 64;
+
+                double h = len / 64;
+                int num_attempts = 0; // Accepted and rejected steps.
+                while (dir*(span[1] - x_.back()) > 0.0) {
+                    if (++num_attempts > max_steps) {
+                        OPM_THROW(std::runtime_error, "Phase pressure integration needs more than "
+                                  << max_steps << " steps.");
+                    }
 
-                for (int i = 0; i < N; ++i) {
-                    const double x  = span_[0] + i*h;
+                    const double x  = x_.back();
                     const double y  = y_.back();
+                    const double k1 = f_.back();
 
-                    const double k1 = f_[i];
-                    const double k2 = f(x + h2, y + h2*k1);
-                    const double k3 = f(x + h2, y + h2*k2);
-                    const double k4 = f(x + h , y + h*k3);
+                    // Do not step past the end point, and do not leave
+                    // a tiny last step.
+                    const double rem = span[1] - x;
+                    if (dir*(h - rem) > 0.0 || std::abs(rem - h) < 1.0e-3*std::abs(h)) {
+                        h = rem;
+                    }
+
+                    const double k2 = f(x + h/5,      y + h*(k1/5));
+                    const double k3 = f(x + 3*h/10,   y + h*(3*k1/40 + 9*k2/40));
+                    const double k4 = f(x + 4*h/5,    y + h*(44*k1/45 - 56*k2/15 + 32*k3/9));
+                    const double k5 = f(x + 8*h/9,    y + h*(19372*k1/6561 - 25360*k2/2187
+                                                             + 64448*k3/6561 - 212*k4/729));
+                    const double k6 = f(x + h,        y + h*(9017*k1/3168 - 355*k2/33 + 46732*k3/5247
+                                                             + 49*k4/176 - 5103*k5/18656));
+                    const double y1 = y + h*(35*k1/384 + 500*k3/1113 + 125*k4/192
+                                             - 2187*k5/6784 + 11*k6/84);
+                    const double k7 = f(x + h, y1);
+
+                    // Difference between the fifth and fourth order solutions.
+                    const double e = h*(71*k1/57600 - 71*k3/16695 + 71*k4/1920
+                                        - 17253*k5/339200 + 22*k6/525 - k7/40);
+                    const double sc  = atol + rtol*std::max(std::abs(y), std::abs(y1));
+                    const double err = std::abs(e) / sc;
+                    if (!std::isfinite(err)) {
+                        OPM_THROW(std::runtime_error, "Phase pressure integration failed: "
+                                  "non-finite error estimate at " << x << ".");
+                    }
+
+                    if (err <= 1.0) {
+                        x_.push_back((h == rem) ? span[1] : x + h);
+                        y_.push_back(y1);
+                        f_.push_back(k7);
+                    }
 
-                    y_.push_back(y + h6*(k1 + 2*(k2 + k3) + k4));
-                    f_.push_back(f(x + h, y_.back()));
+                    // Standard step size controller with safety factor.
+                    const double fac = (err == 0.0) ? 5.0 : 0.9*std::pow(err, -0.2);
+                    h *= std::min(5.0, std::max(0.2, fac));
+                    h  = dir * std::min(std::abs(h), hmax);
+                    if (err > 1.0 && std::abs(h) < hmin) {
+                        OPM_THROW(std::runtime_error, "Phase pressure integration failed: "
+                                  "step size underflow at " << x << ".");
+                    }
                 }
 
-                assert (y_.size() == std::vector<double>::size_type(N + 1));
+                assert (x_.size() == y_.size());
+                assert (x_.size() == f_.size());
             }
 
             double
             operator()(const double x) const
             {
-                // Dense output (O(h**3)) according to Shampine
-                // (Hermite interpolation)
-                const double h = stepsize();
-                int          i = (x - span_[0]) / h;
-                const double t = (x - (span_[0] + i*h)) / h;
+                return evaluate(x);
+            }
+
+            /// Evaluate the dense output at n points.  Same as calling
+            /// operator()(x[k]) for each point, but in a single loop
+            /// that the compiler can keep tight.
+            void
+            operator()(const int n, const double* x, double* y) const
+            {
+                for (int k = 0; k < n; ++k) {
+                    y[k] = evaluate(x[k]);
+                }
+            }
+
+            /// Number of integration steps taken.
+            int
+            numSteps() const { return int(x_.size()) - 1; }
+
+        private:
+            std::vector<double> x_;
+            std::vector<double> y_;
+            std::vector<double> f_;
+
+            double
+            evaluate(const double x) const
+            {
+                const int n = x_.size();
+                if (n == 1) {
+                    return y_[0] + (x - x_[0])*f_[0];
+                }
 
-                // Crude handling of evaluation point outside "span_";
-                if (i  <  0) { i = 0;      }
-                if (N_ <= i) { i = N_ - 1; }
+                // Step [x_[i], x_[i + 1]] containing x.  Evaluation
+                // points outside the interval use the first or last
+                // step's polynomial.
+                int i;
+                if (x_[n - 1] > x_[0]) {
+                    i = int(std::upper_bound(x_.begin(), x_.end(), x) - x_.begin()) - 1;
+                } else {
+                    i = int(std::upper_bound(x_.begin(), x_.end(), x, std::greater<double>()) - x_.begin()) - 1;
+                }
+                if (i  <  0    ) { i = 0;     }
+                if (n - 1 <= i ) { i = n - 2; }
+
+                const double h = x_[i + 1] - x_[i];
+                const double t = (x - x_[i]) / h;
 
                 const double y0 = y_[i], y1 = y_[i + 1];
                 const double f0 = f_[i], f1 = f_[i + 1];
@@ -95,15 +208,6 @@ namespace Opm
 
                 return u;
             }
-
-        private:
-            int                  N_;
-            std::array<double,2> span_;
-            std::vector<double>  y_;
-            std::vector<double>  f_;
-
-            double
-            stepsize() const { return (span_[1] - span_[0]) / N_; }
         };
 
         namespace PhasePressODE {
@@ -237,42 +341,43 @@ namespace Opm
 
 
         namespace PhasePressure {
-            template <class Grid,
-                      class PressFunction,
-                      class CellRange>
+            // The cells are sorted by increasing depth z, so those above
+            // the split depth form a prefix and each of the two pressure
+            // functions is evaluated for a contiguous range of depths.
+            template <class PressFunction>
             void
-            assign(const Grid&                         G    ,
-                   const std::array<PressFunction, 2>& f    ,
+            assign(const std::array<PressFunction, 2>& f    ,
                    const double                        split,
-                   const CellRange&                    cells,
+                   const std::vector<int>&             cells,
+                   const std::vector<double>&          z    ,
                    std::vector<double>&                p    )
             {
 
                 enum { up = 0, down = 1 };
 
-                std::vector<double>::size_type c = 0;
-                for (typename CellRange::const_iterator
-                         ci = cells.begin(), ce = cells.end();
-                     ci != ce; ++ci, ++c)
-                {
-                    assert (c < p.size());
+                assert (std::is_sorted(z.begin(), z.end()));
+                const int n   = z.size();
+                const int nup = std::lower_bound(z.begin(), z.end(), split) - z.begin();
 
-                    const double z = UgGridHelpers::cellCenterDepth(G, *ci);
-                    p[c] = (z < split) ? f[up](z) : f[down](z);
+                std::vector<double> pz(n);
+                f[up]  (nup    , z.data()      , pz.data()      );
+                f[down](n - nup, z.data() + nup, pz.data() + nup);
+
+                for (int k = 0; k < n; ++k) {
+                    assert (std::vector<double>::size_type(cells[k]) < p.size());
+                    p[cells[k]] = pz[k];
                 }
             }
 
-            template <                     class FluidSystem,
-                                           class Grid,
-                                           class Region,
-                                           class CellRange>
+            template <class FluidSystem,
+                      class Region>
             void
-            water(const Grid&                 G     ,
-                  const Region&               reg   ,
+            water(const Region&               reg   ,
                   const std::array<double,2>& span  ,
                   const double                grav  ,
                   double&                     po_woc,
-                  const CellRange&            cells ,
+                  const std::vector<int>&     cells ,
+                  const std::vector<double>&  z     ,
                   std::vector<double>&        press )
             {
                 using PhasePressODE::Water;
@@ -294,16 +399,16 @@ namespace Opm
                 std::array<double,2> up   = {{ z0, span[0] }};
                 std::array<double,2> down = {{ z0, span[1] }};
 
-                typedef Details::RK4IVP<ODE> WPress;
+                typedef Details::DormandPrinceIVP<ODE> WPress;
                 std::array<WPress,2> wpress = {
                     {
-                        WPress(drho, up  , p0, 2000)
+                        WPress(drho, up  , p0)
                         ,
-                        WPress(drho, down, p0, 2000)
+                        WPress(drho, down, p0)
                     }
                 };
 
-                assign(G, wpress, z0, cells, press);
+                assign(wpress, z0, cells, z, press);
 
                 if (reg.datum() > reg.zwoc()) {
                     // Return oil pressure at contact
@@ -312,15 +417,13 @@ namespace Opm
             }
 
             template <class FluidSystem,
-                      class Grid,
-                      class Region,
-                      class CellRange>
+                      class Region>
             void
-            oil(const Grid&                 G     ,
-                const Region&               reg   ,
+            oil(const Region&               reg   ,
                 const std::array<double,2>& span  ,
                 const double                grav  ,
-                const CellRange&            cells ,
+                const std::vector<int>&     cells ,
+                const std::vector<double>&  z     ,
                 std::vector<double>&        press ,
                 double&                     po_woc,
                 double&                     po_goc)
@@ -348,16 +451,16 @@ namespace Opm
                 std::array<double,2> up   = {{ z0, span[0] }};
                 std::array<double,2> down = {{ z0, span[1] }};
 
-                typedef Details::RK4IVP<ODE> OPress;
+                typedef Details::DormandPrinceIVP<ODE> OPress;
                 std::array<OPress,2> opress = {
                     {
-                        OPress(drho, up  , p0, 2000)
+                        OPress(drho, up  , p0)
                         ,
-                        OPress(drho, down, p0, 2000)
+                        OPress(drho, down, p0)
                     }
                 };
 
-                assign(G, opress, z0, cells, press);
+                assign(opress, z0, cells, z, press);
 
                 const double woc = reg.zwoc();
                 if      (z0 > woc) { po_woc = opress[0](woc); } // WOC above datum
@@ -371,16 +474,14 @@ namespace Opm
             }
 
             template <class FluidSystem,
-                      class Grid,
-                      class Region,
-                      class CellRange>
+                      class Region>
             void
-            gas(const Grid&                 G     ,
-                const Region&               reg   ,
+            gas(const Region&               reg   ,
                 const std::array<double,2>& span  ,
                 const double                grav  ,
                 double&                     po_goc,
-                const CellRange&            cells ,
+                const std::vector<int>&     cells ,
+                const std::vector<double>&  z     ,
                 std::vector<double>&        press )
             {
                 using PhasePressODE::Gas;
@@ -403,16 +504,16 @@ namespace Opm
                 std::array<double,2> up   = {{ z0, span[0] }};
                 std::array<double,2> down = {{ z0, span[1] }};
 
-                typedef Details::RK4IVP<ODE> GPress;
+                typedef Details::DormandPrinceIVP<ODE> GPress;
                 std::array<GPress,2> gpress = {
                     {
-                        GPress(drho, up  , p0, 2000)
+                        GPress(drho, up  , p0)
                         ,
-                        GPress(drho, down, p0, 2000)
+                        GPress(drho, down, p0)
                     }
                 };
 
-                assign(G, gpress, z0, cells, press);
+                assign(gpress, z0, cells, z, press);
 
                 if (reg.datum() < reg.zgoc()) {
                     // Return oil pressure at contact
@@ -422,15 +523,13 @@ namespace Opm
         } // namespace PhasePressure
 
         template <class FluidSystem,
-                  class Grid,
-                  class Region,
-                  class CellRange>
+                  class Region>
         void
-        equilibrateOWG(const Grid&                         G,
-                       const Region&                       reg,
+        equilibrateOWG(const Region&                       reg,
                        const double                        grav,
                        const std::array<double,2>&         span,
-                       const CellRange&                    cells,
+                       const std::vector<int>&             cells,
+                       const std::vector<double>&          z,
                        std::vector< std::vector<double> >& press)
         {
             const bool water = FluidSystem::phaseIsActive(FluidSystem::waterPhaseIdx);
@@ -445,54 +544,54 @@ namespace Opm
                 double po_goc = -1;
 
                 if (water) {
-                    PhasePressure::water<FluidSystem>(G, reg, span, grav, po_woc,
-                                         cells, press[ waterpos ]);
+                    PhasePressure::water<FluidSystem>(reg, span, grav, po_woc,
+                                         cells, z, press[ waterpos ]);
                 }
 
                 if (oil) {
-                    PhasePressure::oil<FluidSystem>(G, reg, span, grav, cells,
+                    PhasePressure::oil<FluidSystem>(reg, span, grav, cells, z,
                                        press[ oilpos ], po_woc, po_goc);
                 }
 
                 if (gas) {
-                    PhasePressure::gas<FluidSystem>(G, reg, span, grav, po_goc,
-                                       cells, press[ gaspos ]);
+                    PhasePressure::gas<FluidSystem>(reg, span, grav, po_goc,
+                                       cells, z, press[ gaspos ]);
                 }
             } else if (reg.datum() < reg.zgoc()) { // Datum in gas zone
                 double po_woc = -1;
                 double po_goc = -1;
 
                 if (gas) {
-                    PhasePressure::gas<FluidSystem>(G, reg, span, grav, po_goc,
-                                       cells, press[ gaspos ]);
+                    PhasePressure::gas<FluidSystem>(reg, span, grav, po_goc,
+                                       cells, z, press[ gaspos ]);
                 }
 
                 if (oil) {
-                    PhasePressure::oil<FluidSystem>(G, reg, span, grav, cells,
+                    PhasePressure::oil<FluidSystem>(reg, span, grav, cells, z,
                                        press[ oilpos ], po_woc, po_goc);
                 }
 
                 if (water) {
-                    PhasePressure::water<FluidSystem>(G, reg, span, grav, po_woc,
-                                         cells, press[ waterpos ]);
+                    PhasePressure::water<FluidSystem>(reg, span, grav, po_woc,
+                                         cells, z, press[ waterpos ]);
                 }
             } else { // Datum in oil zone
                 double po_woc = -1;
                 double po_goc = -1;
 
                 if (oil) {
-                    PhasePressure::oil<FluidSystem>(G, reg, span, grav, cells,
+                    PhasePressure::oil<FluidSystem>(reg, span, grav, cells, z,
                                                     press[ oilpos ], po_woc, po_goc);
                 }
 
                 if (water) {
-                    PhasePressure::water<FluidSystem>(G, reg, span, grav, po_woc,
-                                         cells, press[ waterpos ]);
+                    PhasePressure::water<FluidSystem>(reg, span, grav, po_woc,
+                                         cells, z, press[ waterpos ]);
                 }
 
                 if (gas) {
-                    PhasePressure::gas<FluidSystem>(G, reg, span, grav, po_goc,
-                                       cells, press[ gaspos ]);
+                    PhasePressure::gas<FluidSystem>(reg, span, grav, po_goc,
+                                       cells, z, press[ gaspos ]);
                 }
             }
         }
@@ -502,67 +601,106 @@ namespace Opm
     namespace EQUIL {
 
 
+        template <class Grid, class CellRange>
+        CellDepths::CellDepths(const Grid& G, const CellRange& cells)
+            : center_(cells.size())
+            , top_   (cells.size())
+            , bottom_(cells.size())
+        {
+            compute(G, std::vector<int>(cells.begin(), cells.end()));
+        }
+
+        template <class Grid>
+        CellDepths::CellDepths(const Grid& G)
+            : center_(UgGridHelpers::numCells(G))
+            , top_   (UgGridHelpers::numCells(G))
+            , bottom_(UgGridHelpers::numCells(G))
+        {
+            std::vector<int> cells(UgGridHelpers::numCells(G));
+            for (int c = 0; c < int(cells.size()); ++c) {
+                cells[c] = c;
+            }
+            compute(G, cells);
+        }
+
+        template <class Grid>
+        void
+        CellDepths::compute(const Grid& G, const std::vector<int>& cells)
+        {
+            // This code is only supported in three space dimensions
+            assert (UgGridHelpers::dimensions(G) == 3);
+
+            const int nd = UgGridHelpers::dimensions(G);
+
+            // The vertical extent of a cell is that of its nodes, found
+            // by looping the nodes of all faces of the cell.
+            auto cell2Faces = UgGridHelpers::cell2Faces(G);
+            auto faceVertices = UgGridHelpers::face2Vertices(G);
+
+            // The depths of cells[i] are stored at position i.
+            const int n = cells.size();
+#pragma omp parallel for schedule(static)
+            for (int i = 0; i < n; ++i) {
+                const int c = cells[i];
+                double ztop    =  std::numeric_limits<double>::max();
+                double zbottom = -std::numeric_limits<double>::max();
+                for (auto fi=cell2Faces[c].begin(),
+                          fe=cell2Faces[c].end();
+                     fi != fe;
+                     ++fi)
+                {
+                    for (auto vi = faceVertices[*fi].begin(), ve = faceVertices[*fi].end();
+                         vi != ve; ++vi)
+                    {
+                        const double z = UgGridHelpers::vertexCoordinates(G, *vi)[nd-1];
+
+                        if (z < ztop)    { ztop = z;    }
+                        if (z > zbottom) { zbottom = z; }
+                    }
+                }
+                center_[i] = UgGridHelpers::cellCenterDepth(G, c);
+                top_[i]    = ztop;
+                bottom_[i] = zbottom;
+            }
+        }
+
+
         template <class FluidSystem,
-                  class Grid,
                   class Region,
                   class CellRange>
-        std::vector< std::vector<double> >
-        phasePressures(const Grid&             G,
-                       const Region&           reg,
-                       const CellRange&        cells,
-                       const double            grav)
+        void
+        phasePressures(const Region&                       reg,
+                       const CellRange&                    cells,
+                       const CellDepths&                   depths,
+                       const double                        grav,
+                       std::vector< std::vector<double> >& press)
         {
+            // Define vertical span as
+            //
+            //   [minimum(node depth(cells)), maximum(node depth(cells))]
+            //
+            // Note: The implementation of 'DormandPrinceIVP<>' implicitly
+            // imposes the requirement that cell centroids are all
+            // within this vertical span.  That requirement is not
+            // checked.
             std::array<double,2> span =
                 {{  std::numeric_limits<double>::max() ,
                    -std::numeric_limits<double>::max() }}; // Symm. about 0.
 
-            int ncell = 0;
-            {
-                // This code is only supported in three space dimensions
-                assert (UgGridHelpers::dimensions(G) == 3);
-
-                const int nd = UgGridHelpers::dimensions(G);
-
-                // Define vertical span as
-                //
-                //   [minimum(node depth(cells)), maximum(node depth(cells))]
-                //
-                // Note: We use a sledgehammer approach--looping all
-                // the nodes of all the faces of all the 'cells'--to
-                // compute those bounds.  This necessarily entails
-                // visiting some nodes (and faces) multiple times.
-                //
-                // Note: The implementation of 'RK4IVP<>' implicitly
-                // imposes the requirement that cell centroids are all
-                // within this vertical span.  That requirement is not
-                // checked.
-                auto cell2Faces = UgGridHelpers::cell2Faces(G);
-                auto faceVertices = UgGridHelpers::face2Vertices(G);
-
-                for (typename CellRange::const_iterator
-                         ci = cells.begin(), ce = cells.end();
-                     ci != ce; ++ci, ++ncell)
-                {
-                    for (auto fi=cell2Faces[*ci].begin(),
-                              fe=cell2Faces[*ci].end();
-                         fi != fe;
-                         ++fi)
-                    {
-                        for (auto i = faceVertices[*fi].begin(), e = faceVertices[*fi].end();
-                             i != e; ++i)
-                        {
-                            const double z = UgGridHelpers::vertexCoordinates(G, *i)[nd-1];
-
-                            if (z < span[0]) { span[0] = z; }
-                            if (z > span[1]) { span[1] = z; }
-                        }
-                    }
-                }
+            std::vector<int> order(cells.begin(), cells.end());
+            for (const int c : order) {
+                span[0] = std::min(span[0], depths.top(c));
+                span[1] = std::max(span[1], depths.bottom(c));
             }
-            const int np = FluidSystem::numPhases;  //reg.phaseUsage().num_phases;
 
-            typedef std::vector<double> pval;
-            std::vector<pval> press(np, pval(ncell, 0.0));
+            // Evaluate the pressure curves in order of increasing depth.
+            std::sort(order.begin(), order.end(),
+                      [&depths](const int a, const int b)
+                      { return depths.center(a) < depths.center(b); });
+            std::vector<double> z(order.size());
+            for (int k = 0; k < int(order.size()); ++k) {
+                z[k] = depths.center(order[k]);
+            }
 
             const double zwoc = reg.zwoc ();
             const double zgoc = reg.zgoc ();
@@ -571,7 +709,34 @@ namespace Opm
             span[0] = std::min(span[0],zgoc);
             span[1] = std::max(span[1],zwoc);
 
-            Details::equilibrateOWG<FluidSystem>(G, reg, grav, span, cells, press);
+            Details::equilibrateOWG<FluidSystem>(reg, grav, span, order, z, press);
+        }
+
+        template <class FluidSystem,
+                  class Grid,
+                  class Region,
+                  class CellRange>
+        std::vector< std::vector<double> >
+        phasePressures(const Grid&             G,
+                       const Region&           reg,
+                       const CellRange&        cells,
+                       const double            grav)
+        {
+            // Depths and pressures of the region only, indexed by the
+            // position of the cell in the range.
+            const CellDepths depths(G, cells);
+
+            const int n = cells.size();
+            const int np = FluidSystem::numPhases;  //reg.phaseUsage().num_phases;
+
+            std::vector<int> local(n);
+            for (int i = 0; i < n; ++i) {
+                local[i] = i;
+            }
+
+            typedef std::vector<double> pval;
+            std::vector<pval> press(np, pval(n, 0.0));
+            phasePressures<FluidSystem>(reg, local, depths, grav, press);
 
             return press;
         }
@@ -588,21 +753,24 @@ namespace Opm
             return std::vector<double>(cells.size(), 273.15 + 20.0);
         }
 
-        template <class FluidSystem, class Grid, class Region, class CellRange, class MaterialLawManager>
-        std::vector< std::vector<double> >
-        phaseSaturations(const Grid&             G,
-                         const Region&           reg,
-                         const CellRange&        cells,
-                         MaterialLawManager& materialLawManager,
-                         const std::vector<double> swat_init,
-                         std::vector< std::vector<double> >& phase_pressures)
+        // Saturations of the cells of a region.  The pressures and
+        // saturations of cellvec[i] are at position cellvec[i] of the
+        // arrays, or at position i if region_indexed is true.
+        template <class FluidSystem, class Grid, class Region, class MaterialLawManager>
+        void
+        regionSaturations(const Grid&             G,
+                          const Region&           reg,
+                          const std::vector<int>& cellvec,
+                          MaterialLawManager& materialLawManager,
+                          const std::vector<double>& swat_init,
+                          const bool              region_indexed,
+                          std::vector< std::vector<double> >& phase_pressures,
+                          std::vector< std::vector<double> >& phase_saturations)
         {
             if (!FluidSystem::phaseIsActive(FluidSystem::oilPhaseIdx)) {
                 OPM_THROW(std::runtime_error, "Cannot initialise: not handling water-gas cases.");
             }
 
-            std::vector< std::vector<double> > phase_saturations = phase_pressures; // Just to get the right size.
-
             // Adjust oil pressure according to gas saturation and cap pressure
             typedef Opm::SimpleModularFluidState<double,
                     /*numPhases=*/3,
@@ -617,7 +785,6 @@ namespace Opm
                     /*storeViscosity=*/false,
                     /*storeEnthalpy=*/false> SatOnlyFluidState;
 
-            SatOnlyFluidState fluidState;
             typedef typename MaterialLawManager::MaterialLaw MaterialLaw;
 
             const bool water = FluidSystem::phaseIsActive(FluidSystem::waterPhaseIdx);
@@ -625,124 +792,184 @@ namespace Opm
             const int oilpos = FluidSystem::oilPhaseIdx;
             const int waterpos = FluidSystem::waterPhaseIdx;
             const int gaspos = FluidSystem::gasPhaseIdx;
-            std::vector<double>::size_type local_index = 0;
-            for (typename CellRange::const_iterator ci = cells.begin(); ci != cells.end(); ++ci, ++local_index) {
-                const int cell = *ci;
-                const auto& scaledDrainageInfo =
-                    materialLawManager.oilWaterScaledEpsInfoDrainage(cell);
-                const auto& matParams = materialLawManager.materialLawParams(cell);
-
-                // Find saturations from pressure differences by
-                // inverting capillary pressure functions.
-                double sw = 0.0;
-                if (water) {
-                    if (isConstPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,FluidSystem::waterPhaseIdx, cell)){
-                        const double cellDepth  =  UgGridHelpers::cellCenterDepth(G,
-                                                                            cell);
-                        sw = satFromDepth<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,cellDepth,reg.zwoc(),waterpos,cell,false);
-                        phase_saturations[waterpos][local_index] = sw;
+
+            const int ncells = cellvec.size();
+
+            // Sampled Pc functions of the SATNUM regions present.  SWATINIT
+            // rescales the Pc curves of individual cells, so the tables
+            // are only used without it.
+            const PcInverseTables<FluidSystem, MaterialLaw, MaterialLawManager>
+                pcInverse(materialLawManager, swat_init.empty() ? cellvec : std::vector<int>());
+
+            // The cells are independent, also with SWATINIT whose scaling
+            // only modifies the material law parameters of the cell itself.
+            // The SWATINIT scaling is therefore done in this loop, as the
+            // cell is reached, rather than in a separate pass over the
+            // region: the scaling is parallel either way, and a pass of its
+            // own would need per-region buffers for the scaled saturations
+            // and the constant-Pc classification.
+            std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic, 64)
+            for (int local_index = 0; local_index < ncells; ++local_index) {
+                try {
+                    const int cell = cellvec[local_index];
+                    const int slot = region_indexed ? local_index : cell;
+                    SatOnlyFluidState fluidState;
+                    const auto& scaledDrainageInfo =
+                        materialLawManager.oilWaterScaledEpsInfoDrainage(cell);
+                    const auto& matParams = materialLawManager.materialLawParams(cell);
+
+                    // Find saturations from pressure differences by
+                    // inverting capillary pressure functions.
+                    double sw = 0.0;
+                    if (water) {
+                        if (isConstPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,FluidSystem::waterPhaseIdx, cell)){
+                            const double cellDepth  =  UgGridHelpers::cellCenterDepth(G,
+                                                                                cell);
+                            sw = satFromDepth<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,cellDepth,reg.zwoc(),waterpos,cell,false);
+                            phase_saturations[waterpos][slot] = sw;
+                        }
+                        else{
+                            const double pcov = phase_pressures[oilpos][slot] - phase_pressures[waterpos][slot];
+                            if (swat_init.empty()) { // Invert Pc to find sw
+                                sw = pcInverse.satFromPc(waterpos, cell, pcov);
+                                phase_saturations[waterpos][slot] = sw;
+                            } else { // Scale Pc to reflect imposed sw
+                                sw = swat_init[cell];
+                                sw = materialLawManager.applySwatinit(cell, pcov, sw);
+                                phase_saturations[waterpos][slot] = sw;
+                            }
+                        }
                     }
-                    else{
-                        const double pcov = phase_pressures[oilpos][local_index] - phase_pressures[waterpos][local_index];
-                        if (swat_init.empty()) { // Invert Pc to find sw
-                            sw = satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, waterpos, cell, pcov);
-                            phase_saturations[waterpos][local_index] = sw;
-                        } else { // Scale Pc to reflect imposed sw
-                            sw = swat_init[cell];
-                            sw = materialLawManager.applySwatinit(cell, pcov, sw);
-                            phase_saturations[waterpos][local_index] = sw;
+                    double sg = 0.0;
+                    if (gas) {
+                        if (isConstPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,FluidSystem::gasPhaseIdx,cell)){
+                            const double cellDepth  = UgGridHelpers::cellCenterDepth(G,
+                                                                                            cell);
+                            sg = satFromDepth<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,cellDepth,reg.zgoc(),gaspos,cell,true);
+                            phase_saturations[gaspos][slot] = sg;
+                        }
+                        else{
+                            // Note that pcog is defined to be (pg - po), not (po - pg).
+                            const double pcog = phase_pressures[gaspos][slot] - phase_pressures[oilpos][slot];
+                            const double increasing = true; // pcog(sg) expected to be increasing function
+                            sg = pcInverse.satFromPc(gaspos, cell, pcog, increasing);
+                            phase_saturations[gaspos][slot] = sg;
                         }
                     }
-                }
-                double sg = 0.0;
-                if (gas) {
-                    if (isConstPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,FluidSystem::gasPhaseIdx,cell)){
-                        const double cellDepth  = UgGridHelpers::cellCenterDepth(G,
-                                                                                        cell);
-                        sg = satFromDepth<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,cellDepth,reg.zgoc(),gaspos,cell,true);
-                        phase_saturations[gaspos][local_index] = sg;
+                    if (gas && water && (sg + sw > 1.0)) {
+                        // Overlapping gas-oil and oil-water transition
+                        // zones can lead to unphysical saturations when
+                        // treated as above. Must recalculate using gas-water
+                        // capillary pressure.
+                        const double pcgw = phase_pressures[gaspos][slot] - phase_pressures[waterpos][slot];
+                        if (! swat_init.empty()) { 
+                            // Re-scale Pc to reflect imposed sw for vanishing oil phase.
+                            // This seems consistent with ecl, and fails to honour 
+                            // swat_init in case of non-trivial gas-oil cap pressure.
+                            sw = materialLawManager.applySwatinit(cell, pcgw, sw);
+                        }
+                        sw = pcInverse.satFromSumOfPcs(waterpos, gaspos, cell, pcgw);
+                        sg = 1.0 - sw;
+                        phase_saturations[waterpos][slot] = sw;
+                        phase_saturations[gaspos][slot] = sg;
+                        if ( water ) {
+                            fluidState.setSaturation(FluidSystem::waterPhaseIdx, sw);
+                        }
+                        else {
+                            fluidState.setSaturation(FluidSystem::waterPhaseIdx, 0.0);
+                        }
+                        fluidState.setSaturation(FluidSystem::oilPhaseIdx, 1.0 - sw - sg);
+                        fluidState.setSaturation(FluidSystem::gasPhaseIdx, sg);
+
+                        double pC[/*numPhases=*/3] = { 0.0, 0.0, 0.0 };
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
+                        phase_pressures[oilpos][slot] = phase_pressures[gaspos][slot] - pcGas;
                     }
-                    else{
-                        // Note that pcog is defined to be (pg - po), not (po - pg).
-                        const double pcog = phase_pressures[gaspos][local_index] - phase_pressures[oilpos][local_index];
-                        const double increasing = true; // pcog(sg) expected to be increasing function
-                        sg = satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, gaspos, cell, pcog, increasing);
-                        phase_saturations[gaspos][local_index] = sg;
+                    phase_saturations[oilpos][slot] = 1.0 - sw - sg;
+                
+                    // Adjust phase pressures for max and min saturation ...
+                    double threshold_sat = 1.0e-6;
+
+                    double so = 1.0;
+                    double pC[FluidSystem::numPhases] = { 0.0, 0.0, 0.0 };
+                    if (water) {
+                        double swu = scaledDrainageInfo.Swu;
+                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, swu);
+                        so -= swu;
                     }
-                }
-                if (gas && water && (sg + sw > 1.0)) {
-                    // Overlapping gas-oil and oil-water transition
-                    // zones can lead to unphysical saturations when
-                    // treated as above. Must recalculate using gas-water
-                    // capillary pressure.
-                    const double pcgw = phase_pressures[gaspos][local_index] - phase_pressures[waterpos][local_index];
-                    if (! swat_init.empty()) { 
-                        // Re-scale Pc to reflect imposed sw for vanishing oil phase.
-                        // This seems consistent with ecl, and fails to honour 
-                        // swat_init in case of non-trivial gas-oil cap pressure.
-                        sw = materialLawManager.applySwatinit(cell, pcgw, sw);
+                    if (gas) {
+                        double sgu = scaledDrainageInfo.Sgu;
+                        fluidState.setSaturation(FluidSystem::gasPhaseIdx, sgu);
+                        so-= sgu;
                     }
-                    sw = satFromSumOfPcs<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, waterpos, gaspos, cell, pcgw);
-                    sg = 1.0 - sw;
-                    phase_saturations[waterpos][local_index] = sw;
-                    phase_saturations[gaspos][local_index] = sg;
-                    if ( water ) {
-                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, sw);
+                    fluidState.setSaturation(FluidSystem::oilPhaseIdx, so);
+
+                    if (water && sw > scaledDrainageInfo.Swu-threshold_sat ) {
+                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, scaledDrainageInfo.Swu);
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcWat = pC[FluidSystem::oilPhaseIdx] - pC[FluidSystem::waterPhaseIdx];
+                        phase_pressures[oilpos][slot] = phase_pressures[waterpos][slot] + pcWat;
+                    } else if (gas && sg > scaledDrainageInfo.Sgu-threshold_sat) {
+                        fluidState.setSaturation(FluidSystem::gasPhaseIdx, scaledDrainageInfo.Sgu);
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
+                        phase_pressures[oilpos][slot] = phase_pressures[gaspos][slot] - pcGas;
                     }
-                    else {
-                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, 0.0);
+                    if (gas && sg < scaledDrainageInfo.Sgl+threshold_sat) {
+                        fluidState.setSaturation(FluidSystem::gasPhaseIdx, scaledDrainageInfo.Sgl);
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
+                        phase_pressures[gaspos][slot] = phase_pressures[oilpos][slot] + pcGas;
+                    }
+                    if (water && sw < scaledDrainageInfo.Swl+threshold_sat) {
+                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, scaledDrainageInfo.Swl);
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcWat = pC[FluidSystem::oilPhaseIdx] - pC[FluidSystem::waterPhaseIdx];
+                        phase_pressures[waterpos][slot] = phase_pressures[oilpos][slot] - pcWat;
                     }
-                    fluidState.setSaturation(FluidSystem::oilPhaseIdx, 1.0 - sw - sg);
-                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, sg);
-
-                    double pC[/*numPhases=*/3] = { 0.0, 0.0, 0.0 };
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
-                    phase_pressures[oilpos][local_index] = phase_pressures[gaspos][local_index] - pcGas;
-                }
-                phase_saturations[oilpos][local_index] = 1.0 - sw - sg;
-                
-                // Adjust phase pressures for max and min saturation ...
-                double threshold_sat = 1.0e-6;
-
-                double so = 1.0;
-                double pC[FluidSystem::numPhases] = { 0.0, 0.0, 0.0 };
-                if (water) {
-                    double swu = scaledDrainageInfo.Swu;
-                    fluidState.setSaturation(FluidSystem::waterPhaseIdx, swu);
-                    so -= swu;
                 }
-                if (gas) {
-                    double sgu = scaledDrainageInfo.Sgu;
-                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, sgu);
-                    so-= sgu;
-                }
-                fluidState.setSaturation(FluidSystem::oilPhaseIdx, so);
-
-                if (water && sw > scaledDrainageInfo.Swu-threshold_sat ) {
-                    fluidState.setSaturation(FluidSystem::waterPhaseIdx, scaledDrainageInfo.Swu);
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcWat = pC[FluidSystem::oilPhaseIdx] - pC[FluidSystem::waterPhaseIdx];
-                    phase_pressures[oilpos][local_index] = phase_pressures[waterpos][local_index] + pcWat;
-                } else if (gas && sg > scaledDrainageInfo.Sgu-threshold_sat) {
-                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, scaledDrainageInfo.Sgu);
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
-                    phase_pressures[oilpos][local_index] = phase_pressures[gaspos][local_index] - pcGas;
-                }
-                if (gas && sg < scaledDrainageInfo.Sgl+threshold_sat) {
-                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, scaledDrainageInfo.Sgl);
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
-                    phase_pressures[gaspos][local_index] = phase_pressures[oilpos][local_index] + pcGas;
-                }
-                if (water && sw < scaledDrainageInfo.Swl+threshold_sat) {
-                    fluidState.setSaturation(FluidSystem::waterPhaseIdx, scaledDrainageInfo.Swl);
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcWat = pC[FluidSystem::oilPhaseIdx] - pC[FluidSystem::waterPhaseIdx];
-                    phase_pressures[waterpos][local_index] = phase_pressures[oilpos][local_index] - pcWat;
+                catch (...) {
+#pragma omp critical
+                    if (!error) {
+                        error = std::current_exception();
+                    }
                 }
             }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        template <class FluidSystem, class Grid, class Region, class CellRange, class MaterialLawManager>
+        void
+        phaseSaturations(const Grid&             G,
+                         const Region&           reg,
+                         const CellRange&        cells,
+                         MaterialLawManager& materialLawManager,
+                         const std::vector<double>& swat_init,
+                         std::vector< std::vector<double> >& phase_pressures,
+                         std::vector< std::vector<double> >& phase_saturations)
+        {
+            const std::vector<int> cellvec(cells.begin(), cells.end());
+            regionSaturations<FluidSystem>(G, reg, cellvec, materialLawManager, swat_init,
+                                           /*region_indexed=*/false, phase_pressures, phase_saturations);
+        }
+
+        template <class FluidSystem, class Grid, class Region, class CellRange, class MaterialLawManager>
+        std::vector< std::vector<double> >
+        phaseSaturations(const Grid&             G,
+                         const Region&           reg,
+                         const CellRange&        cells,
+                         MaterialLawManager& materialLawManager,
+                         const std::vector<double>& swat_init,
+                         std::vector< std::vector<double> >& phase_pressures)
+        {
+            const std::vector<int> cellvec(cells.begin(), cells.end());
+            std::vector< std::vector<double> > phase_saturations = phase_pressures; // Inactive phases keep the pressure values.
+            regionSaturations<FluidSystem>(G, reg, cellvec, materialLawManager, swat_init,
+                                           /*region_indexed=*/true, phase_pressures, phase_saturations);
             return phase_saturations;
         }
 
@@ -768,10 +995,10 @@ namespace Opm
         template <class Grid, class CellRangeType>
         std::vector<double> computeRs(const Grid& grid,
                                       const CellRangeType& cells,
-                                      const std::vector<double> oil_pressure,
+                                      const std::vector<double>& oil_pressure,
                                       const std::vector<double>& temperature,
                                       const Miscibility::RsFunction& rs_func,
-                                      const std::vector<double> gas_saturation)
+                                      const std::vector<double>& gas_saturation)
         {
             assert(UgGridHelpers::dimensions(grid) == 3);
             std::vector<double> rs(cells.size());
@@ -783,6 +1010,24 @@ namespace Opm
             return rs;
         }
 
+        template <class Grid, class CellRangeType>
+        void computeRs(const Grid& grid,
+                       const CellRangeType& cells,
+                       const std::vector<double>& oil_pressure,
+                       const std::vector<double>& temperature,
+                       const Miscibility::RsFunction& rs_func,
+                       const std::vector<double>& gas_saturation,
+                       std::vector<double>& rs)
+        {
+            assert(UgGridHelpers::dimensions(grid) == 3);
+            int count = 0;
+            for (auto it = cells.begin(); it != cells.end(); ++it, ++count) {
+                const int cell = *it;
+                const double depth = UgGridHelpers::cellCenterDepth(grid, cell);
+                rs[cell] = rs_func(depth, oil_pressure[cell], temperature[count], gas_saturation[cell]);
+            }
+        }
+
     } // namespace Equil
 
 
@@ -36,6 +36,7 @@
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <opm/parser/eclipse/EclipseState/InitConfig/Equil.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 
@@ -766,30 +767,41 @@ namespace Opm
                              const Props& props,
                              State& state)
     {
-        state.surfacevol() = state.saturation();
         const int np = props.numPhases();
         const int nc = number_of_cells;
-        std::vector<double> allA(nc*np*np);
-        std::vector<int> allcells(nc);
-        for (int c = 0; c < nc; ++c) {
-            allcells[c] = c;
-        }
-        // Assuming that using the saturation as z argument here does not change
-        // the outcome. This is not guaranteed unless we have only a single phase
-        // per cell.
-        props.matrix(nc, &state.pressure()[0], &state.temperature()[0], &state.surfacevol()[0], &allcells[0], &allA[0], 0);
-        for (int c = 0; c < nc; ++c) {
-            // Using z = As
-            double* z = &state.surfacevol()[c*np];
-            const double* s = &state.saturation()[c*np];
-            const double* A = &allA[c*np*np];
-
-            for (int row = 0; row < np; ++row) { z[row] = 0.0; }
-
-            for (int col = 0; col < np; ++col) {
-                for (int row = 0; row < np; ++row) {
-                    // Recall: A has column-major ordering.
-                    z[row] += A[row + np*col]*s[col];
+        state.surfacevol().resize(nc*np);
+
+        // The cells are processed in blocks, so the A matrices are only
+        // stored for one block at a time.
+        const int block_size = 4096;
+        std::vector<double> blockA(block_size*np*np);
+        std::vector<int> blockcells(block_size);
+
+        for (int c0 = 0; c0 < nc; c0 += block_size) {
+            const int n = std::min(block_size, nc - c0);
+            for (int k = 0; k < n; ++k) {
+                blockcells[k] = c0 + k;
+            }
+            const double* s = &state.saturation()[c0*np];
+            double* z = &state.surfacevol()[c0*np];
+
+            // Assuming that using the saturation as z argument here does not change
+            // the outcome. This is not guaranteed unless we have only a single phase
+            // per cell.
+            props.matrix(n, &state.pressure()[c0], &state.temperature()[c0], s, &blockcells[0], &blockA[0], 0);
+            for (int k = 0; k < n; ++k) {
+                // Using z = As
+                const double* A = &blockA[k*np*np];
+                double* zk = z + k*np;
+                const double* sk = s + k*np;
+
+                for (int row = 0; row < np; ++row) { zk[row] = 0.0; }
+
+                for (int col = 0; col < np; ++col) {
+                    for (int row = 0; row < np; ++row) {
+                        // Recall: A has column-major ordering.
+                        zk[row] += A[row + np*col]*sk[col];
+                    }
                 }
             }
         }
@@ -812,110 +824,109 @@ namespace Opm
     {
         const std::vector<double>& rs = state.gasoilratio();
         const std::vector<double>& rv = state.rv();
+        const std::vector<double>& sat = state.saturation();
 
-        //make input for computation of the A matrix
-        state.surfacevol() = state.saturation();
         const PhaseUsage pu = props.phaseUsage();
 
         const int np = props.numPhases();
-
-        std::vector<double> allA_a(number_of_cells*np*np);
-        std::vector<double> allA_l(number_of_cells*np*np);
-        std::vector<double> allA_v(number_of_cells*np*np);
-
-        std::vector<int> allcells(number_of_cells);
-        std::vector<double> z_init(number_of_cells*np);
-        std::fill(z_init.begin(),z_init.end(),0.0);
-
-        for (int c = 0; c < number_of_cells; ++c) {
-            allcells[c] = c;
-        }
-
-        std::vector<double> capPressures(number_of_cells*np);
-        props.capPress(number_of_cells,&state.saturation()[0],&allcells[0],&capPressures[0],NULL);
-
-        double z_tmp;
-
-        // Water phase
-        if(pu.phase_used[BlackoilPhases::Aqua])
-           for (int c = 0; c <  number_of_cells ; ++c){
-               for (int p = 0; p < np ; ++p){
-                   if (p == BlackoilPhases::Aqua)
-                       z_tmp = 1;
-                   else
-                       z_tmp = 0;
-
-                   z_init[c*np + p] = z_tmp;
-               }
-           }
-        props.matrix(number_of_cells, &state.pressure()[0], &state.temperature()[0], &z_init[0], &allcells[0], &allA_a[0], 0);
-
-        // Liquid phase
-        if(pu.phase_used[BlackoilPhases::Liquid]){
-            for (int c = 0; c <  number_of_cells ; ++c){
-                for (int p = 0; p < np ; ++p){
-                     if(p == BlackoilPhases::Vapour){
-                         if(state.saturation()[np*c + p] > 0)
-                             z_tmp = 1e10;
-                         else
-                             z_tmp = rs[c];
-                     }
-                     else if(p == BlackoilPhases::Liquid)
-                         z_tmp = 1;
-                     else
-                         z_tmp = 0;
-
-                     z_init[c*np + p] = z_tmp;
-
+        const int nc = number_of_cells;
+        state.surfacevol().resize(nc*np);
+
+        // The cells are processed in blocks.  For each block, row 0 of z
+        // is computed from the water phase A matrix, row 1 from the oil
+        // phase one and row 2 from the gas phase one, so only a single
+        // block of A matrices is stored at any time.  As in the original
+        // whole-field formulation, the z used for a phase not in use is
+        // that of the previous phase.
+        const int block_size = 4096;
+        std::vector<double> blockA(block_size*np*np);
+        std::vector<double> z_init(block_size*np);
+        std::vector<int> blockcells(block_size);
+
+        for (int c0 = 0; c0 < nc; c0 += block_size) {
+            const int n = std::min(block_size, nc - c0);
+            for (int k = 0; k < n; ++k) {
+                blockcells[k] = c0 + k;
+            }
+            const double* p = &state.pressure()[c0];
+            const double* T = &state.temperature()[c0];
+            const double* s = &sat[c0*np];
+            double* z = &state.surfacevol()[c0*np];
+            std::fill(z, z + n*np, 0.0);
+            std::fill(z_init.begin(), z_init.end(), 0.0);
+
+            // Water phase
+            if (pu.phase_used[BlackoilPhases::Aqua]) {
+                for (int k = 0; k < n; ++k) {
+                    for (int ph = 0; ph < np; ++ph) {
+                        z_init[k*np + ph] = (ph == BlackoilPhases::Aqua) ? 1.0 : 0.0;
+                    }
                 }
             }
-        }
-        props.matrix(number_of_cells, &state.pressure()[0], &state.temperature()[0], &z_init[0], &allcells[0], &allA_l[0], 0);
-
-        if(pu.phase_used[BlackoilPhases::Vapour]){
-            for (int c = 0; c <  number_of_cells ; ++c){
-                for (int p = 0; p < np ; ++p){
-                     if(p == BlackoilPhases::Liquid){
-                         if(state.saturation()[np*c + p] > 0)
-                             z_tmp = 1e10;
-                         else
-                             z_tmp = rv[c];
-                     }
-                     else if(p == BlackoilPhases::Vapour)
-                         z_tmp = 1;
-                     else
-                         z_tmp = 0;
-
-                     z_init[c*np + p] = z_tmp;
-
+            props.matrix(n, p, T, &z_init[0], &blockcells[0], &blockA[0], 0);
+            for (int k = 0; k < n; ++k) {
+                const double* A_a = &blockA[k*np*np];
+                for (int col = 0; col < np; ++col) {
+                    z[k*np + 0] += A_a[0 + np*col]*s[k*np + col];
                 }
             }
-        }
-        props.matrix(number_of_cells, &state.pressure()[0], &state.temperature()[0], &z_init[0], &allcells[0], &allA_v[0], 0);
-
-        for (int c = 0; c < number_of_cells; ++c) {
-            // Using z = As
-            double* z = &state.surfacevol()[c*np];
-            const double* s = &state.saturation()[c*np];
-            const double* A_a = &allA_a[c*np*np];
-            const double* A_l = &allA_l[c*np*np];
-            const double* A_v = &allA_v[c*np*np];
-
-            for (int row = 0; row < np; ++row) { z[row] = 0.0; }
-
-            for (int col = 0; col < np; ++col) {
-                z[0] += A_a[0 + np*col]*s[col];
-                z[1] += A_l[1 + np*col]*s[col];
-                if (np > 2)
-                    z[2] += A_v[2 + np*col]*s[col];
 
+            // Liquid phase
+            if (pu.phase_used[BlackoilPhases::Liquid]) {
+                for (int k = 0; k < n; ++k) {
+                    const int c = c0 + k;
+                    for (int ph = 0; ph < np; ++ph) {
+                        double z_tmp;
+                        if (ph == BlackoilPhases::Vapour) {
+                            z_tmp = (sat[np*c + ph] > 0) ? 1e10 : rs[c];
+                        } else if (ph == BlackoilPhases::Liquid) {
+                            z_tmp = 1;
+                        } else {
+                            z_tmp = 0;
+                        }
+                        z_init[k*np + ph] = z_tmp;
+                    }
+                }
             }
-            if (np > 2) {
-                double ztmp = z[2];
-                z[2] += z[1]*rs[c];
-                z[1] += ztmp*rv[c];
+            props.matrix(n, p, T, &z_init[0], &blockcells[0], &blockA[0], 0);
+            for (int k = 0; k < n; ++k) {
+                const double* A_l = &blockA[k*np*np];
+                for (int col = 0; col < np; ++col) {
+                    z[k*np + 1] += A_l[1 + np*col]*s[k*np + col];
+                }
             }
 
+            if (np > 2) {
+                // Vapour phase
+                if (pu.phase_used[BlackoilPhases::Vapour]) {
+                    for (int k = 0; k < n; ++k) {
+                        const int c = c0 + k;
+                        for (int ph = 0; ph < np; ++ph) {
+                            double z_tmp;
+                            if (ph == BlackoilPhases::Liquid) {
+                                z_tmp = (sat[np*c + ph] > 0) ? 1e10 : rv[c];
+                            } else if (ph == BlackoilPhases::Vapour) {
+                                z_tmp = 1;
+                            } else {
+                                z_tmp = 0;
+                            }
+                            z_init[k*np + ph] = z_tmp;
+                        }
+                    }
+                }
+                props.matrix(n, p, T, &z_init[0], &blockcells[0], &blockA[0], 0);
+                for (int k = 0; k < n; ++k) {
+                    const int c = c0 + k;
+                    const double* A_v = &blockA[k*np*np];
+                    double* zk = z + k*np;
+                    for (int col = 0; col < np; ++col) {
+                        zk[2] += A_v[2 + np*col]*s[k*np + col];
+                    }
+                    double ztmp = zk[2];
+                    zk[2] += zk[1]*rs[c];
+                    zk[1] += ztmp*rv[c];
+                }
+            }
         }
     }
 
@@ -956,6 +967,7 @@ namespace Opm
         if (grid_props.hasDeckDoubleGridProperty("RS")) {
             const auto& rs_deck = grid_props.getDoubleGridProperty("RS").getData();
             const int num_cells = number_of_cells;
+#pragma omp parallel for schedule(static)
             for (int c = 0; c < num_cells; ++c) {
                 int c_deck = (global_cell == NULL) ? c : global_cell[c];
                 state.gasoilratio()[c] = rs_deck[c_deck];
@@ -965,6 +977,7 @@ namespace Opm
         } else if (grid_props.hasDeckDoubleGridProperty("RV")) {
             const auto& rv_deck = grid_props.getDoubleGridProperty("RV").getData();
             const int num_cells = number_of_cells;
+#pragma omp parallel for schedule(static)
             for (int c = 0; c < num_cells; ++c) {
                 int c_deck = (global_cell == NULL) ? c : global_cell[c];
                 state.rv()[c] = rv_deck[c_deck];
@@ -973,8 +986,8 @@ namespace Opm
             computeSaturation(props,state);
         }
         else {
-            state.gasoilratio() = std::vector<double>(number_of_cells, 0.0);
-            state.rv() = std::vector<double>(number_of_cells, 0.0);
+            state.gasoilratio().assign(number_of_cells, 0.0);
+            state.rv().assign(number_of_cells, 0.0);
             initBlackoilSurfvolUsingRSorRV(number_of_cells, props, state);
             computeSaturation(props,state);
         }
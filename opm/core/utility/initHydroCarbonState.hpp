@@ -3,6 +3,13 @@
 
 #include "opm/core/simulator/BlackoilState.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 namespace Opm
 {
 
@@ -18,25 +25,51 @@ inline void initHydroCarbonState(BlackoilState& state, const PhaseUsage& pu, con
         return;
     }
     const int np = pu.num_phases;
-    std::fill(hydroCarbonState.begin(), hydroCarbonState.end(), HydroCarbonState::GasAndOil);
 
     // set hydrocarbon state
+    // Cells (almost) filled with water are treated as GasAndOil cells.
+    // Without a water phase the oil saturation is compared against a
+    // limit it can never exceed, so the loop below has no phase
+    // dependent branches.
     const double epsilon = std::sqrt(std::numeric_limits<double>::epsilon());
-    const std::vector<double>& saturation = state.saturation();
+    const bool has_water = pu.phase_used[Water];
+    const int wpos = has_water ? pu.phase_pos[Water] : pu.phase_pos[Oil];
+    const int opos = pu.phase_pos[Oil];
+    const int gpos = pu.phase_pos[Gas];
+    const double water_limit = has_water ? 1.0 - epsilon : std::numeric_limits<double>::max();
+    const double* saturation = state.saturation().data();
+    HydroCarbonState* hcs = hydroCarbonState.data();
+
+    // GasOnly = GasAndOil - 1 and OilOnly = GasAndOil + 1, and at most
+    // one of oil_only and gas_only is set.
+#pragma omp parallel for schedule(static)
     for (int c = 0; c < num_cells; ++c) {
-        if (pu.phase_used[Water]) {
-            if ( saturation[c*np + pu.phase_pos[ Water ]] > (1.0 - epsilon)) {
-                continue; // cases (almost) filled with water is treated as GasAndOil case;
-            }
-        }
-        if ( saturation[c*np + pu.phase_pos[ Gas ]] == 0.0 && has_disgas) {
-            hydroCarbonState[c] = HydroCarbonState::OilOnly;
-            continue;
-        }
-        if ( saturation[c*np + pu.phase_pos[ Oil ]] == 0.0 && has_vapoil) {
-            hydroCarbonState[c] = HydroCarbonState::GasOnly;
-        }
+        const double* s = saturation + c*np;
+        const bool hydrocarbon = !(s[wpos] > water_limit);
+        const bool oil_only = hydrocarbon && has_disgas && (s[gpos] == 0.0);
+        const bool gas_only = hydrocarbon && !oil_only && has_vapoil && (s[opos] == 0.0);
+        hcs[c] = static_cast<HydroCarbonState>(HydroCarbonState::GasAndOil + int(oil_only) - int(gas_only));
+    }
+}
+
+
+/// Number of cells in each hydrocarbon state, indexed by the
+/// HydroCarbonState value.
+inline std::array<int, 3> countHydroCarbonStates(const std::vector<HydroCarbonState>& hydroCarbonState) {
+    const int n = hydroCarbonState.size();
+    const HydroCarbonState* hcs = hydroCarbonState.data();
+    int gas_only = 0;
+    int oil_only = 0;
+#pragma omp parallel for schedule(static) reduction(+:gas_only,oil_only)
+    for (int c = 0; c < n; ++c) {
+        gas_only += int(hcs[c] == HydroCarbonState::GasOnly);
+        oil_only += int(hcs[c] == HydroCarbonState::OilOnly);
     }
+    std::array<int, 3> count;
+    count[HydroCarbonState::GasOnly] = gas_only;
+    count[HydroCarbonState::GasAndOil] = n - gas_only - oil_only;
+    count[HydroCarbonState::OilOnly] = oil_only;
+    return count;
 }
 
 
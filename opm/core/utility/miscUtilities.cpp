@@ -24,6 +24,7 @@
 #include <opm/core/wells.h>
 #include <opm/core/well_controls.h>
 #include <opm/core/props/IncompPropertiesInterface.hpp>
+#include <opm/core/props/BlackoilPhases.hpp>
 #include <opm/core/props/BlackoilPropertiesInterface.hpp>
 #include <opm/core/props/rock/RockCompressibility.hpp>
 #include <opm/common/ErrorMacros.hpp>
@@ -80,8 +81,10 @@ namespace Opm
     {
         int num_cells = grid.number_of_cells;
         porosity.resize(num_cells);
+        rock_comp.poroMult(num_cells, &pressure[0], 0, &porosity[0], 0);
+#pragma omp parallel for schedule(static)
         for (int i = 0; i < num_cells; ++i) {
-            porosity[i] = porosity_standard[i]*rock_comp.poroMult(pressure[i]);
+            porosity[i] = porosity_standard[i]*porosity[i];
         }
     }
 
@@ -193,6 +196,48 @@ namespace Opm
 
 
 
+    namespace {
+        // Total mobility and, if omega is non-null, omega of cells
+        // [0, n).  The relative permeabilities of all cells are
+        // evaluated in a single relperm() call into the workspace kr, so
+        // that property classes can group the whole cell set by region.
+        void totalMobilityOmega(const Opm::IncompPropertiesInterface& props,
+                                const int n,
+                                const int* cells,
+                                const double* s,
+                                double* kr,
+                                double* totmob,
+                                double* omega)
+        {
+            const int np = props.numPhases();
+
+            const double* mu  = props.viscosity();
+            const double* rho = props.density();
+
+            if (n == 0) {
+                return;
+            }
+            props.relperm(n, s, cells, kr, 0);
+
+#pragma omp parallel for schedule(static)
+            for (int i = 0; i < n; ++i) {
+                double lt = 0.0;
+                double om = 0.0;
+                for (int p = 0; p < np; ++p) {
+                    const double lam = kr[i*np + p] / mu[ p ];
+                    lt += lam;
+                    om += lam * rho[ p ];
+                }
+
+                totmob[ i ] = lt;
+                if (omega != 0) {
+                    omega[ i ] = om / lt;
+                }
+            }
+        }
+    } // anonymous namespace
+
+
     /// @brief Computes total mobility for a set of saturation values.
     /// @param[in]  props     rock and fluid properties
     /// @param[in]  cells     cells with which the saturation values are associated
@@ -203,20 +248,10 @@ namespace Opm
                               const std::vector<double>& s,
                               std::vector<double>& totmob)
     {
-        std::vector<double> pmobc;
-
-        computePhaseMobilities(props, cells, s, pmobc);
-
-        const std::size_t                 np = props.numPhases();
-        const std::vector<int>::size_type nc = cells.size();
-
-        std::vector<double>(cells.size(), 0.0).swap(totmob);
-
-        for (std::vector<int>::size_type c = 0; c < nc; ++c) {
-            for (std::size_t p = 0; p < np; ++p) {
-                totmob[ c ] += pmobc[c*np + p];
-            }
-        }
+        std::vector<double> kr(s.size());
+        totmob.resize(cells.size());
+        computeTotalMobility(props, cells.size(), cells.data(), s.data(),
+                             kr.data(), totmob.data());
     }
 
 
@@ -232,25 +267,11 @@ namespace Opm
                                    std::vector<double>& totmob,
                                    std::vector<double>& omega)
     {
-        std::vector<double> pmobc;
-
-        computePhaseMobilities(props, cells, s, pmobc);
-
-        const std::size_t                 np = props.numPhases();
-        const std::vector<int>::size_type nc = cells.size();
-
-        std::vector<double>(cells.size(), 0.0).swap(totmob);
-        std::vector<double>(cells.size(), 0.0).swap(omega );
-
-        const double* rho = props.density();
-        for (std::vector<int>::size_type c = 0; c < nc; ++c) {
-            for (std::size_t p = 0; p < np; ++p) {
-                totmob[ c ] += pmobc[c*np + p];
-                omega [ c ] += pmobc[c*np + p] * rho[ p ];
-            }
-
-            omega[ c ] /= totmob[ c ];
-        }
+        std::vector<double> kr(s.size());
+        totmob.resize(cells.size());
+        omega .resize(cells.size());
+        computeTotalMobilityOmega(props, cells.size(), cells.data(), s.data(),
+                                  kr.data(), totmob.data(), omega.data());
     }
 
 
@@ -269,16 +290,49 @@ namespace Opm
 
         assert(s.size() == nc * np);
 
-        std::vector<double>(nc * np, 0.0).swap(pmobc );
-        double*                                dpmobc = 0;
-        props.relperm(static_cast<const int>(nc), &s[0], &cells[0],
-                      &pmobc[0], dpmobc);
+        pmobc.resize(nc * np);
+        computePhaseMobilities(props, nc, cells.data(), s.data(), pmobc.data());
+    }
+
+
+    void computeTotalMobility(const Opm::IncompPropertiesInterface& props,
+                              const int n,
+                              const int* cells,
+                              const double* s,
+                              double* kr,
+                              double* totmob)
+    {
+        totalMobilityOmega(props, n, cells, s, kr, totmob, 0);
+    }
 
-        const double*                 mu  = props.viscosity();
-        std::vector<double>::iterator lam = pmobc.begin();
-        for (std::vector<int>::size_type c = 0; c < nc; ++c) {
-            for (std::size_t p = 0; p < np; ++p, ++lam) {
-                *lam /= mu[ p ];
+
+    void computeTotalMobilityOmega(const Opm::IncompPropertiesInterface& props,
+                                   const int n,
+                                   const int* cells,
+                                   const double* s,
+                                   double* kr,
+                                   double* totmob,
+                                   double* omega)
+    {
+        totalMobilityOmega(props, n, cells, s, kr, totmob, omega);
+    }
+
+
+    void computePhaseMobilities(const Opm::IncompPropertiesInterface& props,
+                                const int n,
+                                const int* cells,
+                                const double* s,
+                                double* pmobc)
+    {
+        const int np = props.numPhases();
+
+        props.relperm(n, s, cells, pmobc, 0);
+
+        const double* mu = props.viscosity();
+#pragma omp parallel for schedule(static)
+        for (int c = 0; c < n; ++c) {
+            for (int p = 0; p < np; ++p) {
+                pmobc[c*np + p] /= mu[ p ];
             }
         }
     }
@@ -168,6 +168,55 @@ namespace Opm
                                 std::vector<double>&                  pmobc);
 
 
+    /// @brief Computes total mobility for a set of saturation values,
+    /// writing into preallocated arrays.  Relative permeabilities of all
+    /// cells are evaluated by one relperm() call into the caller's
+    /// workspace, so nothing is allocated.
+    /// @param[in]  props     rock and fluid properties
+    /// @param[in]  n         number of cells
+    /// @param[in]  cells     cells with which the saturation values are associated
+    /// @param[in]  s         saturation values (for all phases)
+    /// @param[out] kr        workspace, array of n*P values.
+    /// @param[out] totmob    total mobilities, array of n values.
+    void computeTotalMobility(const Opm::IncompPropertiesInterface& props,
+                              const int n,
+                              const int* cells,
+                              const double* s,
+                              double* kr,
+                              double* totmob);
+
+    /// @brief Computes total mobility and omega for a set of saturation
+    /// values, writing into preallocated arrays.  See the pointer-based
+    /// computeTotalMobility().
+    /// @param[in]  props     rock and fluid properties
+    /// @param[in]  n         number of cells
+    /// @param[in]  cells     cells with which the saturation values are associated
+    /// @param[in]  s         saturation values (for all phases)
+    /// @param[out] kr        workspace, array of n*P values.
+    /// @param[out] totmob    total mobility, array of n values.
+    /// @param[out] omega     fractional-flow weighted fluid densities, array of n values.
+    void computeTotalMobilityOmega(const Opm::IncompPropertiesInterface& props,
+                                   const int n,
+                                   const int* cells,
+                                   const double* s,
+                                   double* kr,
+                                   double* totmob,
+                                   double* omega);
+
+    /// @brief Computes phase mobilities for a set of saturation values,
+    /// writing into a preallocated array.
+    /// @param[in]  props     rock and fluid properties
+    /// @param[in]  n         number of cells
+    /// @param[in]  cells     cells with which the saturation values are associated
+    /// @param[in]  s         saturation values (for all phases)
+    /// @param[out] pmobc     phase mobilities (for all phases), array of n*P values.
+    void computePhaseMobilities(const Opm::IncompPropertiesInterface& props,
+                                const int n,
+                                const int* cells,
+                                const double* s,
+                                double* pmobc);
+
+
     /// Computes the fractional flow for each cell in the cells argument
     /// @param[in] props                rock and fluid properties
     /// @param[in] cells                cells with which the saturation values are associated
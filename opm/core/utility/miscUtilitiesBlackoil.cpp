@@ -26,12 +26,14 @@
 #include <opm/core/wells.h>
 #include <opm/core/linalg/blas_lapack.h>
 #include <opm/core/props/BlackoilPropertiesInterface.hpp>
+#include <opm/core/props/BlackoilPhases.hpp>
 #include <opm/core/simulator/BlackoilState.hpp>
 #include <opm/core/simulator/WellState.hpp>
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/parser/eclipse/Units/Units.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <functional>
 #include <limits>
@@ -134,20 +136,42 @@ namespace Opm
                               const std::vector<double>& s,
                               std::vector<double>& totmob)
     {
-        std::vector<double> pmobc;
+        std::vector<double> mu(s.size()), kr(s.size());
+        totmob.resize(cells.size());
+        computeTotalMobility(props, cells.size(), cells.data(),
+                             press.data(), temp.data(), z.data(), s.data(),
+                             mu.data(), kr.data(), totmob.data());
+    }
 
-        computePhaseMobilities(props, cells, press, temp, z, s, pmobc);
 
-        const std::size_t                 np = props.numPhases();
-        const std::vector<int>::size_type nc = cells.size();
+    void computeTotalMobility(const Opm::BlackoilPropertiesInterface& props,
+                              const int n,
+                              const int* cells,
+                              const double* press,
+                              const double* temp,
+                              const double* z,
+                              const double* s,
+                              double* mu,
+                              double* kr,
+                              double* totmob)
+    {
+        const int np = props.numPhases();
+        if (n == 0) {
+            return;
+        }
 
-        totmob.clear();
-        totmob.resize(nc, 0.0);
+        // One call each for all cells, so that the property classes can
+        // group the whole cell set by region.
+        props.viscosity(n, press, temp, z, cells, mu, 0);
+        props.relperm(n, s, cells, kr, 0);
 
-        for (std::vector<int>::size_type c = 0; c < nc; ++c) {
-            for (std::size_t p = 0; p < np; ++p) {
-                totmob[ c ] += pmobc[c*np + p];
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i) {
+            double lt = 0.0;
+            for (int p = 0; p < np; ++p) {
+                lt += kr[i*np + p] / mu[i*np + p];
             }
+            totmob[ i ] = lt;
         }
     }
 
@@ -208,24 +232,42 @@ namespace Opm
                                 const std::vector<double>&              s,
                                 std::vector<double>&                    pmobc)
     {
-        const int nc = props.numCells();
+        const int nc = cells.size();
         const int np = props.numPhases();
 
         assert(int(s.size()) == nc * np);
 
-        std::vector<double> mu(nc*np);
-        props.viscosity(nc, &p[0], &T[0], &z[0], &cells[0], &mu[0], 0);
+        pmobc.resize(nc*np);
+        computePhaseMobilities(props, nc, cells.data(), p.data(), T.data(), z.data(), s.data(), pmobc.data());
+    }
+
 
-        pmobc.clear();
-        pmobc.resize(nc*np, 0.0);
-        double* dpmobc = 0;
-        props.relperm(nc, &s[0], &cells[0],
-                      &pmobc[0], dpmobc);
+    void computePhaseMobilities(const Opm::BlackoilPropertiesInterface& props,
+                                const int n,
+                                const int* cells,
+                                const double* p,
+                                const double* T,
+                                const double* z,
+                                const double* s,
+                                double* pmobc)
+    {
+        const int np = props.numPhases();
+        assert(np <= BlackoilPhases::MaxNumPhases);
 
-        std::transform(pmobc.begin(), pmobc.end(),
-                       mu.begin(),
-                       pmobc.begin(),
-                       std::divides<double>());
+        double mu[mobility_block_size * BlackoilPhases::MaxNumPhases];
+
+        props.relperm(n, s, cells, pmobc, 0);
+
+        for (int begin = 0; begin < n; begin += mobility_block_size) {
+            const int size = std::min(mobility_block_size, n - begin);
+
+            props.viscosity(size, p + begin, T + begin, z + begin*np,
+                            cells + begin, mu, 0);
+
+            for (int i = 0; i < size*np; ++i) {
+                pmobc[begin*np + i] /= mu[i];
+            }
+        }
     }
 
     /// Computes the fractional flow for each cell in the cells argument
@@ -297,57 +339,60 @@ namespace Opm
 
         const int np = props.numPhases();
         const int nc = props.numCells();
-        std::vector<double> allA(nc*np*np);
-        std::vector<int> allcells(nc);
-        for (int c = 0; c < nc; ++c) {
-            allcells[c] = c;
-        }
 
-        //std::vector<double> res_vol(np);
         const std::vector<double>& z = state.surfacevol();
 
-        props.matrix(nc, &state.pressure()[0], &state.temperature()[0], &z[0], &allcells[0], &allA[0], 0);
-
-        // Linear solver.
-        MAT_SIZE_T n = np;
-        MAT_SIZE_T nrhs = 1;
-        MAT_SIZE_T lda = np;
-        std::vector<MAT_SIZE_T> piv(np);
-        MAT_SIZE_T ldb = np;
-        MAT_SIZE_T info = 0;
+        // The cells are processed in blocks, so the A matrices are only
+        // stored for one block at a time.  The matrix() calls are made
+        // from a single thread, the linear solves are made in parallel.
+        const int block_size = 4096;
+        std::vector<double> blockA(block_size*np*np);
+        std::vector<int> blockcells(block_size);
 
-
-        //double res_vol;
-        double tot_sat;
         const double epsilon = std::sqrt(std::numeric_limits<double>::epsilon());
 
-        for (int c = 0; c < nc; ++c) {
-            double* A = &allA[c*np*np];
-            const double* z_loc = &z[c*np];
-            double* s = &state.saturation()[c*np];
-
-            for (int p = 0; p < np; ++p){
-                s[p] = z_loc[p];
-                }
+        assert(np <= 3);
+        for (int c0 = 0; c0 < nc; c0 += block_size) {
+            const int nb = std::min(block_size, nc - c0);
+            for (int k = 0; k < nb; ++k) {
+                blockcells[k] = c0 + k;
+            }
 
-            dgesv_(&n, &nrhs, &A[0], &lda, &piv[0], &s[0], &ldb, &info);
+            props.matrix(nb, &state.pressure()[c0], &state.temperature()[c0], &z[c0*np], &blockcells[0], &blockA[0], 0);
 
-            tot_sat = 0;
-            for (int p = 0; p < np; ++p){
-                if (s[p] < epsilon) // saturation may be less then zero due to round of errors
-                    s[p] = 0;
+#pragma omp parallel for schedule(static)
+            for (int k = 0; k < nb; ++k) {
+                const int c = c0 + k;
+                double* A = &blockA[k*np*np];
+                const double* z_loc = &z[c*np];
+                double* s = &state.saturation()[c*np];
 
-                tot_sat += s[p];
-            }
-
-            for (int p = 0; p < np; ++p){
-                s[p]  = s[p]/tot_sat;
-            }
+                for (int p = 0; p < np; ++p){
+                    s[p] = z_loc[p];
+                }
 
+                // Linear solver.
+                MAT_SIZE_T n = np;
+                MAT_SIZE_T nrhs = 1;
+                MAT_SIZE_T lda = np;
+                MAT_SIZE_T piv[3];
+                MAT_SIZE_T ldb = np;
+                MAT_SIZE_T info = 0;
 
+                dgesv_(&n, &nrhs, &A[0], &lda, &piv[0], &s[0], &ldb, &info);
 
+                double tot_sat = 0;
+                for (int p = 0; p < np; ++p){
+                    if (s[p] < epsilon) // saturation may be less then zero due to round of errors
+                        s[p] = 0;
 
+                    tot_sat += s[p];
+                }
 
+                for (int p = 0; p < np; ++p){
+                    s[p]  = s[p]/tot_sat;
+                }
+            }
         }
 
     }
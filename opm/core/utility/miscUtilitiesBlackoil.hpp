@@ -60,17 +60,45 @@ namespace Opm
     /// @param[in]  props     rock and fluid properties
     /// @param[in]  cells     cells with which the saturation values are associated
     /// @param[in]  p         pressure (one value per cell)
+    /// @param[in]  T         temperature (one value per cell)
     /// @param[in]  z         surface-volume values (for all P phases)
     /// @param[in]  s         saturation values (for all phases)
     /// @param[out] totmob    total mobilities.
     void computeTotalMobility(const Opm::BlackoilPropertiesInterface& props,
                               const std::vector<int>& cells,
                               const std::vector<double>& p,
+                              const std::vector<double>& T,
                               const std::vector<double>& z,
                               const std::vector<double>& s,
                               std::vector<double>& totmob);
 
 
+    /// @brief Computes total mobility for a set of saturation values,
+    /// writing into preallocated arrays.  Viscosities and relative
+    /// permeabilities of all cells are evaluated by one call each into
+    /// the caller's workspaces, so nothing is allocated.
+    /// @param[in]  props     rock and fluid properties
+    /// @param[in]  n         number of cells
+    /// @param[in]  cells     cells with which the saturation values are associated
+    /// @param[in]  p         pressure (one value per cell)
+    /// @param[in]  T         temperature (one value per cell)
+    /// @param[in]  z         surface-volume values (for all P phases)
+    /// @param[in]  s         saturation values (for all phases)
+    /// @param[out] mu        workspace, array of n*P values.
+    /// @param[out] kr        workspace, array of n*P values.
+    /// @param[out] totmob    total mobilities, array of n values.
+    void computeTotalMobility(const Opm::BlackoilPropertiesInterface& props,
+                              const int n,
+                              const int* cells,
+                              const double* p,
+                              const double* T,
+                              const double* z,
+                              const double* s,
+                              double* mu,
+                              double* kr,
+                              double* totmob);
+
+
     /// @brief Computes total mobility and omega for a set of saturation values.
     /// @param[in]  props     rock and fluid properties
     /// @param[in]  cells     cells with which the saturation values are associated
@@ -105,6 +133,26 @@ namespace Opm
                                 std::vector<double>&                    pmobc);
 
 
+    /// @brief Computes phase mobilities for a set of saturation values,
+    /// writing into a preallocated array.
+    /// @param[in]  props     rock and fluid properties
+    /// @param[in]  n         number of cells
+    /// @param[in]  cells     cells with which the saturation values are associated
+    /// @param[in]  p         pressure (one value per cell)
+    /// @param[in]  T         temperature (one value per cell)
+    /// @param[in]  z         surface-volume values (for all P phases)
+    /// @param[in]  s         saturation values (for all phases)
+    /// @param[out] pmobc     phase mobilities (for all phases), array of n*P values.
+    void computePhaseMobilities(const Opm::BlackoilPropertiesInterface& props,
+                                const int n,
+                                const int* cells,
+                                const double* p,
+                                const double* T,
+                                const double* z,
+                                const double* s,
+                                double* pmobc);
+
+
     /// Computes the fractional flow for each cell in the cells argument
     /// @param[in]  props            rock and fluid properties
     /// @param[in]  cells            cells with which the saturation values are associated
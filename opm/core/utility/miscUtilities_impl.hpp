@@ -70,8 +70,10 @@ namespace Opm
                            std::vector<double>& porevol)
     {
         porevol.resize(number_of_cells);
-        for (int i = 0; i < number_of_cells; ++i) {
-            porevol[i] = porosity[i]*begin_cell_volumes[i]*rock_comp.poroMult(pressure[i]);
+        rock_comp.poroMult(number_of_cells, pressure.data(), 0, porevol.data(), 0);
+        // The cell volumes are only traversed forward, once.
+        for (int i = 0; i < number_of_cells; ++i, ++begin_cell_volumes) {
+            porevol[i] = porosity[i]*(*begin_cell_volumes)*porevol[i];
         }
     }
 
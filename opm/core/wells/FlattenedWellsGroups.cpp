@@ -0,0 +1,536 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <opm/core/wells/FlattenedWellsGroups.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace Opm
+{
+
+    FlattenedWellsGroups::FlattenedWellsGroups()
+        : child_start_(1, 0),
+          num_roots_(0)
+    {
+    }
+
+
+
+    FlattenedWellsGroups::FlattenedWellsGroups(const std::vector<std::shared_ptr<WellsGroupInterface> >& roots)
+        : num_roots_(roots.size())
+    {
+        // Breadth first numbering.  Node i is visited as the i'th node,
+        // so its children are appended right after those of node i - 1.
+        for (const auto& root : roots) {
+            node_.push_back(root.get());
+            parent_.push_back(-1);
+        }
+        for (size_t i = 0; i < node_.size(); ++i) {
+            WellsGroupInterface* node = node_[i];
+            child_start_.push_back(node_.size());
+            is_leaf_.push_back(node->isLeafNode());
+            if (!is_leaf_[i]) {
+                for (const auto& child : static_cast<WellsGroup*>(node)->children()) {
+                    node_.push_back(child.get());
+                    parent_.push_back(i);
+                }
+            }
+        }
+        const int n = node_.size();
+        child_start_.push_back(n);
+
+        // Depth first post-order, as the recursion of conditionsMet().
+        postorder_.reserve(n);
+        std::vector<std::pair<int, int> > stack;  // (node, next child)
+        for (int r = 0; r < num_roots_; ++r) {
+            stack.push_back(std::make_pair(r, child_start_[r]));
+            while (!stack.empty()) {
+                const int i = stack.back().first;
+                const int c = stack.back().second;
+                if (c < child_start_[i + 1]) {
+                    ++stack.back().second;
+                    stack.push_back(std::make_pair(c, child_start_[c]));
+                } else {
+                    postorder_.push_back(i);
+                    stack.pop_back();
+                }
+            }
+        }
+        assert(int(postorder_.size()) == n);
+    }
+
+
+
+    int FlattenedWellsGroups::numberOfNodes() const
+    {
+        return node_.size();
+    }
+
+
+
+    WellsGroupInterface* FlattenedWellsGroups::node(const int index) const
+    {
+        return node_[index];
+    }
+
+
+
+    int FlattenedWellsGroups::parent(const int index) const
+    {
+        return parent_[index];
+    }
+
+
+
+    WellNode* FlattenedWellsGroups::leaf(const int index) const
+    {
+        assert(is_leaf_[index]);
+        return static_cast<WellNode*>(node_[index]);
+    }
+
+
+
+    void FlattenedWellsGroups::productionGuideRates(const bool only_group,
+                                                    std::vector<double>& guide_rate) const
+    {
+        const int n = node_.size();
+        guide_rate.resize(n);
+        for (int i = n - 1; i >= 0; --i) {
+            if (is_leaf_[i]) {
+                guide_rate[i] = leaf(i)->productionGuideRate(only_group);
+                continue;
+            }
+            double sum = 0.0;
+            for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                if (!only_group || !node_[c]->individualControl()) {
+                    sum += guide_rate[c];
+                }
+            }
+            guide_rate[i] = sum;
+        }
+    }
+
+
+
+    void FlattenedWellsGroups::injectionGuideRates(const bool only_group,
+                                                   std::vector<double>& guide_rate) const
+    {
+        const int n = node_.size();
+        guide_rate.resize(n);
+        for (int i = n - 1; i >= 0; --i) {
+            if (is_leaf_[i]) {
+                guide_rate[i] = leaf(i)->injectionGuideRate(only_group);
+                continue;
+            }
+            double sum = 0.0;
+            for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                sum += guide_rate[c];
+            }
+            guide_rate[i] = sum;
+        }
+    }
+
+
+
+    void FlattenedWellsGroups::totalProductionFlows(const std::vector<double>& phase_flows,
+                                                    const BlackoilPhases::PhaseIndex phase,
+                                                    std::vector<double>& flow) const
+    {
+        const int n = node_.size();
+        flow.resize(n);
+        for (int i = n - 1; i >= 0; --i) {
+            if (is_leaf_[i]) {
+                flow[i] = leaf(i)->getTotalProductionFlow(phase_flows, phase);
+                continue;
+            }
+            double sum = 0.0;
+            for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                sum += flow[c];
+            }
+            flow[i] = sum;
+        }
+    }
+
+
+
+    void FlattenedWellsGroups::totalVoidageRates(const std::vector<double>& well_voidage_rates,
+                                                 std::vector<double>& rate) const
+    {
+        const int n = node_.size();
+        rate.resize(n);
+        for (int i = n - 1; i >= 0; --i) {
+            if (is_leaf_[i]) {
+                rate[i] = leaf(i)->getTotalVoidageRate(well_voidage_rates);
+                continue;
+            }
+            double sum = 0.0;
+            for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                sum += rate[c];
+            }
+            rate[i] = sum * node_[i]->efficiencyFactor();
+        }
+    }
+
+
+
+    bool FlattenedWellsGroups::conditionsMet(const std::vector<double>& well_bhp,
+                                             const std::vector<double>& well_reservoirrates_phase,
+                                             const std::vector<double>& well_surfacerates_phase)
+    {
+        // The wells and groups are checked in the same order as by the
+        // recursion, since the first violation found is acted upon.
+        summed_phases_.assign(node_.size(), WellPhasesSummed());
+        for (const int i : postorder_) {
+            if (is_leaf_[i]) {
+                if (!node_[i]->conditionsMet(well_bhp,
+                                             well_reservoirrates_phase,
+                                             well_surfacerates_phase,
+                                             summed_phases_[i])) {
+                    return false;
+                }
+                continue;
+            }
+            WellPhasesSummed child_phases_summed;
+            for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                child_phases_summed += summed_phases_[c];
+            }
+            if (!static_cast<WellsGroup*>(node_[i])->groupConditionsMet(well_reservoirrates_phase,
+                                                                          well_surfacerates_phase,
+                                                                          child_phases_summed)) {
+                return false;
+            }
+            summed_phases_[i] += child_phases_summed;
+        }
+        return true;
+    }
+
+
+
+    void FlattenedWellsGroups::applyProdGroupControls()
+    {
+        const int n = node_.size();
+        productionGuideRates(false, guide_rate_);
+        action_.assign(n, Skip);
+        mode_.resize(n);
+        target_.resize(n);
+        std::fill(action_.begin(), action_.begin() + num_roots_, Controls);
+
+        for (int i = 0; i < n; ++i) {
+            if (action_[i] == Skip) {
+                continue;
+            }
+            if (is_leaf_[i]) {
+                // WellNode::applyProdGroupControls() does nothing.
+                if (action_[i] == Control) {
+                    leaf(i)->applyProdGroupControl(ProductionSpecification::ControlMode(mode_[i]),
+                                                   target_[i], false);
+                }
+                continue;
+            }
+
+            WellsGroupInterface* group = node_[i];
+            ProductionSpecification& prod_spec = group->prodSpec();
+            if (action_[i] == Controls) {
+                const ProductionSpecification::ControlMode prod_mode = prod_spec.control_mode_;
+                switch (prod_mode) {
+                case ProductionSpecification::ORAT:
+                case ProductionSpecification::WRAT:
+                case ProductionSpecification::LRAT:
+                case ProductionSpecification::RESV:
+                {
+                    const double my_guide_rate = guide_rate_[i];
+                    if (my_guide_rate == 0) {
+                        OPM_THROW(std::runtime_error, "Can't apply group control for group " << group->name() << " as the sum of guide rates for all group controlled wells is zero.");
+                    }
+                    for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                        action_[c] = Control;
+                        mode_[c] = prod_mode;
+                        target_[c] = (guide_rate_[c] / my_guide_rate) * group->getTarget(prod_mode);
+                    }
+                    break;
+                }
+                case ProductionSpecification::FLD:
+                case ProductionSpecification::NONE:
+                    for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                        action_[c] = Controls;
+                    }
+                    break;
+                default:
+                    OPM_THROW(std::runtime_error, "Unhandled group production control type " << prod_mode);
+                }
+            } else {
+                if (prod_spec.control_mode_ == ProductionSpecification::NONE) {
+                    continue;
+                }
+                const double my_guide_rate = guide_rate_[i];
+                if (my_guide_rate == 0.0) {
+                    continue;
+                }
+                for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                    action_[c] = Control;
+                    mode_[c] = mode_[i];
+                    target_[c] = target_[i] / group->efficiencyFactor() * guide_rate_[c] / my_guide_rate;
+                }
+                prod_spec.control_mode_ = ProductionSpecification::FLD;
+            }
+        }
+    }
+
+
+
+    void FlattenedWellsGroups::applyInjGroupControls()
+    {
+        const int n = node_.size();
+        injectionGuideRates(false, guide_rate_);
+        action_.assign(n, Skip);
+        mode_.resize(n);
+        target_.resize(n);
+        std::vector<InjectionSpecification::InjectorType> injector_type(n);
+        std::fill(action_.begin(), action_.begin() + num_roots_, Controls);
+
+        for (int i = 0; i < n; ++i) {
+            if (action_[i] == Skip) {
+                continue;
+            }
+            if (is_leaf_[i]) {
+                // WellNode::applyInjGroupControls() does nothing.
+                if (action_[i] == Control) {
+                    leaf(i)->applyInjGroupControl(InjectionSpecification::ControlMode(mode_[i]),
+                                                  injector_type[i], target_[i], false);
+                }
+                continue;
+            }
+
+            WellsGroupInterface* group = node_[i];
+            InjectionSpecification& inj_spec = group->injSpec();
+            if (action_[i] == Controls) {
+                const InjectionSpecification::ControlMode inj_mode = inj_spec.control_mode_;
+                switch (inj_mode) {
+                case InjectionSpecification::RATE:
+                case InjectionSpecification::RESV:
+                {
+                    const double my_guide_rate = guide_rate_[i];
+                    for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                        action_[c] = Control;
+                        mode_[c] = inj_mode;
+                        injector_type[c] = inj_spec.injector_type_;
+                        target_[c] = (guide_rate_[c] / my_guide_rate) * group->getTarget(inj_mode) / group->efficiencyFactor();
+                    }
+                    break;
+                }
+                case InjectionSpecification::VREP:
+                case InjectionSpecification::REIN:
+                    break;
+                case InjectionSpecification::FLD:
+                case InjectionSpecification::NONE:
+                    for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                        action_[c] = Controls;
+                    }
+                    break;
+                default:
+                    OPM_THROW(std::runtime_error, "Unhandled group injection control mode " << inj_mode);
+                }
+            } else {
+                if (inj_spec.control_mode_ == InjectionSpecification::NONE) {
+                    continue;
+                }
+                const double my_guide_rate = guide_rate_[i];
+                if (my_guide_rate == 0.0) {
+                    continue;
+                }
+                for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                    action_[c] = Control;
+                    mode_[c] = mode_[i];
+                    injector_type[c] = injector_type[i];
+                    target_[c] = target_[i] / group->efficiencyFactor() * guide_rate_[c] / my_guide_rate;
+                }
+                inj_spec.control_mode_ = InjectionSpecification::FLD;
+            }
+        }
+    }
+
+
+
+    void FlattenedWellsGroups::applyExplicitReinjectionControls(const std::vector<double>& well_reservoirrates_phase,
+                                                                const std::vector<double>& well_surfacerates_phase)
+    {
+        // Only the roots may have reinjection controls, as in
+        // WellsGroup::applyExplicitReinjectionControls().  Their
+        // children are called with only_group = true for REIN and
+        // only_group = false for VREP.
+        const int n = node_.size();
+        injectionGuideRates(false, guide_rate_);
+        injectionGuideRates(true, group_guide_rate_);
+        action_.assign(n, Skip);
+        only_group_.assign(n, false);
+        mode_.resize(n);
+        target_.resize(n);
+        std::vector<InjectionSpecification::InjectorType> injector_type(n);
+
+        for (int r = 0; r < num_roots_; ++r) {
+            if (is_leaf_[r]) {
+                continue;
+            }
+            const InjectionSpecification& inj_spec = node_[r]->injSpec();
+            if (inj_spec.control_mode_ == InjectionSpecification::REIN) {
+                // Defaulting to water to satisfy -Wmaybe-uninitialized
+                BlackoilPhases::PhaseIndex phase = BlackoilPhases::Aqua;
+                switch (inj_spec.injector_type_) {
+                case InjectionSpecification::WATER:
+                    phase = BlackoilPhases::Aqua;
+                    break;
+                case InjectionSpecification::GAS:
+                    phase = BlackoilPhases::Vapour;
+                    break;
+                case InjectionSpecification::OIL:
+                    phase = BlackoilPhases::Liquid;
+                    break;
+                }
+                totalProductionFlows(well_surfacerates_phase, phase, rate_);
+                const double total_reinjected = - rate_[r]; // Production negative, injection positive
+                const double my_guide_rate = group_guide_rate_[r];
+                for (int c = child_start_[r]; c < child_start_[r + 1]; ++c) {
+                    action_[c] = Control;
+                    only_group_[c] = true;
+                    mode_[c] = InjectionSpecification::RATE;
+                    injector_type[c] = inj_spec.injector_type_;
+                    target_[c] = (group_guide_rate_[c] / my_guide_rate) * total_reinjected * inj_spec.reinjection_fraction_target_;
+                }
+            }
+            else if (inj_spec.control_mode_ == InjectionSpecification::VREP) {
+                const PhaseUsage& pu = node_[r]->phaseUsage();
+                double total_produced = 0.0;
+                const BlackoilPhases::PhaseIndex phases[] = { BlackoilPhases::Aqua,
+                                                              BlackoilPhases::Liquid,
+                                                              BlackoilPhases::Vapour };
+                for (const BlackoilPhases::PhaseIndex phase : phases) {
+                    if (pu.phase_used[phase]) {
+                        totalProductionFlows(well_reservoirrates_phase, phase, rate_);
+                        total_produced += rate_[r];
+                    }
+                }
+                const double total_reinjected = - total_produced; // Production negative, injection positive
+                const double my_guide_rate = group_guide_rate_[r];
+                for (int c = child_start_[r]; c < child_start_[r + 1]; ++c) {
+                    action_[c] = Control;
+                    mode_[c] = InjectionSpecification::RESV;
+                    injector_type[c] = inj_spec.injector_type_;
+                    target_[c] = (guide_rate_[c] / my_guide_rate) * total_reinjected * inj_spec.voidage_replacment_fraction_;
+                }
+            }
+        }
+
+        for (int i = num_roots_; i < n; ++i) {
+            if (action_[i] == Skip) {
+                continue;
+            }
+            const bool only_group = only_group_[i];
+            if (is_leaf_[i]) {
+                leaf(i)->applyInjGroupControl(InjectionSpecification::ControlMode(mode_[i]),
+                                              injector_type[i], target_[i], only_group);
+                continue;
+            }
+            WellsGroupInterface* group = node_[i];
+            InjectionSpecification& inj_spec = group->injSpec();
+            if (inj_spec.control_mode_ == InjectionSpecification::NONE) {
+                continue;
+            }
+            if (!only_group || inj_spec.control_mode_ == InjectionSpecification::FLD) {
+                const std::vector<double>& guide_rate = only_group ? group_guide_rate_ : guide_rate_;
+                const double my_guide_rate = guide_rate[i];
+                if (my_guide_rate == 0.0) {
+                    continue;
+                }
+                for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                    action_[c] = Control;
+                    mode_[c] = mode_[i];
+                    injector_type[c] = injector_type[i];
+                    target_[c] = target_[i] / group->efficiencyFactor() * guide_rate[c] / my_guide_rate;
+                }
+                inj_spec.control_mode_ = InjectionSpecification::FLD;
+            }
+        }
+    }
+
+
+
+    void FlattenedWellsGroups::applyVREPGroupControls(const std::vector<double>& well_voidage_rates,
+                                                      const std::vector<double>& conversion_coeffs)
+    {
+        const int n = node_.size();
+        injectionGuideRates(false, guide_rate_);
+        totalVoidageRates(well_voidage_rates, rate_);
+        action_.assign(n, Skip);
+        target_.resize(n);
+        std::vector<InjectionSpecification::InjectorType> injector_type(n);
+        std::fill(action_.begin(), action_.begin() + num_roots_, Controls);
+
+        for (int i = 0; i < n; ++i) {
+            if (action_[i] == Skip) {
+                continue;
+            }
+            if (is_leaf_[i]) {
+                // WellNode::applyVREPGroupControls() does nothing.
+                if (action_[i] == Control) {
+                    leaf(i)->applyVREPGroupControl(target_[i], injector_type[i],
+                                                   well_voidage_rates, conversion_coeffs, false);
+                }
+                continue;
+            }
+
+            WellsGroupInterface* group = node_[i];
+            InjectionSpecification& inj_spec = group->injSpec();
+            if (action_[i] == Controls) {
+                if (inj_spec.control_mode_ == InjectionSpecification::VREP) {
+                    const double total_reinjected = rate_[i];
+                    const double my_guide_rate = guide_rate_[i];
+                    for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                        action_[c] = Control;
+                        injector_type[c] = inj_spec.injector_type_;
+                        target_[c] = guide_rate_[c] / my_guide_rate * total_reinjected / group->efficiencyFactor()
+                                   * inj_spec.voidage_replacment_fraction_;
+                    }
+                } else {
+                    for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                        action_[c] = Controls;
+                    }
+                }
+            } else {
+                if (inj_spec.control_mode_ == InjectionSpecification::NONE) {
+                    continue;
+                }
+                const double my_guide_rate = guide_rate_[i];
+                if (my_guide_rate == 0.0) {
+                    continue;
+                }
+                for (int c = child_start_[i]; c < child_start_[i + 1]; ++c) {
+                    action_[c] = Control;
+                    injector_type[c] = injector_type[i];
+                    target_[c] = target_[i] / group->efficiencyFactor() * guide_rate_[c] / my_guide_rate;
+                }
+                inj_spec.control_mode_ = InjectionSpecification::FLD;
+            }
+        }
+    }
+
+} // namespace Opm
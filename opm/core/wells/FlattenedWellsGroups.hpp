@@ -0,0 +1,149 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_FLATTENEDWELLSGROUPS_HPP
+#define OPM_FLATTENEDWELLSGROUPS_HPP
+
+#include <opm/core/wells/WellsGroup.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Array representation of a forest of WellsGroupInterface trees,
+    /// for evaluating group controls without recursing over the trees.
+    ///
+    /// The nodes are numbered breadth first, so a parent always comes
+    /// before its children, and the children of a node are numbered
+    /// consecutively in the order they were added to the group.  Sums
+    /// over the children are therefore formed in the same order as by
+    /// the recursive WellsGroup methods, and the results are identical
+    /// to theirs.  Rates and guide rates are computed for all nodes in
+    /// one pass from the leaves up, and targets are distributed in one
+    /// pass from the roots down.
+    ///
+    /// The trees remain the authoring representation: the efficiency
+    /// factors, guide rates, control modes and individual control flags
+    /// are read from the nodes at every evaluation, and the results are
+    /// written back through the nodes.  Only the tree structure is
+    /// stored, so the object must be rebuilt if nodes are added.
+    class FlattenedWellsGroups
+    {
+    public:
+        /// Empty forest.
+        FlattenedWellsGroups();
+
+        /// Flatten the trees with the given roots.
+        explicit FlattenedWellsGroups(const std::vector<std::shared_ptr<WellsGroupInterface> >& roots);
+
+        /// Number of nodes, groups and wells.
+        int numberOfNodes() const;
+
+        /// The node with the given index.
+        WellsGroupInterface* node(const int index) const;
+
+        /// Index of the parent of a node, -1 for the roots.
+        int parent(const int index) const;
+
+        /// Production guide rates of all nodes, as
+        /// WellsGroupInterface::productionGuideRate() computes them.
+        /// \param[in]  only_group  If true, only accumulate guide rates
+        ///                         of wells under group control.
+        /// \param[out] guide_rate  Guide rate of each node.
+        void productionGuideRates(const bool only_group,
+                                  std::vector<double>& guide_rate) const;
+
+        /// Injection guide rates of all nodes, as
+        /// WellsGroupInterface::injectionGuideRate() computes them.
+        /// \param[in]  only_group  If true, only accumulate guide rates
+        ///                         of wells under group control.
+        /// \param[out] guide_rate  Guide rate of each node.
+        void injectionGuideRates(const bool only_group,
+                                 std::vector<double>& guide_rate) const;
+
+        /// Total production flows of a phase for all nodes, as
+        /// WellsGroupInterface::getTotalProductionFlow() computes them.
+        /// \param[in]  phase_flows  Rates by phase for each well, ordered
+        ///                          as the related Wells struct.
+        /// \param[in]  phase        The phase for which to sum up.
+        /// \param[out] flow         Total flow of each node.
+        void totalProductionFlows(const std::vector<double>& phase_flows,
+                                  const BlackoilPhases::PhaseIndex phase,
+                                  std::vector<double>& flow) const;
+
+        /// Total voidage rates of all nodes, as
+        /// WellsGroupInterface::getTotalVoidageRate() computes them.
+        /// \param[in]  well_voidage_rates  Voidage rate of each well.
+        /// \param[out] rate                Total voidage rate of each node.
+        void totalVoidageRates(const std::vector<double>& well_voidage_rates,
+                               std::vector<double>& rate) const;
+
+        /// Same as calling conditionsMet() on each root in turn.
+        bool conditionsMet(const std::vector<double>& well_bhp,
+                           const std::vector<double>& well_reservoirrates_phase,
+                           const std::vector<double>& well_surfacerates_phase);
+
+        /// Same as calling applyProdGroupControls() on each root.
+        void applyProdGroupControls();
+
+        /// Same as calling applyInjGroupControls() on each root.
+        void applyInjGroupControls();
+
+        /// Same as calling applyExplicitReinjectionControls() on each root.
+        void applyExplicitReinjectionControls(const std::vector<double>& well_reservoirrates_phase,
+                                              const std::vector<double>& well_surfacerates_phase);
+
+        /// Same as calling applyVREPGroupControls() on each root.
+        void applyVREPGroupControls(const std::vector<double>& well_voidage_rates,
+                                    const std::vector<double>& conversion_coeffs);
+
+    private:
+        // What the top-down passes do at a node.
+        enum Action {
+            Skip,      // Nothing, the node is not reached.
+            Controls,  // apply*GroupControls()
+            Control    // apply*GroupControl() with the node's target
+        };
+
+        WellNode* leaf(const int index) const;
+
+        // Structure.
+        std::vector<WellsGroupInterface*> node_;
+        std::vector<int> parent_;
+        std::vector<int> child_start_;  // Children of i are child_start_[i], ..., child_start_[i+1] - 1.
+        std::vector<int> postorder_;    // Depth first order, children before parents.
+        std::vector<char> is_leaf_;
+        int num_roots_;
+
+        // Scratch space for the top-down passes.
+        std::vector<char> action_;
+        std::vector<char> only_group_;
+        std::vector<int> mode_;
+        std::vector<double> target_;
+        std::vector<double> guide_rate_;
+        std::vector<double> group_guide_rate_;
+        std::vector<double> rate_;
+        std::vector<WellPhasesSummed> summed_phases_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_FLATTENEDWELLSGROUPS_HPP
@@ -36,6 +36,7 @@ namespace Opm
         }
 
         roots_.push_back(createGroupWellsGroup(fieldGroup, timeStep, phaseUsage));
+        nodeAdded(roots_.back().get());
     }
 
     void WellCollection::addGroup(const Group& groupChild, std::string parent_name,
@@ -66,6 +67,7 @@ namespace Opm
         }
         parent_as_group->addChild(child);
         child->setParent(parent);
+        nodeAdded(child.get());
     }
 
     void WellCollection::addWell(const Well* wellChild, size_t timeStep, const PhaseUsage& phaseUsage) {
@@ -87,7 +89,8 @@ namespace Opm
         }
         parent_as_group->addChild(child);
 
-        leaf_nodes_.push_back(static_cast<WellNode*>(child.get()));
+        addLeafNode(static_cast<WellNode*>(child.get()));
+        nodeAdded(child.get());
 
         child->setParent(parent);
     }
@@ -98,42 +101,85 @@ namespace Opm
 
     WellsGroupInterface* WellCollection::findNode(const std::string& name)
     {
+        refreshIndex();
+        const auto it = node_index_.find(name);
+        return (it == node_index_.end()) ? NULL : it->second;
+    }
+
+    const WellsGroupInterface* WellCollection::findNode(const std::string& name) const
+    {
+        refreshIndex();
+        const auto it = node_index_.find(name);
+        return (it == node_index_.end()) ? NULL : it->second;
+    }
+
+
+    WellNode& WellCollection::findWellNode(const std::string& name) const
+    {
+        const auto it = leaf_index_.find(name);
 
-        for (size_t i = 0; i < roots_.size(); i++) {
-            WellsGroupInterface* result = roots_[i]->findGroup(name);
-            if (result) {
-                return result;
+        // Does not find the well
+        if (it == leaf_index_.end()) {
+            OPM_THROW(std::runtime_error, "Could not find well " << name << " in the well collection!\n");
+        }
+
+        return *leaf_nodes_[it->second];
+    }
+
+    void WellCollection::indexNode(WellsGroupInterface* node) const
+    {
+        // All nodes pass through here when added, so this is also
+        // where the flattened forest becomes out of date.
+        flattened_valid_ = false;
+        node_index_.emplace(node->name(), node);
+        if (!node->isLeafNode()) {
+            for (const auto& child : static_cast<WellsGroup*>(node)->children()) {
+                indexNode(child.get());
             }
         }
-        return NULL;
     }
 
-    const WellsGroupInterface* WellCollection::findNode(const std::string& name) const
+    std::size_t WellCollection::structureRevision() const
     {
+        std::size_t revision = 0;
+        for (const auto& root : roots_) {
+            revision += root->structureRevision();
+        }
+        return revision;
+    }
 
-        for (size_t i = 0; i < roots_.size(); i++) {
-            WellsGroupInterface* result = roots_[i]->findGroup(name);
-            if (result) {
-                return result;
+    void WellCollection::refreshIndex() const
+    {
+        const std::size_t revision = structureRevision();
+        if (revision != indexed_revision_) {
+            node_index_.clear();
+            for (const auto& root : roots_) {
+                indexNode(root.get());
             }
+            indexed_revision_ = revision;
         }
-        return NULL;
     }
 
-
-    WellNode& WellCollection::findWellNode(const std::string& name) const
+    void WellCollection::nodeAdded(WellsGroupInterface* node)
     {
-        auto well_node = std::find_if(leaf_nodes_.begin(), leaf_nodes_.end(),
-                    [&] ( WellNode* w) {
-                    return w->name() == name;
-                    });
+        indexNode(node);
+        indexed_revision_ = structureRevision();
+    }
 
-        // Does not find the well
-        if (well_node == leaf_nodes_.end()) {
-            OPM_THROW(std::runtime_error, "Could not find well " << name << " in the well collection!\n");
+    FlattenedWellsGroups& WellCollection::flattenedGroups()
+    {
+        refreshIndex();
+        if (!flattened_valid_) {
+            flattened_ = FlattenedWellsGroups(roots_);
+            flattened_valid_ = true;
         }
+        return flattened_;
+    }
 
-        return *(*well_node);
+    void WellCollection::addLeafNode(WellNode* node)
+    {
+        leaf_index_.emplace(node->name(), leaf_nodes_.size());
+        leaf_nodes_.push_back(node);
     }
 
     /// Adds the child to the collection
@@ -151,8 +197,9 @@ namespace Opm
         assert(!parent->isLeafNode());
         static_cast<WellsGroup*>(parent)->addChild(child_node);
         if (child_node->isLeafNode()) {
-            leaf_nodes_.push_back(static_cast<WellNode*>(child_node.get()));
+            addLeafNode(static_cast<WellNode*>(child_node.get()));
         }
+        nodeAdded(child_node.get());
 
     }
 
@@ -160,26 +207,21 @@ namespace Opm
 
     void WellCollection::addChild(std::shared_ptr<WellsGroupInterface>& child_node)
     {
+        refreshIndex();
         roots_.push_back(child_node);
         if (child_node->isLeafNode()) {
-            leaf_nodes_.push_back(static_cast<WellNode*> (child_node.get()));
+            addLeafNode(static_cast<WellNode*> (child_node.get()));
         }
+        nodeAdded(child_node.get());
     }
 
     bool WellCollection::conditionsMet(const std::vector<double>& well_bhp,
                                        const std::vector<double>& well_reservoirrates_phase,
                                        const std::vector<double>& well_surfacerates_phase)
     {
-        for (size_t i = 0; i < roots_.size(); i++) {
-            WellPhasesSummed phases;
-            if (!roots_[i]->conditionsMet(well_bhp,
-                                          well_reservoirrates_phase,
-                                          well_surfacerates_phase,
-                                          phases)) {
-                return false;
-            }
-        }
-        return true;
+        return flattenedGroups().conditionsMet(well_bhp,
+                                               well_reservoirrates_phase,
+                                               well_surfacerates_phase);
     }
 
     void WellCollection::setWellsPointer(Wells* wells) {
@@ -190,10 +232,12 @@ namespace Opm
 
     void WellCollection::applyGroupControls()
     {
-        for (size_t i = 0; i < roots_.size(); ++i) {
-            roots_[i]->applyProdGroupControls();
-            roots_[i]->applyInjGroupControls();
-        }
+        // The production and injection controls are independent, so
+        // applying each to all roots is the same as applying both to one
+        // root at a time.
+        FlattenedWellsGroups& groups = flattenedGroups();
+        groups.applyProdGroupControls();
+        groups.applyInjGroupControls();
 
         group_control_applied_ = true;
     }
@@ -211,18 +255,14 @@ namespace Opm
     void WellCollection::applyExplicitReinjectionControls(const std::vector<double>& well_reservoirrates_phase,
                                                           const std::vector<double>& well_surfacerates_phase)
     {
-        for (size_t i = 0; i < roots_.size(); ++i) {
-            roots_[i]->applyExplicitReinjectionControls(well_reservoirrates_phase, well_surfacerates_phase);
-        }
+        flattenedGroups().applyExplicitReinjectionControls(well_reservoirrates_phase, well_surfacerates_phase);
     }
 
 
     void WellCollection::applyVREPGroupControls(const std::vector<double>& well_voidage_rates,
                                                 const std::vector<double>& conversion_coeffs)
     {
-        for (size_t i = 0; i < roots_.size(); ++i) {
-            roots_[i]->applyVREPGroupControls(well_voidage_rates, conversion_coeffs);
-        }
+        flattenedGroups().applyVREPGroupControls(well_voidage_rates, conversion_coeffs);
     }
 
 
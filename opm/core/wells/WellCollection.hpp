@@ -21,7 +21,10 @@
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
+#include <opm/core/wells/FlattenedWellsGroups.hpp>
 #include <opm/core/wells/WellsGroup.hpp>
 #include <opm/core/grid.h>
 #include <opm/core/props/phaseUsageFromDeck.hpp>
@@ -86,6 +89,9 @@ namespace Opm
         const std::vector<WellNode*>& getLeafNodes() const;
 
         /// Finds the group with the given name.
+        /// Nodes are looked up by name in constant time.  The index is
+        /// rebuilt if nodes were attached to a group of the collection
+        /// with WellsGroup::addChild() since the last lookup.
         /// \param[in] the name of the group
         /// \return the pointer to the group if found, NULL otherwise
         WellsGroupInterface* findNode(const std::string& name);
@@ -96,6 +102,8 @@ namespace Opm
         const WellsGroupInterface* findNode(const std::string& name) const;
 
 
+        /// Finds the leaf node of the well with the given name.
+        /// Throws if the well is not in the collection.
         WellNode& findWellNode(const std::string& name) const;
 
 
@@ -159,12 +167,46 @@ namespace Opm
         bool requireWellPotentials() const;
 
     private:
+        // Adds the node and all nodes below it to node_index_.
+        void indexNode(WellsGroupInterface* node) const;
+
+        // Sum of the structure revisions of the roots.
+        std::size_t structureRevision() const;
+
+        // Rebuilds node_index_ and invalidates the flattened forest if
+        // the trees were changed outside of this class.
+        void refreshIndex() const;
+
+        // Indexes a node added by this class, keeping the index in
+        // step with the trees.
+        void nodeAdded(WellsGroupInterface* node);
+
+        // Appends the node to leaf_nodes_ and leaf_index_.
+        void addLeafNode(WellNode* node);
+
+        // The forest in roots_ as arrays, rebuilt after nodes are added.
+        FlattenedWellsGroups& flattenedGroups();
+
         // To account for the possibility of a forest
         std::vector<std::shared_ptr<WellsGroupInterface> > roots_;
 
         // This will be used to traverse the bottom nodes.
         std::vector<WellNode*> leaf_nodes_;
 
+        // Name of every node in the forest -> node.  If several nodes
+        // have the same name, the first one added is kept.
+        mutable std::unordered_map<std::string, WellsGroupInterface*> node_index_;
+
+        // structureRevision() when node_index_ was last brought up to date.
+        mutable std::size_t indexed_revision_ = 0;
+
+        // Name of every leaf node -> position in leaf_nodes_.
+        std::unordered_map<std::string, size_t> leaf_index_;
+
+        // Used for evaluating the group controls.
+        FlattenedWellsGroups flattened_;
+        mutable bool flattened_valid_ = false;
+
         bool having_vrep_groups_ = false;
 
         bool group_control_active_ = false;
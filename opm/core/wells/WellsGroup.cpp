@@ -68,6 +68,7 @@ namespace Opm
         : parent_(NULL),
           individual_control_(true), // always begin with individual control
           efficiency_factor_(efficiency_factor),
+          structure_revision_(0),
           name_(myname),
           production_specification_(prod_spec),
           injection_specification_(inje_spec),
@@ -89,6 +90,20 @@ namespace Opm
         return parent_;
     }
 
+    std::size_t WellsGroupInterface::structureRevision() const
+    {
+        return structure_revision_;
+    }
+
+    void WellsGroupInterface::structureChanged()
+    {
+        WellsGroupInterface* root = this;
+        while (root->parent_ != NULL) {
+            root = root->parent_;
+        }
+        ++root->structure_revision_;
+    }
+
     const std::string& WellsGroupInterface::name() const
     {
         return name_;
@@ -350,8 +365,6 @@ namespace Opm
                                    const std::vector<double>& well_surfacerates_phase,
                                    WellPhasesSummed& summed_phases)
     {
-        // TODO: adding here for compilation, not sure everything will work correctly.
-        const InjectionSpecification::InjectorType injector_type = injSpec().injector_type_;
         // Check children's constraints recursively.
         WellPhasesSummed child_phases_summed;
         for (size_t i = 0; i < children_.size(); ++i) {
@@ -365,6 +378,23 @@ namespace Opm
             child_phases_summed += current_child_phases_summed;
         }
 
+        if (!groupConditionsMet(well_reservoirrates_phase,
+                                well_surfacerates_phase,
+                                child_phases_summed)) {
+            return false;
+        }
+
+        summed_phases += child_phases_summed;
+        return true;
+    }
+
+    bool WellsGroup::groupConditionsMet(const std::vector<double>& well_reservoirrates_phase,
+                                        const std::vector<double>& well_surfacerates_phase,
+                                        const WellPhasesSummed& child_phases_summed)
+    {
+        // TODO: adding here for compilation, not sure everything will work correctly.
+        const InjectionSpecification::InjectorType injector_type = injSpec().injector_type_;
+
 
         // Injection constraints.
         InjectionSpecification::ControlMode injection_modes[] = {InjectionSpecification::RATE,
@@ -444,13 +474,18 @@ namespace Opm
             }
         }
 
-        summed_phases += child_phases_summed;
         return true;
     }
 
     void WellsGroup::addChild(std::shared_ptr<WellsGroupInterface> child)
     {
         children_.push_back(child);
+        structureChanged();
+    }
+
+    const std::vector<std::shared_ptr<WellsGroupInterface> >& WellsGroup::children() const
+    {
+        return children_;
     }
 
 
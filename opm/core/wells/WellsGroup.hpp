@@ -28,6 +28,7 @@
 #include <opm/parser/eclipse/EclipseState/Schedule/Well.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/Group.hpp>
 
+#include <cstddef>
 #include <string>
 #include <memory>
 
@@ -95,6 +96,10 @@ namespace Opm
 
         WellsGroupInterface* getParent();
 
+        /// Number of children added anywhere in the tree of which this
+        /// node is the root, used to detect changes of the tree structure.
+        std::size_t structureRevision() const;
+
         /// Calculates the number of leaf nodes in the given group.
         /// A leaf node is defined to have one leaf node in its group.
         virtual int numberOfLeafNodes() = 0;
@@ -263,6 +268,10 @@ namespace Opm
                           const double* surf_rates,
                           const InjectionSpecification::ControlMode mode);
 
+        /// Records a change of the tree structure at the root of the
+        /// tree containing this node.
+        void structureChanged();
+
         WellsGroupInterface* parent_;
 
         // Whether well is running under the group control target.
@@ -274,6 +283,7 @@ namespace Opm
         double efficiency_factor_;
 
     private:
+        std::size_t structure_revision_;
         std::string name_;
         ProductionSpecification production_specification_;
         InjectionSpecification injection_specification_;
@@ -295,11 +305,24 @@ namespace Opm
 
         void addChild(std::shared_ptr<WellsGroupInterface> child);
 
+        /// The children of this group, in the order they were added.
+        const std::vector<std::shared_ptr<WellsGroupInterface> >& children() const;
+
         virtual bool conditionsMet(const std::vector<double>& well_bhp,
                                    const std::vector<double>& well_reservoirrates_phase,
                                    const std::vector<double>& well_surfacerates_phase,
                                    WellPhasesSummed& summed_phases);
 
+        /// Checks the constraints of this group only, given the summed
+        /// rates of its children, and applies a control change if one
+        /// is violated.  This is what conditionsMet() does after the
+        /// children's constraints have been checked.
+        /// \param[in] child_phases_summed  Sum of the children's rates.
+        /// \return true if no violations were found, false otherwise.
+        bool groupConditionsMet(const std::vector<double>& well_reservoirrates_phase,
+                                const std::vector<double>& well_surfacerates_phase,
+                                const WellPhasesSummed& child_phases_summed);
+
         virtual int numberOfLeafNodes();
         virtual std::pair<WellNode*, double> getWorstOffending(const std::vector<double>& well_reservoirrates_phase,
                                                                const std::vector<double>& well_surfacerates_phase,
@@ -15,6 +15,9 @@
 #define BOOST_TEST_MODULE BlackoilStateTest
 #define BOOST_TEST_MAIN
 #include <boost/test/unit_test.hpp>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <iostream>
 #include <iterator>
@@ -23,6 +26,7 @@
 
 #include "opm/core/grid/GridManager.hpp"
 #include "opm/core/simulator/BlackoilState.hpp"
+#include "opm/core/utility/initHydroCarbonState.hpp"
 
 using namespace Opm;
 using namespace std;
@@ -141,3 +145,156 @@ BOOST_AUTO_TEST_CASE(EqualsNumericalDifferenceReturnFalse) {
         BOOST_CHECK(   state1.equal(state2) );
     }
 }
+
+
+
+namespace {
+    PhaseUsage phaseUsage(const bool water, const bool gas)
+    {
+        PhaseUsage pu;
+        for (int phase = 0; phase < BlackoilPhases::MaxNumPhases + BlackoilPhases::NumCryptoPhases; ++phase) {
+            pu.phase_used[phase] = 0;
+            pu.phase_pos[phase] = -1;
+        }
+        pu.num_phases = 0;
+        if (water) {
+            pu.phase_used[BlackoilPhases::Aqua] = 1;
+            pu.phase_pos[BlackoilPhases::Aqua] = pu.num_phases++;
+        }
+        pu.phase_used[BlackoilPhases::Liquid] = 1;
+        pu.phase_pos[BlackoilPhases::Liquid] = pu.num_phases++;
+        if (gas) {
+            pu.phase_used[BlackoilPhases::Vapour] = 1;
+            pu.phase_pos[BlackoilPhases::Vapour] = pu.num_phases++;
+        }
+        pu.has_solvent = false;
+        pu.has_polymer = false;
+        pu.has_energy = false;
+        return pu;
+    }
+
+    // The classification as initHydroCarbonState() did it with
+    // branches, before it became branch free.
+    std::vector<HydroCarbonState> branchingHydroCarbonState(const std::vector<double>& saturation,
+                                                            const PhaseUsage& pu,
+                                                            const int num_cells,
+                                                            const bool has_disgas,
+                                                            const bool has_vapoil)
+    {
+        enum { Oil = BlackoilPhases::Liquid, Gas = BlackoilPhases::Vapour, Water = BlackoilPhases::Aqua };
+        if (!pu.phase_used[Gas]) {
+            return std::vector<HydroCarbonState>(num_cells, HydroCarbonState::OilOnly);
+        }
+        const int np = pu.num_phases;
+        std::vector<HydroCarbonState> hydroCarbonState(num_cells, HydroCarbonState::GasAndOil);
+        const double epsilon = std::sqrt(std::numeric_limits<double>::epsilon());
+        for (int c = 0; c < num_cells; ++c) {
+            if (pu.phase_used[Water]) {
+                if ( saturation[c*np + pu.phase_pos[ Water ]] > (1.0 - epsilon)) {
+                    continue;
+                }
+            }
+            if ( saturation[c*np + pu.phase_pos[ Gas ]] == 0.0 && has_disgas) {
+                hydroCarbonState[c] = HydroCarbonState::OilOnly;
+                continue;
+            }
+            if ( saturation[c*np + pu.phase_pos[ Oil ]] == 0.0 && has_vapoil) {
+                hydroCarbonState[c] = HydroCarbonState::GasOnly;
+            }
+        }
+        return hydroCarbonState;
+    }
+
+    void checkHydroCarbonState(const bool water, const bool gas,
+                               const std::vector< std::vector<double> >& cell_saturations)
+    {
+        const PhaseUsage pu = phaseUsage(water, gas);
+        const int np = pu.num_phases;
+        // Repeat the pattern so that the cells are split among threads.
+        const int num_cells = 100 * cell_saturations.size();
+        BlackoilState state(num_cells, 0, np);
+        for (int c = 0; c < num_cells; ++c) {
+            const std::vector<double>& s = cell_saturations[c % cell_saturations.size()];
+            BOOST_REQUIRE(int(s.size()) == np);
+            std::copy(s.begin(), s.end(), state.saturation().begin() + c*np);
+        }
+
+        for (const bool has_disgas : { false, true }) {
+            for (const bool has_vapoil : { false, true }) {
+                initHydroCarbonState(state, pu, num_cells, has_disgas, has_vapoil);
+                const std::vector<HydroCarbonState> expected =
+                    branchingHydroCarbonState(state.saturation(), pu, num_cells, has_disgas, has_vapoil);
+                const std::vector<HydroCarbonState>& hcs = state.hydroCarbonState();
+                BOOST_REQUIRE(int(hcs.size()) == num_cells);
+
+                std::array<int, 3> expected_count = {{ 0, 0, 0 }};
+                for (int c = 0; c < num_cells; ++c) {
+                    BOOST_CHECK_EQUAL(int(hcs[c]), int(expected[c]));
+                    ++expected_count[expected[c]];
+                }
+                const std::array<int, 3> count = countHydroCarbonStates(hcs);
+                BOOST_CHECK_EQUAL(count[HydroCarbonState::GasOnly], expected_count[HydroCarbonState::GasOnly]);
+                BOOST_CHECK_EQUAL(count[HydroCarbonState::GasAndOil], expected_count[HydroCarbonState::GasAndOil]);
+                BOOST_CHECK_EQUAL(count[HydroCarbonState::OilOnly], expected_count[HydroCarbonState::OilOnly]);
+            }
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(HydroCarbonStateMatchesBranchingClassification) {
+    // Water, oil and gas.
+    checkHydroCarbonState(true, true, {
+            { 1.0, 0.0, 0.0 },                 // Filled with water.
+            { 1.0 - 1.0e-10, 0.0, 1.0e-10 },   // Almost filled with water.
+            { 1.0 - 1.0e-6, 1.0e-6, 0.0 },     // Not quite.
+            { 0.2, 0.8, 0.0 },
+            { 0.2, 0.0, 0.8 },
+            { 0.2, 0.5, 0.3 },
+            { 0.5, 0.0, 0.0 },                 // No oil and no gas.
+            { 0.0, 1.0, 0.0 },
+            { 0.0, 0.0, 1.0 }
+        });
+
+    // Oil and gas.
+    checkHydroCarbonState(false, true, {
+            { 1.0, 0.0 },
+            { 0.0, 1.0 },
+            { 0.5, 0.5 },
+            { 0.0, 0.0 }
+        });
+
+    // Water and oil, always OilOnly.
+    checkHydroCarbonState(true, false, {
+            { 1.0, 0.0 },
+            { 0.2, 0.8 },
+            { 0.0, 1.0 }
+        });
+}
+
+
+
+BOOST_AUTO_TEST_CASE(HydroCarbonStateCounts) {
+    std::vector<HydroCarbonState> hcs;
+    for (int c = 0; c < 1000; ++c) {
+        hcs.push_back(c % 7 == 0 ? HydroCarbonState::GasOnly
+                      : c % 3 == 0 ? HydroCarbonState::OilOnly
+                      : HydroCarbonState::GasAndOil);
+    }
+    int gas_only = 0;
+    int oil_only = 0;
+    for (int c = 0; c < 1000; ++c) {
+        gas_only += (c % 7 == 0);
+        oil_only += (c % 7 != 0 && c % 3 == 0);
+    }
+    const std::array<int, 3> count = countHydroCarbonStates(hcs);
+    BOOST_CHECK_EQUAL(count[HydroCarbonState::GasOnly], gas_only);
+    BOOST_CHECK_EQUAL(count[HydroCarbonState::OilOnly], oil_only);
+    BOOST_CHECK_EQUAL(count[HydroCarbonState::GasAndOil], 1000 - gas_only - oil_only);
+
+    const std::array<int, 3> empty = countHydroCarbonStates(std::vector<HydroCarbonState>());
+    BOOST_CHECK_EQUAL(empty[HydroCarbonState::GasOnly], 0);
+    BOOST_CHECK_EQUAL(empty[HydroCarbonState::GasAndOil], 0);
+    BOOST_CHECK_EQUAL(empty[HydroCarbonState::OilOnly], 0);
+}
@@ -0,0 +1,286 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define NVERBOSE  // Suppress own messages when throw()ing
+
+#define BOOST_TEST_MODULE CfsTpfaResidualTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/core/grid.h>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/linalg/sparse_sys.h>
+#include <opm/core/pressure/tpfa/cfs_tpfa_residual.h>
+#include <opm/core/pressure/tpfa/compr_quant_general.h>
+#include <opm/core/well_controls.h>
+#include <opm/core/wells.h>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    /// Fluid state of a compressible flow problem with 'nactive' real
+    /// phases, stored with 'np' >= 'nactive' phases.  Additional phases
+    /// are inert: unit fluid matrix, no mass and no mobility.  They do
+    /// not contribute to the pressure residual, so a problem stored with
+    /// extra phases assembles the same system through the generic fluid
+    /// matrix kernels.
+    struct FluidState
+    {
+        FluidState(const UnstructuredGrid& g, const int nactive, const int np)
+            : nphases(np)
+        {
+            const int nc = g.number_of_cells;
+            const int nf = g.number_of_faces;
+            const int nperf = 4;
+
+            Ac.assign(nc*np*np, 0.0);
+            dAc.assign(nc*np*np, 0.0);
+            Af.assign(nf*np*np, 0.0);
+            phasemobf.assign(nf*np, 0.0);
+            gravcap_f.assign(nf*np, 0.0);
+            zc.assign(nc*np, 0.0);
+            wellA.assign(nperf*np*np, 0.0);
+            wellmob.assign(nperf*np, 0.0);
+
+            // Column major, element (p,q) at offset p + q*np.
+            for (int c = 0; c < nc; ++c) {
+                double* A = &Ac[c*np*np];
+                double* dA = &dAc[c*np*np];
+                for (int p = 0; p < np; ++p) {
+                    for (int q = 0; q < np; ++q) {
+                        if ((p < nactive) && (q < nactive)) {
+                            A[p + q*np] = (p == q)
+                                ? 1.0 + 0.1*((c + p) % 5)
+                                : 0.05*std::sin(double(c + p + 2*q));
+                            dA[p + q*np] = 1.0e-3*std::cos(double(c*p + q));
+                        } else {
+                            A[p + q*np] = (p == q) ? 1.0 : 0.0;
+                        }
+                    }
+                }
+                for (int p = 0; p < nactive; ++p) {
+                    zc[c*np + p] = 0.3 + 0.1*std::sin(double(c + p));
+                }
+            }
+
+            for (int f = 0; f < nf; ++f) {
+                double* A = &Af[f*np*np];
+                for (int p = 0; p < np; ++p) {
+                    for (int q = 0; q < np; ++q) {
+                        if ((p < nactive) && (q < nactive)) {
+                            A[p + q*np] = (p == q) ? 1.1 : 0.02*(p + 2*q);
+                        } else {
+                            A[p + q*np] = (p == q) ? 1.0 : 0.0;
+                        }
+                    }
+                }
+                for (int p = 0; p < nactive; ++p) {
+                    phasemobf[f*np + p] = 0.5 + 0.1*p + 0.01*f;
+                    gravcap_f[f*np + p] = 0.01*(p + 1);
+                }
+            }
+
+            for (int i = 0; i < nperf; ++i) {
+                double* A = &wellA[i*np*np];
+                for (int p = 0; p < np; ++p) {
+                    for (int q = 0; q < np; ++q) {
+                        if ((p < nactive) && (q < nactive)) {
+                            A[p + q*np] = (p == q) ? 1.2 : 0.01*(i + 1);
+                        } else {
+                            A[p + q*np] = (p == q) ? 1.0 : 0.0;
+                        }
+                    }
+                }
+                for (int p = 0; p < nactive; ++p) {
+                    wellmob[i*np + p] = 0.3 + 0.1*p;
+                }
+            }
+
+            cq.nphases   = np;
+            cq.Ac        = &Ac[0];
+            cq.dAc       = &dAc[0];
+            cq.Af        = &Af[0];
+            cq.phasemobf = &phasemobf[0];
+            cq.voldiscr  = 0;
+        }
+
+        int nphases;
+        std::vector<double> Ac, dAc, Af, phasemobf, gravcap_f, zc;
+        std::vector<double> wellA, wellmob;
+        compr_quantities_gen cq;
+    };
+
+    /// Pressure and rock state shared by all phase counts.
+    struct RockState
+    {
+        explicit RockState(const UnstructuredGrid& g)
+        {
+            for (int f = 0; f < g.number_of_faces; ++f) {
+                trans.push_back(1.0 + 0.01*f);
+            }
+            for (int c = 0; c < g.number_of_cells; ++c) {
+                cpress.push_back(280.0 + std::sin(double(c)));
+                porevol.push_back(1.0 + 0.01*c);
+                porevol0.push_back(0.99*(1.0 + 0.01*c));
+                rock_comp.push_back(1.0e-4);
+            }
+            wpress.push_back(310.0);
+            wpress.push_back(250.0);
+            wdp.push_back(0.1);
+            wdp.push_back(0.2);
+            wdp.push_back(0.3);
+            wdp.push_back(0.4);
+        }
+
+        std::vector<double> trans, cpress, porevol, porevol0, rock_comp;
+        std::vector<double> wpress, wdp;
+    };
+
+    // BHP controlled injector and producer, two perforations each.
+    std::shared_ptr<Wells> makeWells(const UnstructuredGrid& g, const int np)
+    {
+        const int nc = g.number_of_cells;
+        std::shared_ptr<Wells> w(create_wells(np, 2, 4), destroy_wells);
+
+        const int inj_cells[] = { 0, 5 };
+        const int prod_cells[] = { nc - 1, nc - 6 };
+        const double WI[] = { 1.5, 2.5 };
+        add_well(INJECTOR, 0.0, 2, 0, inj_cells, WI, 0, "INJ", 1, w.get());
+        append_well_controls(BHP, 300.0, 0.0, 0, 0, 0, w.get());
+        well_controls_set_current(w->ctrls[0], 0);
+
+        add_well(PRODUCER, 0.0, 2, 0, prod_cells, WI, 0, "PROD", 1, w.get());
+        append_well_controls(BHP, 200.0, 0.0, 0, 0, 1, w.get());
+        well_controls_set_current(w->ctrls[1], 0);
+
+        return w;
+    }
+
+    /// Assembled Jacobian and residual.
+    struct AssembledSystem
+    {
+        std::vector<int>         ia;
+        std::vector<int>         ja;
+        std::vector<double>      J, F;
+    };
+
+    AssembledSystem assemble(const UnstructuredGrid& g, const RockState& rock,
+                             FluidState& fluid, const bool with_wells,
+                             const bool comprock)
+    {
+        UnstructuredGrid* G = const_cast<UnstructuredGrid*>(&g);
+        const std::shared_ptr<Wells> W = makeWells(g, fluid.nphases);
+
+        RockState r = rock;
+        CompletionData cd = { &r.wdp[0], &fluid.wellA[0], &fluid.wellmob[0] };
+        cfs_tpfa_res_wells wells = { W.get(), &cd };
+        cfs_tpfa_res_wells* wellsp = with_wells ? &wells : 0;
+        const double* wpress = with_wells ? &r.wpress[0] : 0;
+        cfs_tpfa_res_forces forces = { wellsp, 0 };
+
+        std::shared_ptr<cfs_tpfa_res_data>
+            h(cfs_tpfa_res_construct(G, wellsp, fluid.nphases),
+              cfs_tpfa_res_destroy);
+        BOOST_REQUIRE(h);
+
+        if (comprock) {
+            cfs_tpfa_res_comprock_assemble(G, 0.5, &forces, &fluid.zc[0], &fluid.cq,
+                                           &r.trans[0], &fluid.gravcap_f[0],
+                                           &r.cpress[0], wpress,
+                                           &r.porevol[0], &r.porevol0[0],
+                                           &r.rock_comp[0], h.get());
+        } else {
+            cfs_tpfa_res_assemble(G, 0.5, &forces, &fluid.zc[0], &fluid.cq,
+                                  &r.trans[0], &fluid.gravcap_f[0],
+                                  &r.cpress[0], wpress,
+                                  &r.porevol[0], h.get());
+        }
+
+        const CSRMatrix& J = *h->J;
+        AssembledSystem sys;
+        sys.ia.assign(J.ia, J.ia + J.m + 1);
+        sys.ja.assign(J.ja, J.ja + J.nnz);
+        sys.J.assign(J.sa, J.sa + J.nnz);
+        sys.F.assign(h->F, h->F + J.m);
+        return sys;
+    }
+
+    void checkSameSystem(const AssembledSystem& s, const AssembledSystem& r)
+    {
+        BOOST_REQUIRE(s.ia == r.ia);
+        BOOST_REQUIRE(s.ja == r.ja);
+        for (std::size_t k = 0; k < s.J.size(); ++k) {
+            BOOST_CHECK_CLOSE(s.J[k], r.J[k], 1.0e-10);
+        }
+        for (std::size_t i = 0; i < s.F.size(); ++i) {
+            BOOST_CHECK_SMALL(s.F[i] - r.F[i], 1.0e-10);
+        }
+    }
+
+    // Assemble a problem with 'nactive' phases, using its specialised
+    // kernels, and again with 'nstored' phases.
+    void checkEmbedded(const int nactive, const int nstored, const bool with_wells)
+    {
+        const GridManager gm(4, 3, 2);
+        const UnstructuredGrid& g = *gm.c_grid();
+        const RockState rock(g);
+
+        FluidState special(g, nactive, nactive);
+        FluidState embedded(g, nactive, nstored);
+
+        for (int comprock = 0; comprock < 2; ++comprock) {
+            checkSameSystem(assemble(g, rock, special , with_wells, comprock != 0),
+                            assemble(g, rock, embedded, with_wells, comprock != 0));
+        }
+    }
+}
+
+
+
+// Four and five phases use the generic LAPACK based kernels.  The well
+// assembly supports at most three phases, so these cases have no wells.
+BOOST_AUTO_TEST_CASE(TwoPhaseKernelsMatchGeneric)
+{
+    checkEmbedded(2, 4, false);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ThreePhaseKernelsMatchGeneric)
+{
+    checkEmbedded(3, 5, false);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(TwoPhaseKernelsMatchThreePhaseWithWells)
+{
+    checkEmbedded(2, 3, true);
+}
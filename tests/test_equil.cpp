@@ -41,6 +41,7 @@
 #include <opm/parser/eclipse/Units/Units.hpp>
 
 #include <array>
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -190,6 +191,62 @@ static Opm::EquilRecord mkEquilRecord( double datd, double datp,
     return EquilRecord( rec );
 }
 
+BOOST_AUTO_TEST_CASE (DormandPrinceExponential)
+{
+    // dy/dx = y, y(0) = 1, with the solution y = exp(x).
+    auto f = [](const double /* x */, const double y) { return y; };
+    typedef Opm::Details::DormandPrinceIVP<decltype(f)> IVP;
+
+    const double reltol = 1.0e-6; // Percent.
+    {
+        const IVP ivp(f, {{ 0.0, 1.0 }}, 1.0);
+
+        // The step length is bounded by 1/64 of the interval, and the
+        // local error of such a step is far below the tolerance, so a
+        // correct tableau takes exactly 64 steps.
+        BOOST_CHECK_EQUAL(ivp.numSteps(), 64);
+        BOOST_CHECK_CLOSE(ivp(1.0), std::exp(1.0), 1.0e-9);
+
+        // Dense output between and at the steps.
+        std::vector<double> x(101);
+        for (int k = 0; k < int(x.size()); ++k) {
+            x[k] = k / 100.0;
+        }
+        std::vector<double> y(x.size());
+        ivp(int(x.size()), x.data(), y.data());
+        for (int k = 0; k < int(x.size()); ++k) {
+            BOOST_CHECK_CLOSE(y[k], std::exp(x[k]), reltol);
+            BOOST_CHECK_EQUAL(y[k], ivp(x[k]));
+        }
+    }
+
+    // Integration towards decreasing x.
+    {
+        const IVP ivp(f, {{ 1.0, 0.0 }}, std::exp(1.0));
+        BOOST_CHECK_EQUAL(ivp.numSteps(), 64);
+        for (int k = 0; k <= 100; ++k) {
+            const double x = k / 100.0;
+            BOOST_CHECK_CLOSE(ivp(x), std::exp(x), reltol);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (DormandPrinceFailures)
+{
+    // A right hand side that becomes NaN gives a non-finite error
+    // estimate, which must not be retried forever.
+    auto nan_rhs = [](const double x, const double y)
+        { return (x > 0.5) ? std::numeric_limits<double>::quiet_NaN() : y; };
+    BOOST_CHECK_THROW(Opm::Details::DormandPrinceIVP<decltype(nan_rhs)>(nan_rhs, {{ 0.0, 1.0 }}, 1.0),
+                      std::runtime_error);
+
+    // A singularity inside the interval makes the step size collapse.
+    auto singular = [](const double x, const double /* y */)
+        { return ((x < 0.5) ? 1.0 : -1.0) / std::pow(std::abs(x - 0.5), 3); };
+    BOOST_CHECK_THROW(Opm::Details::DormandPrinceIVP<decltype(singular)>(singular, {{ 0.0, 1.0 }}, 1.0),
+                      std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE (PhasePressure)
 {
     typedef std::vector<double> PVal;
@@ -504,6 +561,148 @@ BOOST_AUTO_TEST_CASE (CapillaryInversion)
 
 
 
+BOOST_AUTO_TEST_CASE (CapillaryInversionTables)
+{
+    Opm::GridManager gm(1, 1, 4, 1.0, 1.0, 1.0);
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    Opm::Parser parser;
+    Opm::ParseContext parseContext;
+    Opm::Deck deck = parser.parseFile("capillary_regions.DATA" , parseContext);
+    Opm::EclipseState eclipseState(deck , parseContext);
+
+    // Create material law manager.
+    std::vector<int> compressedToCartesianIdx
+        = Opm::compressedToCartesian(grid.number_of_cells, grid.global_cell);
+    MaterialLawManager materialLawManager = MaterialLawManager();
+    materialLawManager.initFromDeck(deck, eclipseState, compressedToCartesianIdx);
+
+    typedef Opm::FluidSystems::BlackOil<double> FluidSystem;
+    typedef MaterialLawManager::MaterialLaw MaterialLaw;
+    typedef Opm::EQUIL::PcEq<FluidSystem, MaterialLaw, MaterialLawManager> PcEq;
+    typedef Opm::EQUIL::PcEqSum<FluidSystem, MaterialLaw, MaterialLawManager> PcEqSum;
+
+    // Initialize the fluid system
+    FluidSystem::initFromDeck(deck, eclipseState);
+
+    const int water = FluidSystem::waterPhaseIdx;
+    const int gas = FluidSystem::gasPhaseIdx;
+
+    // Cells 0 and 1 are in SATNUM region 1, cells 2 and 3 in region 2.
+    BOOST_REQUIRE(materialLawManager.satnumRegionIdx(0) == materialLawManager.satnumRegionIdx(1));
+    BOOST_REQUIRE(materialLawManager.satnumRegionIdx(2) == materialLawManager.satnumRegionIdx(3));
+    BOOST_REQUIRE(materialLawManager.satnumRegionIdx(0) != materialLawManager.satnumRegionIdx(2));
+
+    const std::vector<int> cells = { 0, 1, 2, 3 };
+    const Opm::EQUIL::PcInverseTables<FluidSystem, MaterialLaw, MaterialLawManager>
+        pcInverse(materialLawManager, cells);
+
+    // Target values for a curve g(s) from s0 to s1: the first two give
+    // s0, the next two s1, and the rest are in between.
+    auto targets = [](const double g0, const double g1)
+    {
+        std::vector<double> t = { g0 + 1.0e5, g0, g1, g1 - 1.0e5 };
+        const int n = 17;
+        for (int k = 1; k < n; ++k) {
+            t.push_back(g0 + (g1 - g0)*k/n);
+        }
+        return t;
+    };
+    const double tol = 1.0e-6;
+
+    for (const int cell : cells) {
+        // Oil-water, pcow(sw) decreasing from SWL to SWU.
+        {
+            const double s0 = Opm::EQUIL::minSaturations<FluidSystem>(materialLawManager, water, cell);
+            const double s1 = Opm::EQUIL::maxSaturations<FluidSystem>(materialLawManager, water, cell);
+            const PcEq pc(materialLawManager, water, cell, 0.0);
+            const std::vector<double> t = targets(pc(s0), pc(s1));
+            for (size_t i = 0; i < t.size(); ++i) {
+                const double s_direct = Opm::EQUIL::satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, water, cell, t[i]);
+                const double s_table = pcInverse.satFromPc(water, cell, t[i]);
+                if (i < 2) {
+                    BOOST_CHECK_EQUAL(s_table, s0);
+                    BOOST_CHECK_EQUAL(s_direct, s0);
+                } else if (i < 4) {
+                    BOOST_CHECK_EQUAL(s_table, s1);
+                    BOOST_CHECK_SMALL(s_direct - s1, tol);
+                } else {
+                    BOOST_CHECK_SMALL(s_table - s_direct, tol);
+                }
+            }
+        }
+
+        // Gas-oil, pcgo(sg) decreasing from SGU to SGL.
+        {
+            const bool increasing = true;
+            const double s0 = Opm::EQUIL::maxSaturations<FluidSystem>(materialLawManager, gas, cell);
+            const double s1 = Opm::EQUIL::minSaturations<FluidSystem>(materialLawManager, gas, cell);
+            const PcEq pc(materialLawManager, gas, cell, 0.0);
+            const std::vector<double> t = targets(pc(s0), pc(s1));
+            for (size_t i = 0; i < t.size(); ++i) {
+                const double s_direct = Opm::EQUIL::satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, gas, cell, t[i], increasing);
+                const double s_table = pcInverse.satFromPc(gas, cell, t[i], increasing);
+                if (i < 2) {
+                    BOOST_CHECK_EQUAL(s_table, s0);
+                    BOOST_CHECK_EQUAL(s_direct, s0);
+                } else if (i < 4) {
+                    BOOST_CHECK_EQUAL(s_table, s1);
+                    BOOST_CHECK_SMALL(s_direct - s1, tol);
+                } else {
+                    BOOST_CHECK_SMALL(s_table - s_direct, tol);
+                }
+            }
+        }
+
+        // Gas-water, pcow(sw) + pcgo(1 - sw) decreasing from SWL to SWU.
+        {
+            const double s0 = Opm::EQUIL::minSaturations<FluidSystem>(materialLawManager, water, cell);
+            const double s1 = Opm::EQUIL::maxSaturations<FluidSystem>(materialLawManager, water, cell);
+            const PcEqSum pc(materialLawManager, water, gas, cell, 0.0);
+            const std::vector<double> t = targets(pc(s0), pc(s1));
+            for (size_t i = 0; i < t.size(); ++i) {
+                const double s_direct = Opm::EQUIL::satFromSumOfPcs<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, water, gas, cell, t[i]);
+                const double s_table = pcInverse.satFromSumOfPcs(water, gas, cell, t[i]);
+                if (i < 2) {
+                    BOOST_CHECK_EQUAL(s_table, s0);
+                    BOOST_CHECK_EQUAL(s_direct, s0);
+                } else if (i < 4) {
+                    BOOST_CHECK_EQUAL(s_table, s1);
+                    BOOST_CHECK_SMALL(s_direct - s1, tol);
+                } else {
+                    BOOST_CHECK_SMALL(s_table - s_direct, tol);
+                }
+            }
+        }
+    }
+
+    // The regions have different curves, so a table of the wrong region
+    // would show up here.
+    {
+        const double pcow = 0.1e5;
+        BOOST_CHECK(std::abs(pcInverse.satFromPc(water, 0, pcow) - pcInverse.satFromPc(water, 2, pcow)) > 0.01);
+    }
+
+    // Cells of regions that were not sampled fall back to the direct
+    // inversion.
+    {
+        const std::vector<int> region1 = { 0 };
+        const Opm::EQUIL::PcInverseTables<FluidSystem, MaterialLaw, MaterialLawManager>
+            pcInverse1(materialLawManager, region1);
+        const double pcow = 0.1e5;
+        const double pcgo = 0.3e5;
+        const double pcgw = 0.5e5;
+        const int cell = 3;
+        BOOST_CHECK_EQUAL(pcInverse1.satFromPc(water, cell, pcow),
+                          (Opm::EQUIL::satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, water, cell, pcow)));
+        BOOST_CHECK_EQUAL(pcInverse1.satFromPc(gas, cell, pcgo, true),
+                          (Opm::EQUIL::satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, gas, cell, pcgo, true)));
+        BOOST_CHECK_EQUAL(pcInverse1.satFromSumOfPcs(water, gas, cell, pcgw),
+                          (Opm::EQUIL::satFromSumOfPcs<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, water, gas, cell, pcgw)));
+    }
+}
+
+
+
 BOOST_AUTO_TEST_CASE (DeckWithCapillary)
 {
     Opm::GridManager gm(1, 1, 20, 1.0, 1.0, 5.0);
@@ -0,0 +1,408 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define NVERBOSE  // Suppress own messages when throw()ing
+
+#define BOOST_TEST_MODULE IfsTpfaTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/core/grid.h>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/linalg/sparse_sys.h>
+#include <opm/core/pressure/tpfa/cell_ordering.h>
+#include <opm/core/pressure/tpfa/ifs_tpfa.h>
+#include <opm/core/well_controls.h>
+#include <opm/core/wells.h>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    typedef std::vector< std::vector<double> > DenseMatrix;
+
+    /// Input of a single pressure assembly.
+    struct TpfaSetup
+    {
+        std::vector<double> trans;
+        std::vector<double> gpress;
+        std::vector<double> src;
+        std::vector<double> porevol;
+        std::vector<double> rock_comp;
+        std::vector<double> pressure;
+        std::vector<double> totmob;
+        std::vector<double> wdp;
+        double              dt;
+    };
+
+    TpfaSetup makeSetup(const UnstructuredGrid& g, const Wells& w)
+    {
+        const int nc = g.number_of_cells;
+        const int nf = g.number_of_faces;
+        const int nhf = g.cell_facepos[nc];
+        const int nperf = w.well_connpos[w.number_of_wells];
+
+        TpfaSetup s;
+        for (int f = 0; f < nf; ++f) {
+            s.trans.push_back(1.0 + 0.1*f);
+        }
+        for (int i = 0; i < nhf; ++i) {
+            s.gpress.push_back(0.01*i);
+        }
+        for (int c = 0; c < nc; ++c) {
+            s.src.push_back(0.1*std::sin(double(c)));
+            s.porevol.push_back(1.0 + 0.01*c);
+            s.rock_comp.push_back(0.1 + 0.001*c);
+            s.pressure.push_back(2.0 + 0.01*c);
+            s.totmob.push_back(1.0 + 0.05*c);
+        }
+        for (int i = 0; i < nperf; ++i) {
+            s.wdp.push_back(0.02*(i + 1));
+        }
+        s.dt = 0.5;
+        return s;
+    }
+
+    // One BHP controlled producer and one RESV controlled injector.
+    std::shared_ptr<Wells> makeWells(const UnstructuredGrid& g)
+    {
+        const int nc = g.number_of_cells;
+        std::shared_ptr<Wells> w(create_wells(1, 2, 4), destroy_wells);
+
+        const double comp_frac[] = { 1.0 };
+        const int prod_cells[] = { 0, 1 };
+        const double prod_wi[] = { 1.5, 2.5 };
+        add_well(PRODUCER, 0.0, 2, comp_frac, prod_cells, prod_wi,
+                 0, "PROD", 1, w.get());
+        append_well_controls(BHP, 1.5, 0.0, 0, 0, 0, w.get());
+        well_controls_set_current(w->ctrls[0], 0);
+
+        const int inj_cells[] = { nc - 1, nc - 2 };
+        const double inj_wi[] = { 3.0, 0.5 };
+        const double distr[] = { 1.0 };
+        add_well(INJECTOR, 0.0, 2, comp_frac, inj_cells, inj_wi,
+                 0, "INJ", 1, w.get());
+        append_well_controls(RESERVOIR_RATE, 0.75, 0.0, 0, distr, 1, w.get());
+        well_controls_set_current(w->ctrls[1], 0);
+
+        return w;
+    }
+
+    // Per-element assembly in natural cell ordering, visiting each
+    // cell's faces in turn.
+    void referenceAssemble(const UnstructuredGrid& g, const Wells& w,
+                           const TpfaSetup& s, const bool comprock,
+                           DenseMatrix& A, std::vector<double>& b,
+                           std::vector<double>& fgrav)
+    {
+        const int nc = g.number_of_cells;
+        const int nw = w.number_of_wells;
+        A.assign(nc + nw, std::vector<double>(nc + nw, 0.0));
+        b.assign(nc + nw, 0.0);
+        fgrav.assign(g.number_of_faces, 0.0);
+
+        for (int c = 0; c < nc; ++c) {
+            for (int i = g.cell_facepos[c]; i < g.cell_facepos[c + 1]; ++i) {
+                const int f = g.cell_faces[i];
+                const int c1 = g.face_cells[2*f + 0];
+                const int c2 = g.face_cells[2*f + 1];
+                const double sgn = (c1 == c) ? 1.0 : -1.0;
+                if ((c1 >= 0) && (c2 >= 0)) {
+                    fgrav[f] += sgn * s.gpress[i];
+                }
+            }
+        }
+
+        for (int c = 0; c < nc; ++c) {
+            for (int i = g.cell_facepos[c]; i < g.cell_facepos[c + 1]; ++i) {
+                const int f = g.cell_faces[i];
+                const int c1 = g.face_cells[2*f + 0];
+                const int c2 = g.face_cells[2*f + 1];
+                const double sgn = (c1 == c) ? 1.0 : -1.0;
+                const int other = (c1 == c) ? c2 : c1;
+
+                b[c] -= s.trans[f] * sgn * fgrav[f];
+                if (other >= 0) {
+                    A[c][c]     += s.trans[f];
+                    A[c][other] -= s.trans[f];
+                }
+            }
+        }
+
+        for (int wix = 0; wix < nw; ++wix) {
+            const int wdof = nc + wix;
+            const WellControls* ctrl = w.ctrls[wix];
+            const double target = well_controls_get_current_target(ctrl);
+            const bool is_bhp = well_controls_get_current_type(ctrl) == BHP;
+
+            for (int i = w.well_connpos[wix]; i < w.well_connpos[wix + 1]; ++i) {
+                const int c = w.well_cells[i];
+                const double t = s.totmob[c] * w.WI[i];
+                if (is_bhp) {
+                    A[c][c]       += t;
+                    b[c]          += t * (target + s.wdp[i]);
+                    A[wdof][wdof] += t;
+                    b[wdof]       += t * target;
+                } else {
+                    A[c][c]       += t;
+                    A[c][wdof]    -= t;
+                    b[c]          += t * s.wdp[i];
+                    A[wdof][c]    -= t;
+                    A[wdof][wdof] += t;
+                    b[wdof]       -= t * s.wdp[i];
+                }
+            }
+            if (!is_bhp) {
+                b[wdof] += target;
+            }
+        }
+
+        for (int c = 0; c < nc; ++c) {
+            b[c] += s.src[c];
+        }
+
+        if (comprock) {
+            for (int c = 0; c < nc; ++c) {
+                const double d = s.porevol[c] * s.rock_comp[c] / s.dt;
+                A[c][c] += d;
+                b[c]    += d * s.pressure[c];
+            }
+        }
+    }
+
+    // Unknown of system row for cell or well 'i' in natural numbering.
+    int systemRow(const ifs_tpfa_data& h, const int nc, const int i)
+    {
+        return (i < nc) ? h.cell_row[i] : i;
+    }
+
+    // Dense copy of the assembled system, rows and columns in natural
+    // cell ordering.
+    DenseMatrix naturalMatrix(const ifs_tpfa_data& h, const int nc)
+    {
+        const int n = static_cast<int>(h.A->m);
+        std::vector<int> natural(n);
+        for (int i = 0; i < n; ++i) {
+            natural[systemRow(h, nc, i)] = i;
+        }
+
+        DenseMatrix A(n, std::vector<double>(n, 0.0));
+        for (int r = 0; r < n; ++r) {
+            for (std::size_t k = h.A->ia[r]; k < h.A->ia[r + 1]; ++k) {
+                A[natural[r]][natural[h.A->ja[k]]] += h.A->sa[k];
+            }
+        }
+        return A;
+    }
+
+    void denseSolve(const struct CSRMatrix& csr, const double* rhs, double* x)
+    {
+        const int n = static_cast<int>(csr.m);
+        DenseMatrix M(n, std::vector<double>(n, 0.0));
+        std::vector<double> r(rhs, rhs + n);
+        for (int i = 0; i < n; ++i) {
+            for (std::size_t k = csr.ia[i]; k < csr.ia[i + 1]; ++k) {
+                M[i][csr.ja[k]] = csr.sa[k];
+            }
+        }
+        for (int k = 0; k < n; ++k) {
+            for (int i = k + 1; i < n; ++i) {
+                const double m = M[i][k] / M[k][k];
+                for (int j = k; j < n; ++j) {
+                    M[i][j] -= m * M[k][j];
+                }
+                r[i] -= m * r[k];
+            }
+        }
+        for (int i = n - 1; i >= 0; --i) {
+            double sum = r[i];
+            for (int j = i + 1; j < n; ++j) {
+                sum -= M[i][j] * x[j];
+            }
+            x[i] = sum / M[i][i];
+        }
+    }
+
+    void checkAgainstReference(const UnstructuredGrid& g, const Wells& w,
+                               const TpfaSetup& s, const bool comprock,
+                               const tpfa_cell_ordering ordering)
+    {
+        const int nc = g.number_of_cells;
+        const int nw = w.number_of_wells;
+
+        DenseMatrix Aref;
+        std::vector<double> bref, fgrav;
+        referenceAssemble(g, w, s, comprock, Aref, bref, fgrav);
+
+        std::shared_ptr<ifs_tpfa_data>
+            h(ifs_tpfa_construct_ordered(const_cast<UnstructuredGrid*>(&g),
+                                         const_cast<Wells*>(&w), ordering),
+              ifs_tpfa_destroy);
+        BOOST_REQUIRE(h);
+        BOOST_REQUIRE_EQUAL(std::size_t(nc + nw), h->A->m);
+
+        ifs_tpfa_forces F = { &s.src[0], 0, &w, &s.totmob[0], &s.wdp[0] };
+        const int ok = comprock
+            ? ifs_tpfa_assemble_comprock(const_cast<UnstructuredGrid*>(&g), &F,
+                                         &s.trans[0], &s.gpress[0],
+                                         &s.porevol[0], &s.rock_comp[0],
+                                         s.dt, &s.pressure[0], h.get())
+            : ifs_tpfa_assemble(const_cast<UnstructuredGrid*>(&g), &F,
+                                &s.trans[0], &s.gpress[0], h.get());
+        BOOST_REQUIRE(ok);
+
+        // Each unknown occupies exactly one row.
+        std::vector<int> seen(nc + nw, 0);
+        for (int i = 0; i < nc + nw; ++i) {
+            ++seen[systemRow(*h, nc, i)];
+        }
+        for (int i = 0; i < nc + nw; ++i) {
+            BOOST_CHECK_EQUAL(1, seen[i]);
+        }
+
+        const DenseMatrix A = naturalMatrix(*h, nc);
+        for (int i = 0; i < nc + nw; ++i) {
+            for (int j = 0; j < nc + nw; ++j) {
+                BOOST_CHECK_SMALL(A[i][j] - Aref[i][j], 1e-12);
+            }
+            BOOST_CHECK_SMALL(h->b[systemRow(*h, nc, i)] - bref[i], 1e-12);
+        }
+
+        std::vector<double> press(nc), flux(g.number_of_faces);
+        std::vector<double> wpress(nw), wflux(w.well_connpos[nw]);
+        denseSolve(*h->A, h->b, h->x);
+        ifs_tpfa_solution soln = { &press[0], &flux[0], &wpress[0], &wflux[0] };
+        ifs_tpfa_press_flux(const_cast<UnstructuredGrid*>(&g), &F,
+                            &s.trans[0], h.get(), &soln);
+
+        for (int c = 0; c < nc; ++c) {
+            BOOST_CHECK_EQUAL(h->x[h->cell_row[c]], press[c]);
+        }
+        for (int f = 0; f < g.number_of_faces; ++f) {
+            const int c1 = g.face_cells[2*f + 0];
+            const int c2 = g.face_cells[2*f + 1];
+            const double expected = ((c1 >= 0) && (c2 >= 0))
+                ? s.trans[f] * (press[c1] - press[c2] + fgrav[f])
+                : 0.0;
+            BOOST_CHECK_SMALL(flux[f] - expected, 1e-12);
+        }
+        for (int wix = 0; wix < nw; ++wix) {
+            BOOST_CHECK_EQUAL(h->x[nc + wix], wpress[wix]);
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(NaturalOrderMatchesPerCellAssembly)
+{
+    const GridManager gm(4, 3, 2);
+    const UnstructuredGrid& g = *gm.c_grid();
+    const std::shared_ptr<Wells> w = makeWells(g);
+    const TpfaSetup s = makeSetup(g, *w);
+
+    checkAgainstReference(g, *w, s, false, TPFA_NATURAL_ORDER);
+    checkAgainstReference(g, *w, s, true , TPFA_NATURAL_ORDER);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(RcmOrderMatchesPerCellAssembly)
+{
+    const GridManager gm(4, 3, 2);
+    const UnstructuredGrid& g = *gm.c_grid();
+    const std::shared_ptr<Wells> w = makeWells(g);
+    const TpfaSetup s = makeSetup(g, *w);
+
+    checkAgainstReference(g, *w, s, false, TPFA_RCM_ORDER);
+    checkAgainstReference(g, *w, s, true , TPFA_RCM_ORDER);
+
+    // The reordering must actually move rows on this grid.
+    std::shared_ptr<ifs_tpfa_data>
+        h(ifs_tpfa_construct_ordered(const_cast<UnstructuredGrid*>(&g),
+                                     w.get(), TPFA_RCM_ORDER),
+          ifs_tpfa_destroy);
+    BOOST_REQUIRE(h);
+    int moved = 0;
+    for (int c = 0; c < g.number_of_cells; ++c) {
+        moved += (h->cell_row[c] != c);
+    }
+    BOOST_CHECK(moved > 0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(OrderingsGiveSamePressures)
+{
+    const GridManager gm(5, 4, 3);
+    const UnstructuredGrid& g = *gm.c_grid();
+    const std::shared_ptr<Wells> w = makeWells(g);
+    const TpfaSetup s = makeSetup(g, *w);
+    const int nc = g.number_of_cells;
+    const int nw = w->number_of_wells;
+
+    std::vector<double> press[2], flux[2], wpress[2], wflux[2];
+    const tpfa_cell_ordering ordering[] = { TPFA_NATURAL_ORDER, TPFA_RCM_ORDER };
+    for (int k = 0; k < 2; ++k) {
+        std::shared_ptr<ifs_tpfa_data>
+            h(ifs_tpfa_construct_ordered(const_cast<UnstructuredGrid*>(&g),
+                                         w.get(), ordering[k]),
+              ifs_tpfa_destroy);
+        BOOST_REQUIRE(h);
+
+        ifs_tpfa_forces F = { &s.src[0], 0, w.get(), &s.totmob[0], &s.wdp[0] };
+        BOOST_REQUIRE(ifs_tpfa_assemble_comprock(const_cast<UnstructuredGrid*>(&g), &F,
+                                                 &s.trans[0], &s.gpress[0],
+                                                 &s.porevol[0], &s.rock_comp[0],
+                                                 s.dt, &s.pressure[0], h.get()));
+        denseSolve(*h->A, h->b, h->x);
+
+        press[k].resize(nc);
+        flux[k].resize(g.number_of_faces);
+        wpress[k].resize(nw);
+        wflux[k].resize(w->well_connpos[nw]);
+        ifs_tpfa_solution soln = { &press[k][0], &flux[k][0],
+                                   &wpress[k][0], &wflux[k][0] };
+        ifs_tpfa_press_flux(const_cast<UnstructuredGrid*>(&g), &F,
+                            &s.trans[0], h.get(), &soln);
+    }
+
+    for (int c = 0; c < nc; ++c) {
+        BOOST_CHECK_CLOSE(press[0][c], press[1][c], 1e-10);
+    }
+    for (int f = 0; f < g.number_of_faces; ++f) {
+        BOOST_CHECK_SMALL(flux[0][f] - flux[1][f], 1e-10);
+    }
+    for (int wix = 0; wix < nw; ++wix) {
+        BOOST_CHECK_CLOSE(wpress[0][wix], wpress[1][wix], 1e-10);
+    }
+    for (std::size_t i = 0; i < wflux[0].size(); ++i) {
+        BOOST_CHECK_SMALL(wflux[0][i] - wflux[1][i], 1e-10);
+    }
+}
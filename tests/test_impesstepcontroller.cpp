@@ -0,0 +1,168 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE ImpesStepControllerTest
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/simulator/ImpesStepController.hpp>
+#include <opm/core/simulator/BlackoilState.hpp>
+#include <opm/core/simulator/WellState.hpp>
+#include <opm/core/simulator/initState.hpp>
+#include <opm/core/pressure/CompressibleTpfa.hpp>
+#include <opm/core/props/BlackoilPropertiesBasic.hpp>
+#include <opm/core/linalg/LinearSolverFactory.hpp>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/grid.h>
+#include <opm/core/wells.h>
+#include <opm/core/utility/miscUtilitiesBlackoil.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/parser/eclipse/Units/Units.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    // Water injector in the first cell and producer in the last cell
+    // of a 1D grid, both controlled by bottom hole pressure.
+    std::shared_ptr<Wells> injectorProducerPair(const int nc)
+    {
+        std::shared_ptr<Wells> wells(create_wells(2, 2, 2), destroy_wells);
+        const int cells[] = { 0, nc - 1 };
+        const double WI = 1.0e-12;
+        const int sat_table_id = -1;
+        const double ifrac[] = { 1.0, 0.0 };
+        const double pfrac[] = { 0.0, 0.0 };
+        const double invalid_alq = -1e100;
+        const int invalid_vfp = -2147483647;
+        BOOST_REQUIRE(add_well(INJECTOR, 0.0, 1, ifrac, &cells[0], &WI, &sat_table_id,
+                               "INJ", true, wells.get()));
+        BOOST_REQUIRE(add_well(PRODUCER, 0.0, 1, pfrac, &cells[1], &WI, &sat_table_id,
+                               "PROD", true, wells.get()));
+        BOOST_REQUIRE(append_well_controls(BHP, 300.0*unit::barsa, invalid_alq, invalid_vfp,
+                                           NULL, 0, wells.get()));
+        BOOST_REQUIRE(append_well_controls(BHP, 100.0*unit::barsa, invalid_alq, invalid_vfp,
+                                           NULL, 1, wells.get()));
+        set_current_control(0, 0, wells.get());
+        set_current_control(1, 0, wells.get());
+        return wells;
+    }
+
+    void initialState(const UnstructuredGrid& grid,
+                      const BlackoilPropertiesInterface& props,
+                      BlackoilState& state)
+    {
+        const int nc = grid.number_of_cells;
+        std::fill(state.pressure().begin(), state.pressure().end(), 200.0*unit::barsa);
+        for (int c = 0; c < nc; ++c) {
+            state.saturation()[2*c + 0] = 0.2;
+            state.saturation()[2*c + 1] = 0.8;
+        }
+        initBlackoilSurfvol(grid, props, state);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SubstepLengths)
+{
+    // A step of 10 with a stable step of 3 is taken as 3 + 3 + 2 + 2.
+    BOOST_CHECK_EQUAL(ImpesStepController::substepLength(10.0, 3.0), 3.0);
+    BOOST_CHECK_EQUAL(ImpesStepController::substepLength(7.0, 3.0), 3.0);
+    BOOST_CHECK_EQUAL(ImpesStepController::substepLength(4.0, 3.0), 2.0);
+    BOOST_CHECK_EQUAL(ImpesStepController::substepLength(2.0, 3.0), 2.0);
+    // Whole stable steps while at least two remain.
+    BOOST_CHECK_EQUAL(ImpesStepController::substepLength(6.0, 3.0), 3.0);
+    // Less than two stable steps left: split evenly.
+    BOOST_CHECK_EQUAL(ImpesStepController::substepLength(5.9, 3.0), 2.95);
+    // The remainder fits in one step.
+    BOOST_CHECK_EQUAL(ImpesStepController::substepLength(3.0, 3.0), 3.0);
+    BOOST_CHECK_EQUAL(ImpesStepController::substepLength(1.0, HUGE_VAL), 1.0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SubstepsUseUpdatedSaturations)
+{
+    const int nc = 10;
+    GridManager gm(nc, 1, 1, 10.0, 10.0, 10.0);
+    const UnstructuredGrid& grid = *gm.c_grid();
+
+    ParameterGroup param;
+    param.insertParameter("num_phases", "2");
+    param.insertParameter("relperm_func", "Quadratic");
+    param.insertParameter("porosity", "0.2");
+    BlackoilPropertiesBasic props(param, grid.dimensions, nc);
+    LinearSolverFactory linsolver(param);
+    std::shared_ptr<Wells> wells = injectorProducerPair(nc);
+
+    CompressibleTpfa psolver(grid, props, NULL, linsolver, 1e-8, 1e-8, 10, NULL, wells.get());
+    const double cfl = 0.9;
+    ImpesStepController controller(psolver, props, cfl, 4, 1000, 2.0);
+
+    const double dt = 10.0*unit::day;
+
+    BlackoilState state(nc, grid.number_of_faces, 2);
+    initialState(grid, props, state);
+    WellState well_state;
+    well_state.init(wells.get(), state);
+    controller.step(dt, state, well_state);
+    BOOST_REQUIRE(controller.numSubsteps() >= 2);
+
+    const std::vector<double>& sizes = controller.substepSizes();
+    BOOST_REQUIRE_EQUAL(int(sizes.size()), controller.numSubsteps());
+
+    // Same pressure step followed by the recorded transport substeps,
+    // each taken from the saturations of the previous one and chosen
+    // from the stable step at those saturations.
+    BlackoilState ref_state(nc, grid.number_of_faces, 2);
+    initialState(grid, props, ref_state);
+    WellState ref_well_state;
+    ref_well_state.init(wells.get(), ref_state);
+    psolver.solve(dt, ref_state, ref_well_state);
+    double t = 0.0;
+    for (const double sub_dt : sizes) {
+        const double stable_dt = cfl * psolver.stableTransportStep(ref_state, ref_well_state);
+        BOOST_CHECK_EQUAL(sub_dt, ImpesStepController::substepLength(dt - t, stable_dt));
+        psolver.explicitTransport(sub_dt, ref_state);
+        computeSaturation(props, ref_state);
+        t += sub_dt;
+    }
+    BOOST_CHECK_CLOSE(t, dt, 1e-10);
+
+    for (int i = 0; i < 2*nc; ++i) {
+        BOOST_CHECK_CLOSE(state.surfacevol()[i], ref_state.surfacevol()[i], 1e-10);
+        BOOST_CHECK_CLOSE(state.saturation()[i], ref_state.saturation()[i], 1e-10);
+    }
+    // The water front has moved away from the injector.
+    BOOST_CHECK_GT(state.saturation()[2*1 + 0], 0.2);
+}
@@ -0,0 +1,247 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define NVERBOSE  // Suppress own messages when throw()ing
+
+#define BOOST_TEST_MODULE MimeticTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/core/pressure/mimetic/mimetic.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace
+{
+    /// Cell geometry of perturbed boxes, one face per connection.
+    /// Every seventh cell lacks its last face and every eleventh cell
+    /// is flattened so that its face centroids are coplanar.
+    struct CellGeometry
+    {
+        explicit CellGeometry(const int ncells)
+            : nc(ncells), d(3), max_nconn(6)
+        {
+            pconn.push_back(0);
+            for (int c = 0; c < nc; ++c) {
+                pconn.push_back(pconn.back() + ((c % 7 == 3) ? 5 : 6));
+            }
+            const int nf = pconn.back();
+
+            conn.resize(nf);
+            fneighbour.resize(2*nf);
+            fcentroid.resize(d*nf);
+            fnormal.resize(d*nf);
+            farea.resize(nf);
+            ccentroid.resize(d*nc);
+            cvol.resize(nc);
+            perm.assign(d*d*nc, 0.0);
+
+            for (int c = 0; c < nc; ++c) {
+                const bool flat = (c % 11 == 5);
+                const double h[] = { 1.0 + 0.3*std::sin(1.0*c),
+                                     2.0 + 0.3*std::cos(2.0*c),
+                                     0.5 + 0.1*std::sin(3.0*c) };
+                for (int k = 0; k < d; ++k) {
+                    ccentroid[d*c + k] = 10.0*std::sin(0.7*c + k);
+                }
+                cvol[c] = h[0]*h[1]*h[2];
+
+                double* K = &perm[d*d*c];
+                K[0] = 1.0 + 0.5*std::sin(double(c));
+                K[4] = 2.0 + 0.5*std::cos(double(c));
+                K[8] = 0.1;
+                K[1] = K[3] = 0.1*std::sin(5.0*c);
+                K[2] = K[6] = 0.02*std::cos(7.0*c);
+
+                for (int i = 0; i < pconn[c + 1] - pconn[c]; ++i) {
+                    const int f = pconn[c] + i;
+                    const int ax = (i / 2) % 3;
+                    const double sgn = (i % 2) ? 1.0 : -1.0;
+                    const double area = cvol[c] / h[ax];
+                    const double eps = 0.02*std::sin(13.0*f);
+
+                    conn[f] = f;
+                    fneighbour[2*f + 0] = (i % 2) ? c : -1;
+                    fneighbour[2*f + 1] = (i % 2) ? -1 : c;
+                    farea[f] = area*(1.0 + 0.05*std::cos(11.0*f));
+
+                    for (int k = 0; k < d; ++k) {
+                        const double offset = (k == ax) ? sgn*h[ax]/2 : 0.0;
+                        fcentroid[d*f + k] = (flat && (k == 2))
+                            ? ccentroid[d*c + k]
+                            : ccentroid[d*c + k] + offset + eps;
+                        fnormal[d*f + k] = (k == ax) ? sgn*area : 1.5*eps;
+                    }
+
+                    // Normals point out of the face's first neighbour.
+                    if (fneighbour[2*f + 0] != c) {
+                        for (int k = 0; k < d; ++k) {
+                            fnormal[d*f + k] = -fnormal[d*f + k];
+                        }
+                    }
+                }
+            }
+        }
+
+        int nc, d, max_nconn;
+        std::vector<int>    pconn, conn, fneighbour;
+        std::vector<double> fcentroid, fnormal, farea, ccentroid, cvol, perm;
+    };
+
+    // mim_ip_simple() applied to one cell at a time, with its inputs
+    // gathered the same way as in mim_ip_simple_all().
+    std::vector<double> perCellInnerProducts(const CellGeometry& g)
+    {
+        const int d = g.d;
+        const int lwork = 64 * g.max_nconn * d;
+        std::vector<double> work(lwork);
+
+        std::vector<double> Binv;
+        for (int c = 0; c < g.nc; ++c) {
+            const int nconn = g.pconn[c + 1] - g.pconn[c];
+            std::vector<double> C(nconn*d), N(nconn*d), A(nconn);
+            std::vector<double> K(&g.perm[d*d*c], &g.perm[d*d*(c + 1)]);
+            std::vector<double> B(nconn*nconn);
+
+            for (int i = 0; i < nconn; ++i) {
+                const int f = g.conn[g.pconn[c] + i];
+                const double s = (g.fneighbour[2*f] == c) ? 1.0 : -1.0;
+                A[i] = g.farea[f];
+                for (int j = 0; j < d; ++j) {
+                    C[i + j*nconn] = g.fcentroid[j + f*d] - g.ccentroid[j + c*d];
+                    N[i + j*nconn] = s * g.fnormal[j + f*d];
+                }
+            }
+
+            mim_ip_simple(nconn, nconn, d, g.cvol[c], &K[0], &C[0],
+                          &A[0], &N[0], &B[0], &work[0], lwork);
+            Binv.insert(Binv.end(), B.begin(), B.end());
+        }
+        return Binv;
+    }
+
+    std::vector<double> allInnerProducts(CellGeometry g)
+    {
+        std::size_t sz = 0;
+        for (int c = 0; c < g.nc; ++c) {
+            const std::size_t n = g.pconn[c + 1] - g.pconn[c];
+            sz += n * n;
+        }
+
+        std::vector<double> Binv(sz);
+        mim_ip_simple_all(g.nc, g.d, g.max_nconn, &g.pconn[0], &g.conn[0],
+                          &g.fneighbour[0], &g.fcentroid[0], &g.fnormal[0],
+                          &g.farea[0], &g.ccentroid[0], &g.cvol[0],
+                          &g.perm[0], &Binv[0]);
+        return Binv;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(AllCellsMatchPerCellInnerProducts)
+{
+    const CellGeometry g(200);
+    const std::vector<double> ref = perCellInnerProducts(g);
+    const std::vector<double> all = allInnerProducts(g);
+
+    BOOST_REQUIRE_EQUAL(ref.size(), all.size());
+
+    double scale = 0.0;
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        scale = std::max(scale, std::fabs(ref[i]));
+    }
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        BOOST_CHECK_SMALL(all[i] - ref[i], 1.0e-10 * scale);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(BlockUpdatesMatchPerCellScaling)
+{
+    const CellGeometry g(50);
+    const int nc = g.nc;
+    const std::vector<double> Binv0 = allInnerProducts(g);
+
+    std::vector<std::size_t> bpos(nc + 1);
+    mim_ip_block_offsets(nc, &g.pconn[0], &bpos[0]);
+
+    std::vector<double> totmob(nc);
+    for (int c = 0; c < nc; ++c) {
+        totmob[c] = 0.5 + 0.01*c;
+    }
+
+    std::vector<double> Binv(Binv0.size()), Binv_offsets(Binv0.size());
+    mim_ip_mobility_update(nc, &g.pconn[0], &totmob[0], &Binv0[0], &Binv[0]);
+    mim_ip_mobility_update_offsets(nc, &bpos[0], &totmob[0],
+                                   &Binv0[0], &Binv_offsets[0]);
+
+    std::size_t p = 0;
+    for (int c = 0; c < nc; ++c) {
+        const std::size_t n = g.pconn[c + 1] - g.pconn[c];
+        BOOST_CHECK_EQUAL(p, bpos[c]);
+        for (std::size_t i = 0; i < n*n; ++i, ++p) {
+            BOOST_CHECK_CLOSE(Binv[p], totmob[c] * Binv0[p], 1.0e-12);
+            BOOST_CHECK_EQUAL(Binv[p], Binv_offsets[p]);
+        }
+    }
+    BOOST_CHECK_EQUAL(p, bpos[nc]);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(GravityMatchesPerFaceFormula)
+{
+    const CellGeometry g(50);
+    const int nc = g.nc;
+    const int d = g.d;
+    const double grav[] = { 0.1, -0.2, 9.81 };
+
+    std::vector<double> gpress0(g.pconn[nc]), gpress(g.pconn[nc]);
+    mim_ip_compute_gpress(nc, d, grav, &g.pconn[0], &g.conn[0],
+                          &g.fcentroid[0], &g.ccentroid[0], &gpress0[0]);
+
+    std::vector<double> omega(nc);
+    for (int c = 0; c < nc; ++c) {
+        omega[c] = 800.0 + c;
+    }
+    mim_ip_density_update(nc, &g.pconn[0], &omega[0], &gpress0[0], &gpress[0]);
+
+    for (int c = 0; c < nc; ++c) {
+        for (int i = g.pconn[c]; i < g.pconn[c + 1]; ++i) {
+            const int f = g.conn[i];
+            double expected = 0.0;
+            for (int j = 0; j < d; ++j) {
+                expected += grav[j]
+                    * (g.fcentroid[j + f*d] - g.ccentroid[j + c*d]);
+            }
+            BOOST_CHECK_CLOSE(gpress0[i], expected, 1.0e-12);
+            BOOST_CHECK_CLOSE(gpress[i], omega[c]*expected, 1.0e-12);
+        }
+    }
+}
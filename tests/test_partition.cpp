@@ -0,0 +1,280 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define NVERBOSE  // Suppress own messages when throw()ing
+
+#define BOOST_TEST_MODULE PartitionTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/core/pressure/msmfem/partition.h>
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    /// Cell neighbourships of an nx-by-ny-by-nz Cartesian grid, with
+    /// one connection weight per neighbourship.  The final entry is a
+    /// boundary connection.
+    struct CartesianGraph
+    {
+        CartesianGraph(const int nx, const int ny, const int nz)
+            : nc(nx*ny*nz)
+        {
+            for (int k = 0; k < nz; ++k) {
+                for (int j = 0; j < ny; ++j) {
+                    for (int i = 0; i < nx; ++i) {
+                        const int c = i + nx*(j + ny*k);
+                        if (i + 1 < nx) { add(c, c + 1    , 1.0 + 0.5*std::sin(double(c))); }
+                        if (j + 1 < ny) { add(c, c + nx   , 1.0 + 0.5*std::cos(double(c))); }
+                        if (k + 1 < nz) { add(c, c + nx*ny, (k % 2 == 0) ? 1.0e-6 : 0.1); }
+                    }
+                }
+            }
+            add(-1, 0, 1.0);
+        }
+
+        void add(const int c1, const int c2, const double weight)
+        {
+            neigh.push_back(c1);
+            neigh.push_back(c2);
+            w.push_back(weight);
+        }
+
+        int nneigh() const { return static_cast<int>(w.size()); }
+
+        int                 nc;
+        std::vector<int>    neigh;
+        std::vector<double> w;
+    };
+
+    // Split disconnected blocks one block and one cell at a time.
+    // Components are numbered by their smallest cell, the first keeps
+    // the block number and the others get new numbers in block order.
+    int referenceSplit(const CartesianGraph& g, std::vector<int>& p)
+    {
+        const int maxblk = *std::max_element(p.begin(), p.end());
+        std::vector< std::vector<int> > adj(g.nc);
+        for (int i = 0; i < g.nneigh(); ++i) {
+            const int c1 = g.neigh[2*i + 0];
+            const int c2 = g.neigh[2*i + 1];
+            if ((c1 >= 0) && (c2 >= 0) && (p[c1] == p[c2])) {
+                adj[c1].push_back(c2);
+                adj[c2].push_back(c1);
+            }
+        }
+
+        const std::vector<int> p0 = p;
+        int nnew = 0;
+        for (int b = 0; b <= maxblk; ++b) {
+            std::vector<int> colour(g.nc, -1);
+            int ncolour = 0;
+            for (int seed = 0; seed < g.nc; ++seed) {
+                if ((p0[seed] != b) || (colour[seed] >= 0)) {
+                    continue;
+                }
+                std::vector<int> stack(1, seed);
+                colour[seed] = ncolour;
+                while (!stack.empty()) {
+                    const int c = stack.back();
+                    stack.pop_back();
+                    for (const int n : adj[c]) {
+                        if (colour[n] < 0) {
+                            colour[n] = ncolour;
+                            stack.push_back(n);
+                        }
+                    }
+                }
+                ++ncolour;
+            }
+            for (int c = 0; c < g.nc; ++c) {
+                if ((p0[c] == b) && (colour[c] > 0)) {
+                    p[c] = maxblk + nnew + colour[c];
+                }
+            }
+            nnew += std::max(ncolour - 1, 0);
+        }
+        return nnew;
+    }
+
+    // Scattered initial partition with many disconnected blocks.
+    std::vector<int> scatteredPartition(const int nc, const int nblk)
+    {
+        std::vector<int> p(nc);
+        for (int c = 0; c < nc; ++c) {
+            p[c] = (c * 37 + c / 5) % nblk;
+        }
+        return p;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SplitMatchesPerBlockLabelling)
+{
+    const CartesianGraph g(12, 10, 4);
+    std::vector<int> p = scatteredPartition(g.nc, 23);
+    std::vector<int> ref = p;
+
+    const int nnew_ref = referenceSplit(g, ref);
+    const int nnew = partition_split_disconnected(g.nc, g.nneigh(), &g.neigh[0], &p[0]);
+
+    BOOST_CHECK(nnew_ref > 0);
+    BOOST_CHECK_EQUAL(nnew_ref, nnew);
+    BOOST_CHECK(p == ref);
+
+    // Splitting again leaves the partition unchanged.
+    BOOST_CHECK_EQUAL(0, partition_split_disconnected(g.nc, g.nneigh(), &g.neigh[0], &p[0]));
+    BOOST_CHECK(p == ref);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SplitBlockContainingFirstCell)
+{
+    // Block 0 holds cells 0 and 2 of a chain 0-1-2-3, block 1 holds
+    // cells 1 and 3.  Both are disconnected.
+    const CartesianGraph g(4, 1, 1);
+    std::vector<int> p = { 0, 1, 0, 1 };
+    BOOST_CHECK_EQUAL(2, partition_split_disconnected(g.nc, g.nneigh(), &g.neigh[0], &p[0]));
+
+    const std::vector<int> expected = { 0, 1, 2, 3 };
+    BOOST_CHECK(p == expected);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(QualityMatchesBruteForce)
+{
+    const CartesianGraph g(12, 10, 4);
+    std::vector<int> p = scatteredPartition(g.nc, 23);
+    p[5] = 30;                  // Leave blocks 23 to 29 empty
+
+    partition_quality q;
+    BOOST_REQUIRE(partition_quality_compute(g.nc, &p[0], g.nneigh(), &g.neigh[0], &g.w[0], &q));
+
+    std::vector<int> cnt(31, 0);
+    for (int c = 0; c < g.nc; ++c) {
+        ++cnt[p[c]];
+    }
+    std::vector<int> sizes;
+    for (const int n : cnt) {
+        if (n > 0) {
+            sizes.push_back(n);
+        }
+    }
+    const double mean = double(g.nc) / sizes.size();
+    double ssq = 0.0;
+    for (const int n : sizes) {
+        ssq += (n - mean)*(n - mean);
+    }
+
+    int ncut = 0;
+    double wtot = 0.0, wcut = 0.0;
+    std::set< std::pair<int,int> > coarse_faces;
+    for (int i = 0; i < g.nneigh(); ++i) {
+        const int c1 = g.neigh[2*i + 0];
+        const int c2 = g.neigh[2*i + 1];
+        if ((c1 < 0) || (c2 < 0)) {
+            continue;
+        }
+        wtot += g.w[i];
+        if (p[c1] != p[c2]) {
+            ++ncut;
+            wcut += g.w[i];
+            coarse_faces.insert(std::make_pair(std::min(p[c1], p[c2]),
+                                               std::max(p[c1], p[c2])));
+        }
+    }
+
+    BOOST_CHECK_EQUAL(int(sizes.size()), q.nblocks);
+    BOOST_CHECK_EQUAL(*std::min_element(sizes.begin(), sizes.end()), q.min_cells);
+    BOOST_CHECK_EQUAL(*std::max_element(sizes.begin(), sizes.end()), q.max_cells);
+    BOOST_CHECK_CLOSE(mean, q.mean_cells, 1.0e-12);
+    BOOST_CHECK_CLOSE(std::sqrt(ssq / sizes.size()), q.stddev_cells, 1.0e-10);
+    BOOST_CHECK_EQUAL(ncut, q.ncut);
+    BOOST_CHECK_EQUAL(int(coarse_faces.size()), q.ncoarse_faces);
+    BOOST_CHECK_CLOSE(wcut / wtot, q.cut_weight, 1.0e-10);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(AgglomerateMergesStrongestConnections)
+{
+    // Chain 0-1-...-7 with strong connections (0,1), (2,3), (4,5) and
+    // (6,7).  Blocks of at most two cells pair up across those.
+    CartesianGraph g(8, 1, 1);
+    for (int i = 0; i < 7; ++i) {
+        g.w[i] = (i % 2 == 0) ? 10.0 : 0.1;
+    }
+
+    std::vector<int> p(g.nc, -1);
+    const int nblk = partition_agglomerate(g.nc, g.nneigh(), &g.neigh[0], &g.w[0], 1, 2, &p[0]);
+    BOOST_CHECK_EQUAL(4, nblk);
+    for (int c = 0; c < g.nc; c += 2) {
+        BOOST_CHECK_EQUAL(p[c], p[c + 1]);
+        if (c > 0) {
+            BOOST_CHECK(p[c] != p[c - 1]);
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(AgglomerateGivesConnectedBoundedBlocks)
+{
+    const CartesianGraph g(12, 10, 4);
+    const int min_size = 4;
+    const int max_size = 16;
+
+    std::vector<int> p(g.nc, -1);
+    const int nblk = partition_agglomerate(g.nc, g.nneigh(), &g.neigh[0], &g.w[0],
+                                           min_size, max_size, &p[0]);
+    BOOST_REQUIRE(nblk > 0);
+    BOOST_CHECK_EQUAL(nblk - 1, *std::max_element(p.begin(), p.end()));
+    BOOST_CHECK_EQUAL(0, *std::min_element(p.begin(), p.end()));
+
+    partition_quality q;
+    BOOST_REQUIRE(partition_quality_compute(g.nc, &p[0], g.nneigh(), &g.neigh[0], &g.w[0], &q));
+    BOOST_CHECK_EQUAL(nblk, q.nblocks);
+    BOOST_CHECK(q.max_cells <= max_size + min_size);
+
+    // The weak vertical connections are cut first.
+    BOOST_CHECK(q.cut_weight < 0.5);
+
+    // Blocks are connected.
+    std::vector<int> split = p;
+    BOOST_CHECK_EQUAL(0, partition_split_disconnected(g.nc, g.nneigh(), &g.neigh[0], &split[0]));
+    BOOST_CHECK(split == p);
+
+    // Without a minimum block size no block exceeds the maximum size.
+    BOOST_REQUIRE(partition_agglomerate(g.nc, g.nneigh(), &g.neigh[0], &g.w[0],
+                                        1, max_size, &p[0]) > 0);
+    BOOST_REQUIRE(partition_quality_compute(g.nc, &p[0], g.nneigh(), &g.neigh[0], &g.w[0], &q));
+    BOOST_CHECK(q.max_cells <= max_size);
+}
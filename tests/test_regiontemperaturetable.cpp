@@ -0,0 +1,187 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define NVERBOSE  // Suppress own messages when throw()ing
+
+#define BOOST_TEST_MODULE RegionTemperatureTableTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/core/props/pvt/RegionTemperatureTable.hpp>
+#include <opm/parser/eclipse/Parser/Parser.hpp>
+#include <opm/parser/eclipse/Parser/ParseContext.hpp>
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+#include <opm/parser/eclipse/EclipseState/Tables/OilvisctTable.hpp>
+#include <opm/parser/eclipse/EclipseState/Tables/WatvisctTable.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    // Two PVT regions with viscosity tables of different lengths.
+    const std::string visctDeck =
+        "RUNSPEC\n"
+        "OIL\n"
+        "WATER\n"
+        "DIMENS\n2 1 1 /\n"
+        "TABDIMS\n1 2 /\n"
+        "START\n1 'JAN' 2017 /\n"
+        "GRID\n"
+        "DXV\n2*1.0 /\n"
+        "DYV\n1.0 /\n"
+        "DZV\n1.0 /\n"
+        "TOPS\n2*0.0 /\n"
+        "PORO\n2*0.2 /\n"
+        "PROPS\n"
+        "OILVISCT\n"
+        "20.0 5.0\n"
+        "50.0 2.5\n"
+        "80.0 1.5 /\n"
+        "10.0 8.0\n"
+        "90.0 1.0 /\n"
+        "WATVISCT\n"
+        "20.0 1.0\n"
+        "40.0 0.7\n"
+        "60.0 0.5\n"
+        "100.0 0.3 /\n"
+        "30.0 0.9\n"
+        "70.0 0.4 /\n";
+
+    // Temperatures below, at, between and above the sampled values of
+    // each region's table.  Elements of different regions alternate.
+    template <class Table>
+    void samplePoints(const std::vector<const Table*>& tables,
+                      std::vector<int>& region,
+                      std::vector<double>& T)
+    {
+        std::vector< std::vector<double> > pts(tables.size());
+        std::size_t maxpts = 0;
+        for (std::size_t r = 0; r < tables.size(); ++r) {
+            const auto& temp = tables[r]->getColumn("Temperature");
+            const std::size_t nrow = temp.size();
+            const double span = temp[nrow - 1] - temp[0];
+
+            pts[r].push_back(temp[0] - 0.1*span);
+            for (std::size_t row = 0; row < nrow; ++row) {
+                pts[r].push_back(temp[row]);
+                if (row + 1 < nrow) {
+                    pts[r].push_back(0.7*temp[row] + 0.3*temp[row + 1]);
+                }
+            }
+            pts[r].push_back(temp[nrow - 1] + 0.1*span);
+            maxpts = std::max(maxpts, pts[r].size());
+        }
+
+        for (std::size_t k = 0; k < maxpts; ++k) {
+            for (std::size_t r = 0; r < tables.size(); ++r) {
+                if (k < pts[r].size()) {
+                    region.push_back(static_cast<int>(r));
+                    T.push_back(pts[r][k]);
+                }
+            }
+        }
+    }
+
+    // Compare with per-element evaluation of the deck tables, as the
+    // thermal PVT wrappers did before the tables were copied.
+    template <class Table>
+    void checkAgainstDeckTables(const std::vector<const Table*>& tables,
+                                const std::vector<double>& scale)
+    {
+        RegionTemperatureTable rtt;
+        for (std::size_t r = 0; r < tables.size(); ++r) {
+            rtt.addRegion(*tables[r], "Viscosity", scale[r]);
+        }
+        BOOST_REQUIRE_EQUAL(int(tables.size()), rtt.numRegions());
+
+        std::vector<int> region;
+        std::vector<double> T;
+        samplePoints(tables, region, T);
+        const int n = static_cast<int>(T.size());
+
+        std::vector<double> batch(n, -1.0);
+        rtt.forEach(n, region.data(), T.data(),
+                    [&](int i, double v) { batch[i] = v; });
+
+        std::vector<double> first(n, -1.0);
+        rtt.forEach(n, nullptr, T.data(),
+                    [&](int i, double v) { first[i] = v; });
+
+        for (int i = 0; i < n; ++i) {
+            const int r = region[i];
+            const double expected = tables[r]->evaluate("Viscosity", T[i]) * scale[r];
+            BOOST_CHECK_CLOSE(expected, rtt.evaluate(r, T[i]), 1.0e-12);
+            BOOST_CHECK_CLOSE(expected, batch[i], 1.0e-12);
+            BOOST_CHECK_CLOSE(tables[0]->evaluate("Viscosity", T[i]) * scale[0],
+                              first[i], 1.0e-12);
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(MatchesDeckTables)
+{
+    ParseContext parseContext;
+    Parser parser;
+    Deck deck = parser.parseString(visctDeck, parseContext);
+    EclipseState eclipseState(deck, parseContext);
+    const auto& tableManager = eclipseState.getTableManager();
+
+    const auto& oilvisctTables = tableManager.getOilvisctTables();
+    const auto& watvisctTables = tableManager.getWatvisctTables();
+    BOOST_REQUIRE_EQUAL(2u, oilvisctTables.size());
+    BOOST_REQUIRE_EQUAL(2u, watvisctTables.size());
+
+    std::vector<const OilvisctTable*> oil;
+    std::vector<const WatvisctTable*> wat;
+    for (int r = 0; r < 2; ++r) {
+        oil.push_back(&oilvisctTables.getTable<OilvisctTable>(r));
+        wat.push_back(&watvisctTables.getTable<WatvisctTable>(r));
+    }
+
+    // Oil and water tables are stored relative to a reference viscosity.
+    checkAgainstDeckTables(oil, { 1.0/2.0e-3, 1.0/3.0e-3 });
+    checkAgainstDeckTables(wat, { 1.0/0.5e-3, 1.0/0.8e-3 });
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SingleRegion)
+{
+    ParseContext parseContext;
+    Parser parser;
+    Deck deck = parser.parseString(visctDeck, parseContext);
+    EclipseState eclipseState(deck, parseContext);
+    const auto& watvisctTables = eclipseState.getTableManager().getWatvisctTables();
+
+    std::vector<const WatvisctTable*> wat(1, &watvisctTables.getTable<WatvisctTable>(1));
+    checkAgainstDeckTables(wat, { 1.0 });
+}
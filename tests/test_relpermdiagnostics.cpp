@@ -35,6 +35,7 @@
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 #include <opm/common/OpmLog/OpmLog.hpp>
 #include <opm/common/OpmLog/CounterLog.hpp>
+#include <opm/common/OpmLog/StreamLog.hpp>
 
 #include <opm/core/grid.h>
 #include <opm/core/grid/cart_grid.h>
@@ -45,6 +46,9 @@
 #include <opm/parser/eclipse/Parser/ParseContext.hpp>
 #include <opm/parser/eclipse/Deck/Deck.hpp>
 
+#include <sstream>
+#include <string>
+
 BOOST_AUTO_TEST_SUITE ()
 
 BOOST_AUTO_TEST_CASE(diagnosis)
@@ -63,4 +67,73 @@ BOOST_AUTO_TEST_CASE(diagnosis)
     diagnostics.diagnosis(eclState, deck, grid);
     BOOST_CHECK_EQUAL(1, counterLog->numMessages(Log::MessageType::Warning));
 }
+
+BOOST_AUTO_TEST_CASE(scaledEndPointMessages)
+{
+    // SGU > 1 - SWL in all six cells.  The first three cells have
+    // identical end points and share one message, the other three each
+    // have their own.  With at most two messages per kind of issue, the
+    // last two cells are only counted in a summary line.
+    const char* deckString =
+        "RUNSPEC\n"
+        "DIMENS\n 6 1 1 /\n"
+        "OIL\nGAS\nWATER\n"
+        "ENDSCALE\n/\n"
+        "START\n 1 'JAN' 2015 /\n"
+        "GRID\n"
+        "DX\n 6*100 /\n"
+        "DY\n 6*100 /\n"
+        "DZ\n 6*10 /\n"
+        "TOPS\n 6*1000 /\n"
+        "PORO\n 6*0.3 /\n"
+        "PERMX\n 6*100 /\n"
+        "PERMY\n 6*100 /\n"
+        "PERMZ\n 6*10 /\n"
+        "PROPS\n"
+        "SWOF\n"
+        "0.1 0.0 1.0 0.0\n"
+        "0.5 0.3 0.2 0.0\n"
+        "1.0 1.0 0.0 0.0 /\n"
+        "SGOF\n"
+        "0.0 0.0 1.0 0.0\n"
+        "0.4 0.3 0.2 0.0\n"
+        "0.9 1.0 0.0 0.0 /\n"
+        "SWL\n 3*0.2 0.25 0.3 0.35 /\n"
+        "SGU\n 6*0.9 /\n";
+
+    using namespace Opm;
+    Parser parser;
+    ParseContext parseContext;
+    Deck deck = parser.parseString(deckString, parseContext);
+    EclipseState eclState(deck, parseContext);
+    GridManager gm(eclState.getInputGrid());
+    const UnstructuredGrid& grid = *gm.c_grid();
+
+    std::ostringstream log;
+    std::shared_ptr<StreamLog> streamLog = std::make_shared<StreamLog>(log, Log::MessageType::Warning);
+    OpmLog::addBackend("SCALEDENDPOINTLOG", streamLog);
+    // The backend writes to the local stream, so it must not outlive
+    // this test case even if diagnosis() throws.
+    struct BackendGuard {
+        ~BackendGuard() { OpmLog::removeBackend("SCALEDENDPOINTLOG"); }
+    } backendGuard;
+    RelpermDiagnostics diagnostics;
+    diagnostics.setMaxMessagesPerCategory(2);
+    diagnostics.diagnosis(eclState, deck, grid);
+
+    const std::string text = log.str();
+    const std::string issue = "SGU exceed 1.0 - SWL";
+    int numIssueMessages = 0;
+    for (auto pos = text.find(issue); pos != std::string::npos; pos = text.find(issue, pos + 1)) {
+        ++numIssueMessages;
+    }
+    BOOST_CHECK_EQUAL(numIssueMessages, 3);
+    BOOST_CHECK(text.find("cell(0, 0, 0)") != std::string::npos);
+    BOOST_CHECK(text.find("also in 2 other cells with the same end points") != std::string::npos);
+    BOOST_CHECK(text.find("cell(3, 0, 0)") != std::string::npos);
+    BOOST_CHECK(text.find("cell(1, 0, 0)") == std::string::npos);
+    BOOST_CHECK(text.find("cell(4, 0, 0)") == std::string::npos);
+    BOOST_CHECK(text.find("cell(5, 0, 0)") == std::string::npos);
+    BOOST_CHECK(text.find(issue + " in 2 more cells, not reported individually") != std::string::npos);
+}
 BOOST_AUTO_TEST_SUITE_END()
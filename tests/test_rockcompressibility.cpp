@@ -0,0 +1,153 @@
+/*
+  Copyright 2017 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define NVERBOSE  // Suppress own messages when throw()ing
+
+#define BOOST_TEST_MODULE RockCompressibilityTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/core/props/rock/RockCompressibility.hpp>
+#include <opm/core/grid.h>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/utility/miscUtilities.hpp>
+#include <opm/parser/eclipse/Parser/Parser.hpp>
+#include <opm/parser/eclipse/Parser/ParseContext.hpp>
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+#include <opm/parser/eclipse/Units/Units.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    // Two ROCK regions, cells 0 and 3 in the first and cells 1 and 2
+    // in the second.
+    const std::string rocknumDeck =
+        "RUNSPEC\n"
+        "OIL\n"
+        "WATER\n"
+        "DIMENS\n4 1 1 /\n"
+        "TABDIMS\n1 2 /\n"
+        "START\n1 'JAN' 2017 /\n"
+        "GRID\n"
+        "DXV\n4*1.0 /\n"
+        "DYV\n1.0 /\n"
+        "DZV\n1.0 /\n"
+        "TOPS\n4*0.0 /\n"
+        "PORO\n4*0.2 /\n"
+        "PROPS\n"
+        "ROCK\n"
+        "100.0 1.0E-4 /\n"
+        "200.0 5.0E-4 /\n"
+        "REGIONS\n"
+        "ROCKNUM\n1 2 2 1 /\n";
+
+    // Porosity multiplier of a ROCK region.
+    double rockPoroMult(const double pref, const double comp, const double p)
+    {
+        const double cpnorm = comp*(p - pref);
+        return 1.0 + cpnorm + 0.5*cpnorm*cpnorm;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(DeckPathUsesRocknum)
+{
+    ParseContext parseContext;
+    Parser parser;
+    Deck deck = parser.parseString(rocknumDeck, parseContext);
+    EclipseState eclipseState(deck, parseContext);
+
+    const RockCompressibility rock_comp(eclipseState);
+    BOOST_CHECK(rock_comp.isActive());
+    BOOST_REQUIRE_EQUAL(2, rock_comp.numRegions());
+
+    const double pref[] = { 100.0*unit::barsa, 200.0*unit::barsa };
+    const double comp[] = { 1.0e-4/unit::barsa, 5.0e-4/unit::barsa };
+    const int region[] = { 0, 1, 1, 0 };
+    const double pressure[] = { 150.0*unit::barsa, 150.0*unit::barsa,
+                                250.0*unit::barsa, 250.0*unit::barsa };
+    double mult[4], dmultdp[4], rc[4];
+    rock_comp.poroMult(4, pressure, 0, mult, dmultdp);
+    rock_comp.rockComp(4, pressure, 0, rc);
+    for (int c = 0; c < 4; ++c) {
+        const int r = region[c];
+        const double cpnorm = comp[r]*(pressure[c] - pref[r]);
+        BOOST_CHECK_CLOSE(mult[c], rockPoroMult(pref[r], comp[r], pressure[c]), 1e-12);
+        BOOST_CHECK_CLOSE(dmultdp[c], comp[r] + cpnorm*comp[r], 1e-12);
+        BOOST_CHECK_CLOSE(rc[c], comp[r], 1e-12);
+    }
+
+    // The scalar accessors evaluate the first region.
+    BOOST_CHECK_CLOSE(rock_comp.poroMult(pressure[1]), mult[0], 1e-12);
+
+    // Explicit cells: cell 0 is deck cell 3 and cell 1 is deck cell 1.
+    const int global_cell[] = { 3, 1 };
+    const RockCompressibility subset(eclipseState, 2, global_cell);
+    const int cells[] = { 1, 0, 1 };
+    const double p[] = { 250.0*unit::barsa, 250.0*unit::barsa, 150.0*unit::barsa };
+    double subset_mult[3];
+    subset.poroMult(3, p, cells, subset_mult, 0);
+    BOOST_CHECK_CLOSE(subset_mult[0], rockPoroMult(pref[1], comp[1], p[0]), 1e-12);
+    BOOST_CHECK_CLOSE(subset_mult[1], rockPoroMult(pref[0], comp[0], p[1]), 1e-12);
+    BOOST_CHECK_CLOSE(subset_mult[2], rockPoroMult(pref[1], comp[1], p[2]), 1e-12);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(PorevolumeByRegion)
+{
+    ParseContext parseContext;
+    Parser parser;
+    Deck deck = parser.parseString(rocknumDeck, parseContext);
+    EclipseState eclipseState(deck, parseContext);
+    GridManager gm(eclipseState.getInputGrid());
+    const UnstructuredGrid& grid = *gm.c_grid();
+    BOOST_REQUIRE_EQUAL(4, grid.number_of_cells);
+
+    const RockCompressibility rock_comp(eclipseState);
+    const std::vector<double> porosity = { 0.1, 0.2, 0.3, 0.4 };
+    const std::vector<double> pressure = { 120.0*unit::barsa, 140.0*unit::barsa,
+                                           160.0*unit::barsa, 180.0*unit::barsa };
+    std::vector<double> porevol;
+    computePorevolume(grid, porosity.data(), rock_comp, pressure, porevol);
+    std::vector<double> poro;
+    computePorosity(grid, porosity.data(), rock_comp, pressure, poro);
+
+    const double pref[] = { 100.0*unit::barsa, 200.0*unit::barsa };
+    const double comp[] = { 1.0e-4/unit::barsa, 5.0e-4/unit::barsa };
+    const int region[] = { 0, 1, 1, 0 };
+    BOOST_REQUIRE_EQUAL(4u, porevol.size());
+    for (int c = 0; c < 4; ++c) {
+        const int r = region[c];
+        const double mult = rockPoroMult(pref[r], comp[r], pressure[c]);
+        BOOST_CHECK_CLOSE(porevol[c], porosity[c]*grid.cell_volumes[c]*mult, 1e-12);
+        BOOST_CHECK_CLOSE(poro[c], porosity[c]*mult, 1e-12);
+    }
+}
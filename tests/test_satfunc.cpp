@@ -26,6 +26,8 @@
 #include <opm/core/props/BlackoilPropertiesBasic.hpp>
 #include <opm/core/props/BlackoilPropertiesFromDeck.hpp>
 #include <opm/core/props/BlackoilPhases.hpp>
+#include <opm/core/props/IncompPropertiesFromDeck.hpp>
+#include <opm/core/props/IncompPropertiesShadow.hpp>
 
 #include <opm/parser/eclipse/Parser/Parser.hpp>
 #include <opm/parser/eclipse/Parser/ParseContext.hpp>
@@ -33,6 +35,7 @@
 
 #include <opm/core/pressure/msmfem/partition.h>
 
+#include <opm/core/utility/miscUtilities.hpp>
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
 #include <opm/parser/eclipse/Units/Units.hpp>
 
@@ -667,4 +670,410 @@ BOOST_AUTO_TEST_CASE (GwsegEPS_D)
 */
 }
 
+BOOST_AUTO_TEST_CASE (LazyMaterialLaws)
+{
+    // Deferred construction of the material law parameters must give
+    // the same saturation functions as eager construction.
+    Opm::GridManager gm(1, 1, 10, 1.0, 1.0, 5.0);
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseFile("satfuncEPSBase.DATA", parseContext);
+    Opm::EclipseState eclipseState(deck , parseContext);
+
+    Opm::ParameterGroup param;
+    Opm::BlackoilPropertiesFromDeck eager(deck, eclipseState, grid, param, false);
+
+    Opm::ParameterGroup lazyParam;
+    lazyParam.insertParameter(std::string("lazy_material_laws"), std::string("true"));
+    Opm::BlackoilPropertiesFromDeck lazy(deck, eclipseState, grid, lazyParam, false);
+
+    BOOST_CHECK(eager.materialLawsInitialized());
+    BOOST_CHECK(!lazy.materialLawsInitialized());
+
+    // Copies share the deferred saturation functions.
+    const Opm::BlackoilPropertiesFromDeck lazyCopy(lazy);
+    BOOST_CHECK(!lazyCopy.materialLawsInitialized());
+
+    const int np = 3;
+    const int n = 11;
+    double s[n*np];
+    int cells[n];
+    double kr_eager[n*np], kr_lazy[n*np];
+    double pc_eager[n*np], pc_lazy[n*np];
+    for (int i = 0; i < n; ++i) {
+        cells[i] = i % grid.number_of_cells;
+        s[i*np + 0] = i*0.1;
+        s[i*np + 1] = 1.0 - s[i*np + 0];
+        s[i*np + 2] = 0.0;
+    }
+
+    eager.relperm(n, s, cells, kr_eager, 0);
+    lazy.relperm(n, s, cells, kr_lazy, 0);
+    BOOST_CHECK(lazy.materialLawsInitialized());
+    BOOST_CHECK(lazyCopy.materialLawsInitialized());
+
+    eager.capPress(n, s, cells, pc_eager, 0);
+    lazy.capPress(n, s, cells, pc_lazy, 0);
+    for (int i = 0; i < n*np; ++i) {
+        BOOST_CHECK_EQUAL(kr_lazy[i], kr_eager[i]);
+        BOOST_CHECK_EQUAL(pc_lazy[i], pc_eager[i]);
+    }
+
+    std::ostringstream report;
+    lazy.writeMaterialLawReport(report);
+    BOOST_CHECK(report.str().find("10 cells") != std::string::npos);
+
+    // The report must not change the format of the caller's stream.
+    std::ostringstream number;
+    lazy.writeMaterialLawReport(number);
+    number.str("");
+    number << 1.25;
+    BOOST_CHECK_EQUAL(number.str(), "1.25");
+
+    // Without a material law manager there are no saturation functions.
+    std::shared_ptr<Opm::BlackoilPropertiesFromDeck::MaterialLawManager> noManager;
+    BOOST_CHECK_THROW(Opm::BlackoilPropertiesFromDeck(deck, eclipseState, noManager,
+                                                      grid.number_of_cells, grid.global_cell,
+                                                      grid.cartdims, param, false),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE (HysteresisStateRoundTrip)
+{
+    // Exporting the hysteresis state, updating it, and importing the
+    // exported state must restore the original state.
+    Opm::GridManager gm(1, 1, 10, 1.0, 1.0, 5.0);
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseFile("satfuncEPS_D.DATA", parseContext);
+    Opm::EclipseState eclipseState(deck , parseContext);
+
+    const int nc = grid.number_of_cells;
+    std::vector<int> cells(nc);
+    std::iota(cells.begin(), cells.end(), 0);
+    auto materialLawManager = std::make_shared<Opm::SaturationPropsFromDeck::MaterialLawManager>();
+    materialLawManager->initFromDeck(deck, eclipseState, cells);
+    Opm::SaturationPropsFromDeck satprops;
+    satprops.init(deck, materialLawManager);
+    BOOST_REQUIRE(materialLawManager->enableHysteresis());
+
+    const int np = 3;
+    std::vector<double> s(nc*np);
+    for (int c = 0; c < nc; ++c) {
+        s[c*np + 0] = 0.2;
+        s[c*np + 1] = 0.7;
+        s[c*np + 2] = 0.1;
+    }
+    satprops.updateSatHyst(nc, cells.data(), s.data());
+
+    Opm::SaturationPropsFromDeck::HysteresisState before;
+    satprops.exportHysteresisState(nc, cells.data(), before);
+    BOOST_CHECK_EQUAL(int(before.pcSwMdcOilWater.size()), nc);
+
+    for (int c = 0; c < nc; ++c) {
+        s[c*np + 0] = 0.1*(c % 5);
+        s[c*np + 2] = 0.05*(c % 3);
+        s[c*np + 1] = 1.0 - s[c*np + 0] - s[c*np + 2];
+    }
+    satprops.updateSatHyst(nc, cells.data(), s.data());
+    satprops.importHysteresisState(nc, cells.data(), before);
+
+    Opm::SaturationPropsFromDeck::HysteresisState after;
+    satprops.exportHysteresisState(nc, cells.data(), after);
+    for (int c = 0; c < nc; ++c) {
+        BOOST_CHECK_EQUAL(after.pcSwMdcOilWater[c], before.pcSwMdcOilWater[c]);
+        BOOST_CHECK_EQUAL(after.krnSwMdcOilWater[c], before.krnSwMdcOilWater[c]);
+        BOOST_CHECK_EQUAL(after.pcSwMdcGasOil[c], before.pcSwMdcGasOil[c]);
+        BOOST_CHECK_EQUAL(after.krnSwMdcGasOil[c], before.krnSwMdcGasOil[c]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (BatchedSwatinitScaling)
+{
+    // Scaling all cells in one call must give the same saturations and
+    // capillary pressures as scaling cell by cell, and the scaling must
+    // be visible to other properties objects sharing the material law
+    // manager, as the simulator does after the initialization.
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseFile("capillarySwatinit.DATA", parseContext);
+    Opm::EclipseState eclipseState(deck , parseContext);
+    Opm::GridManager gm(eclipseState.getInputGrid());
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    const int nc = grid.number_of_cells;
+    const int np = 3;
+
+    std::vector<int> cells(nc);
+    std::iota(cells.begin(), cells.end(), 0);
+    typedef Opm::BlackoilPropertiesFromDeck::MaterialLawManager MaterialLawManager;
+    auto sharedManager = std::make_shared<MaterialLawManager>();
+    sharedManager->initFromDeck(deck, eclipseState, cells);
+    auto referenceManager = std::make_shared<MaterialLawManager>();
+    referenceManager->initFromDeck(deck, eclipseState, cells);
+
+    Opm::ParameterGroup param;
+    Opm::BlackoilPropertiesFromDeck initProps(deck, eclipseState, sharedManager, nc,
+                                             grid.global_cell, grid.cartdims, param, false);
+    Opm::SaturationPropsFromDeck reference;
+    reference.init(deck, referenceManager);
+
+    // Swl = 0.2 and Swu = 1 in SWOF.  Cells 0-2 are below Swl, and
+    // cells with negative pcow end up at Swu.
+    std::vector<double> pcow(nc);
+    std::vector<double> swat(nc);
+    std::vector<double> swat_ref(nc);
+    for (int c = 0; c < nc; ++c) {
+        pcow[c] = (c % 4 == 3) ? -1.0e3 : 1.0e4 * (c + 1);
+        swat[c] = 0.1 + 0.04*c;
+        swat_ref[c] = swat[c];
+    }
+    // Process the cells in reverse order to check the indexing.
+    std::vector<int> reversed(cells.rbegin(), cells.rend());
+    std::vector<double> pcow_reversed(pcow.rbegin(), pcow.rend());
+    std::vector<double> swat_reversed(swat.rbegin(), swat.rend());
+    initProps.swatInitScaling(nc, reversed.data(), pcow_reversed.data(), swat_reversed.data());
+    for (int c = 0; c < nc; ++c) {
+        reference.swatInitScaling(c, pcow[c], swat_ref[c]);
+    }
+
+    Opm::BlackoilPropertiesFromDeck simProps(deck, eclipseState, sharedManager, nc,
+                                            grid.global_cell, grid.cartdims, param, false);
+    std::vector<double> s(nc*np);
+    std::vector<double> pc(nc*np);
+    std::vector<double> pc_ref(nc*np);
+    for (int c = 0; c < nc; ++c) {
+        BOOST_CHECK_EQUAL(swat_reversed[nc - 1 - c], swat_ref[c]);
+        if (c < 3) {
+            BOOST_CHECK_CLOSE(swat_ref[c], 0.2, 1e-12);
+        } else if (pcow[c] < 0.0) {
+            BOOST_CHECK_CLOSE(swat_ref[c], 1.0, 1e-12);
+        }
+        s[np*c + 0] = swat_ref[c];
+        s[np*c + 1] = 1.0 - swat_ref[c];
+        s[np*c + 2] = 0.0;
+    }
+    simProps.capPress(nc, s.data(), cells.data(), pc.data(), 0);
+    reference.capPress(nc, s.data(), cells.data(), pc_ref.data(), 0);
+    for (int c = 0; c < nc; ++c) {
+        for (int p = 0; p < np; ++p) {
+            BOOST_CHECK_EQUAL(pc[np*c + p], pc_ref[np*c + p]);
+        }
+        // The scaled curve passes through the imposed point.
+        if (c >= 3 && pcow[c] > 0.0) {
+            BOOST_CHECK_CLOSE(pc[np*c + 0], pcow[c], 1e-6);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (RegionGroupedEvaluation)
+{
+    // Without end-point scaling, large relperm() and capPress() calls
+    // group the data points by SATNUM region and use the parameters
+    // of one cell per region.  They must agree with single data point
+    // calls, which use each cell's own parameters.
+    const int nc = 512;
+    std::ostringstream deckString;
+    deckString << "RUNSPEC\nWATER\nOIL\nGAS\n"
+               << "TABDIMS\n2 1 40 20 1 20 /\n"
+               << "DIMENS\n1 1 " << nc << " /\n"
+               << "START\n1 'JAN' 1990 /\n"
+               << "GRID\n"
+               << "DXV\n1.0 /\n"
+               << "DYV\n1.0 /\n"
+               << "DZV\n" << nc << "*1.0 /\n"
+               << "TOPS\n0.0 /\n"
+               << "PORO\n" << nc << "*0.2 /\n"
+               << "PERMX\n" << nc << "*100 /\n"
+               << "PERMY\n" << nc << "*100 /\n"
+               << "PERMZ\n" << nc << "*10 /\n"
+               << "PROPS\n"
+               << "SWOF\n"
+               << "0.1 0.0 1.0 0.9\n"
+               << "0.3 0.1 0.6 0.7\n"
+               << "0.9 0.7 0.0 0.1 /\n"
+               << "0.2 0.0 1.0 2.0\n"
+               << "0.5 0.3 0.2 0.5\n"
+               << "1.0 1.0 0.0 0.0 /\n"
+               << "SGOF\n"
+               << "0.0 0.0 1.0 0.2\n"
+               << "0.2 0.1 0.6 0.6\n"
+               << "0.9 1.0 0.0 2.1 /\n"
+               << "0.0 0.0 1.0 0.0\n"
+               << "0.4 0.3 0.2 0.3\n"
+               << "0.8 1.0 0.0 1.0 /\n"
+               << "PVDO\n1 1.0 1.0\n500 0.9 1.0 /\n"
+               << "PVDG\n1 0.1 0.01\n500 0.002 0.03 /\n"
+               << "PVTW\n1 1.0 4.0E-5 0.96 0.0 /\n"
+               << "DENSITY\n700 1000 1 /\n"
+               << "REGIONS\n"
+               << "SATNUM\n" << nc/4 << "*1 " << nc/2 << "*2 " << nc/4 << "*1 /\n";
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseString(deckString.str(), parseContext);
+    Opm::EclipseState eclipseState(deck, parseContext);
+
+    std::vector<int> cells(nc);
+    std::iota(cells.begin(), cells.end(), 0);
+    auto materialLawManager = std::make_shared<Opm::SaturationPropsFromDeck::MaterialLawManager>();
+    materialLawManager->initFromDeck(deck, eclipseState, cells);
+    BOOST_REQUIRE(!materialLawManager->enableEndPointScaling());
+    BOOST_REQUIRE(!materialLawManager->enableHysteresis());
+    Opm::SaturationPropsFromDeck satprops;
+    satprops.init(deck, materialLawManager);
+    satprops.cacheAllCellsGrouping(nc);
+
+    // All cells in order, using the cached grouping, and all cells in
+    // reverse order, grouped on the fly.
+    std::vector<int> reversed(cells.rbegin(), cells.rend());
+    const int np = 3;
+    for (const std::vector<int>* c : { &cells, &reversed }) {
+        std::vector<double> s(nc*np);
+        for (int i = 0; i < nc; ++i) {
+            s[i*np + 0] = 0.1 + 0.8*((*c)[i] % 17)/16.0;
+            s[i*np + 2] = 0.05*((*c)[i] % 5);
+            s[i*np + 1] = 1.0 - s[i*np + 0] - s[i*np + 2];
+        }
+        std::vector<double> kr(nc*np), dkrds(nc*np*np), pc(nc*np), dpcds(nc*np*np);
+        satprops.relperm(nc, s.data(), c->data(), kr.data(), dkrds.data());
+        satprops.capPress(nc, s.data(), c->data(), pc.data(), dpcds.data());
+        std::vector<double> kr_nod(nc*np), pc_nod(nc*np);
+        satprops.relperm(nc, s.data(), c->data(), kr_nod.data(), 0);
+        satprops.capPress(nc, s.data(), c->data(), pc_nod.data(), 0);
+
+        for (int i = 0; i < nc; ++i) {
+            double kr1[np], dkrds1[np*np], pc1[np], dpcds1[np*np];
+            satprops.relperm(1, &s[i*np], &(*c)[i], kr1, dkrds1);
+            satprops.capPress(1, &s[i*np], &(*c)[i], pc1, dpcds1);
+            for (int p = 0; p < np; ++p) {
+                BOOST_CHECK_EQUAL(kr[i*np + p], kr1[p]);
+                BOOST_CHECK_EQUAL(kr_nod[i*np + p], kr1[p]);
+                BOOST_CHECK_EQUAL(pc[i*np + p], pc1[p]);
+                BOOST_CHECK_EQUAL(pc_nod[i*np + p], pc1[p]);
+            }
+            for (int k = 0; k < np*np; ++k) {
+                BOOST_CHECK_EQUAL(dkrds[i*np*np + k], dkrds1[k]);
+                BOOST_CHECK_EQUAL(dpcds[i*np*np + k], dpcds1[k]);
+            }
+        }
+    }
+
+    // BlackoilPropertiesFromDeck caches the all-cells grouping of its
+    // saturation functions, and must agree with the same single data
+    // point calls.
+    Opm::GridManager gm(eclipseState.getInputGrid());
+    Opm::ParameterGroup param;
+    const Opm::BlackoilPropertiesFromDeck props(deck, eclipseState, *gm.c_grid(), param, false);
+    std::vector<double> s(nc*np);
+    for (int i = 0; i < nc; ++i) {
+        s[i*np + 0] = 0.1 + 0.8*(i % 13)/12.0;
+        s[i*np + 2] = 0.05*(i % 3);
+        s[i*np + 1] = 1.0 - s[i*np + 0] - s[i*np + 2];
+    }
+    std::vector<double> kr(nc*np);
+    props.relperm(nc, s.data(), cells.data(), kr.data(), 0);
+    for (int i = 0; i < nc; ++i) {
+        double kr1[np];
+        satprops.relperm(1, &s[i*np], &cells[i], kr1, 0);
+        for (int p = 0; p < np; ++p) {
+            BOOST_CHECK_EQUAL(kr[i*np + p], kr1[p]);
+        }
+    }
+}
+
+namespace {
+    // Records the number of data points of each relperm() call.
+    struct RelpermCallRecorder : public Opm::IncompPropertiesShadow
+    {
+        explicit RelpermCallRecorder(const Opm::IncompPropertiesInterface& original)
+            : Opm::IncompPropertiesShadow(original)
+        {
+        }
+
+        virtual void relperm(const int n,
+                             const double* s,
+                             const int* cells,
+                             double* kr,
+                             double* dkrds) const
+        {
+            callSizes.push_back(n);
+            Opm::IncompPropertiesShadow::relperm(n, s, cells, kr, dkrds);
+        }
+
+        mutable std::vector<int> callSizes;
+    };
+}
+
+BOOST_AUTO_TEST_CASE (TotalMobilityOmegaAllCells)
+{
+    // computeTotalMobilityOmega() must ask for the relative
+    // permeabilities of all cells at once, so that the region grouped
+    // evaluation and the cached all-cells grouping are used, and agree
+    // with single cell evaluation.
+    const int nc = 400;
+    std::ostringstream deckString;
+    deckString << "RUNSPEC\nWATER\nOIL\n"
+               << "TABDIMS\n2 1 40 20 1 20 /\n"
+               << "DIMENS\n20 20 1 /\n"
+               << "START\n1 'JAN' 1990 /\n"
+               << "GRID\n"
+               << "DX\n" << nc << "*10 /\n"
+               << "DY\n" << nc << "*10 /\n"
+               << "DZ\n" << nc << "*5 /\n"
+               << "TOPS\n" << nc << "*1000 /\n"
+               << "PORO\n" << nc << "*0.2 /\n"
+               << "PERMX\n" << nc << "*100 /\n"
+               << "PERMY\n" << nc << "*100 /\n"
+               << "PERMZ\n" << nc << "*10 /\n"
+               << "PROPS\n"
+               << "SWOF\n"
+               << "0.1 0.0 1.0 0.0\n"
+               << "0.3 0.1 0.6 0.0\n"
+               << "0.9 0.7 0.0 0.0 /\n"
+               << "0.2 0.0 1.0 0.0\n"
+               << "0.5 0.3 0.2 0.0\n"
+               << "1.0 1.0 0.0 0.0 /\n"
+               << "PVTW\n1 1.0 0.0 0.5 0.0 /\n"
+               << "PVCDO\n1 1.0 0.0 2.0 0.0 /\n"
+               << "DENSITY\n700 1000 1 /\n"
+               << "REGIONS\n"
+               << "SATNUM\n" << nc/2 << "*1 " << nc/2 << "*2 /\n";
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseString(deckString.str(), parseContext);
+    Opm::EclipseState eclipseState(deck, parseContext);
+    Opm::GridManager gm(eclipseState.getInputGrid());
+    const UnstructuredGrid& grid = *gm.c_grid();
+    BOOST_REQUIRE_EQUAL(grid.number_of_cells, nc);
+
+    const Opm::IncompPropertiesFromDeck props(deck, eclipseState, grid);
+    const RelpermCallRecorder recorder(props);
+    const int np = 2;
+    std::vector<int> cells(nc);
+    std::iota(cells.begin(), cells.end(), 0);
+    std::vector<double> s(nc*np);
+    for (int c = 0; c < nc; ++c) {
+        s[c*np + 0] = 0.1 + 0.8*(c % 17)/16.0;
+        s[c*np + 1] = 1.0 - s[c*np + 0];
+    }
+
+    std::vector<double> kr(nc*np), totmob(nc), omega(nc);
+    Opm::computeTotalMobilityOmega(recorder, nc, cells.data(), s.data(),
+                                   kr.data(), totmob.data(), omega.data());
+    BOOST_REQUIRE_EQUAL(recorder.callSizes.size(), 1u);
+    BOOST_CHECK_EQUAL(recorder.callSizes[0], nc);
+
+    const double* mu = props.viscosity();
+    const double* rho = props.density();
+    for (int c = 0; c < nc; ++c) {
+        double kr1[np];
+        props.relperm(1, &s[c*np], &c, kr1, 0);
+        const double lt = kr1[0]/mu[0] + kr1[1]/mu[1];
+        const double om = (kr1[0]/mu[0]*rho[0] + kr1[1]/mu[1]*rho[1]) / lt;
+        BOOST_CHECK_EQUAL(totmob[c], lt);
+        BOOST_CHECK_CLOSE(omega[c], om, 1e-12);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
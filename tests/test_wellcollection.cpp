@@ -27,6 +27,8 @@
 
 #define BOOST_TEST_MODULE WellCollectionTest
 #include <boost/test/unit_test.hpp>
+#include <opm/core/wells.h>
+#include <opm/core/well_controls.h>
 #include <opm/core/wells/WellCollection.hpp>
 #include <opm/parser/eclipse/Parser/Parser.hpp>
 #include <opm/parser/eclipse/Parser/ParseContext.hpp>
@@ -117,3 +119,86 @@ BOOST_AUTO_TEST_CASE(EfficiencyFactor) {
     // 1.0 (prod2) * 1.0 (G2)
     BOOST_CHECK_CLOSE(1.0, collection.findWellNode("PROD2").getAccumulativeEfficiencyFactor(), 1e-10);
 }
+
+BOOST_AUTO_TEST_CASE(FindNodesAddedAsSubtrees) {
+    PhaseUsage pu;
+    pu.num_phases = 2;
+    const ProductionSpecification prod_spec;
+    const InjectionSpecification inj_spec;
+
+    std::shared_ptr<WellsGroupInterface> field = std::make_shared<WellsGroup>("FIELD", 1.0, prod_spec, inj_spec, pu);
+    std::shared_ptr<WellsGroupInterface> g1 = std::make_shared<WellsGroup>("G1", 1.0, prod_spec, inj_spec, pu);
+    std::shared_ptr<WellsGroupInterface> w1 = std::make_shared<WellNode>("W1", 1.0, prod_spec, inj_spec, pu);
+    std::shared_ptr<WellsGroupInterface> w2 = std::make_shared<WellNode>("W2", 1.0, prod_spec, inj_spec, pu);
+
+    // G1 already has W1 as a child when it is added to the collection.
+    static_cast<WellsGroup*>(g1.get())->addChild(w1);
+
+    WellCollection collection;
+    collection.addChild(field);
+    collection.addChild(g1, "FIELD");
+    collection.addChild(w2, "G1");
+
+    BOOST_CHECK_EQUAL(field.get(), collection.findNode("FIELD"));
+    BOOST_CHECK_EQUAL(g1.get(), collection.findNode("G1"));
+    BOOST_CHECK_EQUAL(w1.get(), collection.findNode("W1"));
+    BOOST_CHECK_EQUAL(w2.get(), collection.findNode("W2"));
+    BOOST_CHECK(collection.findNode("W3") == NULL);
+
+    // Only nodes added through the collection are leaf nodes.
+    BOOST_CHECK_EQUAL(1U, collection.getLeafNodes().size());
+    BOOST_CHECK_EQUAL(w2.get(), &collection.findWellNode("W2"));
+    BOOST_CHECK_THROW(collection.findWellNode("W1"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(GroupControlsSeeNodesAttachedToGroups) {
+    PhaseUsage pu;
+    pu.num_phases = 2;
+    pu.phase_used[BlackoilPhases::Aqua] = 1;
+    pu.phase_used[BlackoilPhases::Liquid] = 1;
+    pu.phase_used[BlackoilPhases::Vapour] = 0;
+    pu.phase_pos[BlackoilPhases::Aqua] = 0;
+    pu.phase_pos[BlackoilPhases::Liquid] = 1;
+    ProductionSpecification field_prod_spec;
+    field_prod_spec.control_mode_ = ProductionSpecification::ORAT;
+    field_prod_spec.oil_max_rate_ = 100.0;
+    const InjectionSpecification inj_spec;
+
+    std::shared_ptr<WellsGroupInterface> field = std::make_shared<WellsGroup>("FIELD", 1.0, field_prod_spec, inj_spec, pu);
+    std::vector<std::shared_ptr<WellsGroupInterface> > nodes;
+    const double guide_rate[] = { 1.0, 3.0 };
+    for (int w = 0; w < 2; ++w) {
+        ProductionSpecification prod_spec;
+        prod_spec.guide_rate_ = guide_rate[w];
+        nodes.push_back(std::make_shared<WellNode>("W" + std::to_string(w + 1), 1.0, prod_spec, inj_spec, pu));
+    }
+
+    std::shared_ptr<Wells> wells(create_wells(2, 2, 2), destroy_wells);
+    for (int w = 0; w < 2; ++w) {
+        const double comp_frac[] = { 0.0, 1.0 };
+        const double WI = 1.0;
+        add_well(PRODUCER, 0.0, 1, comp_frac, &w, &WI, NULL, nodes[w]->name().c_str(), 1, wells.get());
+    }
+
+    WellCollection collection;
+    collection.addChild(field);
+    collection.addChild(nodes[0], "FIELD");
+    collection.setWellsPointer(wells.get());
+    collection.applyGroupControls();
+
+    // W2 is attached to FIELD directly, after the group controls have
+    // been evaluated once.
+    static_cast<WellsGroup*>(field.get())->addChild(nodes[1]);
+    nodes[1]->setParent(field.get());
+    static_cast<WellNode*>(nodes[1].get())->setWellsPointer(wells.get(), 1);
+    BOOST_CHECK_EQUAL(nodes[1].get(), collection.findNode("W2"));
+
+    collection.applyGroupControls();
+    for (int w = 0; w < 2; ++w) {
+        const WellNode& node = static_cast<const WellNode&>(*nodes[w]);
+        BOOST_REQUIRE(node.groupControlIndex() >= 0);
+        BOOST_CHECK_CLOSE(-100.0*guide_rate[w]/4.0,
+                          well_controls_iget_target(wells->ctrls[w], node.groupControlIndex()),
+                          1e-12);
+    }
+}
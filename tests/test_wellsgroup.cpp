@@ -27,13 +27,18 @@
 
 #define BOOST_TEST_MODULE WellsGroupTest
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <opm/core/props/phaseUsageFromDeck.hpp>
+#include <opm/core/wells.h>
+#include <opm/core/well_controls.h>
+#include <opm/core/wells/FlattenedWellsGroups.hpp>
 #include <opm/core/wells/WellsGroup.hpp>
 
 #include <opm/parser/eclipse/Parser/Parser.hpp>
@@ -149,3 +154,263 @@ BOOST_AUTO_TEST_CASE(EfficiencyFactor) {
     }
 }
 
+
+
+BOOST_AUTO_TEST_CASE(FlattenedWellsGroupsMatchRecursion) {
+    PhaseUsage pu;
+    pu.num_phases = 2;
+    pu.phase_used[BlackoilPhases::Aqua] = 1;
+    pu.phase_used[BlackoilPhases::Liquid] = 1;
+    pu.phase_used[BlackoilPhases::Vapour] = 0;
+    pu.phase_pos[BlackoilPhases::Aqua] = 0;
+    pu.phase_pos[BlackoilPhases::Liquid] = 1;
+    ProductionSpecification prod_spec;
+    InjectionSpecification inj_spec;
+
+    // FIELD -> (G1 -> (W1, W2), W3)
+    std::shared_ptr<WellsGroup> field = std::make_shared<WellsGroup>("FIELD", 1.0, prod_spec, inj_spec, pu);
+    std::shared_ptr<WellsGroup> g1 = std::make_shared<WellsGroup>("G1", 0.8, prod_spec, inj_spec, pu);
+    std::vector<std::shared_ptr<WellNode> > wells_nodes;
+    const double guide_rate[] = { 1.0, 2.0, 4.0 };
+    for (int w = 0; w < 3; ++w) {
+        prod_spec.guide_rate_ = guide_rate[w];
+        inj_spec.guide_rate_ = guide_rate[w];
+        wells_nodes.push_back(std::make_shared<WellNode>("W" + std::to_string(w + 1), 0.5, prod_spec, inj_spec, pu));
+    }
+    field->addChild(g1);
+    g1->addChild(wells_nodes[0]);
+    g1->addChild(wells_nodes[1]);
+    field->addChild(wells_nodes[2]);
+
+    std::shared_ptr<Wells> wells(create_wells(2, 3, 3), destroy_wells);
+    const WellType type[] = { PRODUCER, INJECTOR, PRODUCER };
+    for (int w = 0; w < 3; ++w) {
+        const double comp_frac[] = { 1.0, 0.0 };
+        const double WI = 1.0;
+        add_well(type[w], 0.0, 1, comp_frac, &w, &WI, NULL, wells_nodes[w]->name().c_str(), 1, wells.get());
+        wells_nodes[w]->setWellsPointer(wells.get(), w);
+    }
+
+    const std::vector<std::shared_ptr<WellsGroupInterface> > roots(1, field);
+    FlattenedWellsGroups flat(roots);
+
+    // Breadth first numbering.
+    BOOST_REQUIRE_EQUAL(5, flat.numberOfNodes());
+    const WellsGroupInterface* order[] = { field.get(), g1.get(), wells_nodes[2].get(),
+                                           wells_nodes[0].get(), wells_nodes[1].get() };
+    const int parent[] = { -1, 0, 0, 1, 1 };
+    for (int i = 0; i < 5; ++i) {
+        BOOST_CHECK_EQUAL(order[i], flat.node(i));
+        BOOST_CHECK_EQUAL(parent[i], flat.parent(i));
+    }
+
+    std::vector<double> prod_guide_rate;
+    std::vector<double> inj_guide_rate;
+    std::vector<double> voidage_rate;
+    const std::vector<double> well_voidage_rates = { 10.0, 20.0, 30.0 };
+    flat.productionGuideRates(false, prod_guide_rate);
+    flat.injectionGuideRates(false, inj_guide_rate);
+    flat.totalVoidageRates(well_voidage_rates, voidage_rate);
+    for (int i = 0; i < 5; ++i) {
+        WellsGroupInterface* node = flat.node(i);
+        BOOST_CHECK_EQUAL(node->productionGuideRate(false), prod_guide_rate[i]);
+        BOOST_CHECK_EQUAL(node->injectionGuideRate(false), inj_guide_rate[i]);
+        BOOST_CHECK_EQUAL(node->getTotalVoidageRate(well_voidage_rates), voidage_rate[i]);
+    }
+    // W1 and W3 produce, 0.5*1 + 0.5*4.
+    BOOST_CHECK_CLOSE(2.5, prod_guide_rate[0], 1e-12);
+    // (0.5*10)*0.8 + 0.5*30.
+    BOOST_CHECK_CLOSE(19.0, voidage_rate[0], 1e-12);
+}
+
+
+
+namespace
+{
+    struct GroupControlForest
+    {
+        std::vector<std::shared_ptr<WellsGroupInterface> > roots;
+        std::vector<std::shared_ptr<WellsGroupInterface> > nodes;
+        std::shared_ptr<Wells> wells;
+    };
+
+    // FIELD -> (G1 -> (G3 -> (W3, W4, W5), W1, W2), G2 -> (G5 -> W13, W6, W7, W8))
+    // and RE -> (G4 -> W12, W9, W10, W11), with wells under individual and
+    // group control.
+    GroupControlForest buildGroupControlForest(const PhaseUsage& pu)
+    {
+        GroupControlForest forest;
+        forest.wells.reset(create_wells(2, 13, 13), destroy_wells);
+
+        auto group = [&](const std::string& name, const double efficiency,
+                         const ProductionSpecification::ControlMode prod_mode,
+                         const InjectionSpecification::ControlMode inj_mode) {
+            ProductionSpecification prod_spec;
+            InjectionSpecification inj_spec;
+            prod_spec.control_mode_ = prod_mode;
+            prod_spec.oil_max_rate_ = 100.0;
+            prod_spec.liquid_max_rate_ = 80.0;
+            prod_spec.guide_rate_ = 1.0;
+            inj_spec.control_mode_ = inj_mode;
+            inj_spec.surface_flow_max_rate_ = 60.0;
+            inj_spec.reservoir_flow_max_rate_ = 30.0;
+            inj_spec.reinjection_fraction_target_ = 0.5;
+            inj_spec.voidage_replacment_fraction_ = 0.9;
+            inj_spec.guide_rate_ = 1.0;
+            std::shared_ptr<WellsGroup> node = std::make_shared<WellsGroup>(name, efficiency, prod_spec, inj_spec, pu);
+            forest.nodes.push_back(node);
+            return node;
+        };
+        auto well = [&](const std::shared_ptr<WellsGroup>& parent, const WellType type,
+                        const bool group_controlled, const double guide_rate) {
+            ProductionSpecification prod_spec;
+            InjectionSpecification inj_spec;
+            prod_spec.guide_rate_ = guide_rate;
+            inj_spec.guide_rate_ = guide_rate;
+            if (group_controlled) {
+                prod_spec.control_mode_ = ProductionSpecification::GRUP;
+                inj_spec.control_mode_ = InjectionSpecification::GRUP;
+            }
+            const int index = forest.wells->number_of_wells;
+            const std::string name = "W" + std::to_string(index + 1);
+            std::shared_ptr<WellNode> node = std::make_shared<WellNode>(name, 0.9, prod_spec, inj_spec, pu);
+            const double comp_frac[] = { 1.0, 0.0 };
+            const double WI = 1.0;
+            add_well(type, 0.0, 1, comp_frac, &index, &WI, NULL, name.c_str(), 1, forest.wells.get());
+            node->setWellsPointer(forest.wells.get(), index);
+            parent->addChild(node);
+            forest.nodes.push_back(node);
+            return node;
+        };
+
+        std::shared_ptr<WellsGroup> field = group("FIELD", 1.0, ProductionSpecification::ORAT, InjectionSpecification::NONE);
+        std::shared_ptr<WellsGroup> g1 = group("G1", 0.8, ProductionSpecification::FLD, InjectionSpecification::RATE);
+        std::shared_ptr<WellsGroup> g3 = group("G3", 0.6, ProductionSpecification::NONE, InjectionSpecification::FLD);
+        std::shared_ptr<WellsGroup> g2 = group("G2", 0.7, ProductionSpecification::LRAT, InjectionSpecification::VREP);
+        std::shared_ptr<WellsGroup> g5 = group("G5", 0.85, ProductionSpecification::NONE, InjectionSpecification::FLD);
+        std::shared_ptr<WellsGroup> re = group("RE", 1.0, ProductionSpecification::NONE, InjectionSpecification::REIN);
+        std::shared_ptr<WellsGroup> g4 = group("G4", 0.75, ProductionSpecification::NONE, InjectionSpecification::FLD);
+        field->addChild(g1);
+        field->addChild(g2);
+        g1->addChild(g3);
+        g2->addChild(g5);
+        re->addChild(g4);
+        well(g1, PRODUCER, true, 1.0);
+        well(g1, INJECTOR, true, 2.0);
+        well(g3, INJECTOR, true, 1.5);
+        well(g3, INJECTOR, false, 1.0);
+        well(g3, PRODUCER, true, 3.0);
+        well(g2, PRODUCER, true, 2.0);
+        well(g2, PRODUCER, false, 1.0);
+        well(g2, INJECTOR, true, 4.0);
+        well(re, PRODUCER, true, 1.0);
+        // W10 and W12 are already under group control, W11 is not: REIN
+        // only changes the former.
+        well(re, INJECTOR, true, 1.0)->setIndividualControl(false);
+        well(re, INJECTOR, true, 3.0);
+        well(g4, INJECTOR, true, 2.0)->setIndividualControl(false);
+        well(g5, INJECTOR, true, 1.0);
+        forest.roots = { field, re };
+        return forest;
+    }
+
+    void checkSameControls(const GroupControlForest& tree, const GroupControlForest& flat)
+    {
+        BOOST_REQUIRE_EQUAL(tree.nodes.size(), flat.nodes.size());
+        for (std::size_t i = 0; i < tree.nodes.size(); ++i) {
+            BOOST_CHECK_EQUAL(tree.nodes[i]->individualControl(), flat.nodes[i]->individualControl());
+            BOOST_CHECK_EQUAL(tree.nodes[i]->prodSpec().control_mode_, flat.nodes[i]->prodSpec().control_mode_);
+            BOOST_CHECK_EQUAL(tree.nodes[i]->injSpec().control_mode_, flat.nodes[i]->injSpec().control_mode_);
+        }
+        for (int w = 0; w < tree.wells->number_of_wells; ++w) {
+            const WellControls* tree_ctrls = tree.wells->ctrls[w];
+            const WellControls* flat_ctrls = flat.wells->ctrls[w];
+            BOOST_REQUIRE_EQUAL(well_controls_get_num(tree_ctrls), well_controls_get_num(flat_ctrls));
+            BOOST_CHECK_EQUAL(well_controls_get_current(tree_ctrls), well_controls_get_current(flat_ctrls));
+            for (int c = 0; c < well_controls_get_num(tree_ctrls); ++c) {
+                BOOST_CHECK_EQUAL(well_controls_iget_type(tree_ctrls, c), well_controls_iget_type(flat_ctrls, c));
+                BOOST_CHECK_CLOSE(well_controls_iget_target(tree_ctrls, c), well_controls_iget_target(flat_ctrls, c), 1e-12);
+                for (int p = 0; p < 2; ++p) {
+                    BOOST_CHECK_EQUAL(well_controls_iget_distr(tree_ctrls, c)[p], well_controls_iget_distr(flat_ctrls, c)[p]);
+                }
+            }
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(FlattenedGroupControlsMatchRecursion) {
+    PhaseUsage pu;
+    pu.num_phases = 2;
+    pu.phase_used[BlackoilPhases::Aqua] = 1;
+    pu.phase_used[BlackoilPhases::Liquid] = 1;
+    pu.phase_used[BlackoilPhases::Vapour] = 0;
+    pu.phase_pos[BlackoilPhases::Aqua] = 0;
+    pu.phase_pos[BlackoilPhases::Liquid] = 1;
+
+    GroupControlForest tree = buildGroupControlForest(pu);
+    GroupControlForest flat = buildGroupControlForest(pu);
+    FlattenedWellsGroups flattened(flat.roots);
+
+    for (const auto& root : tree.roots) {
+        root->applyProdGroupControls();
+    }
+    flattened.applyProdGroupControls();
+    checkSameControls(tree, flat);
+
+    for (const auto& root : tree.roots) {
+        root->applyInjGroupControls();
+    }
+    flattened.applyInjGroupControls();
+    checkSameControls(tree, flat);
+
+    // Water and oil rates of the wells, production negative.
+    const std::vector<double> reservoir_rates = {
+        -10.0, -20.0,   15.0, 0.0,   12.0, 0.0,    8.0, 0.0,   -5.0, -6.0,   -7.0, -3.0,   -4.0, -9.0,
+        11.0, 0.0,      -8.0, -2.0,  9.0, 0.0,     6.0, 0.0,   5.0, 0.0,     3.0, 0.0
+    };
+    std::vector<double> surface_rates(reservoir_rates);
+    for (double& rate : surface_rates) {
+        rate *= 0.5;
+    }
+    std::vector<double> voidage_rates(13);
+    for (int w = 0; w < 13; ++w) {
+        voidage_rates[w] = std::min(reservoir_rates[2*w] + reservoir_rates[2*w + 1], 0.0);
+    }
+    const std::vector<double> conversion_coeffs = { 1.0, 1.0 };
+
+    // RE reinjects with only_group = true.
+    for (const auto& root : tree.roots) {
+        root->applyExplicitReinjectionControls(reservoir_rates, surface_rates);
+    }
+    flattened.applyExplicitReinjectionControls(reservoir_rates, surface_rates);
+    checkSameControls(tree, flat);
+    BOOST_CHECK_EQUAL(1, well_controls_get_num(flat.wells->ctrls[9]));
+    BOOST_CHECK_EQUAL(0, well_controls_get_num(flat.wells->ctrls[10]));
+    BOOST_CHECK_EQUAL(1, well_controls_get_num(flat.wells->ctrls[11]));
+
+    for (const auto& root : tree.roots) {
+        root->applyVREPGroupControls(voidage_rates, conversion_coeffs);
+    }
+    flattened.applyVREPGroupControls(voidage_rates, conversion_coeffs);
+    checkSameControls(tree, flat);
+
+    // G1 injects more than its reservoir rate limit, which switches
+    // its injectors to RESV.
+    const std::vector<double> bhp(13, 0.0);
+    for (int iter = 0; iter < 2; ++iter) {
+        bool tree_met = true;
+        for (const auto& root : tree.roots) {
+            WellPhasesSummed summed;
+            if (!root->conditionsMet(bhp, reservoir_rates, surface_rates, summed)) {
+                tree_met = false;
+                break;
+            }
+        }
+        const bool flat_met = flattened.conditionsMet(bhp, reservoir_rates, surface_rates);
+        BOOST_CHECK_EQUAL(tree_met, flat_met);
+        checkSameControls(tree, flat);
+    }
+    BOOST_CHECK_EQUAL(InjectionSpecification::RESV, flat.nodes[1]->injSpec().control_mode_);
+}